@@ -0,0 +1,69 @@
+#!/bin/bash
+set -e  # Exit on error
+
+# Runs the canned benchmark scenes headless and collects one JSON report per scene
+SCRIPT_DIR="$( cd "$( dirname "${BASH_SOURCE[0]}" )" && pwd )"
+BINARY="$SCRIPT_DIR/fractal-core/bin/fractal"
+OUT_DIR="$SCRIPT_DIR/benchmark-results"
+FRAMES=600
+WIDTH=1920
+HEIGHT=1080
+SCENES=""
+EXTRA_ARGS=""
+SUFFIX=""
+
+# Parse command line arguments
+while [ "$1" != "" ]; do
+    case $1 in
+        --frames=* )    FRAMES="${1#*=}"
+                        ;;
+        --width=* )     WIDTH="${1#*=}"
+                        ;;
+        --height=* )    HEIGHT="${1#*=}"
+                        ;;
+        --out-dir=* )   OUT_DIR="${1#*=}"
+                        ;;
+        --scene=* )     SCENES="$SCENES ${1#*=}"
+                        ;;
+        --single-thread ) EXTRA_ARGS="$EXTRA_ARGS --single-thread"
+                        SUFFIX="$SUFFIX-single-thread"
+                        ;;
+        --merged-geometry ) EXTRA_ARGS="$EXTRA_ARGS --merged-geometry"
+                        SUFFIX="$SUFFIX-merged"
+                        ;;
+        --threads=* )   EXTRA_ARGS="$EXTRA_ARGS $1"
+                        SUFFIX="$SUFFIX-threads${1#*=}"
+                        ;;
+        --generic-kernels ) EXTRA_ARGS="$EXTRA_ARGS --fractal-kernel=generic"
+                        SUFFIX="$SUFFIX-generic"
+                        ;;
+        --fractal-cone ) EXTRA_ARGS="$EXTRA_ARGS --fractal-cone"
+                        SUFFIX="$SUFFIX-cone"
+                        ;;
+        * )             echo "Unknown option: $1"
+                        echo "Usage: ./benchmark.sh [--frames=N] [--width=N] [--height=N] [--out-dir=dir] [--scene=name ...] [--single-thread] [--merged-geometry] [--threads=N] [--generic-kernels] [--fractal-cone]"
+                        exit 1
+    esac
+    shift
+done
+
+if [ ! -x "$BINARY" ]; then
+    echo "Native binary not found, run ./build.sh --target=native first"
+    exit 1
+fi
+
+# Default to every scene in assets/benchmarks
+if [ -z "$SCENES" ]; then
+    for scene in "$SCRIPT_DIR"/fractal-core/assets/benchmarks/*.scene; do
+        SCENES="$SCENES $(basename "$scene" .scene)"
+    done
+fi
+
+mkdir -p "$OUT_DIR"
+cd "$SCRIPT_DIR/fractal-core"
+for scene in $SCENES; do
+    echo "Running $scene..."
+    "$BINARY" --headless --width="$WIDTH" --height="$HEIGHT" \
+              --benchmark="$scene" --frames="$FRAMES" --out="$OUT_DIR/$scene$SUFFIX.json" $EXTRA_ARGS
+done
+echo "Reports written to $OUT_DIR"
@@ -0,0 +1,91 @@
+#version 300 es
+precision highp float;
+precision highp sampler2D;
+
+// Perturbation deep zoom of z -> z^2 + c, one pixel per fragment. Mirrors
+// CpuDeepZoom in fractal/deepzoom.cpp: each pixel iterates its scaled difference
+// d to the reference orbit Z,
+//
+//   d' = (2 Z + s d) d + dc          z = Z + s d
+//
+// and is rebased onto the start of the critical orbit whenever |z| drops below
+// |s d| or the reference runs out. Same smooth count, palette and gamma as the
+// CPU path.
+
+uniform sampler2D uOrbit;       // RG32F orbit points, ORBIT_WIDTH per row
+uniform int uReferenceEnd;
+uniform int uCriticalStart;
+uniform int uCriticalEnd;
+uniform int uIterations;
+
+uniform vec2 uResolution;
+uniform float uScale;
+uniform float uInvScale;
+uniform vec2 uOffset;           // view centre from the reference point, in view scales
+uniform vec2 uRotation;         // cos, sin of the view angle
+uniform float uJulia;           // 1 for a Julia set, 0 for the Mandelbrot set
+
+in vec2 vUv;
+out vec4 fragColor;
+
+// Row width of the orbit texture, FractalRenderer::ORBIT_WIDTH
+const int ORBIT_WIDTH = 2048;
+const float ESCAPE_RADIUS_SQUARED = 4096.0;
+const float PALETTE_PERIOD = 48.0;
+const float TAU = 6.28318531;
+
+vec2 orbitPoint(int index) {
+    return texelFetch(uOrbit, ivec2(index % ORBIT_WIDTH, index / ORBIT_WIDTH), 0).xy;
+}
+
+vec3 palette(float smoothIterations) {
+    float phase = smoothIterations * (TAU / PALETTE_PERIOD);
+    return 0.5 + 0.5 * cos(phase + TAU * vec3(0.0, 0.15, 0.3));
+}
+
+void main() {
+    // Pixel centres map to [-aspect, aspect] x [-1, 1], then rotate and move to
+    // the reference point
+    vec2 plane = gl_FragCoord.xy / uResolution * 2.0 - 1.0;
+    plane.x *= uResolution.x / uResolution.y;
+    vec2 dc = vec2(plane.x * uRotation.x - plane.y * uRotation.y,
+                   plane.x * uRotation.y + plane.y * uRotation.x) + uOffset;
+
+    // The Mandelbrot set adds its pixel offset every step, a Julia set starts from it
+    vec2 add = dc * (1.0 - uJulia);
+    vec2 d = dc * uJulia;
+    vec2 Z = orbitPoint(0);
+    int index = 0;
+    int end = uReferenceEnd;
+
+    vec3 color = vec3(0.0);
+    for (int i = 1; i <= uIterations; i++) {
+        vec2 a = 2.0 * Z + uScale * d;
+        d = vec2(a.x * d.x - a.y * d.y, a.x * d.y + a.y * d.x) + add;
+        index++;
+        Z = orbitPoint(index);
+
+        // The full value z / s, and z itself for the escape test
+        vec2 u = Z * uInvScale + d;
+        vec2 w = u * uScale;
+        float length2 = dot(w, w);
+        if (length2 > ESCAPE_RADIUS_SQUARED) {
+            float smoothIterations = float(i) + 1.0 - log2(0.5 * log2(length2));
+            color = palette(smoothIterations);
+            break;
+        }
+
+        // Max norms, since squares of z / s overflow long before z gets large
+        vec2 absU = abs(u);
+        vec2 absD = abs(d);
+        if (max(absU.x, absU.y) < max(absD.x, absD.y) || index + 1 >= end) {
+            d = u;
+            index = uCriticalStart;
+            end = uCriticalEnd;
+            Z = orbitPoint(index);
+        }
+    }
+
+    // Same gamma 2 encode as the CPU path
+    fragColor = vec4(sqrt(clamp(color, 0.0, 1.0)), 1.0);
+}
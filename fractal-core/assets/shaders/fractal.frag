@@ -0,0 +1,427 @@
+#version 300 es
+precision highp float;
+
+// Sphere traced fractal, one primary ray per fragment. Mirrors the CPU reference
+// in fractal/distanceestimator.h and fractal/cpuraymarcher.cpp: same estimators,
+// same bailout sphere clipping, hit threshold and shading, so the two images
+// agree up to transcendental precision.
+//
+// Each formula kernel (fractal/formula.h) is its own variant: FRACTAL_TYPE picks
+// the estimator and MANDELBULB_POWER, when defined, replaces the generic
+// pow/atan/acos Mandelbulb with a trig-free expansion for that whole power.
+//
+// The cone pre-pass of CpuRayMarcher is two more variants. CONE_PASS draws one
+// fragment per cell of a coarse level, marching a cone that holds every ray of
+// the cell, and writes where it stopped into an RGBA8 target: depth over
+// uConeRange rounded down to 16 bits in red and green, the steps it stands in
+// for in blue. CONE_START reads such a level, the one above in a cone pass or
+// the finest in the full resolution pass, and starts each ray from its cell.
+//
+// TEMPORAL is the GPU side of TemporalRenderer (fractal/temporalrenderer.h).
+// Only fragments in block cell uTemporalCell march; the others look for the
+// history pixel that lands on them and copy it, unless it is rejected. Besides
+// the color it writes a second RGBA8 target with the view depth over
+// uTemporalRange in 16 bits over red and green, all ones for a miss, and an
+// octahedral normal in blue and alpha, which the next frame reads as history.
+
+// FractalType
+#define MANDELBULB 0
+#define QUATERNION_JULIA 1
+#ifndef FRACTAL_TYPE
+#define FRACTAL_TYPE MANDELBULB
+#endif
+
+uniform vec2 uResolution;
+uniform vec3 uCameraPosition;
+uniform vec3 uCameraRight;
+uniform vec3 uCameraUp;
+uniform vec3 uCameraForward;
+uniform vec2 uPlaneExtent;      // tan(fov / 2) * aspect, tan(fov / 2)
+
+uniform float uPower;
+uniform int uIterations;
+uniform float uBailout;
+uniform vec4 uJuliaC;
+
+uniform int uMaxSteps;
+uniform float uPixelFootprint;  // pixel angle times the hit threshold in pixels
+uniform float uStepScale;
+
+#ifdef CONE_START
+precision highp sampler2D;
+
+uniform sampler2D uConeInput;
+uniform int uConeInputCellSize;
+#endif
+#if defined(CONE_PASS) || defined(CONE_START)
+uniform float uConeRange;       // depth of a full encoding; beyond every exit, so it marks misses
+#endif
+#ifdef CONE_PASS
+uniform float uConeCellSize;
+uniform float uConeSlope;       // cone radius per unit depth
+#endif
+
+#ifdef TEMPORAL
+precision highp sampler2D;
+
+uniform sampler2D uHistoryColor;
+uniform sampler2D uHistoryGeometry;
+uniform float uHistoryRange;    // depth of a full encoding in the history
+uniform float uTemporalRange;   // and in this frame's geometry
+uniform int uTemporalCell;      // block cell marched this frame, -1 to march every fragment
+// TemporalReprojection from the history's view to this one
+uniform vec3 uReprojectOrigin;
+uniform vec3 uReprojectBase;
+uniform vec3 uReprojectStepX;
+uniform vec3 uReprojectStepY;
+uniform vec2 uReprojectScale;
+// TemporalSettings
+uniform int uTemporalIterations;
+uniform float uTemporalMaxError;
+uniform float uTemporalDepthThreshold;
+uniform float uTemporalMaxParallax;
+uniform float uTemporalMinFacing;
+#endif
+
+in vec2 vUv;
+#ifdef TEMPORAL
+layout(location = 0) out vec4 fragColor;
+layout(location = 1) out vec4 fragGeometry;
+#else
+out vec4 fragColor;
+#endif
+
+const vec3 LIGHT_DIRECTION = vec3(0.50508, 0.80812, 0.30305);
+const vec3 KEY_COLOR = vec3(1.0, 0.92, 0.8);
+const vec3 SKY_COLOR = vec3(0.25, 0.3, 0.4);
+const vec3 ALBEDO = vec3(0.85, 0.72, 0.55);
+const vec3 BACKGROUND_BOTTOM = vec3(0.04, 0.045, 0.06);
+const vec3 BACKGROUND_TOP = vec3(0.32, 0.38, 0.48);
+const float MIN_EPSILON = 1e-5;
+
+#ifdef MANDELBULB_POWER
+// Same bit loop as IntPower and UnitComplexPower in distanceestimator.h; the trip
+// count is a constant, so the compiler unrolls it and drops the untaken branches
+float intPower(float base) {
+    float result = 1.0;
+    for (int n = MANDELBULB_POWER - 1; n > 0; n >>= 1) {
+        if ((n & 1) != 0) {
+            result *= base;
+        }
+        base *= base;
+    }
+    return result;
+}
+
+vec2 complexMultiply(vec2 a, vec2 b) {
+    return vec2(a.x * b.x - a.y * b.y, a.x * b.y + a.y * b.x);
+}
+
+// (cos a, sin a) -> (cos N a, sin N a)
+vec2 unitComplexPower(vec2 c) {
+    vec2 result = vec2(1.0, 0.0);
+    for (int n = MANDELBULB_POWER; n > 0; n >>= 1) {
+        if ((n & 1) != 0) {
+            result = complexMultiply(result, c);
+        }
+        c = complexMultiply(c, c);
+    }
+    return result;
+}
+
+// MandelbulbDistanceN: theta and phi only ever appear as cosines and sines
+float mandelbulbDistance(vec3 p) {
+    const float power = float(MANDELBULB_POWER);
+    vec3 z = p;
+    float dr = 1.0;
+    float r = length(z);
+    for (int i = 0; i < uIterations && r <= uBailout; i++) {
+        float safeR = max(r, 1e-20);
+        float rho = length(z.xy);
+        vec2 theta = unitComplexPower(vec2(z.z, rho) / safeR);
+        vec2 phi = rho > 0.0 ? unitComplexPower(z.xy / rho) : vec2(1.0, 0.0);
+        float rPowMinusOne = intPower(safeR);
+        dr = rPowMinusOne * power * dr + 1.0;
+        z = rPowMinusOne * safeR * vec3(theta.y * phi.x, theta.y * phi.y, theta.x) + p;
+        r = length(z);
+    }
+    r = max(r, 1e-20);
+    return 0.5 * log(r) * r / dr;
+}
+#else
+float mandelbulbDistance(vec3 p) {
+    vec3 z = p;
+    float dr = 1.0;
+    float r = length(z);
+    for (int i = 0; i < uIterations && r <= uBailout; i++) {
+        float safeR = max(r, 1e-20);
+        float theta = acos(clamp(z.z / safeR, -1.0, 1.0)) * uPower;
+        float phi = atan(z.y, z.x) * uPower;
+        float rPowMinusOne = pow(safeR, uPower - 1.0);
+        dr = rPowMinusOne * uPower * dr + 1.0;
+        float sinTheta = sin(theta);
+        z = rPowMinusOne * safeR * vec3(sinTheta * cos(phi), sinTheta * sin(phi), cos(theta)) + p;
+        r = length(z);
+    }
+    r = max(r, 1e-20);
+    return 0.5 * log(r) * r / dr;
+}
+#endif
+
+float juliaDistance(vec3 p) {
+    // Real part in x
+    vec4 q = vec4(p, 0.0);
+    vec4 dq = vec4(1.0, 0.0, 0.0, 0.0);
+    float bailout2 = uBailout * uBailout;
+    float r2 = dot(q, q);
+    for (int i = 0; i < uIterations && r2 <= bailout2; i++) {
+        dq = 2.0 * vec4(q.x * dq.x - dot(q.yzw, dq.yzw),
+                        q.x * dq.y + q.y * dq.x + q.z * dq.w - q.w * dq.z,
+                        q.x * dq.z - q.y * dq.w + q.z * dq.x + q.w * dq.y,
+                        q.x * dq.w + q.y * dq.z - q.z * dq.y + q.w * dq.x);
+        q = vec4(q.x * q.x - dot(q.yzw, q.yzw), 2.0 * q.x * q.yzw) + uJuliaC;
+        r2 = dot(q, q);
+    }
+    float r = max(sqrt(r2), 1e-20);
+    return 0.5 * r * log(r) / max(length(dq), 1e-20);
+}
+
+float fractalDistance(vec3 p) {
+#if FRACTAL_TYPE == QUATERNION_JULIA
+    return juliaDistance(p);
+#else
+    return mandelbulbDistance(p);
+#endif
+}
+
+vec3 fractalNormal(vec3 p, float h) {
+    float a = fractalDistance(p + vec3(h, -h, -h));
+    float b = fractalDistance(p + vec3(-h, -h, h));
+    float c = fractalDistance(p + vec3(-h, h, -h));
+    float d = fractalDistance(p + vec3(h, h, h));
+    return normalize(vec3(a - b - c + d, -a - b + c + d, -a + b - c + d));
+}
+
+#ifdef CONE_START
+// Start depth and steps of the cell pixel lies in
+float coneStart(ivec2 pixel, out float steps) {
+    vec3 texel = texelFetch(uConeInput, pixel / uConeInputCellSize, 0).rgb;
+    vec3 bytes = floor(texel * 255.0 + 0.5);
+    steps = bytes.b;
+    return (bytes.r * 256.0 + bytes.g) / 65535.0 * uConeRange;
+}
+#endif
+
+#ifdef TEMPORAL
+vec2 signNotZero(vec2 v) {
+    return vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+}
+
+// View depth to red and green, rounded to the nearest of 65534 steps
+vec2 encodeDepth(float depth) {
+    float value = min(floor(depth / uTemporalRange * 65534.0 + 0.5), 65534.0);
+    float high = floor(value / 256.0);
+    return vec2(high, value - high * 256.0) / 255.0;
+}
+
+// Unit normal folded onto an octahedron and flattened to blue and alpha
+vec2 encodeNormal(vec3 n) {
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    vec2 e = n.z >= 0.0 ? n.xy : (1.0 - abs(n.yx)) * signNotZero(n.xy);
+    return e * 0.5 + 0.5;
+}
+
+vec3 decodeNormal(vec2 encoded) {
+    vec2 e = encoded * 2.0 - 1.0;
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0) {
+        n.xy = (1.0 - abs(n.yx)) * signNotZero(n.xy);
+    }
+    return normalize(n);
+}
+
+// View depth of a history pixel, negative for a miss
+float historyDepth(ivec2 pixel) {
+    vec2 bytes = floor(texelFetch(uHistoryGeometry, pixel, 0).rg * 255.0 + 0.5);
+    float value = bytes.r * 256.0 + bytes.g;
+    return value >= 65535.0 ? -1.0 : value / 65534.0 * uHistoryRange;
+}
+
+// Same as TemporalRenderer::Land
+bool land(ivec2 source, out vec3 point, out vec2 motion) {
+    vec2 sourceCentre = vec2(source) + 0.5;
+    vec3 ray = uReprojectBase + uReprojectStepX * sourceCentre.x + uReprojectStepY * sourceCentre.y;
+    float depth = historyDepth(source);
+    point = depth >= 0.0 ? uReprojectOrigin + ray * depth : ray;
+    motion = vec2(0.0);
+    if (point.z <= 0.0) {
+        return false;
+    }
+    motion = point.xy / point.z * uReprojectScale + uResolution * 0.5 - sourceCentre;
+    return true;
+}
+
+bool isDepthEdge(float a, float b) {
+    if ((a >= 0.0) != (b >= 0.0)) {
+        return true;
+    }
+    return a >= 0.0 && abs(a - b) > uTemporalDepthThreshold * min(a, b);
+}
+
+// Same as TemporalRenderer::Reproject, but every search starts from no motion
+bool reproject(vec2 centre, out vec4 color, out vec4 geometry) {
+    color = vec4(0.0);
+    geometry = vec4(0.0);
+    ivec2 size = ivec2(uResolution);
+    vec2 motion = vec2(0.0);
+    vec3 point = vec3(0.0);
+    ivec2 source = ivec2(0);
+    bool landed = false;
+    for (int i = 0; i <= uTemporalIterations && !landed; i++) {
+        source = clamp(ivec2(floor(centre - motion)), ivec2(0), size - 1);
+        if (!land(source, point, motion)) {
+            return false;
+        }
+        vec2 error = abs(vec2(source) + 0.5 + motion - centre);
+        landed = max(error.x, error.y) <= uTemporalMaxError;
+    }
+    if (!landed) {
+        return false;
+    }
+
+    // A neighbour across a depth edge that moves apart from this pixel
+    float depth = historyDepth(source);
+    ivec2 offsets[4] = ivec2[4](ivec2(-1, 0), ivec2(1, 0), ivec2(0, -1), ivec2(0, 1));
+    for (int i = 0; i < 4; i++) {
+        ivec2 neighbour = source + offsets[i];
+        if (any(lessThan(neighbour, ivec2(0))) || any(greaterThanEqual(neighbour, size)) ||
+            !isDepthEdge(depth, historyDepth(neighbour))) {
+            continue;
+        }
+        vec3 neighbourPoint;
+        vec2 neighbourMotion;
+        if (!land(neighbour, neighbourPoint, neighbourMotion)) {
+            return false;
+        }
+        vec2 parallax = abs(neighbourMotion - motion);
+        if (max(parallax.x, parallax.y) > uTemporalMaxParallax) {
+            return false;
+        }
+    }
+
+    // A surface turned away from this view, or seen nearly edge on
+    vec4 stored = texelFetch(uHistoryGeometry, source, 0);
+    if (depth >= 0.0) {
+        vec3 offset = uCameraRight * point.x + uCameraUp * point.y + uCameraForward * point.z;
+        if (-dot(decodeNormal(stored.ba), offset) < uTemporalMinFacing * length(offset)) {
+            return false;
+        }
+        stored.rg = encodeDepth(point.z);
+    }
+    color = texelFetch(uHistoryColor, source, 0);
+    geometry = stored;
+    return true;
+}
+#endif
+
+#ifdef CONE_PASS
+// Same march as MarchCone in cpuraymarcher.cpp
+void main() {
+    vec2 pixel = gl_FragCoord.xy * uConeCellSize;
+    vec2 plane = (pixel * (2.0 / uResolution) - 1.0) * uPlaneExtent;
+    vec3 dir = normalize(uCameraForward + uCameraUp * plane.y + uCameraRight * plane.x);
+    vec3 origin = uCameraPosition;
+    float b = dot(origin, dir);
+
+    float t = 0.0;
+    float steps = 0.0;
+#ifdef CONE_START
+    t = coneStart(ivec2(gl_FragCoord.xy) * int(uConeCellSize), steps);
+#endif
+    bool missed = t >= uConeRange;
+    for (int i = 0; i < uMaxSteps && !missed; i++) {
+        vec3 position = origin + dir * t;
+        float len = length(position);
+        bool outside = len > uBailout;
+        // The distance to the bailout sphere bounds the set too
+        float distance = max(len - uBailout, fractalDistance(position) * uStepScale);
+        float radius = t * uConeSlope;
+        float clearance = distance - radius;
+        if (outside && clearance > 0.0 && b + t > len * uConeSlope) {
+            missed = true;
+            break;
+        }
+        if (clearance < radius) {
+            break;
+        }
+        if (!outside) {
+            steps += 1.0;
+        }
+        t += clearance / (1.0 + uConeSlope);
+    }
+
+    float depth = missed ? 65535.0 : min(floor(t / uConeRange * 65535.0), 65535.0);
+    float high = floor(depth / 256.0);
+    fragColor = vec4(high, depth - high * 256.0, min(steps, 255.0), 255.0) / 255.0;
+}
+#else
+void main() {
+    vec2 plane = (gl_FragCoord.xy * (2.0 / uResolution) - 1.0) * uPlaneExtent;
+    vec3 dir = normalize(uCameraForward + uCameraUp * plane.y + uCameraRight * plane.x);
+    vec3 origin = uCameraPosition;
+
+    vec3 color = mix(BACKGROUND_BOTTOM, BACKGROUND_TOP, dir.y * 0.5 + 0.5);
+#ifdef TEMPORAL
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    if (uTemporalCell >= 0 && ((pixel.x & 1) | ((pixel.y & 1) << 1)) != uTemporalCell) {
+        vec4 history;
+        vec4 geometry;
+        if (reproject(gl_FragCoord.xy, history, geometry)) {
+            fragColor = history;
+            fragGeometry = geometry;
+            return;
+        }
+    }
+    // A miss until the march says otherwise
+    fragGeometry = vec4(1.0, 1.0, 0.5, 0.5);
+#endif
+
+    // Clip to the bailout sphere
+    float b = dot(origin, dir);
+    float discriminant = b * b - (dot(origin, origin) - uBailout * uBailout);
+    if (discriminant > 0.0) {
+        float root = sqrt(discriminant);
+        float tExit = -b + root;
+        float t = max(-b - root, 0.0);
+        float steps = 0.0;
+#ifdef CONE_START
+        t = max(t, coneStart(ivec2(gl_FragCoord.xy), steps));
+#endif
+        bool hit = false;
+        for (int i = 0; i < uMaxSteps && t < tExit; i++) {
+            vec3 position = origin + dir * t;
+            steps += 1.0;
+            float distance = fractalDistance(position);
+            if (distance < max(t * uPixelFootprint, MIN_EPSILON)) {
+                hit = true;
+                break;
+            }
+            t += distance * uStepScale;
+        }
+
+        if (hit) {
+            vec3 normal = fractalNormal(origin + dir * t, max(t * uPixelFootprint, MIN_EPSILON));
+            float diffuse = max(dot(normal, LIGHT_DIRECTION), 0.0);
+            float sky = normal.y * 0.5 + 0.5;
+            float occlusion = clamp(1.0 - steps / float(uMaxSteps), 0.0, 1.0);
+            color = ALBEDO * (KEY_COLOR * diffuse + SKY_COLOR * sky) * occlusion;
+#ifdef TEMPORAL
+            fragGeometry = vec4(encodeDepth(t * dot(dir, uCameraForward)), encodeNormal(normal));
+#endif
+        }
+    }
+
+    // Same gamma 2 encode as the CPU path
+    fragColor = vec4(sqrt(clamp(color, 0.0, 1.0)), 1.0);
+}
+#endif
@@ -2,16 +2,28 @@
 
 layout(location = 0) in vec3 aPosition;
 
-uniform mat4 uModel;
+// per-light instance data
+layout(location = 1) in vec3 aLightPosition;
+layout(location = 2) in vec3 aLightColor;
+layout(location = 3) in float aLightIntensity;
+
 uniform mat4 uView;
 uniform mat4 uProjection;
-uniform vec3 uColor;
-uniform float uIntensity;
 
 out vec3 vColor;
 
 void main()
 {
-    gl_Position = uProjection * uView * uModel * vec4(aPosition, 1.0);
-    vColor = uColor * uIntensity;
-}
\ No newline at end of file
+    // Billboard: orient the gizmo with the camera axes taken from the view matrix rows
+    vec3 cameraRight = vec3(uView[0][0], uView[1][0], uView[2][0]);
+    vec3 cameraUp = vec3(uView[0][1], uView[1][1], uView[2][1]);
+    vec3 cameraForward = vec3(uView[0][2], uView[1][2], uView[2][2]);
+
+    vec3 worldPosition = aLightPosition
+        + cameraRight * aPosition.x
+        + cameraUp * aPosition.y
+        + cameraForward * aPosition.z;
+
+    gl_Position = uProjection * uView * vec4(worldPosition, 1.0);
+    vColor = aLightColor * aLightIntensity;
+}
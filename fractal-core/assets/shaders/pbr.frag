@@ -2,29 +2,82 @@
 precision highp float;
 precision highp int;
 
+// Feature defines are injected by ShaderVariantCache:
+// HAS_ALBEDO_MAP, HAS_NORMAL_MAP, HAS_METALLIC_MAP, HAS_ROUGHNESS_MAP, HAS_AO_MAP, NUM_LIGHTS,
+// USE_INSTANCE_ATTRIBUTES, USE_SHADOWS
+#ifndef NUM_LIGHTS
+#define NUM_LIGHTS 4
+#endif
+
 out vec4 FragColor;
 
 in vec3 FragPos;
 in vec2 TexCoords;
-in vec3 TangentLightPos[4];
-in vec3 TangentViewPos;
-in vec3 TangentFragPos;
+in vec3 Normal;
+#ifdef HAS_NORMAL_MAP
+in vec3 Tangent;
+#endif
 
+#ifdef HAS_ALBEDO_MAP
 uniform sampler2D albedoMap;
+#endif
+#ifdef HAS_NORMAL_MAP
 uniform sampler2D normalMap;
+#endif
+#ifdef HAS_METALLIC_MAP
 uniform sampler2D metallicMap;
+#endif
+#ifdef HAS_ROUGHNESS_MAP
 uniform sampler2D roughnessMap;
+#endif
+#ifdef HAS_AO_MAP
 uniform sampler2D aoMap;
+#endif
+
+// Streamed per frame and per instance by MeshRenderer, std140 layouts mirrored
+// in meshrenderer.h. Both stages declare both blocks so their layouts match.
+layout(std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec4 viewPos;
+    vec4 lightPositions[NUM_LIGHTS];  // w: type, 0 point, 1 directional, 2 spot
+    vec4 lightColors[NUM_LIGHTS];     // color * intensity, w: spot cos inner half-angle
+    vec4 lightDirections[NUM_LIGHTS]; // w: spot cos outer half-angle
+};
 
-uniform vec3 lightPositions[4];
-uniform vec3 lightColors[4];
-uniform vec3 viewPos;
+#ifdef USE_INSTANCE_ATTRIBUTES
+flat in vec4 vAlbedoMetallic;
+flat in vec2 vRoughnessAo;
+#define albedoMetallic vAlbedoMetallic
+#define roughnessAo vRoughnessAo
+#else
+layout(std140) uniform InstanceData {
+    mat4 model;
+    // transpose(inverse(mat3(model))), computed once per instance on the CPU
+    mat3 normalMatrix;
+    vec4 albedoMetallic;
+    vec4 roughnessAo;
+};
+#endif
 
-// PBR material properties (fallback if no textures)
-uniform vec3 albedo;
-uniform float metallic;
-uniform float roughness;
-uniform float ao;
+#ifdef USE_SHADOWS
+// Mirrors ShadowSampling in shadowcache.h, streamed by MeshRenderer
+#define MAX_SHADOW_LAYERS 16
+#define MAX_SHADOWED_LIGHTS 32
+layout(std140) uniform ShadowData {
+    // World to shadow map texture space, or world to light view for paraboloids
+    mat4 shadowMatrices[MAX_SHADOW_LAYERS];
+    // x: layer holds a map, y: paraboloid, z: texel world size or near plane, w: far plane
+    vec4 shadowLayerParams[MAX_SHADOW_LAYERS];
+    // Per light: x first layer (-1 unshadowed), y layer count
+    vec4 lightShadows[MAX_SHADOWED_LIGHTS];
+    // x: 1 / map size, y: depth bias
+    vec4 shadowParams;
+};
+uniform highp sampler2DArrayShadow shadowMap;
+
+float ShadowFactor(int light, vec3 N, vec3 toLight);
+#endif
 
 const float PI = 3.14159265359;
 
@@ -35,57 +88,109 @@ float GeometrySmith(vec3 N, vec3 V, vec3 L, float roughness);
 vec3 FresnelSchlick(float cosTheta, vec3 F0);
 vec3 FresnelSchlickRoughness(float cosTheta, vec3 F0, float roughness);
 
+// One light's contribution. main() calls it with constant indices: in a loop
+// the body is too large to unroll at 8 lights and up, and indexing the light
+// arrays with a loop counter is much slower than constant indices.
+vec3 ShadeLight(int i, vec3 N, vec3 V, vec3 F0, vec3 albedoValue, float metallicValue, float roughnessValue) {
+    vec3 L;
+    float attenuation;
+    if (lightPositions[i].w == 1.0) {
+        // Directional: parallel rays, no falloff
+        L = -normalize(lightDirections[i].xyz);
+        attenuation = 1.0;
+    }
+    else {
+        vec3 toLight = lightPositions[i].xyz - FragPos;
+        float distance = length(toLight);
+        L = toLight / distance;
+        attenuation = 1.0 / (distance * distance);
+        if (lightPositions[i].w == 2.0) {
+            float cosAngle = dot(-L, normalize(lightDirections[i].xyz));
+            attenuation *= smoothstep(lightDirections[i].w, lightColors[i].w, cosAngle);
+        }
+    }
+#ifdef USE_SHADOWS
+    if (attenuation > 0.0) {
+        attenuation *= ShadowFactor(i, normalize(Normal), lightPositions[i].xyz - FragPos);
+    }
+#endif
+    vec3 H = normalize(V + L);
+    vec3 radiance = lightColors[i].rgb * attenuation;
+    
+    // Cook-Torrance BRDF
+    float NDF = DistributionGGX(N, H, roughnessValue);
+    float G = GeometrySmith(N, V, L, roughnessValue);
+    vec3 F = FresnelSchlick(max(dot(H, V), 0.0), F0);
+    
+    vec3 numerator = NDF * G * F;
+    float denominator = 4.0 * max(dot(N, V), 0.0) * max(dot(N, L), 0.0) + 0.0001;
+    vec3 specular = numerator / denominator;
+    
+    // Energy conservation
+    vec3 kS = F;
+    vec3 kD = vec3(1.0) - kS;
+    kD *= 1.0 - metallicValue;
+    
+    float NdotL = max(dot(N, L), 0.0);
+    return (kD * albedoValue / PI + specular) * radiance * NdotL;
+}
+
 void main() {
-    // Sample material properties
+    // Sample material properties, falling back to the instance block for maps the mesh doesn't bind
+#ifdef HAS_ALBEDO_MAP
     vec3 albedoValue = texture(albedoMap, TexCoords).rgb;
-    if (albedoValue == vec3(0.0)) albedoValue = albedo; // Use uniform if texture is black
-    
+#else
+    vec3 albedoValue = albedoMetallic.rgb;
+#endif
+
+#ifdef HAS_METALLIC_MAP
     float metallicValue = texture(metallicMap, TexCoords).r;
-    if (metallicValue == 0.0) metallicValue = metallic;
-    
+#else
+    float metallicValue = albedoMetallic.a;
+#endif
+
+#ifdef HAS_ROUGHNESS_MAP
     float roughnessValue = texture(roughnessMap, TexCoords).r;
-    if (roughnessValue == 0.0) roughnessValue = roughness;
-    
+#else
+    float roughnessValue = roughnessAo.x;
+#endif
+
+#ifdef HAS_AO_MAP
     float aoValue = texture(aoMap, TexCoords).r;
-    if (aoValue == 0.0) aoValue = ao;
+#else
+    float aoValue = roughnessAo.y;
+#endif
     
-    // Normal mapping
-    vec3 normal = texture(normalMap, TexCoords).rgb;
-    normal = normalize(normal * 2.0 - 1.0);
-    
-    vec3 N = normalize(normal);
-    vec3 V = normalize(TangentViewPos - TangentFragPos);
+    // Normal mapping, with the TBN built per fragment from the interpolated normal and tangent
+    vec3 N = normalize(Normal);
+#ifdef HAS_NORMAL_MAP
+    vec3 T = normalize(Tangent - dot(Tangent, N) * N);
+    vec3 B = cross(N, T);
+    vec3 tangentNormal = texture(normalMap, TexCoords).rgb * 2.0 - 1.0;
+    N = normalize(mat3(T, B, N) * tangentNormal);
+#endif
+    vec3 V = normalize(viewPos.xyz - FragPos);
     
     // Calculate reflectance at normal incidence
     vec3 F0 = vec3(0.04);
     F0 = mix(F0, albedoValue, metallicValue);
     
-    // Lighting calculation
-    vec3 Lo = vec3(0.0);
-    for(int i = 0; i < 4; ++i) {
-        vec3 L = normalize(TangentLightPos[i] - TangentFragPos);
-        vec3 H = normalize(V + L);
-        float distance = length(lightPositions[i] - FragPos);
-        float attenuation = 1.0 / (distance * distance);
-        vec3 radiance = lightColors[i] * attenuation;
-        
-        // Cook-Torrance BRDF
-        float NDF = DistributionGGX(N, H, roughnessValue);
-        float G = GeometrySmith(N, V, L, roughnessValue);
-        vec3 F = FresnelSchlick(max(dot(H, V), 0.0), F0);
-        
-        vec3 numerator = NDF * G * F;
-        float denominator = 4.0 * max(dot(N, V), 0.0) * max(dot(N, L), 0.0) + 0.0001;
-        vec3 specular = numerator / denominator;
-        
-        // Energy conservation
-        vec3 kS = F;
-        vec3 kD = vec3(1.0) - kS;
-        kD *= 1.0 - metallicValue;
-        
-        float NdotL = max(dot(N, L), 0.0);
-        Lo += (kD * albedoValue / PI + specular) * radiance * NdotL;
-    }
+    // Lighting calculation, unrolled in groups of four (light counts are 4, 8, 16 or 32)
+#if NUM_LIGHTS % 4 != 0 || NUM_LIGHTS > 32
+#error NUM_LIGHTS must be a multiple of 4 up to 32
+#endif
+#define SHADE_LIGHT(i) ShadeLight(i, N, V, F0, albedoValue, metallicValue, roughnessValue)
+#define SHADE_LIGHTS_4(i) SHADE_LIGHT(i) + SHADE_LIGHT(i + 1) + SHADE_LIGHT(i + 2) + SHADE_LIGHT(i + 3)
+    vec3 Lo = SHADE_LIGHTS_4(0);
+#if NUM_LIGHTS > 4
+    Lo += SHADE_LIGHTS_4(4);
+#endif
+#if NUM_LIGHTS > 8
+    Lo += SHADE_LIGHTS_4(8) + SHADE_LIGHTS_4(12);
+#endif
+#if NUM_LIGHTS > 16
+    Lo += SHADE_LIGHTS_4(16) + SHADE_LIGHTS_4(20) + SHADE_LIGHTS_4(24) + SHADE_LIGHTS_4(28);
+#endif
     
     // Ambient lighting (simple ambient)
     vec3 ambient = vec3(0.03) * albedoValue * aoValue;
@@ -138,4 +243,69 @@ vec3 FresnelSchlick(float cosTheta, vec3 F0) {
 
 vec3 FresnelSchlickRoughness(float cosTheta, vec3 F0, float roughness) {
     return F0 + (max(vec3(1.0 - roughness), F0) - F0) * pow(clamp(1.0 - cosTheta, 0.0, 1.0), 5.0);
-} 
\ No newline at end of file
+} 
+
+#ifdef USE_SHADOWS
+// 2x2 taps, each a bilinear hardware comparison
+float SampleShadow(vec2 uv, float layer, float depth) {
+    float texel = shadowParams.x;
+    float lit = 0.0;
+    lit += texture(shadowMap, vec4(uv + vec2(-0.5, -0.5) * texel, layer, depth));
+    lit += texture(shadowMap, vec4(uv + vec2( 0.5, -0.5) * texel, layer, depth));
+    lit += texture(shadowMap, vec4(uv + vec2(-0.5,  0.5) * texel, layer, depth));
+    lit += texture(shadowMap, vec4(uv + vec2( 0.5,  0.5) * texel, layer, depth));
+    return lit * 0.25;
+}
+
+float ShadowFactor(int light, vec3 N, vec3 toLight) {
+    int firstLayer = int(lightShadows[light].x);
+    int layerCount = int(lightShadows[light].y);
+    if (firstLayer < 0) {
+        return 1.0;
+    }
+    float bias = shadowParams.y;
+
+    // Point light: pick the hemisphere facing the fragment
+    if (shadowLayerParams[firstLayer].y > 0.5) {
+        // Push the lookup off the surface by about a texel at this distance
+        vec3 world = FragPos + N * length(toLight) * shadowParams.x * 2.0;
+        vec3 p = (shadowMatrices[firstLayer] * vec4(world, 1.0)).xyz;
+        int layer = p.z >= 0.0 ? firstLayer : firstLayer + 1;
+        vec4 params = shadowLayerParams[layer];
+        if (params.x < 0.5) {
+            return 1.0;
+        }
+        p.z = abs(p.z);
+        float distance = length(p);
+        vec3 direction = p / max(distance, 0.0001);
+        vec2 uv = direction.xy / (1.0 + direction.z) * 0.5 + 0.5;
+        float depth = (distance - params.z) / (params.w - params.z);
+        if (depth >= 1.0) {
+            return 1.0;
+        }
+        return SampleShadow(uv, float(layer), depth - bias);
+    }
+
+    // Cascades and spot lights: the first layer that covers the fragment wins
+    for (int k = 0; k < layerCount; ++k) {
+        int layer = firstLayer + k;
+        vec4 params = shadowLayerParams[layer];
+        if (params.x < 0.5) {
+            continue;
+        }
+        // Orthographic layers know their texel size; perspective ones scale with distance
+        float offset = params.z > 0.0 ? params.z * 1.5 : length(toLight) * shadowParams.x * 2.0;
+        vec4 coords = shadowMatrices[layer] * vec4(FragPos + N * offset, 1.0);
+        if (coords.w <= 0.0) {
+            continue;
+        }
+        coords.xyz /= coords.w;
+        if (all(greaterThanEqual(coords.xyz, vec3(0.0))) && all(lessThanEqual(coords.xyz, vec3(1.0)))) {
+            // Perspective depth is too nonlinear for a constant bias; the polygon
+            // offset and normal offset cover spot lights on their own
+            return SampleShadow(coords.xy, float(layer), params.z > 0.0 ? coords.z - bias : coords.z);
+        }
+    }
+    return 1.0;
+}
+#endif
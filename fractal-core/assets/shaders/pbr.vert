@@ -2,41 +2,73 @@
 precision highp float;
 precision highp int;
 
+#ifndef NUM_LIGHTS
+#define NUM_LIGHTS 4
+#endif
+
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
 layout (location = 3) in vec3 aTangent;
 layout (location = 4) in vec3 aBitangent;
 
+#ifdef USE_INSTANCE_ATTRIBUTES
+// Merged geometry path: per-instance data comes from instanced attributes
+// (InstanceVertex in geometrypool.h) so a whole multi-draw shares one stream
+layout (location = 5) in mat4 aModel;
+layout (location = 9) in mat3 aNormalMatrix;
+layout (location = 12) in vec4 aAlbedoMetallic;
+layout (location = 13) in vec2 aRoughnessAo;
+#endif
+
 out vec3 FragPos;
 out vec2 TexCoords;
-out vec3 TangentLightPos[4];
-out vec3 TangentViewPos;
-out vec3 TangentFragPos;
+out vec3 Normal;
+#ifdef HAS_NORMAL_MAP
+out vec3 Tangent;
+#endif
+#ifdef USE_INSTANCE_ATTRIBUTES
+flat out vec4 vAlbedoMetallic;
+flat out vec2 vRoughnessAo;
+#endif
 
-uniform mat4 projection;
-uniform mat4 view;
-uniform mat4 model;
-uniform vec3 lightPositions[4];
-uniform vec3 viewPos;
+// Streamed per frame and per instance by MeshRenderer, std140 layouts mirrored
+// in meshrenderer.h. Both stages declare both blocks so their layouts match.
+layout(std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec4 viewPos;
+    vec4 lightPositions[NUM_LIGHTS];  // w: type, 0 point, 1 directional, 2 spot
+    vec4 lightColors[NUM_LIGHTS];     // color * intensity, w: spot cos inner half-angle
+    vec4 lightDirections[NUM_LIGHTS]; // w: spot cos outer half-angle
+};
+
+#ifndef USE_INSTANCE_ATTRIBUTES
+layout(std140) uniform InstanceData {
+    mat4 model;
+    // transpose(inverse(mat3(model))), computed once per instance on the CPU
+    mat3 normalMatrix;
+    vec4 albedoMetallic;
+    vec4 roughnessAo;
+};
+#endif
 
 void main() {
+#ifdef USE_INSTANCE_ATTRIBUTES
+    mat4 model = aModel;
+    mat3 normalMatrix = aNormalMatrix;
+    vAlbedoMetallic = aAlbedoMetallic;
+    vRoughnessAo = aRoughnessAo;
+#endif
     FragPos = vec3(model * vec4(aPos, 1.0));
     TexCoords = aTexCoords;
-    
-    mat3 normalMatrix = transpose(inverse(mat3(model)));
-    vec3 T = normalize(normalMatrix * aTangent);
-    vec3 N = normalize(normalMatrix * aNormal);
-    T = normalize(T - dot(T, N) * N);
-    vec3 B = cross(N, T);
-    
-    mat3 TBN = transpose(mat3(T, B, N));
-    
-    for(int i = 0; i < 4; i++) {
-        TangentLightPos[i] = TBN * lightPositions[i];
-    }
-    TangentViewPos = TBN * viewPos;
-    TangentFragPos = TBN * FragPos;
+
+    // Lighting happens in world space in the fragment shader, so the number of
+    // varyings no longer grows with NUM_LIGHTS
+    Normal = normalMatrix * aNormal;
+#ifdef HAS_NORMAL_MAP
+    Tangent = mat3(model) * aTangent;
+#endif
     
     gl_Position = projection * view * vec4(FragPos, 1.0);
-} 
\ No newline at end of file
+}
@@ -0,0 +1,17 @@
+#version 300 es
+precision mediump float;
+
+// Depth only; nothing is written but the depth buffer
+
+#ifdef PARABOLOID
+in float vHemisphere;
+#endif
+
+void main() {
+#ifdef PARABOLOID
+    // The other hemisphere's layer covers it
+    if (vHemisphere < 0.0) {
+        discard;
+    }
+#endif
+}
@@ -0,0 +1,43 @@
+#version 300 es
+precision highp float;
+
+// Depth-only pass into one layer of the shadow map array, see shadowrenderer.cpp.
+// Defines: USE_INSTANCE_ATTRIBUTES (merged geometry batches), PARABOLOID (point lights)
+
+layout (location = 0) in vec3 aPos;
+
+#ifdef USE_INSTANCE_ATTRIBUTES
+// Only the model matrix of InstanceVertex (geometrypool.h) is used
+layout (location = 5) in mat4 aModel;
+#else
+uniform mat4 model;
+#endif
+
+// World to clip space, or world to light view for paraboloids
+uniform mat4 lightMatrix;
+
+#ifdef PARABOLOID
+// x: hemisphere (+1 faces +z, -1 faces -z), y: near plane, z: far plane
+uniform vec3 paraboloid;
+out float vHemisphere;
+#endif
+
+void main() {
+#ifdef USE_INSTANCE_ATTRIBUTES
+    mat4 model = aModel;
+#endif
+    vec4 world = model * vec4(aPos, 1.0);
+
+#ifdef PARABOLOID
+    // Dual paraboloid projection; pbr.frag does the same mapping when sampling
+    vec3 p = (lightMatrix * world).xyz;
+    p.z *= paraboloid.x;
+    float distance = length(p);
+    vec3 direction = p / max(distance, 0.0001);
+    vHemisphere = direction.z;
+    float depth = (distance - paraboloid.y) / (paraboloid.z - paraboloid.y);
+    gl_Position = vec4(direction.xy / max(1.0 + direction.z, 0.0001), depth * 2.0 - 1.0, 1.0);
+#else
+    gl_Position = lightMatrix * world;
+#endif
+}
@@ -0,0 +1,36 @@
+#version 300 es
+precision mediump float;
+
+// Bilinear upscale of the scaled scene with a contrast-adaptive sharpen: the
+// unsharp mask is clamped to the local min/max so edges don't ring
+uniform sampler2D uScene;
+uniform vec2 uTexelSize;    // one source texel in UV
+uniform vec2 uUvMax;        // last fully rendered texel center
+uniform float uSharpness;   // 0 = plain bilinear
+
+in vec2 vUv;
+out vec4 fragColor;
+
+vec3 sampleScene(vec2 uv) {
+    return texture(uScene, min(uv, uUvMax)).rgb;
+}
+
+void main() {
+    vec3 center = sampleScene(vUv);
+    if (uSharpness <= 0.0) {
+        fragColor = vec4(center, 1.0);
+        return;
+    }
+
+    vec3 north = sampleScene(vUv + vec2(0.0, uTexelSize.y));
+    vec3 south = sampleScene(vUv - vec2(0.0, uTexelSize.y));
+    vec3 east = sampleScene(vUv + vec2(uTexelSize.x, 0.0));
+    vec3 west = sampleScene(vUv - vec2(uTexelSize.x, 0.0));
+
+    vec3 minColor = min(center, min(min(north, south), min(east, west)));
+    vec3 maxColor = max(center, max(max(north, south), max(east, west)));
+    vec3 blurred = (north + south + east + west) * 0.25;
+    vec3 sharpened = center + (center - blurred) * uSharpness;
+
+    fragColor = vec4(clamp(sharpened, minColor, maxColor), 1.0);
+}
@@ -0,0 +1,13 @@
+#version 300 es
+precision mediump float;
+
+// Fullscreen triangle from gl_VertexID, no vertex buffer needed
+uniform vec2 uUvScale;
+
+out vec2 vUv;
+
+void main() {
+    vec2 corner = vec2(float((gl_VertexID << 1) & 2), float(gl_VertexID & 2));
+    vUv = corner * uUvScale;
+    gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);
+}
@@ -4,7 +4,10 @@
 #include <memory>
 #include <vector>
 #include <chrono>
+#include <functional>
+#include <mutex>
 #include <string>
+#include <thread>
 
 // Engine includes
 #include "window.h"
@@ -23,6 +26,163 @@
 #include "input/Keyboard.h"
 #include "input/Mouse.h"
 
+// Streaming
+#include "streambuffer.h"
+#include "geometrypool.h"
+
+// Diagnostics
+#include "profiler.h"
+#include "benchmark.h"
+
+// Timing
+#include "frameclock.h"
+#include "framepacer.h"
+
+// Dynamic resolution
+#include "resolutionscaler.h"
+#include "upscalepass.h"
+
+// Shadows
+#include "shadowcache.h"
+#include "shadowrenderer.h"
+
+// Fractals
+#include "fractal/animationrenderer.h"
+#include "fractal/cpuraymarcher.h"
+#include "fractal/deepzoom.h"
+#include "fractal/fractalcollider.h"
+#include "fractal/fractalrenderer.h"
+#include "fractal/progressiverenderer.h"
+#include "fractal/temporalrenderer.h"
+#include "fractal/surfacemesher.h"
+#include "jobsystem.h"
+
+// Render thread handoff
+#include "framemailbox.h"
+#include "framepacket.h"
+
+// Startup options, filled from the command line on native or by the host
+struct EngineConfig {
+    int width = 1920;
+    int height = 1080;
+
+    // Render through an EGL context into an offscreen target, no display needed
+    bool bHeadless = false;
+
+    // Close after this many frames, 0 runs until the window is closed
+    unsigned int frameLimit = 0;
+
+    // Write the last frame to this PPM file when frameLimit is reached
+    std::string capturePath;
+
+    // Chrome trace written on shutdown
+    std::string tracePath;
+
+    // Scripted benchmark: scene name or .scene file, JSON report path (stdout when empty)
+    std::string benchmarkScene;
+    std::string benchmarkOutput;
+    unsigned int warmupFrames = 30;
+
+    // Advance engine time by this many seconds per frame instead of wall clock, 0 disables
+    float fixedTimestep = 0.0f;
+
+    // Record the interactive camera into a path file that benchmark scenes can replay
+    std::string recordPath;
+
+    // Fixed simulation rate in Hz and the most steps run to catch up in one frame
+    float simulationRate = 60.0f;
+    int maxCatchUpSteps = 5;
+
+    // Frame pacing: frame rate cap (0 uncapped) and vsync on the native window
+    float targetFps = 0.0f;
+    bool bVsync = true;
+
+    // Native only: submit GL from a dedicated render thread while the main
+    // thread simulates the next frame. The web build is always single threaded.
+    bool bRenderThread = true;
+
+    // Dynamic resolution: render the scene at a scale picked from the measured
+    // GPU frame time (frame interval without timer queries) and upscale it.
+    // On by default in the browser. targetGpuMs 0 derives the budget from the fps cap.
+    bool bDynamicResolution = false;
+    float minRenderScale = 0.5f;
+    float maxRenderScale = 1.0f;
+    float targetGpuMs = 0.0f;
+    float sharpness = 0.5f;
+
+    // Meshes always share the GeometryPool buffers; this also draws each
+    // material batch with one multi-draw, whatever the number of distinct meshes
+    bool bMergedGeometry = false;
+
+    // Shadow maps for every light that casts them: cascades for directional
+    // lights, one map per spot light, dual paraboloids for point lights. Maps are
+    // cached and at most shadowBudget of them re-rendered per frame (0 = all).
+    bool bShadows = false;
+    int shadowMapSize = ShadowCache::DEFAULT_MAP_SIZE;
+    int shadowBudget = ShadowCache::DEFAULT_UPDATE_BUDGET;
+
+    // Fractal view in place of the mesh scene: ray marched in fractal.frag, or
+    // by the SIMD CPU reference on the job system at fractalScale of the viewport
+    FractalBackend fractalBackend = FractalBackend::None;
+    FractalType fractalType = FractalType::Mandelbulb;
+    float fractalScale = 0.5f;
+    // Run the generic pow/atan2/acos Mandelbulb even for whole powers, to compare
+    // against the specialised kernels
+    bool bFractalGenericKernels = false;
+    // CPU backend only: cheap previews while the view changes, then refinement
+    // within fractalBudgetMs of main thread time per frame once it holds still
+    bool bFractalProgressive = false;
+    float fractalBudgetMs = 12.0f;
+    // Trace one pixel of each 2x2 block per frame and reproject the rest from the
+    // frame before; the progressive renderer takes precedence on the CPU
+    bool bFractalTemporal = false;
+    // March cones over 8x8 then 4x4 pixel cells first and start each ray where
+    // its cell's cone stopped
+    bool bFractalConePrepass = false;
+    // Extract the fractal surface with this many cells per axis and use it as the
+    // scene mesh in place of the model, 0 to load the model; optionally also
+    // written to fractalMeshPath as OBJ
+    int fractalMeshResolution = 0;
+    std::string fractalMeshPath;
+    // Keep the camera a small sphere's width outside the fractal, sliding along
+    // the surface instead of flying into it
+    bool bFractalCollision = true;
+    // Perturbation deep zoom of the Mandelbrot set, or the Julia set of
+    // deepZoomJulia, on the fractal backend. The centre stays a decimal string
+    // until the scale is known, so it is parsed at the precision it needs.
+    bool bDeepZoom = false;
+    std::string deepZoomX = "-0.5";
+    std::string deepZoomY = "0";
+    double deepZoomScale = 1.5;
+    int deepZoomIterations = 1000;
+    bool bDeepZoomJulia = false;
+    glm::dvec2 deepZoomJulia = glm::dvec2(-0.8, 0.156);
+
+    // Batch mode: render every frame of the keyframe file animationPath headless
+    // into numbered PNGs under animationOutput at width x height, animationSamples
+    // rays per pixel, on the fractal backend (the CPU one unless gpu is picked),
+    // then exit. Frames already there are skipped, so an interrupted run resumes.
+    std::string animationPath;
+    std::string animationOutput = "frames";
+    int animationSamples = 4;
+
+    // Job system workers, -1 for one per hardware thread besides the main thread
+    int jobThreads = -1;
+
+    // --headless --width=N --height=N --frames=N --capture=<file.ppm> --trace=<file.json>
+    // --benchmark=<scene> --out=<file.json> --warmup=N --fixed-dt=<seconds> --record-path=<file>
+    // --sim-rate=<hz> --max-catch-up=N --fps-cap=<fps> --no-vsync --single-thread
+    // --dynamic-res --min-scale=<s> --max-scale=<s> --target-gpu-ms=<ms> --sharpness=<s>
+    // --merged-geometry --shadows --shadow-size=N --shadow-budget=N
+    // --fractal=<cpu|gpu> --fractal-type=<mandelbulb|julia> --fractal-scale=<s> --threads=N
+    // --fractal-kernel=<specialized|generic> --fractal-progressive --fractal-budget-ms=<ms>
+    // --fractal-temporal --fractal-cone --fractal-mesh=N --fractal-mesh-obj=<file.obj>
+    // --no-fractal-collision
+    // --deep-zoom=<cpu|gpu> --deep-zoom-center=<x>,<y> --deep-zoom-scale=<s> --deep-zoom-iterations=N
+    // --deep-zoom-julia=<x>,<y> --animation=<file> --animation-out=<dir> --samples=N
+    static EngineConfig FromArgs(int argc, char** argv);
+};
+
 class Engine {
     static Engine* engineInstance;
 public:
@@ -35,11 +195,24 @@ public:
     bool Initialize(const std::string& canvasId = "");
     // Core lifecycle - native version
     bool Initialize(int argc, char** argv);
+    bool Initialize(const EngineConfig& config);
  
+    // One host frame: events, fixed simulation steps for frameDt, interpolated render.
+    // Both the native loop and the browser's requestAnimationFrame call this.
+    void Frame(float frameDt);
+    // Native only: block for the frame cap and return the elapsed frame time
+    float WaitForNextFrame();
+
     void ProcessEvents();
+    // One fixed simulation step
     void Update(float dt);
+    // Build this frame's packet and draw it, or hand it to the render thread
     void Render();
     void Shutdown();
+
+    // Window size changes arrive on the main thread; the viewport follows with the next packet
+    void HandleResize(int width, int height);
+    bool IsRenderThreaded() const { return renderThread.joinable(); }
     
     // Getters for platform-specific code
     Window* GetWindow() const { return window.get(); }
@@ -59,8 +232,77 @@ public:
     
     // File handling (future)
     void LoadModel(const std::string& path);
+    // Replaces the scene mesh with the surface of the current fractal params,
+    // extracted on the job system with resolution cells per axis
+    void LoadFractalMesh(int resolution);
+    const SurfaceMeshStats& GetFractalMeshStats() const { return surfaceMesher.GetStats(); }
     void HandleFileDrop(const std::string& filePath);
 
+    // Profiling
+    ProfileFrameSummary GetFrameSummary() const;
+    std::vector<ProfileZoneStat> GetProfileZones() const;
+    StreamBufferStats GetStreamBufferStats() const;
+    void StartTrace();
+    std::string StopTrace();
+
+    // Batch mode for EngineConfig::animationPath; true once every frame is on disk
+    bool RenderAnimation();
+    const AnimationRenderStats& GetAnimationStats() const { return animationRenderer.GetStats(); }
+
+    // Frame readback for validation, call between Render() calls
+    bool SaveFrame(const std::string& path);
+    const EngineConfig& GetConfig() const { return config; }
+    bool IsBenchmarking() const { return benchmark != nullptr; }
+
+    // Engine time drives all animation; it only advances through Update(dt)
+    double GetTime() const { return engineTime; }
+    void SetTime(double time) { engineTime = time; }
+
+    // Frame pacing
+    void SetTargetFps(float fps) { config.targetFps = fps; framePacer.SetTargetFps(fps); }
+    float GetFrameJitterMs() const { return framePacer.GetJitterMs(); }
+    unsigned int GetDroppedSimulationSteps() const { return frameClock.GetDroppedSteps(); }
+
+    // Dynamic resolution
+    void SetDynamicResolution(bool bEnabled);
+    void SetRenderScaleBounds(float minScale, float maxScale);
+    void SetTargetGpuMs(float ms);
+    float GetRenderScale() const { return config.bDynamicResolution ? resolutionScaler.GetScale() : 1.0f; }
+
+    // Fractal view; changes apply from the next built frame
+    void SetFractalBackend(FractalBackend backend) { config.fractalBackend = backend; }
+    FractalBackend GetFractalBackend() const { return config.fractalBackend; }
+    void SetFractalParams(const FractalParams& params) { fractalParams = params; }
+    const FractalParams& GetFractalParams() const { return fractalParams; }
+    void SetFractalType(FractalType type) { fractalParams.type = type; }
+    void SetFractalPower(float power) { fractalParams.power = power; }
+    void SetFractalSpecializedKernels(bool bEnabled) { fractalSettings.bSpecializedKernels = bEnabled; }
+    const CpuRayMarchStats& GetCpuRayMarchStats() const { return cpuRayMarcher.GetStats(); }
+    void SetFractalProgressive(bool bEnabled) { config.bFractalProgressive = bEnabled; }
+    void SetFractalBudgetMs(float ms);
+    // Share of the progressive refinement done, 1 when it is off or finished
+    float GetFractalCompletion() const;
+    const ProgressiveStats& GetProgressiveStats() const { return progressiveRenderer.GetStats(); }
+    void SetFractalTemporal(bool bEnabled) { config.bFractalTemporal = bEnabled; }
+    // Rays and reprojected pixels of the last CPU temporal frame
+    const TemporalStats& GetTemporalStats() const { return temporalRenderer.GetStats(); }
+    void SetFractalConePrepass(bool bEnabled) { fractalSettings.bConePrepass = bEnabled; }
+    void SetFractalCollision(bool bEnabled) { config.bFractalCollision = bEnabled; }
+    // Batched sphere and ray queries against the current fractal
+    FractalCollider& GetFractalCollider() { return fractalCollider; }
+    // Deep zoom on the fractal backend. The centre is exchanged as decimal strings
+    // so no precision is lost on the way; zooms keep the point under (x, y) in
+    // [-1, 1] image coordinates, y up, at the same place on screen.
+    void SetDeepZoom(bool bEnabled) { config.bDeepZoom = bEnabled; }
+    bool SetDeepZoomCenter(const std::string& x, const std::string& y) { return deepZoomView.SetCenter(x, y); }
+    void SetDeepZoomScale(double scale);
+    void SetDeepZoomIterations(int iterations);
+    void ZoomDeepZoom(float x, float y, double factor) { deepZoomView.ZoomAt(x, y, factor); }
+    std::string GetDeepZoomCenterX() const { return deepZoomView.centerX.ToString(GetDeepZoomDigits()); }
+    std::string GetDeepZoomCenterY() const { return deepZoomView.centerY.ToString(GetDeepZoomDigits()); }
+    double GetDeepZoomScale() const { return deepZoomView.scale; }
+    const DeepZoomStats& GetDeepZoomStats() const { return cpuDeepZoom.GetStats(); }
+
 private:
     // Core systems
     std::unique_ptr<Window> window;
@@ -68,7 +310,14 @@ private:
     std::unique_ptr<MeshRenderer> meshRenderer;
     std::unique_ptr<LightRenderer> lightRenderer;
     std::unique_ptr<TriangleRenderer> triangleRenderer;
+    std::unique_ptr<UpscalePass> upscalePass;
+    // Created only with shadows on; the cache lives on the main thread, the renderer where GL is
+    std::unique_ptr<ShadowCache> shadowCache;
+    std::unique_ptr<ShadowRenderer> shadowRenderer;
+    std::unique_ptr<FractalRenderer> fractalRenderer;
     std::unique_ptr<Mesh> mesh;
+    // Further models a benchmark scene cycles its instances through
+    std::vector<std::unique_ptr<Mesh>> sceneMeshes;
     std::unique_ptr<Keyboard> keyboard;
     std::unique_ptr<Mouse> mouse;
 
@@ -83,10 +332,94 @@ private:
     // Platform
     std::string canvasId;
     bool isWebPlatform = false;
+
+    EngineConfig config;
+    unsigned int frameCount = 0;
+    double engineTime = 0.0;
+
+    // Fixed-step simulation; rendering blends the previous and current state
+    struct SimState {
+        glm::vec3 cameraPosition = glm::vec3(0.0f);
+        glm::quat cameraRotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+        std::vector<glm::vec3> lightPositions;
+    };
+    FrameClock frameClock;
+    FramePacer framePacer;
+    SimState previousState;
+    float interpolationAlpha = 1.0f;
+    std::unique_ptr<Camera> renderCamera;
+    std::vector<Light> renderLights;
+    double lookLastX = 0.0;
+    double lookLastY = 0.0;
+
+    // Scripted benchmark run, null when interactive
+    std::unique_ptr<Benchmark> benchmark;
+
+    // Camera recording for --record-path
+    CameraPath recordedPath;
+    double nextRecordTime = 0.0;
+
+    // Render thread. The main thread owns the simulation and builds packets;
+    // the render thread owns the GL context and only reads packets.
+    std::thread renderThread;
+    FrameMailbox<FramePacket> frameMailbox;
+    FramePacket immediatePacket;    // single-threaded path
+    std::vector<std::function<void()>> pendingRenderCommands;
+    int viewportWidth = 0;
+    int viewportHeight = 0;
+
+    // Dynamic resolution. The scaler runs on the main thread; the scene target
+    // belongs to whichever thread renders.
+    ResolutionScaler resolutionScaler;
+    std::unique_ptr<RenderTarget> sceneTarget;
+
+    // Fractal view. The CPU marcher runs on the main thread and the job system
+    // while the packet is built.
+    FractalParams fractalParams;
+    RayMarchSettings fractalSettings;
+    CpuRayMarcher cpuRayMarcher;
+    ProgressiveRenderer progressiveRenderer;
+    TemporalRenderer temporalRenderer;
+    FractalCollider fractalCollider;
+    SweptSphereController cameraController;
+    DeepZoomView deepZoomView;
+    ReferenceOrbitCache orbitCache;
+    CpuDeepZoom cpuDeepZoom;
+    SurfaceMesher surfaceMesher;
+    AnimationRenderer animationRenderer;
+
+    // Bounds of the loaded mesh, written wherever the model is loaded
+    std::mutex meshBoundsMutex;
+    glm::vec3 meshBoundsCenter = glm::vec3(0.0f);
+    float meshBoundsRadius = 0.0f;
     
     void UpdateLightAnimation(float time);
+    void ApplyCameraInput(float dt);
+    void ApplyMouseLook();
+    void SaveSimState(SimState& state) const;
+    void InterpolateRenderState();
+    void ConfigureFrameTiming();
+    void ConfigureResolutionScaler();
+    void UpdateResolutionScale();
+
+    // Frame packets
+    void BuildFramePacket(FramePacket& packet);
+    void CullInstances(const glm::mat4& viewProjection, std::vector<MeshInstance>& visible);
+    void UpdateShadows(ShadowFrame& shadows);
+    void UpdateFractal(FractalFrame& fractal);
+    void RenderFractal(FractalFrame& fractal, int width, int height);
+    void UpdateDeepZoom(FractalFrame& fractal);
+    // Decimal places that resolve a pixel at the current deep zoom scale
+    int GetDeepZoomDigits() const;
+    void RenderPacket(FramePacket& packet);
+    void StartRenderThread();
+    void StopRenderThread();
+    void RenderThreadMain();
+    void LoadModelNow(const std::string& path);
+    void SetMeshNow(std::unique_ptr<Mesh> loaded);
     
     // Initialization helpers
     bool InitializeCommon();
     void SetupDefaultScene();
+    void SetupBenchmarkScene();
 };
\ No newline at end of file
@@ -15,6 +15,9 @@ public:
     
     // Get the shaders directory path
     static std::string getShadersDir();
+
+    // Get the benchmark scenes directory path
+    static std::string getBenchmarksDir();
     
     // Resolve a relative asset path to an absolute path
     // If the path is already absolute, return it as-is
@@ -29,6 +32,9 @@ public:
     
     // Resolve a shader path (relative to shaders directory)
     static std::string resolveShaderPath(const std::string& shaderName);
+
+    // Resolve a benchmark scene, either a file path or a scene name in the benchmarks directory
+    static std::string resolveBenchmarkPath(const std::string& sceneName);
     
     // Check if a file exists
     static bool fileExists(const std::string& path);
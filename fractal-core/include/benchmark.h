@@ -0,0 +1,174 @@
+#pragma once
+
+// STL includes
+#include <chrono>
+#include <string>
+#include <vector>
+
+// glm
+#include <glm/glm.hpp>
+
+// local headers
+#include "camera.h"
+#include "camerapath.h"
+#include "light.h"
+#include "profiler.h"
+#include "fractal/deepzoom.h"
+#include "fractal/fractalparams.h"
+#include "fractal/surfacemesher.h"
+
+// Scene description for a benchmark run, loaded from assets/benchmarks/*.scene.
+// One keyword per line:
+//   name <name>
+//   model <file>                                    model from assets/models; repeat to
+//                                                   cycle instances through several models
+//   instances <count> [spacing]                     square grid on the XZ plane
+//   lights <count> [radius] [height] [intensity] [speed]
+//   spots <count> [angle]                           first count ring lights become spot
+//                                                   lights aimed at the origin, cone in degrees
+//   sun <dx> <dy> <dz> [intensity]                  static directional light
+//   shadows                                         render with shadow maps (--shadows)
+//   fractal <cpu|gpu> [mandelbulb|julia]            ray marched fractal instead of the
+//                                                   mesh scene (--fractal)
+//   deepzoom <x> <y> <scale> [iterations]           perturbation deep zoom of the Mandelbrot
+//                                                   set on the fractal backend (--deep-zoom)
+//   orbit <radius> <height> <period> [targetY]      looping camera orbit
+//   camera <time> <px> <py> <pz> <tx> <ty> <tz>     explicit keyframe
+//   path <file>                                     recorded camera path (--record-path)
+struct BenchmarkScene {
+    std::string name;
+    std::string model = "columns.fbx";
+    // Every model line in order; model is the first. Instance i uses models[i % size].
+    std::vector<std::string> models;
+
+    unsigned int instanceCount = 1;
+    float instanceSpacing = 60.0f;
+
+    unsigned int lightCount = 4;
+    float lightRadius = 30.0f;
+    float lightHeight = 10.0f;
+    float lightIntensity = 10.0f;
+    float lightSpeed = 0.5f;    // radians per second around the ring
+    unsigned int spotCount = 0;
+    float spotAngle = 45.0f;
+
+    bool bSun = false;
+    glm::vec3 sunDirection = glm::vec3(0.0f, -1.0f, 0.0f);
+    float sunIntensity = 3.0f;
+
+    bool bShadows = false;
+
+    FractalBackend fractalBackend = FractalBackend::None;
+    FractalType fractalType = FractalType::Mandelbulb;
+    // Centre as decimal strings, parsed at the precision the scale needs
+    bool bDeepZoom = false;
+    std::string deepZoomX;
+    std::string deepZoomY;
+    double deepZoomScale = 1.5;
+    int deepZoomIterations = 1000;
+
+    CameraPath cameraPath;
+
+    bool Load(const std::string& path);
+
+    std::vector<glm::mat4> GetInstanceTransforms() const;
+    std::vector<Light> CreateLights() const;
+    void AnimateLights(std::vector<Light>& lights, float time) const;
+
+    void AddOrbit(float radius, float height, float period, float targetY);
+
+    // Far plane distance that keeps the whole grid visible along the camera path
+    float GetViewDistance() const;
+};
+
+struct BenchmarkStats {
+    float mean = 0.0f;
+    float p50 = 0.0f;
+    float p95 = 0.0f;
+    float p99 = 0.0f;
+    float max = 0.0f;
+    unsigned int samples = 0;
+
+    // Nearest-rank percentiles
+    static BenchmarkStats FromSamples(std::vector<float> samples);
+};
+
+// Drives the camera for a scripted run and collects per-frame results
+class Benchmark {
+public:
+    Benchmark(const BenchmarkScene& scene, unsigned int warmupFrames);
+
+    const BenchmarkScene& GetScene() const { return scene; }
+
+    void UpdateCamera(Camera& camera, float time) const;
+
+    // Called once per frame after Profiler::EndFrame()
+    void RecordFrame(const ProfileFrameSummary& summary);
+
+    // Reported so single-threaded and render-thread runs can be told apart
+    void SetRenderThreaded(bool bThreaded) { bRenderThreaded = bThreaded; }
+    void SetMergedGeometry(bool bMerged, bool bMultiDraw) { bMergedGeometry = bMerged; this->bMultiDraw = bMultiDraw; }
+    void SetShadows(bool bEnabled) { bShadows = bEnabled; }
+    void SetFractal(FractalBackend backend, const std::string& kernel, int simdWidth, int threads) {
+        fractalBackend = backend;
+        fractalKernel = kernel;
+        this->simdWidth = simdWidth;
+        jobThreads = threads;
+    }
+    void SetDeepZoom(const DeepZoomView& view, const ReferenceOrbit& orbit) {
+        bDeepZoom = true;
+        deepZoomScale = view.scale;
+        deepZoomIterations = view.iterations;
+        deepZoomLimbs = orbit.limbs;
+        deepZoomReferenceMs = orbit.ms;
+        deepZoomReferenceLength = orbit.referenceLength;
+    }
+    void SetFractalMesh(const SurfaceMeshStats& stats) {
+        bFractalMesh = true;
+        meshStats = stats;
+    }
+    // Size the sample arrays up front so recording doesn't allocate mid-run
+    void ReserveFrames(unsigned int frames);
+
+    std::string GetReportJson(int width, int height, float fixedTimestep) const;
+    bool WriteReport(const std::string& path, int width, int height, float fixedTimestep) const;
+
+    // Peak resident memory of the process (heap size on the web)
+    static uint64_t GetPeakMemoryKB();
+
+private:
+    BenchmarkScene scene;
+    unsigned int warmupFrames;
+    unsigned int seenFrames = 0;
+    unsigned int firstMeasuredFrame = 0;
+    bool bRenderThreaded = false;
+    bool bMergedGeometry = false;
+    bool bMultiDraw = false;
+    bool bShadows = false;
+    FractalBackend fractalBackend = FractalBackend::None;
+    std::string fractalKernel;
+    int simdWidth = 1;
+    int jobThreads = 1;
+    bool bDeepZoom = false;
+    double deepZoomScale = 0.0;
+    int deepZoomIterations = 0;
+    int deepZoomLimbs = 0;
+    float deepZoomReferenceMs = 0.0f;
+    int deepZoomReferenceLength = 0;
+    bool bFractalMesh = false;
+    SurfaceMeshStats meshStats;
+
+    // Wall clock over the measured frames, for throughput
+    std::chrono::steady_clock::time_point firstMeasuredTime;
+    std::chrono::steady_clock::time_point lastMeasuredTime;
+
+    std::vector<float> cpuFrameMs;
+    std::vector<float> gpuFrameMs;
+    std::vector<float> drawCalls;
+    std::vector<float> triangles;
+    std::vector<float> stateChanges;
+    std::vector<float> heapAllocations;
+    std::vector<float> shadowUpdates;
+    std::vector<float> cpuMraysPerSecond;
+    uint64_t uploadBytes = 0;
+};
@@ -19,6 +19,9 @@ public:
     glm::vec3 getRotation() const;
     glm::vec3 getScale() const;
 
+    void setOrientation(const glm::quat& orientation);
+    glm::quat getOrientation() const;
+
     // First-person movement
     void moveForward(float distance);
     inline void moveBackward(float distance) { moveForward(-distance); }
@@ -27,6 +30,8 @@ public:
     void moveUp(float distance);
     inline void moveDown(float distance) { moveUp(-distance); }
     void moveLocal(const glm::vec3& direction, float distance);
+    // Orient the camera toward a world-space point, keeping world up
+    void lookAt(const glm::vec3& target);
 
     // First-person rotation
     void rotateYaw(float angle);
@@ -0,0 +1,41 @@
+#pragma once
+
+// STL includes
+#include <string>
+#include <vector>
+
+// glm
+#include <glm/glm.hpp>
+
+struct CameraKeyframe {
+    float time = 0.0f;
+    glm::vec3 position = glm::vec3(0.0f);
+    glm::vec3 target = glm::vec3(0.0f, 0.0f, -1.0f);
+};
+
+// Catmull-Rom spline through timed camera keyframes (position and look-at target).
+// A looping path should repeat its first keyframe as the last one.
+class CameraPath {
+public:
+    void AddKeyframe(float time, const glm::vec3& position, const glm::vec3& target);
+    void Clear() { keyframes.clear(); }
+
+    bool IsEmpty() const { return keyframes.empty(); }
+    size_t GetKeyframeCount() const { return keyframes.size(); }
+    const std::vector<CameraKeyframe>& GetKeyframes() const { return keyframes; }
+    float GetDuration() const;
+
+    void SetLooping(bool bLoop) { this->bLoop = bLoop; }
+    bool IsLooping() const { return bLoop; }
+
+    // Sample the path; times outside the keyframe range clamp, or wrap when looping
+    void Evaluate(float time, glm::vec3& position, glm::vec3& target) const;
+
+    // Text format, one "key <time> <px> <py> <pz> <tx> <ty> <tz>" line per keyframe
+    bool Load(const std::string& path);
+    bool Save(const std::string& path) const;
+
+private:
+    std::vector<CameraKeyframe> keyframes;
+    bool bLoop = false;
+};
@@ -0,0 +1,116 @@
+#ifndef FRACTAL_ANIMATIONRENDERER_H
+#define FRACTAL_ANIMATIONRENDERER_H
+
+// C++ standard library
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// local headers
+#include "fractal/fractalanimation.h"
+#include "jobsystem.h"
+
+struct AnimationRenderSettings {
+    std::string outputDirectory = "frames";
+    int width = 1920;
+    int height = 1080;
+    // Rays per pixel; how they are placed is up to the render hook
+    int samples = 4;
+    // Frames between render and disk at once, each holding one image; at least two
+    // so a readback can finish while the next frame draws
+    int framesInFlight = 3;
+    // zlib level of the PNG files
+    int pngLevel = 6;
+};
+
+struct AnimationRenderStats {
+    int frames = 0;
+    int rendered = 0;
+    // Already on disk from an earlier run
+    int skipped = 0;
+    int failed = 0;
+    // Main thread time in the render and read hooks, and job time spent resolving
+    // and encoding images and writing them, all summed over the rendered frames
+    float renderMs = 0.0f;
+    float encodeMs = 0.0f;
+    float writeMs = 0.0f;
+    uint64_t bytes = 0;
+    float totalMs = 0.0f;
+    // Wall clock per rendered frame, the pipeline overlap included
+    float secondsPerFrame = 0.0f;
+};
+
+// RGBA8 pixels, bottom row first
+struct AnimationImage {
+    std::vector<uint32_t> pixels;
+    int width = 0;
+    int height = 0;
+};
+
+// Renders every frame of a FractalAnimation to numbered PNG files, without a
+// window or anyone watching. The main thread only draws: each frame it calls the
+// render hook, then the read hook of the frame before, whose GPU work had a whole
+// frame to finish, then hands that image to a job that resolves it to the output
+// size, encodes it and writes it while the next frames are drawn. framesInFlight
+// images rotate through the stages, so memory stays bounded however far the
+// encoder falls behind.
+//
+// Frames are written to a temporary name and renamed once complete, so a run that
+// is interrupted can simply be started again: frames already on disk are skipped.
+//
+// Images larger than the output by a whole factor each way are box filtered down
+// in the job, decoding the gamma 2 the renderers encode with; that is how a
+// supersampled GPU frame is resolved.
+class AnimationRenderer
+{
+    public:
+        // Draws frame through pipeline slot, filling image or leaving it to the read hook
+        typedef std::function<bool(const FractalAnimationFrame& frame, int slot, AnimationImage& image)> RenderFunction;
+        // Finishes the frame of slot into image
+        typedef std::function<bool(int slot, AnimationImage& image)> ReadFunction;
+
+        static constexpr int MAX_FRAMES_IN_FLIGHT = 8;
+
+        // Blocks until every frame is on disk or failed. Without a read hook the render
+        // hook fills the image itself. False if any frame failed.
+        bool Render(const FractalAnimation& animation, const AnimationRenderSettings& settings, const RenderFunction& render,
+                    const ReadFunction& read = ReadFunction());
+
+        // <directory>/frame_00042.png
+        static std::string GetFramePath(const std::string& directory, int frame);
+        // Box filter of an image to a whole fraction of its size, in linear light
+        static bool Resolve(const AnimationImage& image, int width, int height, AnimationImage& resolved);
+
+        const AnimationRenderStats& GetStats() const { return stats; }
+
+    private:
+        // One image on its way through the pipeline
+        struct Slot {
+            AnimationImage image;
+            AnimationImage resolved;
+            std::vector<uint8_t> png;
+            std::string path;
+            int width = 0;
+            int height = 0;
+            int level = 6;
+            JobCounter counter;
+            // Holds a frame the stats haven't seen yet
+            bool bPending = false;
+            bool bFailed = false;
+            float encodeMs = 0.0f;
+            float writeMs = 0.0f;
+        };
+
+        AnimationRenderStats stats;
+
+        static void EncodeJob(void* context, size_t begin, size_t end);
+        // Queues the slot's encode job, unless its frame already failed
+        void Submit(Slot& slot);
+        // Waits for the slot's frame and adds it to the stats
+        void Collect(Slot& slot);
+};
+
+#endif
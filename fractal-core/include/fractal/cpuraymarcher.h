@@ -0,0 +1,130 @@
+#ifndef FRACTAL_CPURAYMARCHER_H
+#define FRACTAL_CPURAYMARCHER_H
+
+// C++ standard library
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// local headers
+#include "fractal/formula.h"
+#include "fractal/fractalparams.h"
+#include "fractal/simd.h"
+
+struct CpuRayMarchStats {
+    uint64_t rays = 0;
+    // Distance estimator evaluations along primary rays, normals not included
+    uint64_t steps = 0;
+    // Cone steps of the pre-pass, over all cells of both levels
+    uint64_t coneSteps = 0;
+    float coneMs = 0.0f;
+    float ms = 0.0f;
+    float mraysPerSecond = 0.0f;
+    FormulaKernel formula;
+};
+
+// One primary ray through an arbitrary image point, shaded but not yet gamma encoded
+struct RaySample {
+    glm::vec3 color;
+    // Surface normal at the hit, zero for misses
+    glm::vec3 normal;
+    // Distance along the ray to the hit, negative for misses
+    float depth;
+    uint32_t steps;
+};
+
+// Reference renderer for the fractal distance estimators. The image is cut into
+// TILE_SIZE tiles spread over the JobSystem; each tile row is sphere traced a
+// packet of horizontally adjacent pixels at a time, one pixel per simd lane.
+// Rays are clipped to the bailout sphere, march until the estimate drops under
+// their pixel footprint and are shaded exactly like fractal.frag. The formula
+// kernel is picked once per frame and the tile loop is instantiated per kernel.
+// With RayMarchSettings::bConePrepass, cones wide enough to hold every ray of
+// an 8x8 pixel cell are marched first, then cones of the 4x4 cells go on from
+// there, and each ray starts where its cell's cone stopped. Cone steps that
+// advanced inside the bailout sphere count towards the step darkening, as the
+// ray steps they stand in for would have.
+//
+// Pixels are RGBA8, bottom row first, ready for glTexSubImage2D.
+class CpuRayMarcher
+{
+    public:
+        static constexpr int TILE_SIZE = 16;
+        // Pixels traced together, the widest lane type of this build
+        static constexpr int PACKET_WIDTH = simd::FloatNative::WIDTH;
+        // Pixels per cone cell side at each pre-pass level, coarsest first
+        static constexpr int CONE_LEVELS = 2;
+        static constexpr int CONE_CELL_SIZES[CONE_LEVELS] = {8, 4};
+
+        // Blocks until the whole image is written; the calling thread works too
+        void Render(const FractalView& view, const FractalParams& params, const RayMarchSettings& settings,
+                    int width, int height, uint32_t* pixels);
+        // samples jittered rays per pixel at SampleOffset() positions, averaged in linear
+        // light; one sample is Render(). Stats count every ray.
+        void RenderSamples(const FractalView& view, const FractalParams& params, const RayMarchSettings& settings,
+                           int width, int height, int samples, uint32_t* pixels);
+        // Same image one ray at a time on the calling thread, the golden reference
+        // the packet path and the GPU path are compared against
+        void RenderReference(const FractalView& view, const FractalParams& params, const RayMarchSettings& settings,
+                             int width, int height, uint32_t* pixels);
+
+        // Packet traces count rays through image points given in pixels of a width x height
+        // image (bottom left origin, pixel centres at +0.5) on the calling thread. Progressive
+        // refinement uses this to place supersamples wherever it needs them.
+        static void TraceRays(const FractalView& view, const FractalParams& params, const RayMarchSettings& settings,
+                              int width, int height, const float* x, const float* y, int count, RaySample* samples);
+
+        // Linear color to an RGBA8 pixel, gamma encoded like every other pixel here
+        static uint32_t PackPixel(const glm::vec3& color);
+        // Sub-pixel position of supersample n in [0, 1)^2: the R2 low discrepancy
+        // sequence, shifted so the first sample lands on the pixel centre
+        static glm::vec2 SampleOffset(int sample);
+
+        // Stats of the last Render() or RenderReference()
+        const CpuRayMarchStats& GetStats() const { return stats; }
+
+    private:
+        // Pre-pass results of one level: per cell the depth its cone reached along
+        // the centre ray, or a depth past every exit where it left the bailout sphere clear,
+        // and the advancing cone steps taken inside the sphere, levels above included
+        struct ConeLevel {
+            int cellSize = 0;
+            int width = 0;
+            int height = 0;
+            std::vector<float> depth;
+            std::vector<float> steps;
+        };
+
+        // Everything a tile job reads, plus the counters it adds to
+        struct Frame {
+            FractalView view;
+            FractalParams params;
+            RayMarchSettings settings;
+            int width;
+            int height;
+            int tilesX;
+            uint32_t* pixels;
+            FormulaKernel formula;
+            // Finest pre-pass level, null without the pre-pass
+            const ConeLevel* cone;
+            std::atomic<uint64_t> steps{0};
+            std::atomic<uint64_t> coneSteps{0};
+        };
+
+        CpuRayMarchStats stats;
+        // Storage is reused across frames
+        ConeLevel coneLevels[CONE_LEVELS];
+
+        static void SetupFrame(Frame& frame, const FractalView& view, const FractalParams& params, const RayMarchSettings& settings,
+                               int width, int height, uint32_t* pixels);
+        void FinishFrame(const Frame& frame, float ms);
+
+        template<typename V, typename Kernel>
+        void RunConePrepass(Frame& frame, const Kernel& kernel);
+        template<typename V, typename Kernel>
+        static void ConeRow(Frame& frame, ConeLevel& level, const ConeLevel* input, int row, const Kernel& kernel);
+        template<typename V, typename Kernel>
+        static void RenderTile(Frame& frame, int tile, const Kernel& kernel);
+};
+
+#endif
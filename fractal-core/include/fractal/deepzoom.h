@@ -0,0 +1,188 @@
+#ifndef FRACTAL_DEEPZOOM_H
+#define FRACTAL_DEEPZOOM_H
+
+// C++ standard library
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// glm
+#include <glm/glm.hpp>
+
+// local headers
+#include "fractal/fixedpoint.h"
+#include "jobsystem.h"
+
+// The z -> z^2 + c family the deep zoom renders: the parameter plane of the
+// Mandelbrot set, or the dynamic plane of one Julia set
+enum class DeepZoomFormula {
+    Mandelbrot,
+    Julia
+};
+
+const char* DeepZoomFormulaToString(DeepZoomFormula formula);
+
+// A 2D view of the complex plane that can zoom far past float and double
+// precision. The centre is fixed point with as many limbs as the scale needs.
+struct DeepZoomView {
+    DeepZoomFormula formula = DeepZoomFormula::Mandelbrot;
+    FixedPoint centerX = FixedPoint::FromDouble(-0.5, 3);
+    FixedPoint centerY;
+    // Half the view height in the complex plane
+    double scale = 1.5;
+    // Counter-clockwise rotation of the view in radians, and width over height
+    float angle = 0.0f;
+    float aspect = 1.0f;
+    int iterations = 1000;
+    // Julia constant c; plain doubles, the set it picks needs no more
+    double juliaX = -0.8;
+    double juliaY = 0.156;
+
+    // Centre the view on image point (x, y), each in [-1, 1] across the image with
+    // y up, and divide the scale by factor
+    void ZoomAt(float x, float y, double factor);
+    // Parses both coordinates at the precision the current scale needs
+    bool SetCenter(const std::string& x, const std::string& y);
+};
+
+// Full precision orbit one point of the view is iterated along, rounded to floats
+// for the CPU lanes and the shader. Pixels iterate only their small difference
+// to it. For the Julia family the orbit of the critical point 0 follows; pixels
+// move on to it when they are rebased.
+struct ReferenceOrbit {
+    // Serial number, so the GPU backend can tell orbits apart
+    uint64_t id = 0;
+    DeepZoomFormula formula = DeepZoomFormula::Mandelbrot;
+    // Reference point: c for the Mandelbrot set, the starting z for a Julia set
+    FixedPoint x;
+    FixedPoint y;
+    double juliaX = 0.0;
+    double juliaY = 0.0;
+    int iterations = 0;
+    int limbs = 0;
+
+    // Z_n for n in [0, referenceLength), then the critical orbit; both stop early
+    // when they escape. For the Mandelbrot set the reference orbit starts at 0 and
+    // doubles as the critical orbit.
+    std::vector<glm::vec2> points;
+    int referenceLength = 0;
+    int criticalStart = 0;
+    int criticalLength = 0;
+    float ms = 0.0f;
+
+    // Whether view can be drawn around this orbit: same formula, enough iterations
+    // and precision, and a reference close enough for float pixel offsets
+    bool Fits(const DeepZoomView& view) const;
+    // Offset of the view centre from the reference point, in units of the view scale
+    glm::vec2 GetOffset(const DeepZoomView& view) const;
+};
+
+// Computes the orbit of the view centre, at view.iterations and the precision of view.scale
+std::shared_ptr<ReferenceOrbit> ComputeReferenceOrbit(const DeepZoomView& view);
+
+// Keeps a reference orbit for the current view. The orbit is one long chain of
+// dependent full precision multiplies with nothing to split between threads, so
+// a new one is computed as a single job on the JobSystem while frames go on
+// using the previous orbit, whose pixels stay correct, only less precise or
+// further from the centre. The web build without workers computes it inline.
+class ReferenceOrbitCache
+{
+    public:
+        ~ReferenceOrbitCache();
+
+        // Starts a new orbit when the current one doesn't fit view and none is computing
+        void Update(const DeepZoomView& view);
+        // Update() that blocks until an orbit fitting view is ready
+        void BuildNow(const DeepZoomView& view);
+
+        // Latest orbit of the view's formula, null until the first one is done
+        const std::shared_ptr<const ReferenceOrbit>& GetOrbit() const { return orbit; }
+        bool IsComputing() const { return bComputing; }
+
+    private:
+        std::shared_ptr<const ReferenceOrbit> orbit;
+        // Written by the job, read once the counter is done
+        DeepZoomView pendingView;
+        std::shared_ptr<ReferenceOrbit> pending;
+        JobCounter counter;
+        bool bComputing = false;
+
+        static void ComputeJob(void* context, size_t begin, size_t end);
+        void Collect(bool bWait);
+};
+
+struct DeepZoomStats {
+    uint64_t pixels = 0;
+    // Perturbed iterations over all pixels, and how often pixels were rebased
+    uint64_t iterations = 0;
+    uint64_t rebases = 0;
+    float ms = 0.0f;
+    float referenceMs = 0.0f;
+    int referenceLength = 0;
+    int limbs = 0;
+};
+
+// Perturbation renderer on the CPU. Each pixel iterates its scaled difference d
+// to the reference orbit Z in float lanes,
+//
+//   d' = (2 Z + s d) d + dc          z = Z + s d
+//
+// with s the view scale, so d stays near the size of the pixel offset dc at any
+// depth floats can still represent s at. Whenever |z| drops below |s d| or the
+// reference runs out, the pixel is rebased: d becomes z / s and it carries on
+// from the start of the critical orbit. That keeps the deltas small against the
+// orbit, which is what glitches come from, so one reference serves every pixel.
+// Escaped pixels get a smooth iteration count through a cosine palette; the
+// GPU backend runs the same loop in deepzoom.frag.
+//
+// Tiles of the image are spread over the JobSystem, horizontally adjacent pixels
+// in simd lanes, with two packets stepped together so one's dependent multiplies
+// overlap the other's. Pixels are RGBA8, bottom row first.
+class CpuDeepZoom
+{
+    public:
+        static constexpr int TILE_SIZE = 16;
+        // Squared escape radius; large, so the smooth count has no bands
+        static constexpr float ESCAPE_RADIUS_SQUARED = 4096.0f;
+        // Floats have to hold the scale and its inverse
+        static constexpr double MIN_SCALE = 1e-36;
+
+        // Blocks until the whole image is written; the calling thread works too
+        void Render(const DeepZoomView& view, const ReferenceOrbit& orbit, int width, int height, uint32_t* pixels);
+        // One pixel at a time on the calling thread, for comparing with the packets
+        void RenderReference(const DeepZoomView& view, const ReferenceOrbit& orbit, int width, int height, uint32_t* pixels);
+
+        // Smooth escape count to a linear color, the same curve as deepzoom.frag
+        static glm::vec3 Palette(float smoothIterations);
+
+        const DeepZoomStats& GetStats() const { return stats; }
+
+    private:
+        struct Frame {
+            const ReferenceOrbit* orbit;
+            int width;
+            int height;
+            int tilesX;
+            uint32_t* pixels;
+            int iterations;
+            float scale;
+            glm::vec2 offset;
+            glm::vec2 rotation;
+            float aspect;
+            std::atomic<uint64_t> iterationCount{0};
+            std::atomic<uint64_t> rebases{0};
+        };
+
+        DeepZoomStats stats;
+
+        static void SetupFrame(Frame& frame, const DeepZoomView& view, const ReferenceOrbit& orbit, int width, int height,
+                               uint32_t* pixels);
+        void FinishFrame(const Frame& frame, float ms);
+
+        template<typename V>
+        static void RenderTile(Frame& frame, int tile);
+};
+
+#endif
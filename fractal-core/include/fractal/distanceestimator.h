@@ -0,0 +1,190 @@
+#ifndef FRACTAL_DISTANCEESTIMATOR_H
+#define FRACTAL_DISTANCEESTIMATOR_H
+
+// glm
+#include <glm/glm.hpp>
+
+// local headers
+#include "fractal/fractalparams.h"
+#include "fractal/simdmath.h"
+
+// Distance estimators, templated over the simd lane type so one definition
+// serves the packet marcher (Float4/Float8) and the scalar reference (Float1).
+// Lanes that escape stop updating but keep riding along until every lane in the
+// packet has escaped or the iteration count runs out. fractal.frag mirrors these.
+
+// Mandelbulb with an arbitrary power through spherical coordinates, with the
+// running derivative dr = power * r^(power-1) * dr + 1
+template<typename V>
+inline V MandelbulbDistance(const simd::Vec3<V>& p, const FractalParams& params) {
+    const V power(params.power);
+    const V bailout(params.bailout);
+    simd::Vec3<V> z = p;
+    V dr(1.0f);
+    V r = simd::Length(z);
+    V active = r <= bailout;
+    for (int i = 0; i < params.iterations && simd::Any(active); i++) {
+        V safeR = simd::Max(r, V(1e-20f));
+        V theta = simd::Acos(z.z / safeR) * power;
+        V phi = simd::Atan2(z.y, z.x) * power;
+        V rPowMinusOne = simd::Pow(safeR, power - V(1.0f));
+        V zr = rPowMinusOne * safeR;
+        V sinTheta = simd::Sin(theta);
+        simd::Vec3<V> next(sinTheta * simd::Cos(phi), sinTheta * simd::Sin(phi), simd::Cos(theta));
+        next = next * zr + p;
+
+        dr = simd::Select(active, simd::MulAdd(rPowMinusOne * power, dr, V(1.0f)), dr);
+        z = simd::Select(active, next, z);
+        r = simd::Select(active, simd::Length(next), r);
+        active = active & (r <= bailout);
+    }
+    r = simd::Max(r, V(1e-20f));
+    return V(0.5f) * simd::Log(r) * r / dr;
+}
+
+// base^N by squaring from the low bit up, the way fractal.frag loops over the
+// bits of MANDELBULB_POWER. N is a compile time constant, so this unrolls into
+// straight multiplies.
+template<int N, typename V>
+inline V IntPower(const V& base) {
+    if constexpr (N == 0) {
+        return V(1.0f);
+    }
+    else if constexpr (N == 1) {
+        return base;
+    }
+    else if constexpr ((N & 1) != 0) {
+        return base * IntPower<N / 2>(base * base);
+    }
+    else {
+        return IntPower<N / 2>(base * base);
+    }
+}
+
+// (cos a, sin a) -> (cos N a, sin N a) as an integer power of the unit complex number
+template<int N, typename V>
+inline void UnitComplexPower(V& re, V& im) {
+    if constexpr (N > 1) {
+        V squareRe = re * re - im * im;
+        V squareIm = V(2.0f) * re * im;
+        if constexpr ((N & 1) != 0) {
+            V halfRe = squareRe, halfIm = squareIm;
+            UnitComplexPower<N / 2>(halfRe, halfIm);
+            V nextRe = halfRe * re - halfIm * im;
+            im = simd::MulAdd(halfRe, im, halfIm * re);
+            re = nextRe;
+        }
+        else {
+            re = squareRe;
+            im = squareIm;
+            UnitComplexPower<N / 2>(re, im);
+        }
+    }
+}
+
+// Mandelbulb specialised for an integer POWER. Same spherical formula as the
+// generic one, but theta and phi are never formed: their cosines and sines come
+// straight from z, and multiplying the angles by POWER is a complex power.
+// No acos, atan2, sin, cos, pow, only multiplies, two square roots and a divide.
+template<int POWER, typename V>
+inline V MandelbulbDistanceN(const simd::Vec3<V>& p, const FractalParams& params) {
+    static_assert(POWER >= 2, "Mandelbulb powers below 2 have no bulb");
+    const V bailout(params.bailout);
+    simd::Vec3<V> z = p;
+    V dr(1.0f);
+    V r = simd::Length(z);
+    V active = r <= bailout;
+    for (int i = 0; i < params.iterations && simd::Any(active); i++) {
+        V safeR = simd::Max(r, V(1e-20f));
+        V rho = simd::Sqrt(simd::MulAdd(z.x, z.x, z.y * z.y));
+        V invR = V(1.0f) / safeR;
+        // theta = acos(z / r) lies in [0, pi], so its sine is rho / r, never negative
+        V cosTheta = z.z * invR;
+        V sinTheta = rho * invR;
+        // phi = atan2(y, x), which is 0 on the z axis
+        V onAxis = rho <= V(0.0f);
+        V invRho = V(1.0f) / simd::Max(rho, V(1e-20f));
+        V cosPhi = simd::Select(onAxis, V(1.0f), z.x * invRho);
+        V sinPhi = simd::Select(onAxis, V(0.0f), z.y * invRho);
+        UnitComplexPower<POWER>(cosTheta, sinTheta);
+        UnitComplexPower<POWER>(cosPhi, sinPhi);
+
+        V rPowMinusOne = IntPower<POWER - 1>(safeR);
+        V zr = rPowMinusOne * safeR;
+        V sinZr = sinTheta * zr;
+        simd::Vec3<V> next(simd::MulAdd(sinZr, cosPhi, p.x), simd::MulAdd(sinZr, sinPhi, p.y), simd::MulAdd(cosTheta, zr, p.z));
+
+        dr = simd::Select(active, simd::MulAdd(rPowMinusOne * V((float)POWER), dr, V(1.0f)), dr);
+        z = simd::Select(active, next, z);
+        r = simd::Select(active, simd::Length(next), r);
+        active = active & (r <= bailout);
+    }
+    r = simd::Max(r, V(1e-20f));
+    return V(0.5f) * simd::Log(r) * r / dr;
+}
+
+// Quaternion Julia set q -> q^2 + c in the w = 0 slice, with the running
+// derivative q' -> 2 q q'. Components are real, i, j, k.
+template<typename V>
+inline V JuliaDistance(const simd::Vec3<V>& p, const FractalParams& params) {
+    const V cx(params.juliaC.x), cy(params.juliaC.y), cz(params.juliaC.z), cw(params.juliaC.w);
+    const V bailout2(params.bailout * params.bailout);
+    V qx = p.x, qy = p.y, qz = p.z, qw(0.0f);
+    V dx(1.0f), dy(0.0f), dz(0.0f), dw(0.0f);
+    V r2 = simd::MulAdd(qx, qx, simd::MulAdd(qy, qy, qz * qz));
+    V active = r2 <= bailout2;
+    for (int i = 0; i < params.iterations && simd::Any(active); i++) {
+        // q' = 2 q q'
+        V ndx = V(2.0f) * (qx * dx - qy * dy - qz * dz - qw * dw);
+        V ndy = V(2.0f) * (qx * dy + qy * dx + qz * dw - qw * dz);
+        V ndz = V(2.0f) * (qx * dz - qy * dw + qz * dx + qw * dy);
+        V ndw = V(2.0f) * (qx * dw + qy * dz - qz * dy + qw * dx);
+        // q = q^2 + c
+        V twoX = qx + qx;
+        V nqx = qx * qx - qy * qy - qz * qz - qw * qw + cx;
+        V nqy = simd::MulAdd(twoX, qy, cy);
+        V nqz = simd::MulAdd(twoX, qz, cz);
+        V nqw = simd::MulAdd(twoX, qw, cw);
+
+        dx = simd::Select(active, ndx, dx);
+        dy = simd::Select(active, ndy, dy);
+        dz = simd::Select(active, ndz, dz);
+        dw = simd::Select(active, ndw, dw);
+        qx = simd::Select(active, nqx, qx);
+        qy = simd::Select(active, nqy, qy);
+        qz = simd::Select(active, nqz, qz);
+        qw = simd::Select(active, nqw, qw);
+        r2 = simd::MulAdd(qx, qx, simd::MulAdd(qy, qy, simd::MulAdd(qz, qz, qw * qw)));
+        active = active & (r2 <= bailout2);
+    }
+    V r = simd::Max(simd::Sqrt(r2), V(1e-20f));
+    V dr = simd::Max(simd::Sqrt(dx * dx + dy * dy + dz * dz + dw * dw), V(1e-20f));
+    return V(0.5f) * r * simd::Log(r) / dr;
+}
+
+// Generic dispatch on the formula type; the marchers pick a kernel once per
+// frame instead (fractal/formula.h)
+template<typename V>
+inline V FractalDistance(const simd::Vec3<V>& p, const FractalParams& params) {
+    if (params.type == FractalType::QuaternionJulia) {
+        return JuliaDistance(p, params);
+    }
+    return MandelbulbDistance(p, params);
+}
+
+// Gradient of the estimate from four samples on a tetrahedron of radius h;
+// distance is any callable distance(p) -> V, such as a formula kernel
+template<typename V, typename Distance>
+inline simd::Vec3<V> FractalNormal(const simd::Vec3<V>& p, const V& h, const Distance& distance) {
+    V a = distance(simd::Vec3<V>(p.x + h, p.y - h, p.z - h));
+    V b = distance(simd::Vec3<V>(p.x - h, p.y - h, p.z + h));
+    V c = distance(simd::Vec3<V>(p.x - h, p.y + h, p.z - h));
+    V d = distance(simd::Vec3<V>(p.x + h, p.y + h, p.z + h));
+    return simd::Normalize(simd::Vec3<V>(a - b - c + d, -a - b + c + d, -a + b - c + d));
+}
+
+// Scalar reference, the golden values the lanes and the shader are checked against
+float EstimateDistance(const glm::vec3& p, const FractalParams& params);
+glm::vec3 EstimateNormal(const glm::vec3& p, float h, const FractalParams& params);
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef FRACTAL_FIXEDPOINT_H
+#define FRACTAL_FIXEDPOINT_H
+
+// C++ standard library
+#include <cstdint>
+#include <string>
+
+// Signed fixed-point number for deep zoom coordinates and reference orbits: a
+// 32-bit integer limb followed by fraction limbs, two's complement, most
+// significant limb first. Every value carries its own limb count; operands of
+// different precision are widened to the larger one. Products truncate, and the
+// integer limb wraps, so values have to stay well below 2^15 in magnitude.
+//
+// Fixed size storage keeps the orbit loop free of allocations; MAX_LIMBS covers
+// more depth than the float deltas the pixels are iterated with can reach.
+class FixedPoint
+{
+    public:
+        static constexpr int MAX_LIMBS = 8;
+        static constexpr int FRACTION_BITS_PER_LIMB = 32;
+
+        FixedPoint() = default;
+        // limbs counts the integer limb too, clamped to [1, MAX_LIMBS]
+        static FixedPoint FromDouble(double value, int limbs);
+        // Plain decimal such as "-0.74364388703715870475", no exponent. Digits
+        // beyond the precision of limbs are dropped; false on anything malformed.
+        static bool Parse(const std::string& text, int limbs, FixedPoint& result);
+        // Limbs that resolve a view of this half height with guard bits to spare
+        static int LimbsForScale(double scale);
+
+        double ToDouble() const;
+        // Decimal with digits places after the point, truncated
+        std::string ToString(int digits) const;
+        int GetLimbs() const { return limbCount; }
+        bool IsNegative() const { return limbCount > 0 && (limbs[0] & 0x80000000u) != 0; }
+        // Same value rounded toward zero or extended to limbs
+        FixedPoint WithLimbs(int newLimbs) const;
+
+        FixedPoint operator+(const FixedPoint& other) const;
+        FixedPoint operator-(const FixedPoint& other) const;
+        FixedPoint operator-() const;
+        FixedPoint operator*(const FixedPoint& other) const;
+
+    private:
+        uint32_t limbs[MAX_LIMBS] = {};
+        int limbCount = 1;
+
+        // In place on a non-negative value; limbs past limbCount are always zero
+        void MultiplySmall(uint32_t factor);
+        void DivideSmall(uint32_t divisor);
+};
+
+#endif
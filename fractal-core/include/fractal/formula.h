@@ -0,0 +1,73 @@
+#ifndef FRACTAL_FORMULA_H
+#define FRACTAL_FORMULA_H
+
+// C++ standard library
+#include <string>
+
+// local headers
+#include "fractal/distanceestimator.h"
+#include "fractal/fractalparams.h"
+
+// Mandelbulb exponents that get a kernel of their own: MandelbulbDistanceN<N>
+// on the CPU and a fractal.frag variant compiled with MANDELBULB_POWER N on the
+// GPU, both free of trig. Any other power, including fractional ones, runs the
+// generic pow/atan2/acos estimator on both backends. Adding a power here is all
+// it takes to specialise it everywhere.
+#define FRACTAL_SPECIALIZED_POWERS(X) X(2) X(3) X(4) X(5) X(6) X(7) X(8)
+
+// The kernel a formula compiles to, chosen once per frame
+struct FormulaKernel {
+    FractalType type = FractalType::Mandelbulb;
+    // Exponent of a specialised Mandelbulb kernel, 0 for the generic one
+    int power = 0;
+
+    bool IsSpecialized() const { return power != 0; }
+    bool operator==(const FormulaKernel& other) const { return type == other.type && power == other.power; }
+    bool operator!=(const FormulaKernel& other) const { return !(*this == other); }
+};
+
+// The specialised kernel for params when there is one and bSpecialized allows it.
+// Both backends go through here, so they always agree on the kernel.
+FormulaKernel SelectFormulaKernel(const FractalParams& params, bool bSpecialized);
+// "mandelbulb8", "mandelbulb" (generic) or "julia", for logs and reports
+std::string FormulaKernelName(const FormulaKernel& kernel);
+
+// Kernels are callables kernel(p) -> distance for any lane type, so each marcher
+// is instantiated once per kernel and calls it without a branch per evaluation
+struct MandelbulbKernel {
+    const FractalParams& params;
+    template<typename V>
+    V operator()(const simd::Vec3<V>& p) const { return MandelbulbDistance(p, params); }
+};
+
+template<int POWER>
+struct MandelbulbPowerKernel {
+    const FractalParams& params;
+    template<typename V>
+    V operator()(const simd::Vec3<V>& p) const { return MandelbulbDistanceN<POWER>(p, params); }
+};
+
+struct JuliaKernel {
+    const FractalParams& params;
+    template<typename V>
+    V operator()(const simd::Vec3<V>& p) const { return JuliaDistance(p, params); }
+};
+
+// Calls body(kernel) with the kernel object for formula. params must outlive the call.
+template<typename F>
+inline void VisitFormulaKernel(const FractalParams& params, const FormulaKernel& formula, const F& body) {
+    if (formula.type == FractalType::QuaternionJulia) {
+        body(JuliaKernel{params});
+        return;
+    }
+    switch (formula.power) {
+        #define FRACTAL_VISIT_POWER(N) case N: body(MandelbulbPowerKernel<N>{params}); return;
+        FRACTAL_SPECIALIZED_POWERS(FRACTAL_VISIT_POWER)
+        #undef FRACTAL_VISIT_POWER
+        default:
+            body(MandelbulbKernel{params});
+            return;
+    }
+}
+
+#endif
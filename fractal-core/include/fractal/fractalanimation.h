@@ -0,0 +1,114 @@
+#ifndef FRACTAL_FRACTALANIMATION_H
+#define FRACTAL_FRACTALANIMATION_H
+
+// C++ standard library
+#include <string>
+#include <vector>
+
+// glm
+#include <glm/glm.hpp>
+
+// local headers
+#include "fractal/fractalparams.h"
+
+// How a channel gets from one key to the next
+enum class AnimationCurve {
+    // Hold the key's value until the next key
+    Step,
+    Linear,
+    // Ease in and out, no velocity at either key
+    Smooth,
+    // Catmull-Rom through the keys on either side, velocity carried through the key
+    Spline
+};
+
+const char* AnimationCurveToString(AnimationCurve curve);
+bool ParseAnimationCurve(const std::string& text, AnimationCurve& curve);
+
+// One channel of an animation: keys sorted by time, each with the curve that leads
+// to the next one. Before the first key and after the last the value holds.
+template<typename T>
+struct AnimationTrack {
+    struct Key {
+        float time;
+        T value;
+        AnimationCurve curve;
+    };
+    std::vector<Key> keys;
+
+    bool IsEmpty() const { return keys.empty(); }
+    // Replaces a key at the same time
+    void AddKey(float time, const T& value, AnimationCurve curve);
+    T Evaluate(float time, const T& fallback) const;
+};
+
+// Everything one frame of an animation renders
+struct FractalAnimationFrame {
+    int index = 0;
+    float time = 0.0f;
+    // Channels without keys keep these; the camera starts where the interactive one does
+    glm::vec3 position = glm::vec3(0.0f, 0.0f, 5.0f);
+    glm::vec3 target = glm::vec3(0.0f);
+    float fov = 45.0f;
+    FractalParams params;
+
+    FractalView GetView(float aspect) const { return FractalView::LookAt(position, target, fov, aspect); }
+};
+
+// Keyframed camera and formula. Every channel has its own keys, so the camera can
+// glide on a spline while the power steps or eases between a few values. The
+// formula type is fixed for the whole animation; the estimators of the two
+// types don't blend into anything meaningful.
+//
+// Text format, one statement per line, # starts a comment:
+//
+//   type <mandelbulb|julia>        formula of the whole animation
+//   fps <rate>                     frames per second, 30 by default
+//   duration <seconds>             length, the last key's time by default
+//   key <time> [curve]             following values are keyed at time, leading
+//                                  to the next key with curve (linear by default)
+//   camera <px> <py> <pz> <tx> <ty> <tz> [curve]
+//   fov <degrees> [curve]
+//   power <p> [curve]
+//   iterations <n> [curve]
+//   bailout <r> [curve]
+//   julia <w> <x> <y> <z> [curve]
+//
+// A curve after a value overrides the key's curve for that channel only.
+// Camera position and target share one curve. Curves are step, linear,
+// smooth or spline.
+class FractalAnimation
+{
+    public:
+        bool Load(const std::string& path);
+        bool Save(const std::string& path) const;
+
+        void SetType(FractalType newType) { type = newType; }
+        FractalType GetType() const { return type; }
+        void SetFps(float newFps) { fps = newFps; }
+        float GetFps() const { return fps; }
+        void SetDuration(float seconds) { duration = seconds; }
+        // Explicit duration, or the time of the last key on any channel
+        float GetDuration() const;
+        // Frames from time 0 up to and including the duration
+        int GetFrameCount() const;
+
+        AnimationTrack<glm::vec3> position;
+        AnimationTrack<glm::vec3> target;
+        AnimationTrack<float> fov;
+        AnimationTrack<float> power;
+        AnimationTrack<float> iterations;
+        AnimationTrack<float> bailout;
+        AnimationTrack<glm::vec4> juliaC;
+
+        FractalAnimationFrame Evaluate(float time) const;
+        FractalAnimationFrame EvaluateFrame(int index) const;
+
+    private:
+        FractalType type = FractalType::Mandelbulb;
+        float fps = 30.0f;
+        // 0 until a duration line sets one
+        float duration = 0.0f;
+};
+
+#endif
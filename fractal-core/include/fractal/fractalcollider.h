@@ -0,0 +1,130 @@
+#ifndef FRACTAL_FRACTALCOLLIDER_H
+#define FRACTAL_FRACTALCOLLIDER_H
+
+// C++ standard library
+#include <cstdint>
+
+// glm
+#include <glm/glm.hpp>
+
+// local headers
+#include "fractal/fractalparams.h"
+
+struct CollisionSettings {
+    // Sphere tracing steps a cast may take. One that runs out of them is crawling
+    // along the surface, so it counts as a hit where it got to rather than letting
+    // anything through.
+    int maxSteps = 128;
+    // A cast hits once the estimate is within this of its sphere
+    float hitDistance = 1e-3f;
+    // Fraction of the estimate stepped, as in RayMarchSettings
+    float stepScale = 0.9f;
+    // Normals are the gradient over a quarter of the sphere radius, at least this
+    float normalStep = 1e-4f;
+    // Queries per job; fewer than this run on the calling thread
+    int batchSize = 64;
+    bool bSpecializedKernels = true;
+};
+
+struct CollisionStats {
+    // Sphere and cast queries answered by the last call
+    uint64_t spheres = 0;
+    uint64_t casts = 0;
+    // Sphere tracing steps the casts took
+    uint64_t steps = 0;
+    float ms = 0.0f;
+};
+
+struct SphereQuery {
+    glm::vec3 center = glm::vec3(0.0f);
+    float radius = 0.0f;
+};
+
+struct ProximityResult {
+    // From the sphere to the surface, negative when they overlap
+    float distance = 0.0f;
+    // Away from the surface at the centre, and the surface point closest to it
+    glm::vec3 normal = glm::vec3(0.0f);
+    glm::vec3 point = glm::vec3(0.0f);
+};
+
+// A sphere swept from origin along a unit direction; radius 0 is a ray
+struct SphereCast {
+    glm::vec3 origin = glm::vec3(0.0f);
+    glm::vec3 direction = glm::vec3(0.0f, 0.0f, -1.0f);
+    float maxDistance = 1.0f;
+    float radius = 0.0f;
+};
+
+struct CastResult {
+    bool bHit = false;
+    // How far the centre travelled before the sphere touched, or maxDistance
+    float distance = 0.0f;
+    // Where the sphere touches the surface, and the surface normal there
+    glm::vec3 point = glm::vec3(0.0f);
+    glm::vec3 normal = glm::vec3(0.0f);
+};
+
+// Collision and proximity queries against a fractal, answered from the same
+// distance estimators the marchers draw with. Queries come in arrays and are
+// evaluated a simd packet at a time, the batches spread over the JobSystem:
+//
+//   QuerySpheres   estimate at each centre less the radius, and its gradient
+//   CastSpheres    sphere tracing each swept sphere to its first contact
+//
+// The estimate is a distance bound, so a sphere it reports clear is clear; the
+// estimate of these formulas is only loose far from the surface, where that
+// doesn't matter. Not for use from several threads at once.
+class FractalCollider
+{
+    public:
+        // Formula the next queries run against
+        void SetScene(const FractalParams& newParams) { params = newParams; }
+        const FractalParams& GetParams() const { return params; }
+
+        void SetSettings(const CollisionSettings& newSettings) { settings = newSettings; }
+        const CollisionSettings& GetSettings() const { return settings; }
+
+        // Blocking; the calling thread works too
+        void QuerySpheres(const SphereQuery* spheres, int count, ProximityResult* results);
+        void CastSpheres(const SphereCast* casts, int count, CastResult* results);
+
+        const CollisionStats& GetStats() const { return stats; }
+
+    private:
+        CollisionSettings settings;
+        CollisionStats stats;
+        FractalParams params;
+};
+
+struct SweptSphereSettings {
+    // Sphere around the camera kept out of the surface
+    float radius = 0.02f;
+    // Gap left to the surface on contact, so the next move doesn't start in it
+    float skin = 0.002f;
+    // Surfaces one move slides along before the rest of it is dropped
+    int maxSlides = 4;
+};
+
+// Moves a sphere through a fractal scene without entering it: each move is
+// cast against the surface, stops short of it at the first contact and carries
+// on with what is left of the move along the surface, so walking into a wall at
+// an angle slides along it. A sphere that starts inside, because the formula
+// changed around it, is pushed out along the normal first.
+class SweptSphereController
+{
+    public:
+        void SetSettings(const SweptSphereSettings& newSettings) { settings = newSettings; }
+        const SweptSphereSettings& GetSettings() const { return settings; }
+
+        // Where a sphere at position ends up moved by displacement
+        glm::vec3 Move(FractalCollider& collider, const glm::vec3& position, const glm::vec3& displacement);
+        // The last Move() touched the surface
+        bool IsTouching() const { return bTouching; }
+
+    private:
+        SweptSphereSettings settings;
+        bool bTouching = false;
+};
+
+#endif
@@ -0,0 +1,88 @@
+#ifndef FRACTAL_FRACTALPARAMS_H
+#define FRACTAL_FRACTALPARAMS_H
+
+// glm
+#include <glm/glm.hpp>
+
+// local headers
+#include "camera.h"
+
+enum class FractalType {
+    Mandelbulb,
+    QuaternionJulia
+};
+
+const char* FractalTypeToString(FractalType type);
+
+// Where the engine renders the fractal view; None draws the mesh scene instead
+enum class FractalBackend {
+    None,
+    Cpu,
+    Gpu
+};
+
+const char* FractalBackendToString(FractalBackend backend);
+
+// The formula being rendered. The CPU kernels and fractal.frag read the same
+// fields, so one set of params renders the same image on both paths.
+struct FractalParams {
+    FractalType type = FractalType::Mandelbulb;
+    // Mandelbulb exponent, z -> z^power + c in spherical coordinates
+    float power = 8.0f;
+    int iterations = 12;
+    // Escape radius; also the bounding sphere rays are clipped to
+    float bailout = 2.0f;
+    // Quaternion Julia constant, real part first, sliced at w = 0
+    glm::vec4 juliaC = glm::vec4(-0.2f, 0.6f, 0.2f, 0.2f);
+
+    bool operator==(const FractalParams& other) const {
+        return type == other.type && power == other.power && iterations == other.iterations &&
+               bailout == other.bailout && juliaC == other.juliaC;
+    }
+    bool operator!=(const FractalParams& other) const { return !(*this == other); }
+};
+
+// Sphere tracing quality, shared by both paths
+struct RayMarchSettings {
+    int maxSteps = 160;
+    // A ray hits once the distance estimate drops below this many pixel
+    // footprints at its current depth
+    float pixelEpsilon = 0.5f;
+    // Steps are shortened by this factor; the estimators slightly overshoot near the surface
+    float stepScale = 0.9f;
+    // Whole Mandelbulb powers run trig-free kernels (fractal/formula.h); off forces
+    // the generic estimator, for comparing the two
+    bool bSpecializedKernels = true;
+    // March cones through 8x8 and then 4x4 pixel cells first, and start each
+    // pixel's ray at the depth its cell's cone got to without touching anything
+    bool bConePrepass = false;
+
+    bool operator==(const RayMarchSettings& other) const {
+        return maxSteps == other.maxSteps && pixelEpsilon == other.pixelEpsilon && stepScale == other.stepScale &&
+               bSpecializedKernels == other.bSpecializedKernels && bConePrepass == other.bConePrepass;
+    }
+    bool operator!=(const RayMarchSettings& other) const { return !(*this == other); }
+};
+
+// Pinhole camera basis; primary rays are forward + right * x + up * y for x, y in
+// [-1, 1] scaled by the half extents of the image plane at distance one
+struct FractalView {
+    glm::vec3 position = glm::vec3(0.0f, 0.0f, 3.0f);
+    glm::vec3 right = glm::vec3(1.0f, 0.0f, 0.0f);
+    glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f);
+    glm::vec3 forward = glm::vec3(0.0f, 0.0f, -1.0f);
+    float tanHalfFov = 0.41421356f;
+    float aspect = 1.0f;
+
+    static FractalView FromCamera(const Camera& camera);
+    // Camera at position looking at target with world y up, fovDegrees the vertical field of view
+    static FractalView LookAt(const glm::vec3& position, const glm::vec3& target, float fovDegrees, float aspect);
+
+    bool operator==(const FractalView& other) const {
+        return position == other.position && right == other.right && up == other.up && forward == other.forward &&
+               tanHalfFov == other.tanHalfFov && aspect == other.aspect;
+    }
+    bool operator!=(const FractalView& other) const { return !(*this == other); }
+};
+
+#endif
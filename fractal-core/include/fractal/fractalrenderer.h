@@ -0,0 +1,144 @@
+#ifndef FRACTAL_FRACTALRENDERER_H
+#define FRACTAL_FRACTALRENDERER_H
+
+// C++ standard library
+#include <cstdint>
+#include <vector>
+
+// glm
+#include <glm/glm.hpp>
+
+// gl header
+#include "glreq.h"
+
+// local headers
+#include "fractal/cpuraymarcher.h"
+#include "fractal/deepzoom.h"
+#include "fractal/formula.h"
+#include "fractal/fractalparams.h"
+#include "fractal/temporalrenderer.h"
+#include "rendertarget.h"
+#include "shaderprogram.h"
+
+// GL side of the fractal view: either ray marches on the GPU with fractal.frag,
+// or takes a CpuRayMarcher image and keeps it in a texture for presentation.
+// Deep zooms run deepzoom.frag around a ReferenceOrbit kept in a texture.
+class FractalRenderer
+{
+    public:
+        // Warms up the shader variants for params: specialised, generic and Julia
+        explicit FractalRenderer(const FractalParams& params = FractalParams());
+        ~FractalRenderer();
+
+        // Fullscreen fractal.frag pass over the bound width x height viewport, with
+        // the variant of the formula kernel SelectFormulaKernel() picks. With
+        // bConePrepass the cone levels of CpuRayMarcher are drawn into their own
+        // small targets first; the bound framebuffer and viewport are restored for
+        // the pass.
+        void Render(const FractalView& view, const FractalParams& params, const RayMarchSettings& settings, int width, int height);
+
+        // TemporalRenderer on the GPU: draws the TEMPORAL variant of the pass into the
+        // next of two width x height color and geometry targets, marching one block
+        // cell and reprojecting the rest from the other target. The first frame, and
+        // any after the params, march settings or size change, marches every
+        // fragment. A still view keeps marching the rotating cell, so it is exact once
+        // a rotation is done. The result is GetTemporalTexture(); the bound
+        // framebuffer and viewport are left as they were.
+        void RenderTemporal(const FractalView& view, const FractalParams& params, const RayMarchSettings& settings,
+                            const TemporalSettings& temporalSettings, int width, int height);
+        GLuint GetTemporalTexture() const { return temporalTargets[temporalCurrent].GetColorTexture(); }
+        // March every fragment on the next RenderTemporal()
+        void InvalidateTemporal() { bTemporalValid = false; }
+
+        // Fullscreen deepzoom.frag pass around orbit over the bound width x height
+        // viewport; the orbit is uploaded the first time its id is seen
+        void RenderDeepZoom(const DeepZoomView& view, const ReferenceOrbit& orbit, int width, int height);
+
+        // Offline frames: draws Render() into an offscreen width x height target and
+        // starts reading it into pixel buffer slot; FinishReadback() waits for the slot
+        // and copies its RGBA8 pixels out, bottom row first. Finishing a frame later
+        // lets the copy overlap the next pass instead of stalling on this one. The
+        // bound framebuffer and viewport are left as they were.
+        bool BeginReadback(const FractalView& view, const FractalParams& params, const RayMarchSettings& settings,
+                           int width, int height, int slot);
+        bool FinishReadback(int slot, std::vector<uint32_t>& pixels, int& width, int& height);
+
+        // Copy RGBA8 pixels, bottom row first, into the image texture; it is
+        // reallocated only when the size changes
+        void Upload(const uint32_t* pixels, int width, int height);
+        GLuint GetImageTexture() const { return imageTexture; }
+        int GetImageWidth() const { return imageWidth; }
+        int GetImageHeight() const { return imageHeight; }
+
+    private:
+        // Orbit points per row of the orbit texture, mirrored in deepzoom.frag
+        static constexpr int ORBIT_WIDTH = 2048;
+
+        ShaderProgram* shader = nullptr;
+        FormulaKernel shaderFormula;
+        bool bShaderCones = false;
+        bool bShaderTemporal = false;
+
+        // One target per cone level, coarsest first, and the CONE_PASS variants
+        // that fill them for shaderFormula
+        RenderTarget coneTargets[CpuRayMarcher::CONE_LEVELS];
+        ShaderProgram* coneShaders[CpuRayMarcher::CONE_LEVELS] = {};
+
+        // What a TEMPORAL pass needs besides the view: where the history is and how
+        // it maps onto this frame
+        struct TemporalPass {
+            TemporalSettings settings;
+            TemporalReprojection reprojection;
+            // Block cell marched, -1 for every fragment
+            int cell = -1;
+            float range = 0.0f;
+            float historyRange = 0.0f;
+            GLuint historyColor = 0;
+            GLuint historyGeometry = 0;
+        };
+
+        // Color and geometry of the last two temporal frames, and what the newer
+        // one, temporalCurrent, was drawn with
+        RenderTarget temporalTargets[2];
+        int temporalCurrent = 0;
+        FractalView temporalView;
+        FractalParams temporalParams;
+        RayMarchSettings temporalMarchSettings;
+        float temporalRange = 0.0f;
+        uint32_t temporalFrame = 0;
+        bool bTemporalValid = false;
+
+        // Orbit points as RG32F rows of ORBIT_WIDTH
+        GLuint orbitTexture = 0;
+        uint64_t orbitId = 0;
+
+        // Offline frames and the pixel pack buffers they are read into; the web
+        // build can't map buffers and reads straight into pixels instead
+        struct Readback {
+            GLuint buffer = 0;
+            size_t bufferSize = 0;
+            std::vector<uint32_t> pixels;
+            int width = 0;
+            int height = 0;
+            bool bPending = false;
+        };
+        RenderTarget readbackTarget;
+        std::vector<Readback> readbacks;
+
+        GLuint emptyVAO = 0;
+        GLuint imageTexture = 0;
+        int imageWidth = 0;
+        int imageHeight = 0;
+
+        // Render() into the bound target, as a TEMPORAL pass when temporal is set
+        void RenderPass(const FractalView& view, const FractalParams& params, const RayMarchSettings& settings, int width, int height,
+                        const TemporalPass* temporal);
+        void SetTemporalUniforms(GLuint program, const TemporalPass& temporal);
+        void SetViewUniforms(GLuint program, const FractalView& view, const FractalParams& params, const RayMarchSettings& settings,
+                             int width, int height);
+        // False when a level has no target
+        bool RenderCones(const FractalView& view, const FractalParams& params, const RayMarchSettings& settings, int width, int height);
+        void UploadOrbit(const ReferenceOrbit& orbit);
+};
+
+#endif
@@ -0,0 +1,123 @@
+#ifndef FRACTAL_PROGRESSIVERENDERER_H
+#define FRACTAL_PROGRESSIVERENDERER_H
+
+// C++ standard library
+#include <cstdint>
+#include <vector>
+
+// glm
+#include <glm/glm.hpp>
+
+// local headers
+#include "fractal/cpuraymarcher.h"
+#include "fractal/fractalparams.h"
+
+struct ProgressiveSettings {
+    // Main thread time spent refining per frame; at least one batch of tiles always runs
+    float budgetMs = 12.0f;
+    // While the view changes the image is traced at 1 / previewDivisor of the
+    // resolution with at most previewIterations formula iterations
+    int previewDivisor = 4;
+    int previewIterations = 6;
+    // Accumulated samples per pixel everywhere, and on depth or normal discontinuities
+    int baseSamples = 4;
+    int edgeSamples = 16;
+    // Neighbouring first samples further apart than this fraction of their depth,
+    // or with normals whose cosine is below normalThreshold, mark both as edges
+    float depthThreshold = 0.04f;
+    float normalThreshold = 0.8f;
+};
+
+struct ProgressiveStats {
+    // Refinement pass, sample index 0 is the one ray through every pixel centre
+    int pass = 0;
+    int edgePixels = 0;
+    uint64_t samplesDone = 0;
+    // Every pixel counts as an edge until pass 0 is done, then the real edges
+    uint64_t samplesPlanned = 0;
+    // Rays traced and time spent by the last Update()
+    uint64_t frameRays = 0;
+    float frameMs = 0.0f;
+    bool bPreview = false;
+    bool bComplete = false;
+};
+
+// Interactive CPU view of a fractal. While the camera or the formula changes
+// every frame gets a cheap preview: reduced resolution and iteration count.
+// Once they hold still the full resolution image is refined over as many
+// frames as it takes, within a per-frame time budget:
+//
+//   pass 0         one ray through every pixel centre, keeping depth and normal
+//   edge detect    pixels whose neighbours differ in depth, normal or hit
+//   passes 1..n    jittered supersamples accumulated into every pixel up to
+//                  baseSamples, and into edge pixels up to edgeSamples
+//
+// Pixels not yet traced show the preview stretched over them. The refinement
+// is thrown away only when the view, params, march settings or size change.
+class ProgressiveRenderer
+{
+    public:
+        // Advances the image by one frame's worth of work on the job system
+        void Update(const FractalView& view, const FractalParams& params, const RayMarchSettings& settings,
+                    int width, int height);
+        // Start over from a preview on the next Update()
+        void Invalidate() { bValid = false; }
+
+        void SetSettings(const ProgressiveSettings& newSettings) { settings = newSettings; }
+        const ProgressiveSettings& GetSettings() const { return settings; }
+
+        // RGBA8, bottom row first: the preview while moving, the refined image otherwise
+        const std::vector<uint32_t>& GetPixels() const { return bShowPreview ? previewPixels : pixels; }
+        int GetImageWidth() const { return bShowPreview ? previewWidth : width; }
+        int GetImageHeight() const { return bShowPreview ? previewHeight : height; }
+
+        // 0 to 1; 1 once every planned sample is in
+        float GetCompletion() const;
+        const ProgressiveStats& GetStats() const { return stats; }
+
+    private:
+        ProgressiveSettings settings;
+        ProgressiveStats stats;
+
+        FractalView view;
+        FractalParams params;
+        RayMarchSettings marchSettings;
+        int width = 0;
+        int height = 0;
+        bool bValid = false;
+        bool bShowPreview = false;
+
+        CpuRayMarcher previewMarcher;
+        std::vector<uint32_t> previewPixels;
+        int previewWidth = 0;
+        int previewHeight = 0;
+
+        // Full resolution refinement state, reallocated only when the size changes
+        std::vector<glm::vec3> colorSums;
+        std::vector<uint8_t> sampleCounts;
+        std::vector<float> depths;
+        std::vector<glm::vec3> normals;
+        std::vector<uint8_t> edges;
+        // Edge pixels per tile, so edge-only passes skip whole tiles
+        std::vector<uint16_t> tileEdges;
+        std::vector<uint32_t> pixels;
+        int tilesX = 0;
+        int tileCount = 0;
+        // Next tile of the current pass, and the tiles handed to the job system at once
+        int nextTile = 0;
+        std::vector<int> batchTiles;
+
+        void Resize(int newWidth, int newHeight);
+        void RenderPreview();
+        void BeginRefinement();
+        void FinishPass();
+        void DetectEdges();
+        bool IsDiscontinuity(uint32_t a, uint32_t b) const;
+        void RefineTile(int tile);
+        // Rays the current pass traces in a tile
+        int GetTileSamples(int tile) const;
+        int GetBaseSamples() const;
+        int GetEdgeSamples() const;
+};
+
+#endif
@@ -0,0 +1,344 @@
+#ifndef FRACTAL_SIMD_H
+#define FRACTAL_SIMD_H
+
+// C++ standard library
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#if defined(__SSE4_1__)
+#include <smmintrin.h>
+#endif
+#elif defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#endif
+
+// Float lanes for the CPU fractal kernels. Every lane type exposes the same
+// operators and free functions, so a kernel written as a template over the
+// lane type runs unchanged on one float (the scalar reference), four (SSE2 or
+// WASM SIMD) or eight (AVX2). The width is fixed at compile time: native builds
+// pick it up from NATIVE_SIMD_FLAGS, the web build from -msimd128.
+//
+// Comparisons return masks with every bit of a true lane set; masks combine with
+// & | and AndNot and pick lanes with Select.
+namespace simd {
+
+// Portable fallback, also the scalar reference as FloatArray<1>. The free
+// functions are templates, so kernels spell constants as V(1.0f) rather than
+// relying on float conversions.
+template<int N>
+struct FloatArray {
+    static constexpr int WIDTH = N;
+    float v[N];
+
+    FloatArray() = default;
+    FloatArray(float value) { for (int i = 0; i < N; i++) v[i] = value; }
+
+    static FloatArray Load(const float* source) { FloatArray r; memcpy(r.v, source, sizeof(r.v)); return r; }
+    void Store(float* destination) const { memcpy(destination, v, sizeof(v)); }
+    float Lane(int i) const { return v[i]; }
+
+    static float FromBits(uint32_t bits) { float f; memcpy(&f, &bits, sizeof(f)); return f; }
+    static uint32_t ToBits(float f) { uint32_t bits; memcpy(&bits, &f, sizeof(bits)); return bits; }
+    static float MaskOf(bool b) { return FromBits(b ? 0xFFFFFFFFu : 0u); }
+};
+
+#define SIMD_ARRAY_BINARY(op, expr) \
+    template<int N> inline FloatArray<N> op(const FloatArray<N>& a, const FloatArray<N>& b) { \
+        FloatArray<N> r; for (int i = 0; i < N; i++) { float x = a.v[i], y = b.v[i]; r.v[i] = (expr); } return r; }
+#define SIMD_ARRAY_BITWISE(op, expr) \
+    template<int N> inline FloatArray<N> op(const FloatArray<N>& a, const FloatArray<N>& b) { \
+        FloatArray<N> r; for (int i = 0; i < N; i++) { \
+            uint32_t x = FloatArray<N>::ToBits(a.v[i]), y = FloatArray<N>::ToBits(b.v[i]); \
+            r.v[i] = FloatArray<N>::FromBits(expr); } return r; }
+#define SIMD_ARRAY_UNARY(op, expr) \
+    template<int N> inline FloatArray<N> op(const FloatArray<N>& a) { \
+        FloatArray<N> r; for (int i = 0; i < N; i++) { float x = a.v[i]; r.v[i] = (expr); } return r; }
+
+SIMD_ARRAY_BINARY(operator+, x + y)
+SIMD_ARRAY_BINARY(operator-, x - y)
+SIMD_ARRAY_BINARY(operator*, x * y)
+SIMD_ARRAY_BINARY(operator/, x / y)
+SIMD_ARRAY_BINARY(operator<, FloatArray<N>::MaskOf(x < y))
+SIMD_ARRAY_BINARY(operator<=, FloatArray<N>::MaskOf(x <= y))
+SIMD_ARRAY_BINARY(operator>, FloatArray<N>::MaskOf(x > y))
+SIMD_ARRAY_BINARY(operator>=, FloatArray<N>::MaskOf(x >= y))
+SIMD_ARRAY_BINARY(Min, y < x ? y : x)
+SIMD_ARRAY_BINARY(Max, y > x ? y : x)
+SIMD_ARRAY_BITWISE(operator&, x & y)
+SIMD_ARRAY_BITWISE(operator|, x | y)
+SIMD_ARRAY_BITWISE(AndNot, x & ~y)
+SIMD_ARRAY_UNARY(operator-, -x)
+SIMD_ARRAY_UNARY(Abs, std::fabs(x))
+SIMD_ARRAY_UNARY(Sqrt, std::sqrt(x))
+SIMD_ARRAY_UNARY(Floor, std::floor(x))
+
+#undef SIMD_ARRAY_BINARY
+#undef SIMD_ARRAY_BITWISE
+#undef SIMD_ARRAY_UNARY
+
+template<int N>
+inline FloatArray<N> MulAdd(const FloatArray<N>& a, const FloatArray<N>& b, const FloatArray<N>& c) { return a * b + c; }
+
+// mask ? a : b per lane
+template<int N>
+inline FloatArray<N> Select(const FloatArray<N>& mask, const FloatArray<N>& a, const FloatArray<N>& b) {
+    FloatArray<N> r;
+    for (int i = 0; i < N; i++) {
+        r.v[i] = FloatArray<N>::ToBits(mask.v[i]) ? a.v[i] : b.v[i];
+    }
+    return r;
+}
+
+// Bit i set when lane i of the mask is true
+template<int N>
+inline int MoveMask(const FloatArray<N>& mask) {
+    int bits = 0;
+    for (int i = 0; i < N; i++) {
+        bits |= (int)(FloatArray<N>::ToBits(mask.v[i]) >> 31) << i;
+    }
+    return bits;
+}
+
+// Mantissa in [0.5, 1) of a positive normal float, exponent returned as a float
+template<int N>
+inline FloatArray<N> FrExp(const FloatArray<N>& a, FloatArray<N>& exponent) {
+    FloatArray<N> r;
+    for (int i = 0; i < N; i++) {
+        uint32_t bits = FloatArray<N>::ToBits(a.v[i]);
+        exponent.v[i] = (float)((int)((bits >> 23) & 0xFF) - 126);
+        r.v[i] = FloatArray<N>::FromBits((bits & 0x807FFFFFu) | 0x3F000000u);
+    }
+    return r;
+}
+
+// a * 2^exponent for a whole-valued exponent in [-126, 127]
+template<int N>
+inline FloatArray<N> LdExp(const FloatArray<N>& a, const FloatArray<N>& exponent) {
+    FloatArray<N> r;
+    for (int i = 0; i < N; i++) {
+        r.v[i] = a.v[i] * FloatArray<N>::FromBits((uint32_t)((int)exponent.v[i] + 127) << 23);
+    }
+    return r;
+}
+
+typedef FloatArray<1> Float1;
+
+#if defined(__SSE2__) || defined(_M_X64)
+
+struct Float4 {
+    static constexpr int WIDTH = 4;
+    __m128 v;
+
+    Float4() = default;
+    Float4(__m128 value) : v(value) {}
+    Float4(float value) : v(_mm_set1_ps(value)) {}
+
+    static Float4 Load(const float* source) { return _mm_loadu_ps(source); }
+    void Store(float* destination) const { _mm_storeu_ps(destination, v); }
+    float Lane(int i) const { alignas(16) float lanes[4]; _mm_store_ps(lanes, v); return lanes[i]; }
+};
+
+inline Float4 operator+(Float4 a, Float4 b) { return _mm_add_ps(a.v, b.v); }
+inline Float4 operator-(Float4 a, Float4 b) { return _mm_sub_ps(a.v, b.v); }
+inline Float4 operator*(Float4 a, Float4 b) { return _mm_mul_ps(a.v, b.v); }
+inline Float4 operator/(Float4 a, Float4 b) { return _mm_div_ps(a.v, b.v); }
+inline Float4 operator-(Float4 a) { return _mm_xor_ps(a.v, _mm_set1_ps(-0.0f)); }
+inline Float4 operator<(Float4 a, Float4 b) { return _mm_cmplt_ps(a.v, b.v); }
+inline Float4 operator<=(Float4 a, Float4 b) { return _mm_cmple_ps(a.v, b.v); }
+inline Float4 operator>(Float4 a, Float4 b) { return _mm_cmpgt_ps(a.v, b.v); }
+inline Float4 operator>=(Float4 a, Float4 b) { return _mm_cmpge_ps(a.v, b.v); }
+inline Float4 operator&(Float4 a, Float4 b) { return _mm_and_ps(a.v, b.v); }
+inline Float4 operator|(Float4 a, Float4 b) { return _mm_or_ps(a.v, b.v); }
+inline Float4 AndNot(Float4 a, Float4 b) { return _mm_andnot_ps(b.v, a.v); }
+inline Float4 Min(Float4 a, Float4 b) { return _mm_min_ps(a.v, b.v); }
+inline Float4 Max(Float4 a, Float4 b) { return _mm_max_ps(a.v, b.v); }
+inline Float4 Abs(Float4 a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v); }
+inline Float4 Sqrt(Float4 a) { return _mm_sqrt_ps(a.v); }
+inline Float4 MulAdd(Float4 a, Float4 b, Float4 c) { return _mm_add_ps(_mm_mul_ps(a.v, b.v), c.v); }
+inline Float4 Select(Float4 mask, Float4 a, Float4 b) { return _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v)); }
+inline int MoveMask(Float4 mask) { return _mm_movemask_ps(mask.v); }
+
+inline Float4 Floor(Float4 a) {
+    #if defined(__SSE4_1__)
+    return _mm_floor_ps(a.v);
+    #else
+    // Truncate, then step down where that rounded up; fine for |a| < 2^31
+    __m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(a.v));
+    return _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, a.v), _mm_set1_ps(1.0f)));
+    #endif
+}
+
+inline Float4 FrExp(Float4 a, Float4& exponent) {
+    __m128i bits = _mm_castps_si128(a.v);
+    __m128i biased = _mm_and_si128(_mm_srli_epi32(bits, 23), _mm_set1_epi32(0xFF));
+    exponent = _mm_cvtepi32_ps(_mm_sub_epi32(biased, _mm_set1_epi32(126)));
+    __m128i mantissa = _mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32((int)0x807FFFFF)), _mm_set1_epi32(0x3F000000));
+    return _mm_castsi128_ps(mantissa);
+}
+
+inline Float4 LdExp(Float4 a, Float4 exponent) {
+    __m128i scale = _mm_slli_epi32(_mm_add_epi32(_mm_cvttps_epi32(exponent.v), _mm_set1_epi32(127)), 23);
+    return _mm_mul_ps(a.v, _mm_castsi128_ps(scale));
+}
+
+#elif defined(__wasm_simd128__)
+
+struct Float4 {
+    static constexpr int WIDTH = 4;
+    v128_t v;
+
+    Float4() = default;
+    Float4(v128_t value) : v(value) {}
+    Float4(float value) : v(wasm_f32x4_splat(value)) {}
+
+    static Float4 Load(const float* source) { return wasm_v128_load(source); }
+    void Store(float* destination) const { wasm_v128_store(destination, v); }
+    float Lane(int i) const { float lanes[4]; wasm_v128_store(lanes, v); return lanes[i]; }
+};
+
+inline Float4 operator+(Float4 a, Float4 b) { return wasm_f32x4_add(a.v, b.v); }
+inline Float4 operator-(Float4 a, Float4 b) { return wasm_f32x4_sub(a.v, b.v); }
+inline Float4 operator*(Float4 a, Float4 b) { return wasm_f32x4_mul(a.v, b.v); }
+inline Float4 operator/(Float4 a, Float4 b) { return wasm_f32x4_div(a.v, b.v); }
+inline Float4 operator-(Float4 a) { return wasm_f32x4_neg(a.v); }
+inline Float4 operator<(Float4 a, Float4 b) { return wasm_f32x4_lt(a.v, b.v); }
+inline Float4 operator<=(Float4 a, Float4 b) { return wasm_f32x4_le(a.v, b.v); }
+inline Float4 operator>(Float4 a, Float4 b) { return wasm_f32x4_gt(a.v, b.v); }
+inline Float4 operator>=(Float4 a, Float4 b) { return wasm_f32x4_ge(a.v, b.v); }
+inline Float4 operator&(Float4 a, Float4 b) { return wasm_v128_and(a.v, b.v); }
+inline Float4 operator|(Float4 a, Float4 b) { return wasm_v128_or(a.v, b.v); }
+inline Float4 AndNot(Float4 a, Float4 b) { return wasm_v128_andnot(a.v, b.v); }
+// pmin/pmax match the SSE operand order, so both lane types agree on NaN
+inline Float4 Min(Float4 a, Float4 b) { return wasm_f32x4_pmin(a.v, b.v); }
+inline Float4 Max(Float4 a, Float4 b) { return wasm_f32x4_pmax(a.v, b.v); }
+inline Float4 Abs(Float4 a) { return wasm_f32x4_abs(a.v); }
+inline Float4 Sqrt(Float4 a) { return wasm_f32x4_sqrt(a.v); }
+inline Float4 Floor(Float4 a) { return wasm_f32x4_floor(a.v); }
+inline Float4 MulAdd(Float4 a, Float4 b, Float4 c) { return wasm_f32x4_add(wasm_f32x4_mul(a.v, b.v), c.v); }
+inline Float4 Select(Float4 mask, Float4 a, Float4 b) { return wasm_v128_bitselect(a.v, b.v, mask.v); }
+inline int MoveMask(Float4 mask) { return (int)wasm_i32x4_bitmask(mask.v); }
+
+inline Float4 FrExp(Float4 a, Float4& exponent) {
+    v128_t biased = wasm_v128_and(wasm_u32x4_shr(a.v, 23), wasm_i32x4_splat(0xFF));
+    exponent = wasm_f32x4_convert_i32x4(wasm_i32x4_sub(biased, wasm_i32x4_splat(126)));
+    return wasm_v128_or(wasm_v128_and(a.v, wasm_i32x4_splat((int)0x807FFFFF)), wasm_i32x4_splat(0x3F000000));
+}
+
+inline Float4 LdExp(Float4 a, Float4 exponent) {
+    v128_t scale = wasm_i32x4_shl(wasm_i32x4_add(wasm_i32x4_trunc_sat_f32x4(exponent.v), wasm_i32x4_splat(127)), 23);
+    return wasm_f32x4_mul(a.v, scale);
+}
+
+#else
+
+typedef FloatArray<4> Float4;
+
+#endif
+
+#if defined(__AVX2__)
+
+struct Float8 {
+    static constexpr int WIDTH = 8;
+    __m256 v;
+
+    Float8() = default;
+    Float8(__m256 value) : v(value) {}
+    Float8(float value) : v(_mm256_set1_ps(value)) {}
+
+    static Float8 Load(const float* source) { return _mm256_loadu_ps(source); }
+    void Store(float* destination) const { _mm256_storeu_ps(destination, v); }
+    float Lane(int i) const { alignas(32) float lanes[8]; _mm256_store_ps(lanes, v); return lanes[i]; }
+};
+
+inline Float8 operator+(Float8 a, Float8 b) { return _mm256_add_ps(a.v, b.v); }
+inline Float8 operator-(Float8 a, Float8 b) { return _mm256_sub_ps(a.v, b.v); }
+inline Float8 operator*(Float8 a, Float8 b) { return _mm256_mul_ps(a.v, b.v); }
+inline Float8 operator/(Float8 a, Float8 b) { return _mm256_div_ps(a.v, b.v); }
+inline Float8 operator-(Float8 a) { return _mm256_xor_ps(a.v, _mm256_set1_ps(-0.0f)); }
+inline Float8 operator<(Float8 a, Float8 b) { return _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ); }
+inline Float8 operator<=(Float8 a, Float8 b) { return _mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ); }
+inline Float8 operator>(Float8 a, Float8 b) { return _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ); }
+inline Float8 operator>=(Float8 a, Float8 b) { return _mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ); }
+inline Float8 operator&(Float8 a, Float8 b) { return _mm256_and_ps(a.v, b.v); }
+inline Float8 operator|(Float8 a, Float8 b) { return _mm256_or_ps(a.v, b.v); }
+inline Float8 AndNot(Float8 a, Float8 b) { return _mm256_andnot_ps(b.v, a.v); }
+inline Float8 Min(Float8 a, Float8 b) { return _mm256_min_ps(a.v, b.v); }
+inline Float8 Max(Float8 a, Float8 b) { return _mm256_max_ps(a.v, b.v); }
+inline Float8 Abs(Float8 a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v); }
+inline Float8 Sqrt(Float8 a) { return _mm256_sqrt_ps(a.v); }
+inline Float8 Floor(Float8 a) { return _mm256_floor_ps(a.v); }
+inline Float8 Select(Float8 mask, Float8 a, Float8 b) { return _mm256_blendv_ps(b.v, a.v, mask.v); }
+inline int MoveMask(Float8 mask) { return _mm256_movemask_ps(mask.v); }
+
+inline Float8 MulAdd(Float8 a, Float8 b, Float8 c) {
+    #if defined(__FMA__)
+    return _mm256_fmadd_ps(a.v, b.v, c.v);
+    #else
+    return _mm256_add_ps(_mm256_mul_ps(a.v, b.v), c.v);
+    #endif
+}
+
+inline Float8 FrExp(Float8 a, Float8& exponent) {
+    __m256i bits = _mm256_castps_si256(a.v);
+    __m256i biased = _mm256_and_si256(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(0xFF));
+    exponent = _mm256_cvtepi32_ps(_mm256_sub_epi32(biased, _mm256_set1_epi32(126)));
+    __m256i mantissa = _mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32((int)0x807FFFFF)), _mm256_set1_epi32(0x3F000000));
+    return _mm256_castsi256_ps(mantissa);
+}
+
+inline Float8 LdExp(Float8 a, Float8 exponent) {
+    __m256i scale = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvttps_epi32(exponent.v), _mm256_set1_epi32(127)), 23);
+    return _mm256_mul_ps(a.v, _mm256_castsi256_ps(scale));
+}
+
+typedef Float8 FloatNative;
+
+#else
+
+typedef FloatArray<8> Float8;
+typedef Float4 FloatNative;
+
+#endif
+
+// Lane helpers shared by every width
+template<typename V> inline bool Any(const V& mask) { return MoveMask(mask) != 0; }
+template<typename V> inline bool All(const V& mask) { return MoveMask(mask) == (1 << V::WIDTH) - 1; }
+template<typename V> inline V Clamp(const V& a, const V& low, const V& high) { return Min(Max(a, low), high); }
+// 1.0 in the lanes the mask selects, 0.0 elsewhere
+template<typename V> inline V MaskToOne(const V& mask) { return mask & V(1.0f); }
+
+template<typename V, int = V::WIDTH> inline V& operator+=(V& a, const V& b) { a = a + b; return a; }
+template<typename V, int = V::WIDTH> inline V& operator-=(V& a, const V& b) { a = a - b; return a; }
+template<typename V, int = V::WIDTH> inline V& operator*=(V& a, const V& b) { a = a * b; return a; }
+
+// Three lanes-wide components, one point or direction per lane
+template<typename V>
+struct Vec3 {
+    V x, y, z;
+
+    Vec3() = default;
+    Vec3(const V& x, const V& y, const V& z) : x(x), y(y), z(z) {}
+    explicit Vec3(float value) : x(value), y(value), z(value) {}
+
+    Vec3 operator+(const Vec3& b) const { return Vec3(x + b.x, y + b.y, z + b.z); }
+    Vec3 operator-(const Vec3& b) const { return Vec3(x - b.x, y - b.y, z - b.z); }
+    Vec3 operator*(const V& s) const { return Vec3(x * s, y * s, z * s); }
+};
+
+template<typename V> inline V Dot(const Vec3<V>& a, const Vec3<V>& b) { return MulAdd(a.x, b.x, MulAdd(a.y, b.y, a.z * b.z)); }
+template<typename V> inline V Length(const Vec3<V>& a) { return Sqrt(Dot(a, a)); }
+template<typename V> inline Vec3<V> Normalize(const Vec3<V>& a) { return a * (V(1.0f) / Max(Length(a), V(1e-20f))); }
+template<typename V>
+inline Vec3<V> Select(const V& mask, const Vec3<V>& a, const Vec3<V>& b) {
+    return Vec3<V>(Select(mask, a.x, b.x), Select(mask, a.y, b.y), Select(mask, a.z, b.z));
+}
+
+}
+
+#endif
@@ -0,0 +1,131 @@
+#ifndef FRACTAL_SIMDMATH_H
+#define FRACTAL_SIMDMATH_H
+
+// local headers
+#include "fractal/simd.h"
+
+// Transcendentals over any simd lane type. Polynomials are the Cephes single
+// precision ones, good to a few ulp over the ranges the distance estimators
+// use; the same code runs for Float1, so the scalar path is bit-compatible with
+// the lanes rather than with libm.
+namespace simd {
+
+constexpr float PI = 3.14159265358979f;
+constexpr float HALF_PI = 1.57079632679490f;
+
+// Natural log of positive normal values
+template<typename V>
+inline V Log(V x) {
+    V e;
+    x = FrExp(x, e);
+    // Mantissa into [sqrt(0.5), sqrt(2)) so the polynomial stays centred on 1
+    V small = x < V(0.707106781186547524f);
+    e = e - MaskToOne(small);
+    x = Select(small, x + x, x) - V(1.0f);
+    V z = x * x;
+
+    V y = V(7.0376836292e-2f);
+    y = MulAdd(y, x, V(-1.1514610310e-1f));
+    y = MulAdd(y, x, V(1.1676998740e-1f));
+    y = MulAdd(y, x, V(-1.2420140846e-1f));
+    y = MulAdd(y, x, V(1.4249322787e-1f));
+    y = MulAdd(y, x, V(-1.6668057665e-1f));
+    y = MulAdd(y, x, V(2.0000714765e-1f));
+    y = MulAdd(y, x, V(-2.4999993993e-1f));
+    y = MulAdd(y, x, V(3.3333331174e-1f));
+    y = y * x * z;
+
+    y = MulAdd(e, V(-2.12194440e-4f), y);
+    y = MulAdd(z, V(-0.5f), y);
+    return MulAdd(e, V(0.693359375f), x + y);
+}
+
+template<typename V>
+inline V Exp(V x) {
+    x = Clamp(x, V(-87.3f), V(88.3f));
+    // exp(x) = 2^n * exp(r), |r| <= ln(2) / 2, with ln(2) split for precision
+    V n = Floor(MulAdd(x, V(1.44269504088896341f), V(0.5f)));
+    x = MulAdd(n, V(-0.693359375f), x);
+    x = MulAdd(n, V(2.12194440e-4f), x);
+    V z = x * x;
+
+    V y = V(1.9875691500e-4f);
+    y = MulAdd(y, x, V(1.3981999507e-3f));
+    y = MulAdd(y, x, V(8.3334519073e-3f));
+    y = MulAdd(y, x, V(4.1665795894e-2f));
+    y = MulAdd(y, x, V(1.6666665459e-1f));
+    y = MulAdd(y, x, V(5.0000001201e-1f));
+    y = MulAdd(y, z, x + V(1.0f));
+    return LdExp(y, n);
+}
+
+// x^y for positive x
+template<typename V>
+inline V Pow(const V& x, const V& y) {
+    return Exp(y * Log(x));
+}
+
+template<typename V>
+inline V Sin(V x) {
+    // Into [-pi, pi] with 2pi split in two so large angles keep their precision
+    V k = Floor(MulAdd(x, V(0.159154943091895f), V(0.5f)));
+    x = MulAdd(k, V(-6.28125f), x);
+    x = MulAdd(k, V(-1.93530717958647692e-3f), x);
+    // Then into [-pi/2, pi/2] through sin(pi - x) = sin(x)
+    x = Select(x > V(HALF_PI), V(PI) - x, x);
+    x = Select(x < V(-HALF_PI), V(-PI) - x, x);
+
+    // Odd Taylor series to x^11, under 1e-7 absolute error on the interval
+    V z = x * x;
+    V y = V(-2.5052108385e-8f);
+    y = MulAdd(y, z, V(2.7557319224e-6f));
+    y = MulAdd(y, z, V(-1.9841269841e-4f));
+    y = MulAdd(y, z, V(8.3333333333e-3f));
+    y = MulAdd(y, z, V(-1.6666666667e-1f));
+    return MulAdd(y * z, x, x);
+}
+
+template<typename V>
+inline V Cos(const V& x) {
+    return Sin(x + V(HALF_PI));
+}
+
+template<typename V>
+inline V Atan(V x) {
+    V sign = x & V(-0.0f);
+    x = Abs(x);
+    // atan(x) = pi/2 - atan(1/x) and pi/4 + atan((x-1)/(x+1)) fold x into [0, tan(pi/8)]
+    V large = x > V(2.414213562373095f);
+    V medium = AndNot(x > V(0.4142135623730950f), large);
+    V offset = Select(large, V(HALF_PI), Select(medium, V(0.25f * PI), V(0.0f)));
+    x = Select(large, V(-1.0f) / x, Select(medium, (x - V(1.0f)) / (x + V(1.0f)), x));
+
+    V z = x * x;
+    V y = V(8.05374449538e-2f);
+    y = MulAdd(y, z, V(-1.38776856032e-1f));
+    y = MulAdd(y, z, V(1.99777106478e-1f));
+    y = MulAdd(y, z, V(-3.33329491539e-1f));
+    y = offset + MulAdd(y * z, x, x);
+    return y | sign;
+}
+
+template<typename V>
+inline V Atan2(const V& y, const V& x) {
+    // Quotient limited so x = 0 gives +-pi/2 rather than NaN
+    V ratio = y / Select(Abs(x) < V(1e-30f), V(1e-30f) | (x & V(-0.0f)), x);
+    V angle = Atan(ratio);
+    // Left half plane: shift by pi towards the sign of y
+    V left = x < V(0.0f);
+    V shift = V(PI) | (y & V(-0.0f));
+    return Select(left, angle + shift, angle);
+}
+
+template<typename V>
+inline V Acos(const V& x) {
+    V clamped = Clamp(x, V(-1.0f), V(1.0f));
+    return Atan2(Sqrt(Max(V(1.0f) - clamped * clamped, V(0.0f))), clamped);
+}
+
+}
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef FRACTAL_SURFACEMESHER_H
+#define FRACTAL_SURFACEMESHER_H
+
+// C++ standard library
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// glm
+#include <glm/glm.hpp>
+
+// local headers
+#include "fractal/fractalparams.h"
+
+struct SurfaceMeshSettings {
+    // Grid cells per axis across the cube
+    int resolution = 128;
+    // Cells per axis of one job; the last chunk along an axis may be smaller
+    int chunkCells = 32;
+    // Half size of the cube, centred on the origin; the default holds both default formulas
+    float bounds = 1.25f;
+    // The surface is taken where the estimate equals this many cells, which closes
+    // gaps and filaments too thin for the grid to hold
+    float isoCells = 0.5f;
+};
+
+struct SurfaceMeshStats {
+    int resolution = 0;
+    uint32_t chunks = 0;
+    // Chunks the estimate at their centre proved empty without sampling them
+    uint32_t emptyChunks = 0;
+    uint64_t samples = 0;
+    uint32_t vertices = 0;
+    uint32_t triangles = 0;
+    float ms = 0.0f;
+    float trianglesPerSecond = 0.0f;
+    // Most bytes held at once by chunk buffers and the output
+    uint64_t peakBytes = 0;
+};
+
+// Triangle mesh of a fractal surface; counter-clockwise seen from outside
+struct SurfaceMesh {
+    std::vector<glm::vec3> positions;
+    // Unit gradient of the estimate at each vertex
+    std::vector<glm::vec3> normals;
+    std::vector<uint32_t> indices;
+
+    // Wavefront OBJ with positions and normals; false if the file can't be written
+    bool SaveObj(const std::string& path) const;
+};
+
+// Extracts the surface of a formula with surface nets, the simplest dual
+// contouring: the estimate minus the iso value is sampled at the corners of a
+// uniform grid, every cell it changes sign in gets one vertex at the mean of
+// its edge crossings, and every grid edge it changes sign along gets a quad
+// joining the four cells around it. Vertices are shared by every quad that
+// touches them, so the mesh has no cracks.
+//
+// The grid is split into chunks run as jobs on the JobSystem, each sampling its
+// corners in simd rows with the formula kernel. Chunks whose centre estimate
+// shows the whole chunk is outside the surface are skipped, which for these thin
+// fractals is most of the cube. A chunk owns the cells and edges whose lower
+// corner lies in it, so the quads along its lower faces reach into the chunks
+// below; those vertices are welded to the neighbour's through the cells it kept
+// on its upper faces once every chunk's vertex count is known.
+class SurfaceMesher
+{
+    public:
+        // Blocks until the mesh is done; the calling thread works too
+        SurfaceMesh Extract(const FractalParams& params, const SurfaceMeshSettings& settings = SurfaceMeshSettings());
+
+        const SurfaceMeshStats& GetStats() const { return stats; }
+
+    private:
+        SurfaceMeshStats stats;
+};
+
+#endif
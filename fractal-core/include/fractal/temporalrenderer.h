@@ -0,0 +1,149 @@
+#ifndef FRACTAL_TEMPORALRENDERER_H
+#define FRACTAL_TEMPORALRENDERER_H
+
+// C++ standard library
+#include <cstdint>
+#include <vector>
+
+// glm
+#include <glm/glm.hpp>
+
+// local headers
+#include "fractal/cpuraymarcher.h"
+#include "fractal/fractalparams.h"
+
+struct TemporalSettings {
+    // Fixed point iterations that look for the history pixel landing on a pixel
+    int iterations = 3;
+    // A history pixel is reused only when it lands within this many pixels of the
+    // centre it fills, so pixels that nothing in the last frame maps onto, the ones
+    // just disoccluded, are traced
+    float maxError = 0.75f;
+    // Neighbouring history pixels further apart than this fraction of their depth
+    // are on different surfaces; if their motions differ by more than maxParallax
+    // pixels one slides over the other, and the pixel is traced
+    float depthThreshold = 0.04f;
+    float maxParallax = 0.5f;
+    // Cosine between the surface normal and the direction to the new camera below
+    // which a history pixel is too foreshortened, or turned away, to reuse
+    float minFacing = 0.1f;
+};
+
+// Previous view's image points and depths into the current view's camera space,
+// the new view-projection times the inverse of the old one
+struct TemporalReprojection {
+    // Old camera position, and the old ray through image point (x, y) as
+    // base + stepX * x + stepY * y with unit forward component
+    glm::vec3 origin = glm::vec3(0.0f);
+    glm::vec3 base = glm::vec3(0.0f);
+    glm::vec3 stepX = glm::vec3(0.0f);
+    glm::vec3 stepY = glm::vec3(0.0f);
+    // Camera space x / z and y / z to image points
+    glm::vec2 scale = glm::vec2(0.0f);
+    glm::vec2 halfSize = glm::vec2(0.0f);
+
+    void Setup(const FractalView& from, const FractalView& to, int width, int height);
+};
+
+struct TemporalStats {
+    // Rays traced by the last Update(): this frame's pattern pixels plus the rejected ones
+    uint64_t rays = 0;
+    // Pixels carried over from the previous frame, and pixels outside the pattern
+    // that couldn't be and were traced
+    uint64_t reprojected = 0;
+    uint64_t rejected = 0;
+    // Pattern cell traced by the last Update(), 0 to PATTERN_CELLS - 1
+    int phase = 0;
+    // The last Update() had no history to go on and traced every pixel
+    bool bReset = false;
+    float ms = 0.0f;
+};
+
+// CPU temporal reprojection for a moving fractal view. Every frame traces only
+// one pixel of each 2x2 block, rotating through the block so every pixel is
+// traced again at least once every PATTERN_CELLS frames. The other pixels are
+// taken from the previous frame: its depths put each of its pixels back in the
+// world, the old and new views give where that point lands now, and a few fixed
+// point iterations find the history pixel that lands on each pixel centre.
+// That pixel is rejected, and the pixel traced after all, when
+//
+//   nothing lands close enough     disoccluded, or the iteration didn't settle
+//   it sits on a depth edge        a history neighbour across the edge moves apart
+//                                  from it: surfaces slide over one another
+//   its normal faces away          seen from behind, or nearly edge on, in the
+//                                  new view
+//
+// Colors are carried over as they were shaded: the lighting doesn't depend on
+// the view. The history is thrown away when the params, march settings or size
+// change. Once the view holds still, only pixels that were last reprojected are
+// traced, so after one rotation the image is exact and no more rays are spent.
+// FractalRenderer::RenderTemporal() runs the same steps in fractal.frag; this is
+// its reference.
+class TemporalRenderer
+{
+    public:
+        // Pixels of a PATTERN_SIZE square block, one traced each frame
+        static constexpr int PATTERN_SIZE = 2;
+        static constexpr int PATTERN_CELLS = PATTERN_SIZE * PATTERN_SIZE;
+
+        // Block cell (x & 1) | (y & 1) << 1 traced by frame; diagonal cells follow
+        // each other so a half done rotation covers the block evenly
+        static int GetPatternCell(uint32_t frame);
+
+        // Renders the next frame on the job system. Without a history, the first time
+        // or after anything but the view changed, every pixel is traced.
+        void Update(const FractalView& view, const FractalParams& params, const RayMarchSettings& settings,
+                    int width, int height);
+        // Trace every pixel on the next Update()
+        void Invalidate() { bValid = false; }
+
+        void SetSettings(const TemporalSettings& newSettings) { settings = newSettings; }
+        const TemporalSettings& GetSettings() const { return settings; }
+
+        // RGBA8, bottom row first
+        const std::vector<uint32_t>& GetPixels() const { return frames[current].pixels; }
+        int GetWidth() const { return width; }
+        int GetHeight() const { return height; }
+        const TemporalStats& GetStats() const { return stats; }
+
+    private:
+        // One frame's image and the geometry it was shaded from
+        struct Frame {
+            FractalView view;
+            std::vector<uint32_t> pixels;
+            // View depth, along the camera's forward axis, negative for misses
+            std::vector<float> depths;
+            std::vector<glm::vec3> normals;
+            // 1 where a ray went through the pixel centre in this view, 0 where reprojected
+            std::vector<uint8_t> traced;
+        };
+
+        TemporalSettings settings;
+        TemporalStats stats;
+
+        FractalParams params;
+        RayMarchSettings marchSettings;
+        int width = 0;
+        int height = 0;
+        bool bValid = false;
+        uint32_t frameIndex = 0;
+
+        // Current and previous frame, swapped every Update()
+        Frame frames[2];
+        int current = 0;
+        TemporalReprojection reprojection;
+        int tilesX = 0;
+        int tileCount = 0;
+
+        void Resize(int newWidth, int newHeight);
+        void RenderTile(int tile, bool bReset, bool bStill, int cell, uint64_t& rays, uint64_t& reprojected, uint64_t& rejected);
+        // History pixel source's point in the new camera space and how far it moved in
+        // the image; false when it is now behind the camera
+        bool Land(uint32_t source, glm::vec3& point, glm::vec2& motion) const;
+        // Fills pixel index of the current frame from the previous one, searching from
+        // motion and leaving the last one found there; false if rejected
+        bool Reproject(int x, int y, uint32_t index, glm::vec2& motion);
+        bool IsDepthEdge(const Frame& frame, uint32_t a, uint32_t b) const;
+};
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef FRAME_ARENA_H
+#define FRAME_ARENA_H
+
+// C++ standard library
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// Linear allocator for data that lives for one frame: allocation bumps an
+// offset, Reset() at the start of the next frame releases everything at once.
+// Nothing is destroyed, so only trivially destructible types belong here.
+//
+// When a frame needs more than the block holds the extra comes from overflow
+// chunks; the next Reset() frees them and regrows the block to the frame's
+// peak, so after the first few frames the arena stops touching the heap.
+// Memory comes from malloc directly and is not counted by MemoryTracker.
+class FrameArena
+{
+    public:
+        static constexpr size_t DEFAULT_CAPACITY = 256 * 1024;
+
+        explicit FrameArena(size_t capacity = DEFAULT_CAPACITY);
+        ~FrameArena();
+
+        FrameArena(const FrameArena&) = delete;
+        FrameArena& operator=(const FrameArena&) = delete;
+
+        // Arena for the calling thread; its frame loop is responsible for Reset()
+        static FrameArena& GetThreadArena();
+
+        void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+        // Uninitialised array of count elements
+        template<typename T>
+        T* AllocateArray(size_t count)
+        {
+            static_assert(std::is_trivially_destructible<T>::value, "FrameArena never runs destructors");
+            return static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+        }
+
+        // Release everything allocated since the last reset
+        void Reset();
+
+        size_t GetCapacity() const { return capacity; }
+        size_t GetUsed() const { return used; }
+        // Most bytes used by a single frame so far
+        size_t GetPeak() const { return peak; }
+
+    private:
+        struct Overflow {
+            Overflow* next;
+        };
+
+        unsigned char* buffer = nullptr;
+        size_t capacity = 0;
+        size_t offset = 0;
+
+        // Chunks allocated after the block filled up, freed on reset
+        Overflow* overflow = nullptr;
+
+        size_t used = 0;
+        size_t peak = 0;
+
+        static uintptr_t AlignUp(uintptr_t value, size_t alignment);
+};
+
+#endif
@@ -0,0 +1,34 @@
+#pragma once
+
+// Fixed-timestep accumulator. The host feeds it variable frame times and runs
+// the returned number of simulation steps, then renders with GetAlpha() to
+// blend the previous and current simulation states.
+class FrameClock {
+public:
+    // Frame times above this are clamped, e.g. after a breakpoint or a hidden tab
+    static constexpr double MAX_FRAME_TIME = 0.25;
+
+    explicit FrameClock(double step = 1.0 / 60.0, int maxSteps = 5);
+
+    void SetStep(double step) { this->step = step > 0.0 ? step : this->step; }
+    double GetStep() const { return step; }
+
+    // Upper bound on catch-up steps per frame; time beyond it is dropped
+    void SetMaxSteps(int maxSteps) { this->maxSteps = maxSteps > 0 ? maxSteps : 1; }
+    int GetMaxSteps() const { return maxSteps; }
+
+    // Add one frame's elapsed time and return how many fixed steps to simulate
+    int Advance(double frameSeconds);
+
+    // Fraction of a step left in the accumulator, in [0, 1)
+    float GetAlpha() const { return (float)(accumulator / step); }
+
+    unsigned int GetDroppedSteps() const { return droppedSteps; }
+    void Reset() { accumulator = 0.0; }
+
+private:
+    double step;
+    double accumulator = 0.0;
+    int maxSteps;
+    unsigned int droppedSteps = 0;
+};
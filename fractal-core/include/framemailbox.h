@@ -0,0 +1,74 @@
+#pragma once
+
+// STL includes
+#include <condition_variable>
+#include <mutex>
+#include <utility>
+
+// Triple-buffered handoff between one producer and one consumer thread. The
+// producer fills the write slot while the consumer works on the read slot; the
+// third slot holds the newest published item. Slots are swapped, never copied,
+// so a slot's buffers are reused once it comes back around.
+template <typename T>
+class FrameMailbox {
+public:
+    // Producer: the slot to fill next. The consumer never sees it until Publish().
+    T& GetWriteSlot() { return slots[writeIndex]; }
+
+    // Producer: hand the write slot over. Waits while the previously published
+    // item has not been picked up, so the producer is at most one item ahead and
+    // nothing is ever dropped. Returns false once the mailbox is closed.
+    bool Publish() {
+        std::unique_lock<std::mutex> lock(mutex);
+        consumed.wait(lock, [this]() { return !bReady || bClosed; });
+        if (bClosed) {
+            return false;
+        }
+        std::swap(writeIndex, readyIndex);
+        bReady = true;
+        published.notify_one();
+        return true;
+    }
+
+    // Consumer: take the published item, waiting for one if needed. The pointer
+    // stays valid until the next Acquire(). Returns nullptr once the mailbox is
+    // closed and the last published item has been handed out.
+    T* Acquire() {
+        std::unique_lock<std::mutex> lock(mutex);
+        published.wait(lock, [this]() { return bReady || bClosed; });
+        if (!bReady) {
+            return nullptr;
+        }
+        std::swap(readIndex, readyIndex);
+        bReady = false;
+        consumed.notify_one();
+        return &slots[readIndex];
+    }
+
+    // Wake both sides and stop accepting new items
+    void Close() {
+        std::lock_guard<std::mutex> lock(mutex);
+        bClosed = true;
+        published.notify_all();
+        consumed.notify_all();
+    }
+
+    // Only valid while neither thread is using the mailbox
+    void Reset() {
+        std::lock_guard<std::mutex> lock(mutex);
+        bReady = false;
+        bClosed = false;
+    }
+
+private:
+    T slots[3];
+    int writeIndex = 0;
+    int readyIndex = 1;
+    int readIndex = 2;
+    bool bReady = false;
+    bool bClosed = false;
+
+    std::mutex mutex;
+    std::condition_variable published;
+    std::condition_variable consumed;
+};
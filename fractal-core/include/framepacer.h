@@ -0,0 +1,47 @@
+#pragma once
+
+// STL includes
+#include <chrono>
+
+// Caps the frame rate and measures frame-to-frame jitter.
+// Native hosts block in WaitForNextFrame(); browser hosts are paced by
+// requestAnimationFrame and use ShouldRunFrame() to drop callbacks early for the cap.
+class FramePacer {
+public:
+    static const int JITTER_WINDOW = 120;
+
+    // 0 runs uncapped (vsync or the browser still pace the frames)
+    void SetTargetFps(float fps) { targetFps = fps > 0.0f ? fps : 0.0f; }
+    float GetTargetFps() const { return targetFps; }
+
+    // sleep_for overshoots by up to a scheduler tick, so the last part of the wait is spun
+    void SetSpinThreshold(double seconds) { spinThreshold = seconds; }
+
+    // Blocks until the next frame slot and returns the seconds since the previous frame
+    double WaitForNextFrame();
+
+    // Host-driven frames: accumulate frameSeconds and return true with the elapsed
+    // time once a frame slot has been reached
+    bool ShouldRunFrame(double frameSeconds, double& elapsedSeconds);
+
+    // Standard deviation of the recent frame intervals
+    float GetJitterMs() const;
+    float GetAverageFrameMs() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    float targetFps = 0.0f;
+    double spinThreshold = 0.002;
+
+    bool bStarted = false;
+    Clock::time_point lastFrameStart;
+    Clock::time_point nextFrameTime;
+    double pendingSeconds = 0.0;
+
+    double intervals[JITTER_WINDOW] = {0.0};
+    int intervalCount = 0;
+    int intervalIndex = 0;
+
+    void RecordInterval(double seconds);
+};
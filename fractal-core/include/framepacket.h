@@ -0,0 +1,78 @@
+#pragma once
+
+// STL includes
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// Engine includes
+#include "light.h"
+#include "meshrenderer.h"
+#include "shadowcache.h"
+#include "fractal/deepzoom.h"
+#include "fractal/fractalparams.h"
+#include "fractal/temporalrenderer.h"
+
+// Fractal view, drawn instead of the mesh scene when enabled. The CPU backend
+// traces the image while the packet is built; the render thread only uploads it.
+struct FractalFrame {
+    FractalBackend backend = FractalBackend::None;
+    FractalView view;
+    FractalParams params;
+    RayMarchSettings settings;
+    // Temporal reprojection on the GPU backend; the CPU backend does its own in
+    // the main thread's TemporalRenderer
+    bool bTemporal = false;
+    TemporalSettings temporal;
+    // 2D perturbation deep zoom instead of the ray marched fractal, around the
+    // latest reference orbit; nothing is drawn until the first one is done
+    bool bDeepZoom = false;
+    DeepZoomView deepZoom;
+    std::shared_ptr<const ReferenceOrbit> orbit;
+
+    // CPU image, width x height RGBA8 bottom row first; storage is reused across frames
+    int width = 0;
+    int height = 0;
+    std::vector<uint32_t> pixels;
+
+    bool IsEnabled() const { return backend != FractalBackend::None; }
+};
+
+// Everything the render thread needs to draw one frame. The main thread builds
+// it from the interpolated simulation state and never touches it again after
+// publishing, so the render thread reads it without locks.
+struct FramePacket {
+    unsigned int frameIndex = 0;
+
+    // Viewport size; the render thread resizes the back buffer when it changes
+    int width = 0;
+    int height = 0;
+
+    glm::mat4 view = glm::mat4(1.0f);
+    glm::mat4 projection = glm::mat4(1.0f);
+    glm::vec3 viewPos = glm::vec3(0.0f);
+
+    // Instances that passed frustum culling, and the interpolated lights
+    std::vector<MeshInstance> instances;
+    std::vector<Light> lights;
+
+    // Shadow maps to re-render this frame and how to sample all of them
+    ShadowFrame shadows;
+
+    FractalFrame fractal;
+
+    // GL work queued by the main thread (e.g. model loads), run before drawing
+    std::vector<std::function<void()>> commands;
+
+    // Fraction of the viewport the scene is rendered at before upscaling, 1 = native.
+    // The offscreen target is sized for maxRenderScale so scale changes don't reallocate.
+    float renderScale = 1.0f;
+    float maxRenderScale = 1.0f;
+    float sharpness = 0.0f;
+
+    // Read back this frame into the configured capture path before presenting
+    bool bCapture = false;
+};
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+// View frustum as six inward-facing planes (xyz = normal, w = distance),
+// extracted from a combined projection * view matrix.
+class Frustum {
+public:
+    enum Plane {
+        Left = 0,
+        Right,
+        Bottom,
+        Top,
+        Near,
+        Far,
+        PLANE_COUNT
+    };
+
+    Frustum();
+    explicit Frustum(const glm::mat4& viewProjection);
+
+    void ExtractFromMatrix(const glm::mat4& viewProjection);
+
+    bool ContainsPoint(const glm::vec3& point) const;
+    bool IntersectsSphere(const glm::vec3& center, float radius) const;
+    bool IntersectsAABB(const glm::vec3& min, const glm::vec3& max) const;
+
+    const glm::vec4& GetPlane(Plane plane) const { return planes[plane]; }
+
+private:
+    glm::vec4 planes[PLANE_COUNT];
+};
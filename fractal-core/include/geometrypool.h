@@ -0,0 +1,182 @@
+#ifndef GEOMETRY_POOL_H
+#define GEOMETRY_POOL_H
+
+// C++ standard library
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// glm
+#include <glm/glm.hpp>
+
+// gl header
+#include "glreq.h"
+
+// local headers
+#include "objectpool.h"
+#include "streambuffer.h"
+#include "tlsfallocator.h"
+
+// mesh.h includes this header
+struct Vertex;
+
+// A mesh's storage in the pool; stays valid while its data moves around
+typedef uint32_t GeometryHandle;
+
+// Where a mesh currently lives inside the pool's shared buffers
+struct GeometryRange {
+    GLint baseVertex = 0;
+    GLuint firstIndex = 0;
+    GLsizei indexCount = 0;
+    GLsizei vertexCount = 0;
+
+    bool IsValid() const { return indexCount > 0; }
+};
+
+// One mesh's share of a batch: instanceCount instances starting at
+// baseInstance in the batch's instance data
+struct GeometryDraw {
+    GeometryRange range;
+    GLuint instanceCount = 0;
+    GLuint baseInstance = 0;
+};
+
+// Per-instance vertex attributes for pooled draws, attribute locations
+// INSTANCE_ATTRIBUTE_LOCATION onwards (see USE_INSTANCE_ATTRIBUTES in pbr.vert)
+struct InstanceVertex {
+    glm::mat4 model;
+    glm::vec3 normalMatrix[3];
+    glm::vec4 albedoMetallic;
+    glm::vec2 roughnessAo;
+};
+
+struct GeometryPoolStats {
+    unsigned int meshes = 0;
+    unsigned int vertexCapacity = 0;
+    unsigned int vertexUsed = 0;
+    unsigned int indexCapacity = 0;
+    unsigned int indexUsed = 0;
+    // Share of the arenas' bytes in use
+    float occupancy = 0.0f;
+    // 1 - largest free block / free space, of the worse arena
+    float fragmentation = 0.0f;
+    // Times an arena ran out of room and was reallocated
+    unsigned int grows = 0;
+    // Defragmentation moves and the bytes they copied
+    unsigned int moves = 0;
+    uint64_t movedBytes = 0;
+};
+
+// Shared vertex and index buffers for every mesh, under a single VAO. Each
+// buffer is an arena carved up by a TlsfAllocator, so loading and unloading
+// models costs a suballocation instead of a GL buffer each, and with batching
+// on a set of different meshes is one multi-draw instead of a VAO switch and a
+// draw call per mesh.
+//
+// Freed space is compacted incrementally: Defragment() moves the arena's last
+// allocation into a lower hole with glCopyBufferSubData, a byte budget's worth
+// per frame. GL orders the copy after the draws already submitted, so nothing
+// has to wait on the GPU.
+//
+// Native GL 4.3 / ARB_multi_draw_indirect: one glMultiDrawElementsIndirect per
+// batch, commands streamed through the StreamBuffer. The web uses
+// WEBGL_multi_draw_instanced_base_vertex_base_instance the same way. Without
+// multi-draw each mesh is still drawn from the shared VAO, one instanced draw
+// per mesh; without base vertex support (plain WebGL2) indices are rebased on
+// upload instead.
+class GeometryPool
+{
+    public:
+        static constexpr GLuint INSTANCE_ATTRIBUTE_LOCATION = 5;
+        static constexpr size_t DEFAULT_VERTEX_CAPACITY = 1 << 18;
+        static constexpr size_t DEFAULT_INDEX_CAPACITY = 1 << 20;
+        static constexpr size_t DEFAULT_DEFRAGMENT_BUDGET = 1 << 20;
+        static constexpr GeometryHandle INVALID_HANDLE = 0xFFFFFFFFu;
+
+        // Shared by every mesh; only touch it from the thread owning the GL context
+        static GeometryPool* GetInstance();
+
+        GeometryPool();
+        ~GeometryPool();
+
+        GeometryPool(const GeometryPool&) = delete;
+        GeometryPool& operator=(const GeometryPool&) = delete;
+
+        // Batch pooled meshes into multi-draws with instance attributes. Without
+        // it pooled meshes still share the buffers but draw one instance at a time.
+        void SetBatching(bool bEnabled) { bBatching = bEnabled; }
+        bool IsBatching() const { return bBatching; }
+
+        // Upload a mesh, growing the arenas as needed. INVALID_HANDLE on failure.
+        GeometryHandle Add(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices);
+        void Remove(GeometryHandle handle);
+        GeometryRange GetRange(GeometryHandle handle) const;
+
+        // Move allocations down into free holes, copying at most maxBytes this
+        // call (at least one allocation if any can move). Call once per frame.
+        void Defragment(size_t maxBytes = DEFAULT_DEFRAGMENT_BUDGET);
+        // Defragment until nothing can move
+        void Compact();
+
+        // Plain draw of one range, for callers without instance data
+        void Draw(const GeometryRange& range);
+
+        // Draw every entry with its instances taken from instanceData, an
+        // array of InstanceVertex in the stream buffer
+        void DrawBatch(const GeometryDraw* draws, size_t drawCount, const StreamAllocation& instanceData);
+
+        bool HasMultiDraw() const { return bMultiDraw; }
+        GeometryPoolStats GetStats() const;
+
+    private:
+        // Matches the DrawElementsIndirectCommand layout
+        struct IndirectCommand {
+            GLuint count;
+            GLuint instanceCount;
+            GLuint firstIndex;
+            GLint baseVertex;
+            GLuint baseInstance;
+        };
+
+        // One mesh: its blocks in the vertex and index arenas
+        struct Entry {
+            uint32_t vertexBlock = TlsfAllocator::INVALID;
+            uint32_t indexBlock = TlsfAllocator::INVALID;
+        };
+
+        static GeometryPool* instance;
+
+        bool bBatching = false;
+        bool bCreated = false;
+
+        GLuint vao = 0;
+        GLuint vbo = 0;
+        GLuint ebo = 0;
+        TlsfAllocator vertexArena;
+        TlsfAllocator indexArena;
+
+        ObjectPool<Entry> entries;
+        unsigned int grows = 0;
+        unsigned int moves = 0;
+        uint64_t movedBytes = 0;
+
+        // Capabilities, detected on first use
+        bool bMultiDraw = false;
+        bool bBaseInstance = false;
+        bool bBaseVertex = false;
+
+        bool bInstanceAttributesEnabled = false;
+
+        std::vector<unsigned int> rebasedIndices;
+
+        void Create();
+        void DetectCapabilities();
+        void Reserve(size_t vertices, size_t indices);
+        uint32_t AllocateBlock(TlsfAllocator& arena, uint32_t size, bool bVertices);
+        size_t MoveLastBlock(TlsfAllocator& arena, bool bVertices);
+        void PublishStats() const;
+        void SetupVertexAttributes();
+        void PointInstanceAttributes(GLuint buffer, GLintptr offset);
+};
+
+#endif
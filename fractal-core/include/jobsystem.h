@@ -0,0 +1,118 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+// C++ standard library
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Jobs still running from one submission; Wait() on it to join them
+struct JobCounter {
+    std::atomic<uint32_t> pending{0};
+
+    bool IsDone() const { return pending.load(std::memory_order_acquire) == 0; }
+};
+
+// Work-stealing thread pool for CPU-heavy frame work (the fractal ray marcher).
+// Each worker owns a queue it pops newest-first, so nested jobs stay cache warm;
+// idle workers steal the oldest job from someone else's queue, which is the
+// largest chunk of work left. Threads outside the pool share one extra queue and
+// run jobs themselves while they Wait(), so the caller is never just blocked.
+//
+// Jobs are a function pointer, a context and an index range: submitting doesn't
+// allocate once the queues have grown to the frame's peak.
+//
+// The web build without pthreads has no workers and runs every job inside Wait().
+class JobSystem
+{
+    public:
+        // Processes items [begin, end) of the submission
+        typedef void (*JobFunction)(void* context, size_t begin, size_t end);
+
+        static JobSystem* GetInstance();
+
+        JobSystem();
+        ~JobSystem();
+
+        JobSystem(const JobSystem&) = delete;
+        JobSystem& operator=(const JobSystem&) = delete;
+
+        // Spawn the workers, by default one per hardware thread besides the caller.
+        // Call with no jobs in flight; restarting replaces the previous workers.
+        void Start(int workerCount = -1);
+        void Stop();
+        int GetWorkerCount() const { return (int)workers.size(); }
+        // Threads that take part in a Wait(): the workers and the caller
+        int GetConcurrency() const { return GetWorkerCount() + 1; }
+
+        // Queue function over [0, count) in jobs of at most grain items
+        void Submit(JobFunction function, void* context, size_t count, size_t grain, JobCounter& counter);
+        // Run queued jobs on the calling thread until the counter's jobs are done
+        void Wait(JobCounter& counter);
+
+        // body(i) for every i in [0, count), returning when all have run. The
+        // body is only referenced, never copied, so lambdas capture freely.
+        template<typename F>
+        void ParallelFor(size_t count, size_t grain, const F& body)
+        {
+            JobCounter counter;
+            Submit(&InvokeRange<F>, const_cast<F*>(&body), count, grain, counter);
+            Wait(counter);
+        }
+
+    private:
+        struct Job {
+            JobFunction function;
+            void* context;
+            size_t begin;
+            size_t end;
+            JobCounter* counter;
+        };
+
+        // Ring of jobs; the owner takes from the back, thieves from the front
+        struct WorkQueue {
+            std::mutex mutex;
+            std::vector<Job> ring;
+            size_t head = 0;
+            size_t count = 0;
+
+            void Push(const Job& job);
+            bool PopBack(Job& job);
+            bool PopFront(Job& job);
+        };
+
+        static constexpr size_t INITIAL_QUEUE_CAPACITY = 256;
+
+        // One queue per worker, then the queue shared by outside threads
+        std::vector<std::unique_ptr<WorkQueue>> queues;
+        std::vector<std::thread> workers;
+        std::atomic<bool> bRunning{false};
+        // Spreads outside submissions over the worker queues
+        std::atomic<uint32_t> nextQueue{0};
+
+        // Idle workers sleep until something is queued
+        std::atomic<int> queuedJobs{0};
+        std::mutex sleepMutex;
+        std::condition_variable wakeCondition;
+
+        template<typename F>
+        static void InvokeRange(void* context, size_t begin, size_t end)
+        {
+            const F& body = *static_cast<const F*>(context);
+            for (size_t i = begin; i < end; i++) {
+                body(i);
+            }
+        }
+
+        size_t GetOwnQueue() const;
+        bool TakeJob(size_t ownQueue, Job& job);
+        static void Execute(const Job& job);
+        void WorkerMain(int index);
+};
+
+#endif
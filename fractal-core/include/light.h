@@ -28,6 +28,9 @@ public:
     void setIntensity(float intensity);
     void setRange(float range);
     void setType(Type type);
+    // Spot lights: full cone angle in degrees
+    void setSpotAngle(float degrees);
+    void setCastsShadows(bool bCastsShadows);
     
     // Getters
     glm::vec3 getPosition() const;
@@ -36,6 +39,8 @@ public:
     float getIntensity() const;
     float getRange() const;
     Type getType() const;
+    float getSpotAngle() const;
+    bool getCastsShadows() const;
 
 private:
     Type m_type;
@@ -44,4 +49,6 @@ private:
     glm::vec3 m_color;
     float m_intensity;
     float m_range;
+    float m_spotAngle = 45.0f;
+    bool m_bCastsShadows = true;
 }; 
\ No newline at end of file
@@ -1,7 +1,10 @@
 #ifndef LIGHTRENDERER_H
 #define LIGHTRENDERER_H
 
+#include <vector>
+
 #include "light.h"
+#include "frustum.h"
 #include "shaderprogram.h"
 #include "glreq.h"
 
@@ -11,9 +14,19 @@ public:
     LightRenderer();
     ~LightRenderer();
 
+    // Draws every light gizmo inside the view frustum with a single instanced draw
     void Render(const std::vector<Light>& lights, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix);
 
+    unsigned int GetVisibleLightCount() const { return (unsigned int)instances.size(); }
+
 private:
+    // Per-instance vertex data, one entry per visible light
+    struct LightInstance {
+        glm::vec3 position;
+        glm::vec3 color;
+        float intensity;
+    };
+
     GLuint VAO;
     GLuint VBO;
     GLuint EBO;
@@ -21,8 +34,18 @@ private:
     GLuint numVertices;
     GLuint numIndices;
 
+    // Visible lights this frame, streamed through the shared StreamBuffer
+    std::vector<LightInstance> instances;
+    float gizmoRadius = 0.3f;
+
     ShaderProgram* shader;
+    GLint viewLocation = -1;
+    GLint projectionLocation = -1;
+    bool bLocationsCached = false;
+
+    Frustum frustum;
+
     void Init();
 };
 
-#endif
\ No newline at end of file
+#endif
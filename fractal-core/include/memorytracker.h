@@ -0,0 +1,68 @@
+#ifndef MEMORY_TRACKER_H
+#define MEMORY_TRACKER_H
+
+// C++ standard library
+#include <cstddef>
+#include <cstdint>
+
+// Subsystem a heap allocation is charged to. A thread's current tag is set
+// with MEMORY_SCOPE and applies to every operator new on that thread until the
+// scope ends.
+enum class MemoryTag : uint8_t {
+    Untagged,
+    Simulation,     // Engine::Update and the fixed step loop
+    FramePacket,    // building the packet handed to the render thread
+    Render,         // executing a packet
+    Assets,         // model, texture and shader loading
+    Count
+};
+
+const char* MemoryTagToString(MemoryTag tag);
+
+// Counts heap allocations per frame per tag. The global operator new and
+// delete are replaced (memorytracker.cpp) so every allocation in the process
+// is seen, including those inside the standard library. Counting is a relaxed
+// atomic add, cheap enough to leave on in release builds.
+class MemoryTracker
+{
+    public:
+        // Close the frame: the running counts become the last frame's and
+        // start again from zero. Called once per frame by the profiler.
+        static void EndFrame();
+
+        // Counts for the last completed frame
+        static uint64_t GetFrameAllocations(MemoryTag tag);
+        static uint64_t GetFrameBytes(MemoryTag tag);
+        static uint64_t GetFrameAllocations();
+        static uint64_t GetFrameBytes();
+
+        // Since startup
+        static uint64_t GetTotalAllocations();
+
+        static MemoryTag GetCurrentTag();
+        static void SetCurrentTag(MemoryTag tag);
+
+        // Called by the operator new replacements
+        static void RecordAllocation(size_t size);
+};
+
+// Tags the current thread's allocations for the lifetime of the scope,
+// restoring the previous tag afterwards so scopes nest
+class MemoryScope
+{
+    public:
+        explicit MemoryScope(MemoryTag tag) : previous(MemoryTracker::GetCurrentTag()) { MemoryTracker::SetCurrentTag(tag); }
+        ~MemoryScope() { MemoryTracker::SetCurrentTag(previous); }
+
+        MemoryScope(const MemoryScope&) = delete;
+        MemoryScope& operator=(const MemoryScope&) = delete;
+
+    private:
+        MemoryTag previous;
+};
+
+#define MEMORY_SCOPE_CONCAT_INNER(a, b) a##b
+#define MEMORY_SCOPE_CONCAT(a, b) MEMORY_SCOPE_CONCAT_INNER(a, b)
+#define MEMORY_SCOPE(tag) MemoryScope MEMORY_SCOPE_CONCAT(memoryScope_, __LINE__)(tag)
+
+#endif
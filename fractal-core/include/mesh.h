@@ -11,6 +11,7 @@
 
 #include "assetutils.h"
 #include "Texture.h"
+#include "geometrypool.h"
 
 struct Vertex {
     glm::vec3 position;
@@ -25,6 +26,8 @@ class Mesh {
     friend class MeshRenderer;
 public:
     Mesh(const std::string& filename);
+    // Geometry built in code, such as an extracted fractal surface; untextured
+    Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices);
     ~Mesh();
 
     // Mesh data
@@ -38,16 +41,28 @@ public:
     float roughness;
     float ao;
 
+    // Local-space bounding sphere, used for culling instances
+    glm::vec3 boundsCenter = glm::vec3(0.0f);
+    float boundsRadius = 0.0f;
+
     // Rendering
     void Draw() const;
+
+    // Storage comes from the shared GeometryPool arenas; a mesh only owns a
+    // VAO if the pool had no room for it
+    bool IsPooled() const { return poolHandle != GeometryPool::INVALID_HANDLE; }
+    // Current location in the pool, which changes as the pool defragments
+    GeometryRange GetPoolRange() const { return GeometryPool::GetInstance()->GetRange(poolHandle); }
     
 private:
     // OpenGL objects
-    unsigned int VAO, VBO, EBO;
+    unsigned int VAO = 0, VBO = 0, EBO = 0;
+    GeometryHandle poolHandle = GeometryPool::INVALID_HANDLE;
     unsigned int textureIndex[(unsigned long)TextureType::MAX_TEXTURE_TYPES] = {0};
     
     // Setup functions
     void SetupMesh();
+    void ComputeBounds();
     void ProcessNode(aiNode* node, const aiScene* scene);
     void ProcessMesh(aiMesh* mesh, const aiScene* scene);
     
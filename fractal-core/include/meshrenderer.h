@@ -2,23 +2,38 @@
 
 #include <vector>
 #include <memory>
+#include <unordered_map>
 #include <glm/glm.hpp>
 #include "mesh.h"
 #include "light.h"
 #include "shaderprogram.h"
+#include "shadervariantcache.h"
+#include "streambuffer.h"
 
 struct MeshInstance {
     glm::mat4 transform;
+    // transpose(inverse(mat3(transform))), kept in sync by MeshRenderer so the
+    // vertex shader doesn't have to invert the model matrix per vertex
+    glm::mat3 normalMatrix;
     glm::vec3 albedo;
     float metallic;
     float roughness;
     float ao;
+    // Mesh to draw, null for the renderer's mesh
+    Mesh* mesh = nullptr;
     
-    MeshInstance() : transform(1.0f), albedo(0.5f, 0.0f, 0.5f), metallic(0.0f), roughness(0.5f), ao(1.0f) {}
+    MeshInstance() : transform(1.0f), normalMatrix(1.0f), albedo(0.5f, 0.0f, 0.5f), metallic(0.0f), roughness(0.5f), ao(1.0f) {}
 };
 
+// shadowcache.h includes this header
+struct ShadowSampling;
+
 class MeshRenderer {
 public:
+    // Default light count; larger sets pick a NUM_LIGHTS variant of 8, 16 or MAX_LIGHTS
+    static constexpr int NUM_LIGHTS = 4;
+    static constexpr int MAX_LIGHTS = 32;
+
     MeshRenderer();
     ~MeshRenderer();
 
@@ -31,31 +46,124 @@ public:
     void SetTransform(long unsigned int instanceIndex, const glm::mat4& transform);
     void SetMaterial(long unsigned int instanceIndex, const glm::vec3& albedo, float metallic, float roughness, float ao);
     
-    // Light management
+    // Light management. A light count in another bucket compiles that bucket's
+    // variants in the background; until they are ready the current ones go on
+    // drawing the first lights that fit.
     void SetLights(const std::vector<Light>& lights);
     void SetLight(int index, const Light& light);
     
+    const std::vector<MeshInstance>& GetInstances() const { return m_instances; }
+    Mesh* GetMesh() const { return m_mesh; }
+    // Bumped whenever instances are added or cleared
+    uint64_t GetInstanceVersion() const { return m_instanceVersion; }
+    // Instances whose transform changed since the last ClearMovedInstances()
+    const std::vector<size_t>& GetMovedInstances() const { return m_movedInstances; }
+    void ClearMovedInstances() { m_movedInstances.clear(); }
+
+    // Shadows: EnableShadows before LoadShaders so the shadowed variants are
+    // warmed up; SetShadows each frame with the maps to sample (null for none)
+    void EnableShadows(bool bEnabled) { m_bShadowsEnabled = bEnabled; }
+    void SetShadows(const ShadowSampling* sampling, GLuint shadowTexture);
+    
     // Rendering
     void Render(const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix, const glm::vec3& viewPos);
+    // Draw an explicit instance list, e.g. the visible set from a frame packet.
+    // Instances are batched by shader variant and texture set; with GeometryPool
+    // batching on a batch goes out as one multi-draw, otherwise one draw per instance.
+    void Render(const std::vector<MeshInstance>& instances, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix, const glm::vec3& viewPos);
     
     // Shader management
     bool LoadShaders(const std::string& vertexPath, const std::string& fragmentPath);
     void UseShader();
 
+    // Feature defines for the pbr variant matching a mesh's bound textures and storage
+    static ShaderDefines GetMeshDefines(const Mesh* mesh, int lightCount = NUM_LIGHTS, bool bShadows = false);
+    // Shader light count used for a given number of scene lights
+    static int GetLightBucket(size_t lightCount);
+
 private:
+    // Uniform block binding points, see pbr.vert
+    static constexpr GLuint FRAME_DATA_BINDING = 0;
+    static constexpr GLuint INSTANCE_DATA_BINDING = 1;
+    static constexpr GLuint SHADOW_DATA_BINDING = 2;
+    // Texture unit of the shadow map array, after the material maps
+    static constexpr GLint SHADOW_MAP_UNIT = 5;
+
+    // std140 mirrors of the FrameData header and InstanceData blocks
+    struct FrameBlockHeader {
+        glm::mat4 view;
+        glm::mat4 projection;
+        glm::vec4 viewPos;
+    };
+    struct InstanceBlock {
+        glm::mat4 model;
+        glm::vec4 normalMatrix[3];  // mat3 columns are padded to vec4
+        glm::vec4 albedoMetallic;
+        glm::vec4 roughnessAo;
+    };
+
+    // Instances sharing a shader variant and texture set, [begin, end) in m_sortedInstances
+    struct Batch {
+        size_t begin;
+        size_t end;
+        const Mesh* material;
+    };
+
     bool bFirstRender = true;
-    // Shader program
-    ShaderProgram m_shaderProgram;
+    // Shader variants, one per combination of bound texture maps
+    std::unique_ptr<ShaderVariantCache> m_shaderVariants;
+    ShaderProgram* m_activeShader = nullptr;
+    std::vector<ShaderProgram*> m_blocksBoundShaders;
+    // Variant per GetVariantKey(), so batches don't rebuild define strings every frame
+    std::unordered_map<uint32_t, ShaderProgram*> m_variantLookup;
+
+    // Per-frame scratch in the render thread's FrameArena, valid during Render()
+    const MeshInstance** m_sortedInstances = nullptr;
+    size_t m_sortedCount = 0;
+    Batch* m_batches = nullptr;
+    size_t m_batchCount = 0;
     
     // Mesh and instances
-    Mesh* m_mesh;
+    Mesh* m_mesh = nullptr;
     std::vector<MeshInstance> m_instances;
     
-    // Lights
+    // Lights, padded with black lights up to the larger of the two light counts
     std::vector<Light> m_lights;
+    // Light count of the variants drawing now, and of the ones SetLights asked for,
+    // which differ while m_requestedVariants compile
+    int m_lightCount = NUM_LIGHTS;
+    int m_requestedLightCount = NUM_LIGHTS;
+    std::vector<ShaderProgram*> m_requestedVariants;
+
+    // Instance changes the shadow cache needs to hear about
+    uint64_t m_instanceVersion = 0;
+    std::vector<size_t> m_movedInstances;
+
+    // Shadow maps for the current frame, valid until the next SetShadows
+    bool m_bShadowsEnabled = false;
+    const ShadowSampling* m_shadowSampling = nullptr;
+    GLuint m_shadowTexture = 0;
     
-    // Uniform setters
-    void SetMaterialUniforms(const MeshInstance& instance);
-    void SetLightUniforms();
-    void SetMatrixUniforms(const glm::mat4& model, const glm::mat4& view, const glm::mat4& projection);
+    void SelectShaderVariant();
+    ShaderProgram* GetVariant(const Mesh* mesh);
+    // Submits the variants in use again with m_requestedLightCount lights
+    void SubmitLightVariants();
+    // Switches to m_requestedLightCount once its variants are ready
+    void UpdateLightCount();
+    static uint32_t GetVariantKey(const Mesh* mesh, int lightCount, bool bShadows);
+    bool IsShadowing() const { return m_bShadowsEnabled && m_shadowSampling && m_shadowTexture; }
+
+    const Mesh* MeshOf(const MeshInstance& instance) const { return instance.mesh ? instance.mesh : m_mesh; }
+    void BuildBatches(const std::vector<MeshInstance>& instances);
+    void BindTextures(ShaderProgram* shader, const Mesh* mesh);
+    void DrawPooled(const Batch& batch);
+    void DrawWithInstanceBlocks(const Batch& batch);
+    static bool SameMaterial(const Mesh* a, const Mesh* b);
+    static void WriteInstanceVertex(const MeshInstance& instance, unsigned char* destination);
+
+    // Uniform blocks, streamed through the shared StreamBuffer
+    void BindUniformBlocks(ShaderProgram* shader);
+    StreamAllocation WriteFrameBlock(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& viewPos);
+    static void WriteInstanceBlock(const MeshInstance& instance, unsigned char* destination);
+    static size_t AlignUp(size_t value, size_t alignment);
 }; 
\ No newline at end of file
@@ -0,0 +1,87 @@
+#ifndef OBJECT_POOL_H
+#define OBJECT_POOL_H
+
+// C++ standard library
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Slots of T addressed by a stable index. Destroyed slots go on a free list
+// and are handed out again by Create, so once the pool has grown to its
+// working size creating and destroying objects never touches the heap.
+// Handles are plain indices: they stay valid across growth but a destroyed
+// handle may come back as a different object.
+template<typename T>
+class ObjectPool
+{
+    public:
+        typedef uint32_t Handle;
+        static constexpr Handle INVALID = 0xFFFFFFFFu;
+
+        Handle Create(const T& value = T())
+        {
+            Handle handle;
+            if (!freeSlots.empty()) {
+                handle = freeSlots.back();
+                freeSlots.pop_back();
+                items[handle] = value;
+            }
+            else {
+                handle = (Handle)items.size();
+                items.push_back(value);
+                alive.push_back(false);
+                // Keep room for every slot on the free list so Destroy never allocates
+                if (freeSlots.capacity() < items.capacity()) {
+                    freeSlots.reserve(items.capacity());
+                }
+            }
+            alive[handle] = true;
+            liveCount++;
+            return handle;
+        }
+
+        void Destroy(Handle handle)
+        {
+            if (!IsAlive(handle)) {
+                return;
+            }
+            // Reset so the slot doesn't hold on to resources while unused
+            items[handle] = T();
+            alive[handle] = false;
+            freeSlots.push_back(handle);
+            liveCount--;
+        }
+
+        bool IsAlive(Handle handle) const { return handle < items.size() && alive[handle]; }
+
+        T& operator[](Handle handle) { return items[handle]; }
+        const T& operator[](Handle handle) const { return items[handle]; }
+
+        void Reserve(size_t count)
+        {
+            items.reserve(count);
+            alive.reserve(count);
+            freeSlots.reserve(count);
+        }
+
+        // Destroy everything; capacity is kept
+        void Clear()
+        {
+            items.clear();
+            alive.clear();
+            freeSlots.clear();
+            liveCount = 0;
+        }
+
+        // Live objects, and slots including destroyed ones
+        size_t GetSize() const { return liveCount; }
+        size_t GetSlotCount() const { return items.size(); }
+
+    private:
+        std::vector<T> items;
+        std::vector<bool> alive;
+        std::vector<Handle> freeSlots;
+        size_t liveCount = 0;
+};
+
+#endif
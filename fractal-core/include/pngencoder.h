@@ -0,0 +1,14 @@
+#ifndef PNG_ENCODER_H
+#define PNG_ENCODER_H
+
+// C++ standard library
+#include <cstdint>
+#include <vector>
+
+// Encodes RGBA8 pixels, bottom row first like every readback here, into an 8-bit
+// RGB PNG; alpha is dropped. Each row gets whichever of the five PNG filters
+// leaves the smallest residuals, then zlib deflates the lot at level (0 to 9).
+// False only if zlib fails.
+bool EncodePng(const uint32_t* pixels, int width, int height, std::vector<uint8_t>& png, int level = 6);
+
+#endif
@@ -0,0 +1,274 @@
+#pragma once
+
+// STL includes
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// gl header
+#include "glreq.h"
+
+// Per-frame counters, bumped from wherever GL work is issued
+enum class ProfileCounter {
+    DrawCalls,
+    Triangles,
+    StateChanges,
+    BufferUploads,
+    UploadBytes,
+    DefragmentBytes,
+    ShadowUpdates,
+    MAX_PROFILE_COUNTERS
+};
+
+const char* ProfileCounterToString(ProfileCounter counter);
+
+// Levels rather than per-frame totals; each frame reports the latest value
+enum class ProfileGauge {
+    GeometryOccupancy,
+    GeometryFragmentation,
+    CpuMraysPerSecond,
+    FractalCompletion,
+    MAX_PROFILE_GAUGES
+};
+
+const char* ProfileGaugeToString(ProfileGauge gauge);
+
+// One completed CPU zone
+struct ProfileEvent {
+    const char* name = nullptr;   // must be a string literal or otherwise outlive the profiler
+    uint64_t startNs = 0;
+    uint64_t endNs = 0;
+    uint32_t depth = 0;
+};
+
+// Aggregated time of all zones sharing a name within one frame
+struct ProfileZoneStat {
+    std::string name;
+    float cpuMs = 0.0f;
+    float gpuMs = 0.0f;
+    unsigned int calls = 0;
+};
+
+// Summary of the last completed frame, read by the React UI through embind.
+// GPU times lag the CPU by GPU_LATENCY frames so reading them never stalls.
+struct ProfileFrameSummary {
+    unsigned int frameIndex = 0;
+    float cpuFrameMs = 0.0f;
+    unsigned int gpuFrameIndex = 0;
+    float gpuFrameMs = 0.0f;
+    unsigned int drawCalls = 0;
+    unsigned int triangles = 0;
+    unsigned int stateChanges = 0;
+    unsigned int bufferUploads = 0;
+    unsigned int uploadBytes = 0;
+    unsigned int defragmentBytes = 0;
+    // Shadow map layers re-rendered; the rest were sampled from cache
+    unsigned int shadowUpdates = 0;
+    // GeometryPool arenas: share of bytes in use, and how splintered the free space is
+    float geometryOccupancy = 0.0f;
+    float geometryFragmentation = 0.0f;
+    // Throughput of the last CPU fractal frame, millions of primary rays per second
+    float cpuMraysPerSecond = 0.0f;
+    // Progressive fractal refinement, 0 to 1
+    float fractalCompletion = 0.0f;
+    // Heap allocations and bytes over the frame, all MemoryTracker tags
+    unsigned int heapAllocations = 0;
+    unsigned int heapBytes = 0;
+};
+
+class Profiler {
+public:
+    static const unsigned int GPU_LATENCY = 4;
+    static const unsigned int MAX_GPU_ZONES_PER_FRAME = 32;
+    static const unsigned int MAX_ZONE_STATS = 64;
+
+    static Profiler* GetInstance();
+
+    Profiler();
+    ~Profiler();
+
+    void SetEnabled(bool bEnabled) { this->bEnabled = bEnabled; }
+    bool IsEnabled() const { return bEnabled; }
+
+    // Frame boundaries, called from the thread that drives the frame
+    void BeginFrame();
+    void EndFrame();
+    unsigned int GetFrameIndex() const { return frameIndex; }
+
+    // GPU query frames normally follow BeginFrame(). When GL is driven from a
+    // separate render thread, that thread calls BeginGpuFrame() per submitted
+    // frame instead, tagging the results with the CPU frame they came from.
+    void SetExternalGpuFrames(bool bExternal) { bExternalGpuFrames = bExternal; }
+    // False until the first GPU zone, and on WebGL without EXT_disjoint_timer_query_webgl2
+    bool HasGpuTimers() const { return bGpuInitialized && bGpuTimersSupported; }
+    void BeginGpuFrame(unsigned int cpuFrameIndex);
+    // Deletes the query objects while their context is still current. The next
+    // GPU zone creates them again, in whatever context is current then.
+    void ShutdownGpuTimers();
+
+    // CPU zones, normally used through PROFILE_ZONE
+    void BeginZone(const char* name);
+    void EndZone();
+    void SetThreadName(const char* name);
+
+    // GPU zones (GL_TIME_ELAPSED queries), normally used through PROFILE_GPU_ZONE.
+    // The query type cannot nest, so a GPU zone opened inside another is ignored
+    // and the outer one's query runs on until that zone ends.
+    void BeginGpuZone(const char* name);
+    void EndGpuZone();
+    // GPU zones open on the GL thread, nested ones included
+    unsigned int GetGpuZoneDepth() const { return gpuZoneDepth; }
+
+    // Counters, cheap enough to call per draw
+    static void Count(ProfileCounter counter, uint64_t amount = 1) {
+        counters[(int)counter].fetch_add(amount, std::memory_order_relaxed);
+    }
+    static void CountDraw(uint64_t triangles) {
+        Count(ProfileCounter::DrawCalls);
+        Count(ProfileCounter::Triangles, triangles);
+    }
+    static void CountUpload(uint64_t bytes) {
+        Count(ProfileCounter::BufferUploads);
+        Count(ProfileCounter::UploadBytes, bytes);
+    }
+    static void SetGauge(ProfileGauge gauge, float value) {
+        gauges[(int)gauge].store(value, std::memory_order_relaxed);
+    }
+
+    // Results
+    const ProfileFrameSummary& GetFrameSummary() const { return summary; }
+    std::vector<ProfileZoneStat> GetZoneStats() const;
+    uint64_t GetCounterTotal(ProfileCounter counter) const { return counterTotals[(int)counter]; }
+
+    // Chrome/Perfetto trace capture (chrome://tracing, ui.perfetto.dev)
+    void StartCapture(size_t maxEvents = 1 << 20);
+    void StopCapture();
+    bool IsCapturing() const { return bCapturing; }
+    std::string GetTraceJson() const;
+    bool WriteTrace(const std::string& path) const;
+
+private:
+    // Lock-free single-producer/single-consumer ring, one per thread. The owning
+    // thread pushes completed zones, EndFrame() drains them on the frame thread.
+    struct ThreadData {
+        static const uint32_t CAPACITY = 4096;
+
+        ProfileEvent events[CAPACITY];
+        std::atomic<uint32_t> head{0};
+        std::atomic<uint32_t> tail{0};
+        std::atomic<uint32_t> dropped{0};
+
+        // Open zones, only touched by the owning thread
+        ProfileEvent stack[64];
+        uint32_t depth = 0;
+
+        uint32_t threadId = 0;
+        std::string threadName;
+
+        bool Push(const ProfileEvent& event);
+    };
+
+    struct GpuQuery {
+        const char* name = nullptr;
+        GLuint queryId = 0;
+        uint64_t cpuStartNs = 0;
+    };
+
+    struct GpuFrame {
+        unsigned int frameIndex = 0;
+        unsigned int queryCount = 0;
+        GpuQuery queries[MAX_GPU_ZONES_PER_FRAME];
+    };
+
+    struct ZoneAccumulator {
+        const char* name = nullptr;
+        double cpuMs = 0.0;
+        double gpuMs = 0.0;
+        unsigned int calls = 0;
+    };
+
+    struct TraceEvent {
+        const char* name;
+        uint64_t startNs;
+        uint64_t durationNs;
+        uint32_t threadId;
+    };
+
+    struct TraceCounter {
+        uint64_t timeNs;
+        uint64_t values[(int)ProfileCounter::MAX_PROFILE_COUNTERS];
+        float gaugeValues[(int)ProfileGauge::MAX_PROFILE_GAUGES];
+    };
+
+    static Profiler* instance;
+    static std::atomic<uint64_t> counters[(int)ProfileCounter::MAX_PROFILE_COUNTERS];
+    static std::atomic<float> gauges[(int)ProfileGauge::MAX_PROFILE_GAUGES];
+    static const uint32_t GPU_THREAD_ID = 0xFFFF;
+
+    bool bEnabled = true;
+    unsigned int frameIndex = 0;
+    uint64_t frameStartNs = 0;
+
+    // Thread registration, and results written by a separate GL thread
+    mutable std::mutex threadsMutex;
+    std::vector<std::unique_ptr<ThreadData>> threads;
+
+    // GPU timers
+    bool bGpuInitialized = false;
+    bool bGpuTimersSupported = false;
+    // The outermost zone's query is running
+    bool bGpuZoneOpen = false;
+    unsigned int gpuZoneDepth = 0;
+    bool bExternalGpuFrames = false;
+    GpuFrame gpuFrames[GPU_LATENCY];
+    unsigned int gpuFrameCounter = 0;
+    unsigned int currentGpuFrame = 0;
+    unsigned int resolvedGpuFrameIndex = 0;
+    float resolvedGpuFrameMs = 0.0f;
+
+    // Summaries
+    ProfileFrameSummary summary;
+    ZoneAccumulator zones[MAX_ZONE_STATS];
+    unsigned int zoneCount = 0;
+    ZoneAccumulator gpuZones[MAX_ZONE_STATS];
+    unsigned int gpuZoneCount = 0;
+    uint64_t counterTotals[(int)ProfileCounter::MAX_PROFILE_COUNTERS] = {0};
+
+    // Capture
+    bool bCapturing = false;
+    size_t maxCapturedEvents = 0;
+    std::vector<TraceEvent> capturedEvents;
+    std::vector<TraceCounter> capturedCounters;
+
+    ThreadData* GetThreadData();
+    uint64_t NowNs() const;
+    void InitGpuTimers();
+    void ResolveGpuFrame(GpuFrame& frame);
+    static ZoneAccumulator* FindZone(ZoneAccumulator* list, unsigned int& count, const char* name);
+};
+
+// RAII CPU zone
+class ProfileZone {
+public:
+    explicit ProfileZone(const char* name) { Profiler::GetInstance()->BeginZone(name); }
+    ~ProfileZone() { Profiler::GetInstance()->EndZone(); }
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+};
+
+// RAII GPU zone, must be opened on the thread owning the GL context
+class GpuProfileZone {
+public:
+    explicit GpuProfileZone(const char* name) { Profiler::GetInstance()->BeginGpuZone(name); }
+    ~GpuProfileZone() { Profiler::GetInstance()->EndGpuZone(); }
+    GpuProfileZone(const GpuProfileZone&) = delete;
+    GpuProfileZone& operator=(const GpuProfileZone&) = delete;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define PROFILE_GPU_ZONE(name) GpuProfileZone PROFILE_CONCAT(gpuProfileZone, __LINE__)(name)
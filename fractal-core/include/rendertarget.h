@@ -0,0 +1,46 @@
+#ifndef RENDER_TARGET_H
+#define RENDER_TARGET_H
+
+// gl header
+#include "glreq.h"
+
+// Framebuffer object with an RGBA8 color texture and an optional depth
+// renderbuffer. Used as the back buffer in headless mode and for any other
+// offscreen pass that needs to be sampled or read back. Passes with several
+// outputs get up to MAX_COLOR_TEXTURES color textures, drawn in attachment order.
+class RenderTarget
+{
+    public:
+        RenderTarget();
+        ~RenderTarget();
+
+        static constexpr int MAX_COLOR_TEXTURES = 4;
+
+        RenderTarget(const RenderTarget&) = delete;
+        RenderTarget& operator=(const RenderTarget&) = delete;
+
+        bool Create(int width, int height, bool bDepth = true, int colorCount = 1);
+        bool Resize(int newWidth, int newHeight);
+        void Destroy();
+
+        // Bind for drawing and reading and set the viewport to the target size
+        void Bind() const;
+        static void BindDefault(int width, int height);
+
+        GLuint GetFramebuffer() const { return framebuffer; }
+        GLuint GetColorTexture(int index = 0) const { return index >= 0 && index < colorCount ? colorTextures[index] : 0; }
+        int GetWidth() const { return width; }
+        int GetHeight() const { return height; }
+        bool IsValid() const { return framebuffer != 0; }
+
+    private:
+        GLuint framebuffer = 0;
+        GLuint colorTextures[MAX_COLOR_TEXTURES] = {};
+        int colorCount = 1;
+        GLuint depthRenderbuffer = 0;
+        int width = 0;
+        int height = 0;
+        bool bHasDepth = true;
+};
+
+#endif
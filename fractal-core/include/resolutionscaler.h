@@ -0,0 +1,55 @@
+#pragma once
+
+// Picks the scene render scale from measured frame cost. Over budget the scale
+// drops quickly, in proportion to the overshoot (cost is roughly proportional
+// to pixel count, i.e. scale squared). Under budget it climbs one step at a
+// time after a hold period; a climb that immediately goes back over budget
+// doubles the hold so the scale doesn't oscillate around the limit.
+class ResolutionScaler {
+public:
+    // Scales are quantized to this step so the render size doesn't creep every frame
+    static constexpr float STEP = 0.05f;
+    static constexpr unsigned int DROP_FRAMES = 3;
+    static constexpr unsigned int RAISE_FRAMES = 30;
+    static constexpr unsigned int MAX_RAISE_FRAMES = 960;
+
+    ResolutionScaler();
+
+    void SetBounds(float minScale, float maxScale);
+    float GetMinScale() const { return minScale; }
+    float GetMaxScale() const { return maxScale; }
+
+    void SetTargetMs(float ms) { targetMs = ms > 0.0f ? ms : targetMs; }
+    float GetTargetMs() const { return targetMs; }
+
+    // Below targetMs * headroom counts as room to grow. Measurements that can't
+    // go below the budget (a vsync-paced frame interval) use a headroom above 1.
+    void SetHeadroom(float headroom) { this->headroom = headroom; }
+
+    // Feed one measurement of the frame submitted as sampleFrame. Samples taken
+    // from frames rendered before the last change are ignored. currentFrame is
+    // the newest submitted frame; returns true when the scale changed.
+    bool Update(unsigned int sampleFrame, float frameMs, unsigned int currentFrame);
+
+    float GetScale() const { return scale; }
+    void Reset();
+
+private:
+    float scale = 1.0f;
+    float minScale = 0.5f;
+    float maxScale = 1.0f;
+    float targetMs = 1000.0f / 60.0f;
+    float headroom = 0.85f;
+
+    bool bHasSample = false;
+    unsigned int lastSampleFrame = 0;
+    bool bChanged = false;
+    unsigned int changedAtFrame = 0;
+    bool bLastChangeRaised = false;
+    unsigned int framesOver = 0;
+    unsigned int framesUnder = 0;
+    unsigned int raiseFrames = RAISE_FRAMES;
+
+    float Quantize(float value) const;
+    void SetScale(float newScale, unsigned int currentFrame);
+};
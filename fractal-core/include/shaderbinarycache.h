@@ -0,0 +1,48 @@
+#ifndef SHADER_BINARY_CACHE_H
+#define SHADER_BINARY_CACHE_H
+
+// c++ standard library
+#include <string>
+#include <vector>
+
+// gl header
+#include "glreq.h"
+
+// On-disk cache of linked program binaries (glGetProgramBinary/glProgramBinary).
+// Entries are keyed by a hash of the stage sources, the define set and the driver
+// vendor/renderer/version strings, so a driver update simply misses the cache.
+// WebGL2 has no program binaries, so the cache is always disabled on the web.
+class ShaderBinaryCache
+{
+    public:
+        static ShaderBinaryCache* GetInstance();
+
+        ShaderBinaryCache();
+        ~ShaderBinaryCache();
+
+        // True when the current context can both retrieve and load program binaries
+        bool IsEnabled();
+        void SetEnabled(bool bEnabled) { bUserEnabled = bEnabled; }
+
+        void SetCacheDirectory(const std::string& directory) { cacheDirectory = directory; }
+        const std::string& GetCacheDirectory() const { return cacheDirectory; }
+
+        std::string MakeKey(const std::string& sources, const std::string& definesKey);
+
+        bool Load(const std::string& key, GLenum& format, std::vector<char>& binary) const;
+        void Store(const std::string& key, GLenum format, const std::vector<char>& binary) const;
+
+    private:
+        static ShaderBinaryCache* instance;
+
+        std::string cacheDirectory;
+        std::string driverString;
+
+        bool bUserEnabled = true;
+        bool bCapabilitiesChecked = false;
+        bool bSupported = false;
+
+        std::string GetEntryPath(const std::string& key) const;
+};
+
+#endif
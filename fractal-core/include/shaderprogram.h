@@ -3,6 +3,8 @@
 
 // c++ standard library
 #include <string>
+#include <vector>
+#include <map>
 
 // glm header
 #include <glm/glm.hpp>
@@ -11,24 +13,92 @@
 // gl header
 #include "glreq.h"
 
+// Set of preprocessor defines used to compile a shader permutation.
+// Kept sorted so that two equal sets always produce the same key.
+class ShaderDefines
+{
+    public:
+        ShaderDefines& Set(const std::string& name, int value = 1);
+        void Remove(const std::string& name);
+        bool Has(const std::string& name) const;
+
+        // Unique key for this set of defines, e.g. "HAS_ALBEDO_MAP=1;NUM_LIGHTS=4"
+        std::string GetKey() const;
+        // "#define NAME VALUE" lines to insert after the #version directive
+        std::string GetPreamble() const;
+
+    private:
+        std::map<std::string, int> defines;
+};
+
 class ShaderProgram
 {
     public:
-        ShaderProgram();
+        ShaderProgram(const ShaderDefines& defines = ShaderDefines());
         ~ShaderProgram();
 
         GLuint programId;
 
         void Use();
         void AttachShaderFromFile(const char* path, unsigned int shaderType);
+        // Submit() + Finish(), for callers that need the program immediately
         void Link();
 
+        // Split compilation: Submit() loads a cached binary or issues the compiles
+        // and link without querying status; Finish() waits for the result, logs
+        // errors, falls back to source for rejected binaries and stores new ones.
+        void Submit();
+        // Finish() would not block: the driver is done, or has no way to say it isn't
+        bool IsReady() const;
+        bool Finish();
+        bool IsLinked() const { return state == State::Ready; }
+
+        // Finish every submitted program, called once before the first frame
+        static void FinishPending();
+        // Finish the submitted programs the driver is done with and leave the rest
+        // compiling, called once per frame so variants requested later link as they
+        // complete instead of on first use
+        static void FinishReady();
+
         int GetAttribLocation(const char* name);
+        const ShaderDefines& GetDefines() const { return defines; }
 
         void SetUniformMat4(const std::string& name, const glm::mat4& value);
         void SetUniformVec3(const std::string& name, const glm::vec3& value);
         void SetUniformFloat(const std::string& name, float value);
+
+    private:
+        enum class State {
+            Unlinked,
+            Pending,
+            Ready,
+            Failed
+        };
+
+        struct ShaderStage {
+            unsigned int type;
+            std::string path;
+            std::string source;
+        };
+
+        ShaderDefines defines;
+        State state = State::Unlinked;
+        std::vector<ShaderStage> stages;
+        std::vector<GLuint> stageShaders;
+        std::string cacheKey;
+        bool bLoadedFromBinary = false;
+
+        static std::vector<ShaderProgram*> pendingPrograms;
+        static bool bCapabilitiesChecked;
+        static bool bParallelCompile;
+
+        static void DetectCapabilities();
+
+        std::string InjectDefines(const std::string& source) const;
+        void SubmitFromSource();
+        void StoreBinary();
+        void DeleteStageShaders();
+        void RemovePending();
 };
 
 #endif
-
@@ -0,0 +1,34 @@
+#ifndef SHADER_VARIANT_CACHE_H
+#define SHADER_VARIANT_CACHE_H
+
+// c++ standard library
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+
+// local headers
+#include "shaderprogram.h"
+
+// Compiles one ShaderProgram per unique set of defines for a vertex/fragment pair.
+// Variants are submitted on first request; WarmUp() submits a known list up front
+// so that the first frame using them does not stall on the driver compiler.
+class ShaderVariantCache
+{
+    public:
+        ShaderVariantCache(const std::string& vertexPath, const std::string& fragmentPath);
+        ~ShaderVariantCache();
+
+        ShaderProgram* Get(const ShaderDefines& defines);
+        void WarmUp(const std::vector<ShaderDefines>& variants);
+
+        bool HasVariant(const ShaderDefines& defines) const;
+        size_t GetVariantCount() const { return variants.size(); }
+
+    private:
+        std::string vertexPath;
+        std::string fragmentPath;
+        std::unordered_map<std::string, std::unique_ptr<ShaderProgram>> variants;
+};
+
+#endif
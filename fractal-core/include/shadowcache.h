@@ -0,0 +1,190 @@
+#ifndef SHADOW_CACHE_H
+#define SHADOW_CACHE_H
+
+// C++ standard library
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// glm
+#include <glm/glm.hpp>
+
+// local headers
+#include "camera.h"
+#include "light.h"
+#include "meshrenderer.h"
+
+// Layers of the shared shadow map array; a directional light takes one per
+// cascade, a spot light one and a point light two (dual paraboloid)
+static constexpr int MAX_SHADOW_LAYERS = 16;
+static constexpr int SHADOW_CASCADE_COUNT = 4;
+
+enum class ShadowProjection : int {
+    // Orthographic cascade or spot perspective; sampled through a matrix
+    Projective = 0,
+    // One hemisphere of a point light, projected in the shader
+    Paraboloid = 1
+};
+
+// Transform and mesh of an instance drawn into a shadow map. A null mesh
+// means the mesh renderer's own mesh, as for MeshInstance.
+struct ShadowCaster {
+    glm::mat4 transform;
+    const Mesh* mesh;
+};
+
+// A shadow map layer to render this frame
+struct ShadowView {
+    // World to clip space for projective views, world to light view for paraboloids
+    glm::mat4 lightMatrix = glm::mat4(1.0f);
+    int layer = 0;
+    ShadowProjection projection = ShadowProjection::Projective;
+    // Paraboloid hemisphere (+1 faces +z, -1 faces -z) and depth range
+    float paraboloidSide = 1.0f;
+    float nearPlane = 0.0f;
+    float farPlane = 1.0f;
+    // Casters in ShadowFrame::casters, sorted by mesh
+    uint32_t firstCaster = 0;
+    uint32_t casterCount = 0;
+};
+
+// std140 mirror of the ShadowData block in pbr.frag, streamed by MeshRenderer
+struct ShadowSampling {
+    // World to shadow map texture space, or world to light view for paraboloids
+    glm::mat4 matrices[MAX_SHADOW_LAYERS];
+    // x: 1 once the layer holds a map, y: 1 paraboloid,
+    // z: world units per texel (orthographic) or near plane, w: far plane
+    glm::vec4 layerParams[MAX_SHADOW_LAYERS];
+    // Per light: x first layer (-1 unshadowed), y layer count
+    glm::vec4 lightShadows[MeshRenderer::MAX_LIGHTS];
+    // x: 1 / map size, y: depth bias
+    glm::vec4 params;
+};
+
+// Everything the render thread needs for shadows in one frame
+struct ShadowFrame {
+    bool bEnabled = false;
+    int mapSize = 0;
+    int layerCount = 0;
+    std::vector<ShadowView> updates;
+    std::vector<ShadowCaster> casters;
+    ShadowSampling sampling;
+};
+
+// Decides on the main thread which shadow maps to (re)render, so the render
+// thread only draws what changed. Each shadowed light keeps its maps between
+// frames; a map is re-rendered when its light moves, when a caster inside its
+// volume moves, or for cascades when the camera's view slice leaves the
+// guard band the cascade was last fitted with. Pending maps are rendered a few
+// per frame (the update budget), never-rendered and nearer cascades first;
+// the others keep sampling their last map until their turn.
+//
+// Cascades are fitted on the CPU to the camera frustum slice, clipped against
+// the casters' bounds in light space, and snapped to whole texels so cached
+// maps don't shimmer as the camera moves.
+class ShadowCache
+{
+    public:
+        static constexpr int DEFAULT_MAP_SIZE = 1024;
+        static constexpr int DEFAULT_UPDATE_BUDGET = 2;
+        static constexpr float DEFAULT_MAX_DISTANCE = 200.0f;
+
+        ShadowCache();
+
+        void Configure(int mapSize, int updateBudget, float maxDistance);
+
+        // Build this frame's shadow work. instanceVersion changes whenever
+        // instances are added or removed; movedInstances lists instances whose
+        // transform changed since the last call. Instances without a mesh use
+        // defaultCenter/defaultRadius for their bounds.
+        void Update(const std::vector<Light>& lights, const Camera& camera,
+                    const std::vector<MeshInstance>& instances, uint64_t instanceVersion,
+                    const std::vector<size_t>& movedInstances,
+                    const glm::vec3& defaultCenter, float defaultRadius, ShadowFrame& frame);
+
+        int GetLayerCount() const { return layerCount; }
+        // Maps rendered and maps reused from cache since startup
+        uint64_t GetRenderedViews() const { return renderedViews; }
+        uint64_t GetCachedViews() const { return cachedViews; }
+
+    private:
+        // One layer of the map array and what it was last rendered with
+        struct CachedView {
+            int lightIndex = -1;
+            int cascade = 0;
+            ShadowProjection projection = ShadowProjection::Projective;
+            float paraboloidSide = 1.0f;
+
+            bool bRendered = false;
+            bool bDirty = true;
+            uint32_t dirtyFrames = 0;
+
+            // Fit to render next
+            glm::mat4 lightMatrix = glm::mat4(1.0f);
+            float nearPlane = 0.0f;
+            float farPlane = 1.0f;
+            float texelWorldSize = 0.0f;
+            // Cascades: fitted light space box, with guard band
+            glm::vec3 boxMin = glm::vec3(0.0f);
+            glm::vec3 boxMax = glm::vec3(0.0f);
+
+            // What the layer currently holds, for sampling and caster invalidation
+            glm::mat4 renderedMatrix = glm::mat4(1.0f);
+            float renderedNear = 0.0f;
+            float renderedFar = 1.0f;
+            float renderedTexelWorldSize = 0.0f;
+        };
+
+        // Light state the views of a light were fitted for
+        struct CachedLight {
+            Light::Type type = Light::Type::Point;
+            glm::vec3 position = glm::vec3(0.0f);
+            glm::vec3 direction = glm::vec3(0.0f);
+            float spotAngle = 0.0f;
+            bool bCastsShadows = false;
+            // Views hold a fit for the state above
+            bool bFitted = false;
+            int firstLayer = -1;
+            int layers = 0;
+        };
+
+        int mapSize = DEFAULT_MAP_SIZE;
+        int updateBudget = DEFAULT_UPDATE_BUDGET;
+        float maxDistance = DEFAULT_MAX_DISTANCE;
+
+        int layerCount = 0;
+        CachedView views[MAX_SHADOW_LAYERS];
+        std::vector<CachedLight> cachedLights;
+
+        // World bounding spheres of the casters (xyz center, w radius) and their box
+        std::vector<glm::vec4> casterSpheres;
+        glm::vec3 sceneMin = glm::vec3(0.0f);
+        glm::vec3 sceneMax = glm::vec3(0.0f);
+        uint64_t casterVersion = ~0ull;
+        glm::vec3 casterDefaultCenter = glm::vec3(0.0f);
+        float casterDefaultRadius = -1.0f;
+
+        // Scratch, reused every frame
+        std::vector<int> pending;
+
+        uint64_t renderedViews = 0;
+        uint64_t cachedViews = 0;
+
+        void AssignLayers(const std::vector<Light>& lights);
+        bool LightChanged(const Light& light, const CachedLight& cached) const;
+        void RebuildCasters(const std::vector<MeshInstance>& instances, const glm::vec3& defaultCenter, float defaultRadius);
+        glm::vec4 CasterSphere(const MeshInstance& instance, const glm::vec3& defaultCenter, float defaultRadius) const;
+        void InvalidateMovedCasters(const std::vector<MeshInstance>& instances, const std::vector<size_t>& movedInstances,
+                                    const glm::vec3& defaultCenter, float defaultRadius);
+
+        void FitCascades(const Light& light, const CachedLight& cached, const Camera& camera, bool bLightChanged);
+        void FitSpot(const Light& light, const CachedLight& cached);
+        void FitParaboloids(const Light& light, const CachedLight& cached);
+        float FarthestSceneDistance(const glm::vec3& position) const;
+
+        bool SphereInView(const CachedView& view, const glm::vec4& sphere) const;
+        void CollectCasters(const CachedView& view, const std::vector<MeshInstance>& instances, ShadowFrame& frame, ShadowView& out) const;
+        void FillSampling(ShadowFrame& frame, size_t lightCount) const;
+};
+
+#endif
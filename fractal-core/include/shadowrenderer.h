@@ -0,0 +1,46 @@
+#ifndef SHADOW_RENDERER_H
+#define SHADOW_RENDERER_H
+
+// C++ standard library
+#include <memory>
+
+// gl header
+#include "glreq.h"
+
+// local headers
+#include "mesh.h"
+#include "shadervariantcache.h"
+#include "shadowcache.h"
+
+// Render thread half of the shadow system: owns the depth texture array the
+// ShadowCache assigns layers in, and draws the views it asks for. Layers that
+// aren't updated keep their contents from earlier frames.
+class ShadowRenderer
+{
+    public:
+        ShadowRenderer();
+        ~ShadowRenderer();
+
+        // Draw this frame's updated views. Leaves the shadow framebuffer bound;
+        // the caller rebinds its own target. defaultMesh draws casters without a mesh.
+        void Render(const ShadowFrame& frame, const Mesh* defaultMesh);
+
+        GLuint GetTexture() const { return depthTexture; }
+
+    private:
+        GLuint depthTexture = 0;
+        GLuint framebuffer = 0;
+        int mapSize = 0;
+
+        // Indexed by [paraboloid][instance attributes]
+        std::unique_ptr<ShaderVariantCache> variants;
+        ShaderProgram* programs[2][2] = {};
+
+        bool Allocate(int size);
+        void Destroy();
+        void DrawView(const ShadowFrame& frame, const ShadowView& view, const Mesh* defaultMesh);
+        void DrawPooledCasters(const ShadowFrame& frame, const ShadowView& view, const Mesh* defaultMesh, bool bParaboloid);
+        void SetViewUniforms(ShaderProgram* program, const ShadowView& view);
+};
+
+#endif
@@ -0,0 +1,114 @@
+#ifndef STREAM_BUFFER_H
+#define STREAM_BUFFER_H
+
+// C++ standard library
+#include <cstddef>
+#include <vector>
+
+// gl header
+#include "glreq.h"
+
+// One suballocation from the stream buffer, valid for the current frame only.
+// data is write-only: with a persistent mapping it points straight at GPU-visible
+// memory, so never read it back.
+struct StreamAllocation {
+    GLuint buffer = 0;
+    GLintptr offset = 0;
+    GLsizeiptr size = 0;
+    unsigned char* data = nullptr;
+
+    bool IsValid() const { return data != nullptr; }
+};
+
+struct StreamBufferStats {
+    unsigned int frames = 0;
+    // Frames that found their region still in use by the GPU and had to wait
+    unsigned int fenceWaits = 0;
+    float lastWaitMs = 0.0f;
+    float totalWaitMs = 0.0f;
+    float maxWaitMs = 0.0f;
+    unsigned int lastFrameBytes = 0;
+    unsigned int peakFrameBytes = 0;
+    unsigned int regionBytes = 0;
+    // Times a frame outgrew its region and the buffer was reallocated
+    unsigned int grows = 0;
+    bool bPersistent = false;
+};
+
+// Ring buffer for data rewritten every frame (uniform blocks, instance
+// attributes). The buffer is split into REGION_COUNT per-frame regions; each
+// frame allocates linearly from its own region.
+//
+// GL 4.4 / ARB_buffer_storage: the buffer is persistently and coherently mapped
+// once, and a fence placed at the end of each frame guards its region until the
+// GPU is done with it. Elsewhere (WebGL2, older drivers) allocations are staged
+// in CPU memory and uploaded with glBufferSubData on Flush(), and the whole
+// buffer is orphaned each time the ring wraps.
+class StreamBuffer
+{
+    public:
+        static const unsigned int REGION_COUNT = 3;
+        static const size_t DEFAULT_REGION_SIZE = 4 << 20;
+
+        // Shared by every renderer; only touch it from the thread owning the GL context
+        static StreamBuffer* GetInstance();
+
+        explicit StreamBuffer(size_t regionSize = DEFAULT_REGION_SIZE);
+        ~StreamBuffer();
+
+        StreamBuffer(const StreamBuffer&) = delete;
+        StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+        // Frame boundaries: BeginFrame() waits until the GPU has released the
+        // next region, EndFrame() fences everything submitted this frame
+        void BeginFrame();
+        void EndFrame();
+
+        // Aligned suballocation from this frame's region. A frame that outgrows
+        // its region reallocates the buffer at twice the size, so this only
+        // fails if the GL buffer can't be created.
+        StreamAllocation Allocate(size_t size, size_t alignment = 16);
+
+        // Make the written range visible to the GPU; call before drawing with it
+        void Flush(const StreamAllocation& allocation);
+
+        // glBindBufferRange offsets for uniform blocks must be multiples of this
+        size_t GetUniformAlignment();
+
+        bool IsPersistent() const { return bPersistent; }
+        const StreamBufferStats& GetStats() const { return stats; }
+
+    private:
+        // A buffer replaced mid-frame; kept until the frame's draws are submitted
+        struct RetiredBuffer {
+            GLuint buffer;
+            bool bMapped;
+            std::vector<unsigned char> staging;
+        };
+
+        static StreamBuffer* instance;
+
+        GLuint buffer = 0;
+        unsigned char* mapped = nullptr;
+        std::vector<unsigned char> staging;
+        bool bCreated = false;
+        bool bPersistent = false;
+
+        size_t regionSize;
+        unsigned int currentRegion = 0;
+        size_t head = 0;
+        size_t uniformAlignment = 0;
+
+        GLsync fences[REGION_COUNT] = {};
+        std::vector<RetiredBuffer> retired;
+
+        StreamBufferStats stats;
+
+        bool Create(size_t newRegionSize);
+        void Destroy();
+        void Grow(size_t minRegionSize);
+        void WaitForRegion(unsigned int region);
+        void DestroyRetired();
+};
+
+#endif
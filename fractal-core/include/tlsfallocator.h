@@ -0,0 +1,97 @@
+#ifndef TLSF_ALLOCATOR_H
+#define TLSF_ALLOCATOR_H
+
+// C++ standard library
+#include <cstdint>
+
+// local headers
+#include "objectpool.h"
+
+// Two-level segregated fit allocator over an abstract range of units (vertices,
+// indices, bytes). It only does the bookkeeping: offsets are handed out here
+// and the owner decides what memory they refer to, so it works for GPU buffers
+// the CPU never maps.
+//
+// Free blocks are binned by size into FL_COUNT power of two classes, each split
+// into SL_COUNT linear subclasses; a pair of bitmaps finds a fitting bin in
+// constant time. Freed blocks merge with free neighbours immediately.
+class TlsfAllocator
+{
+    public:
+        static constexpr uint32_t INVALID = 0xFFFFFFFFu;
+
+        explicit TlsfAllocator(uint32_t capacity = 0);
+
+        // Drop every allocation and start over with one free block
+        void Reset(uint32_t capacity);
+        // Extend the range at the end; existing offsets stay valid
+        void Grow(uint32_t newCapacity);
+
+        // Returns a block handle, or INVALID when no free block is large enough.
+        // Handles stay valid until the block is freed.
+        uint32_t Allocate(uint32_t size);
+        void Free(uint32_t block);
+
+        uint32_t GetOffset(uint32_t block) const { return blocks[block].offset; }
+        uint32_t GetSize(uint32_t block) const { return blocks[block].size; }
+
+        // Opaque value stored with an allocation, e.g. the owner's index
+        void SetUserData(uint32_t block, uint32_t value) { blocks[block].userData = value; }
+        uint32_t GetUserData(uint32_t block) const { return blocks[block].userData; }
+
+        // Allocated block with the highest offset, INVALID when empty
+        uint32_t GetLastUsedBlock() const;
+
+        uint32_t GetCapacity() const { return capacity; }
+        uint32_t GetUsed() const { return used; }
+        uint32_t GetFree() const { return capacity - used; }
+        uint32_t GetLargestFree() const;
+        uint32_t GetAllocationCount() const { return allocationCount; }
+        uint32_t GetFreeBlockCount() const { return freeBlockCount; }
+        // 0 when all free space is one block, approaching 1 as it splinters
+        float GetFragmentation() const;
+
+    private:
+        static constexpr uint32_t SL_BITS = 4;
+        static constexpr uint32_t SL_COUNT = 1u << SL_BITS;
+        static constexpr uint32_t FL_COUNT = 32 - SL_BITS + 1;
+
+        struct Block {
+            uint32_t offset = 0;
+            uint32_t size = 0;
+            // Neighbours in address order
+            uint32_t prevPhysical = INVALID;
+            uint32_t nextPhysical = INVALID;
+            // Neighbours in the free list of the block's bin
+            uint32_t prevFree = INVALID;
+            uint32_t nextFree = INVALID;
+            uint32_t userData = 0;
+            bool bFree = false;
+        };
+
+        // Handles are pool indices, recycled as blocks split and merge
+        ObjectPool<Block> blocks;
+
+        uint32_t firstLevelBitmap = 0;
+        uint32_t secondLevelBitmaps[FL_COUNT] = {};
+        uint32_t freeHeads[FL_COUNT][SL_COUNT];
+
+        uint32_t lastBlock = INVALID;
+        uint32_t capacity = 0;
+        uint32_t used = 0;
+        uint32_t allocationCount = 0;
+        uint32_t freeBlockCount = 0;
+
+        static void Mapping(uint32_t size, uint32_t& firstLevel, uint32_t& secondLevel);
+        static uint32_t HighestBit(uint32_t value);
+        static uint32_t LowestBit(uint32_t value);
+
+        uint32_t NewBlock();
+        void ReleaseBlock(uint32_t block);
+        void InsertFree(uint32_t block);
+        void RemoveFree(uint32_t block);
+        uint32_t FindFree(uint32_t size) const;
+        void Absorb(uint32_t block, uint32_t next);
+};
+
+#endif
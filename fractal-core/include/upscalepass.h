@@ -0,0 +1,27 @@
+#ifndef UPSCALEPASS_H
+#define UPSCALEPASS_H
+
+// gl header
+#include "glreq.h"
+
+// local headers
+#include "rendertarget.h"
+
+// Draws the lower-left width x height region of a render target over the
+// whole currently bound framebuffer, sharpening to recover detail lost to the
+// lower render resolution
+class UpscalePass
+{
+    public:
+        UpscalePass();
+        ~UpscalePass();
+
+        void Render(const RenderTarget& source, int width, int height, float sharpness);
+        // Same for the lower-left region of any textureWidth x textureHeight texture
+        void Render(GLuint texture, int textureWidth, int textureHeight, int width, int height, float sharpness);
+
+    private:
+        GLuint emptyVAO = 0;
+};
+
+#endif
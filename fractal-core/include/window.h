@@ -2,15 +2,22 @@
 #define WINDOW_H
 
 // C++ standard library
+#include <memory>
 #include <string>
+#include <vector>
 
 // gl header
 #include "glreq.h"
 
+// local headers
+#include "rendertarget.h"
+
 class Window
 {
     public:
-        Window(int width = 800, int height = 600);
+        // A headless window has no surface: the context comes from EGL and
+        // everything is drawn into an offscreen render target instead
+        Window(int width = 800, int height = 600, bool bHeadless = false);
         ~Window();
 
         bool Init(const std::string& canvasId = "");
@@ -18,6 +25,21 @@ class Window
 
         void Resize(int newWidth, int newHeight);
         void SwapBuffers();
+        // Native windows only; the browser always presents on requestAnimationFrame
+        void SetVsync(bool bEnabled);
+
+        // Move the GL context between threads: release it on the old thread
+        // first, then make it current on the new one. No-ops on the web.
+        void MakeCurrent();
+        void ReleaseCurrent();
+
+        // Read the current back buffer (or headless target) as tightly packed
+        // RGBA8 rows, top row first. Call before SwapBuffers().
+        bool ReadPixels(std::vector<unsigned char>& pixels) const;
+
+        // Bind whatever the window presents from: framebuffer 0, or the
+        // offscreen target in headless mode. Offscreen passes call this when done.
+        void BindBackBuffer() const;
         
         bool ShouldClose() const;
         void* GetNativeHandle() const;
@@ -25,9 +47,13 @@ class Window
         int GetWidth() const { return width; }
         int GetHeight() const { return height; }
         bool IsInitialized() const { return bIsInitialized; }
+        bool IsHeadless() const { return bHeadless; }
         void Close() { 
+            bShouldClose = true;
             #ifndef __EMSCRIPTEN__
-            glfwSetWindowShouldClose(window, GLFW_TRUE); 
+            if (window) {
+                glfwSetWindowShouldClose(window, GLFW_TRUE); 
+            }
             #endif
         }
 
@@ -45,9 +71,21 @@ class Window
         EMSCRIPTEN_WEBGL_CONTEXT_HANDLE glContext;
         #else
         GLFWwindow* window;
+
+        // Headless EGL objects, kept opaque so EGL headers stay out of the engine
+        void* eglDisplay = nullptr;
+        void* eglContext = nullptr;
+        void* eglSurface = nullptr;
+
+        bool InitHeadless();
+        void DestroyHeadless();
         #endif
+
+        std::unique_ptr<RenderTarget> headlessTarget;
         
         bool bIsInitialized = false;
+        bool bHeadless = false;
+        bool bShouldClose = false;
         
     };
 
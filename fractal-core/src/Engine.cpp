@@ -1,10 +1,185 @@
 #include "Engine.h"
 #include <iostream>
+#include <fstream>
 #include <cstring>
+#include <cstdlib>
 #include <memory>
+#include <algorithm>
+#include <cmath>
+
+#include "assetutils.h"
+#include "framearena.h"
+#include "frustum.h"
+#include "memorytracker.h"
 
 Engine* Engine::engineInstance = nullptr;
 
+EngineConfig EngineConfig::FromArgs(int argc, char** argv) {
+    EngineConfig config;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--headless") {
+            config.bHeadless = true;
+        }
+        else if (arg.rfind("--width=", 0) == 0) {
+            config.width = std::atoi(arg.c_str() + 8);
+        }
+        else if (arg.rfind("--height=", 0) == 0) {
+            config.height = std::atoi(arg.c_str() + 9);
+        }
+        else if (arg.rfind("--frames=", 0) == 0) {
+            config.frameLimit = (unsigned int)std::strtoul(arg.c_str() + 9, nullptr, 10);
+        }
+        else if (arg.rfind("--capture=", 0) == 0) {
+            config.capturePath = arg.substr(10);
+        }
+        else if (arg.rfind("--trace=", 0) == 0) {
+            config.tracePath = arg.substr(8);
+        }
+        else if (arg.rfind("--benchmark=", 0) == 0) {
+            config.benchmarkScene = arg.substr(12);
+        }
+        else if (arg.rfind("--out=", 0) == 0) {
+            config.benchmarkOutput = arg.substr(6);
+        }
+        else if (arg.rfind("--warmup=", 0) == 0) {
+            config.warmupFrames = (unsigned int)std::strtoul(arg.c_str() + 9, nullptr, 10);
+        }
+        else if (arg.rfind("--fixed-dt=", 0) == 0) {
+            config.fixedTimestep = std::strtof(arg.c_str() + 11, nullptr);
+        }
+        else if (arg.rfind("--record-path=", 0) == 0) {
+            config.recordPath = arg.substr(14);
+        }
+        else if (arg.rfind("--sim-rate=", 0) == 0) {
+            config.simulationRate = std::strtof(arg.c_str() + 11, nullptr);
+        }
+        else if (arg.rfind("--max-catch-up=", 0) == 0) {
+            config.maxCatchUpSteps = std::atoi(arg.c_str() + 15);
+        }
+        else if (arg.rfind("--fps-cap=", 0) == 0) {
+            config.targetFps = std::strtof(arg.c_str() + 10, nullptr);
+        }
+        else if (arg == "--no-vsync") {
+            config.bVsync = false;
+        }
+        else if (arg == "--single-thread") {
+            config.bRenderThread = false;
+        }
+        else if (arg == "--dynamic-res") {
+            config.bDynamicResolution = true;
+        }
+        else if (arg.rfind("--min-scale=", 0) == 0) {
+            config.minRenderScale = std::strtof(arg.c_str() + 12, nullptr);
+        }
+        else if (arg.rfind("--max-scale=", 0) == 0) {
+            config.maxRenderScale = std::strtof(arg.c_str() + 12, nullptr);
+        }
+        else if (arg.rfind("--target-gpu-ms=", 0) == 0) {
+            config.targetGpuMs = std::strtof(arg.c_str() + 16, nullptr);
+        }
+        else if (arg.rfind("--sharpness=", 0) == 0) {
+            config.sharpness = std::strtof(arg.c_str() + 12, nullptr);
+        }
+        else if (arg == "--merged-geometry") {
+            config.bMergedGeometry = true;
+        }
+        else if (arg == "--shadows") {
+            config.bShadows = true;
+        }
+        else if (arg.rfind("--shadow-size=", 0) == 0) {
+            config.shadowMapSize = std::atoi(arg.c_str() + 14);
+        }
+        else if (arg.rfind("--shadow-budget=", 0) == 0) {
+            config.shadowBudget = std::atoi(arg.c_str() + 16);
+        }
+        else if (arg == "--fractal=cpu") {
+            config.fractalBackend = FractalBackend::Cpu;
+        }
+        else if (arg == "--fractal=gpu") {
+            config.fractalBackend = FractalBackend::Gpu;
+        }
+        else if (arg == "--fractal-type=mandelbulb") {
+            config.fractalType = FractalType::Mandelbulb;
+        }
+        else if (arg == "--fractal-type=julia") {
+            config.fractalType = FractalType::QuaternionJulia;
+        }
+        else if (arg.rfind("--fractal-scale=", 0) == 0) {
+            config.fractalScale = std::strtof(arg.c_str() + 16, nullptr);
+        }
+        else if (arg == "--fractal-kernel=generic") {
+            config.bFractalGenericKernels = true;
+        }
+        else if (arg == "--fractal-kernel=specialized") {
+            config.bFractalGenericKernels = false;
+        }
+        else if (arg == "--fractal-progressive") {
+            config.bFractalProgressive = true;
+        }
+        else if (arg == "--fractal-temporal") {
+            config.bFractalTemporal = true;
+        }
+        else if (arg == "--no-fractal-collision") {
+            config.bFractalCollision = false;
+        }
+        else if (arg.rfind("--fractal-budget-ms=", 0) == 0) {
+            config.fractalBudgetMs = std::strtof(arg.c_str() + 20, nullptr);
+        }
+        else if (arg == "--fractal-cone") {
+            config.bFractalConePrepass = true;
+        }
+        else if (arg.rfind("--fractal-mesh=", 0) == 0) {
+            config.fractalMeshResolution = std::atoi(arg.c_str() + 15);
+        }
+        else if (arg.rfind("--fractal-mesh-obj=", 0) == 0) {
+            config.fractalMeshPath = arg.substr(19);
+        }
+        else if (arg == "--deep-zoom=cpu" || arg == "--deep-zoom=gpu") {
+            config.bDeepZoom = true;
+            config.fractalBackend = arg == "--deep-zoom=cpu" ? FractalBackend::Cpu : FractalBackend::Gpu;
+        }
+        else if (arg.rfind("--deep-zoom-center=", 0) == 0) {
+            std::string value = arg.substr(19);
+            size_t comma = value.find(',');
+            if (comma == std::string::npos) {
+                std::cerr << "Expected --deep-zoom-center=<x>,<y>: " << arg << std::endl;
+                continue;
+            }
+            config.deepZoomX = value.substr(0, comma);
+            config.deepZoomY = value.substr(comma + 1);
+        }
+        else if (arg.rfind("--deep-zoom-scale=", 0) == 0) {
+            config.deepZoomScale = std::strtod(arg.c_str() + 18, nullptr);
+        }
+        else if (arg.rfind("--deep-zoom-iterations=", 0) == 0) {
+            config.deepZoomIterations = std::atoi(arg.c_str() + 23);
+        }
+        else if (arg.rfind("--deep-zoom-julia=", 0) == 0) {
+            char* end = nullptr;
+            config.deepZoomJulia.x = std::strtod(arg.c_str() + 18, &end);
+            config.deepZoomJulia.y = *end == ',' ? std::strtod(end + 1, nullptr) : 0.0;
+            config.bDeepZoomJulia = true;
+        }
+        else if (arg.rfind("--animation=", 0) == 0) {
+            config.animationPath = arg.substr(12);
+        }
+        else if (arg.rfind("--animation-out=", 0) == 0) {
+            config.animationOutput = arg.substr(16);
+        }
+        else if (arg.rfind("--samples=", 0) == 0) {
+            config.animationSamples = std::atoi(arg.c_str() + 10);
+        }
+        else if (arg.rfind("--threads=", 0) == 0) {
+            config.jobThreads = std::atoi(arg.c_str() + 10);
+        }
+        else {
+            std::cerr << "Ignoring unknown argument: " << arg << std::endl;
+        }
+    }
+    return config;
+}
+
 Engine::Engine() {
     if(!engineInstance) {
         engineInstance = this;
@@ -24,6 +199,14 @@ Engine::Engine() {
 
 Engine::~Engine() {
     Shutdown();
+
+    // The geometry pool and stream buffer outlive the engine but their GL objects
+    // belong to this context. Meshes hand their ranges back first, then both are
+    // dropped and the next engine creates fresh ones on first use.
+    sceneMeshes.clear();
+    mesh.reset();
+    delete GeometryPool::GetInstance();
+    delete StreamBuffer::GetInstance();
 }
 
 bool Engine::Initialize(const std::string& canvasId) {
@@ -33,9 +216,13 @@ bool Engine::Initialize(const std::string& canvasId) {
     
     this->canvasId = canvasId;
     this->isWebPlatform = true;
+    config.bRenderThread = false;
+
+    // Integrated GPUs can't hold 1080p; let the scaler find what they can
+    config.bDynamicResolution = true;
     
     // Create systems
-    window = std::make_unique<Window>(1920, 1080);
+    window = std::make_unique<Window>(config.width, config.height);
     camera = std::make_unique<Camera>();
     
     // Initialize window with canvas ID for web
@@ -43,15 +230,59 @@ bool Engine::Initialize(const std::string& canvasId) {
         std::cerr << "Failed to initialize window" << std::endl;
         return false;
     }
+    ConfigureFrameTiming();
     
     return InitializeCommon();
 }
 
 bool Engine::Initialize(int argc, char** argv) {
+    return Initialize(EngineConfig::FromArgs(argc, argv));
+}
+
+bool Engine::Initialize(const EngineConfig& config) {
     this->isWebPlatform = false;
+    this->config = config;
+
+    if (this->config.width <= 0 || this->config.height <= 0) {
+        std::cerr << "Invalid resolution " << this->config.width << "x" << this->config.height << std::endl;
+        return false;
+    }
+
+    // Benchmarks are deterministic: scripted camera, fixed timestep, fixed frame count
+    if (!this->config.benchmarkScene.empty()) {
+        BenchmarkScene scene;
+        if (!scene.Load(AssetUtils::resolveBenchmarkPath(this->config.benchmarkScene))) {
+            return false;
+        }
+        if (this->config.fixedTimestep <= 0.0f) {
+            this->config.fixedTimestep = 1.0f / 60.0f;
+        }
+        if (this->config.frameLimit == 0) {
+            this->config.frameLimit = this->config.warmupFrames + 600;
+        }
+        benchmark = std::make_unique<Benchmark>(scene, this->config.warmupFrames);
+        benchmark->ReserveFrames(this->config.frameLimit);
+        std::cout << "Benchmark '" << scene.name << "': " << scene.instanceCount << " instances, "
+                  << scene.lightCount << " lights, " << this->config.frameLimit << " frames" << std::endl;
+    }
+
+    // Animations render offscreen on the main thread, with the CPU marcher unless told otherwise
+    if (!this->config.animationPath.empty()) {
+        this->config.bHeadless = true;
+        this->config.bRenderThread = false;
+        if (this->config.fractalBackend == FractalBackend::None) {
+            this->config.fractalBackend = FractalBackend::Cpu;
+        }
+    }
+
+    // Nothing can close a headless window, so never spin forever
+    if (this->config.bHeadless && this->config.frameLimit == 0) {
+        std::cout << "Headless run without a frame limit, rendering a single frame" << std::endl;
+        this->config.frameLimit = 1;
+    }
     
     // Create systems
-    window = std::make_unique<Window>(1920, 1080);
+    window = std::make_unique<Window>(this->config.width, this->config.height, this->config.bHeadless);
     camera = std::make_unique<Camera>();
     
     // Initialize window for native (no canvas ID needed)
@@ -59,29 +290,99 @@ bool Engine::Initialize(int argc, char** argv) {
         std::cerr << "Failed to initialize window" << std::endl;
         return false;
     }
+    window->SetVsync(this->config.bVsync);
+    ConfigureFrameTiming();
     
     return InitializeCommon();
 }
 
 bool Engine::InitializeCommon() {
     std::cout << "Engine::InitializeCommon() called" << std::endl;
+    Profiler::GetInstance()->SetThreadName("Main");
+    if (!config.tracePath.empty()) {
+        Profiler::GetInstance()->StartCapture();
+    }
+
+    // Must be set before any mesh loads, and before the pooled variants are warmed up
+    GeometryPool::GetInstance()->SetBatching(config.bMergedGeometry);
+
+    JobSystem::GetInstance()->Start(config.jobThreads);
+    std::cout << "Job system: " << JobSystem::GetInstance()->GetWorkerCount() << " workers, "
+              << CpuRayMarcher::PACKET_WIDTH << "-wide simd packets" << std::endl;
+
+    // Renderers submit their programs on construction; nothing waits on the
+    // driver until ShaderProgram::FinishPending() below
+    auto shaderStart = std::chrono::high_resolution_clock::now();
     meshRenderer = std::make_unique<MeshRenderer>();
     lightRenderer = std::make_unique<LightRenderer>();
     triangleRenderer = std::make_unique<TriangleRenderer>();
+    upscalePass = std::make_unique<UpscalePass>();
+
+    // Benchmark scenes can ask for shadows and fractals
+    if (benchmark && benchmark->GetScene().bShadows) {
+        config.bShadows = true;
+    }
+    if (benchmark && benchmark->GetScene().fractalBackend != FractalBackend::None) {
+        config.fractalBackend = benchmark->GetScene().fractalBackend;
+        config.fractalType = benchmark->GetScene().fractalType;
+    }
+    if (benchmark && benchmark->GetScene().bDeepZoom) {
+        const BenchmarkScene& scene = benchmark->GetScene();
+        config.bDeepZoom = true;
+        config.deepZoomX = scene.deepZoomX;
+        config.deepZoomY = scene.deepZoomY;
+        config.deepZoomScale = scene.deepZoomScale;
+        config.deepZoomIterations = scene.deepZoomIterations;
+    }
+    fractalParams.type = config.fractalType;
+    fractalSettings.bSpecializedKernels = !config.bFractalGenericKernels;
+    fractalSettings.bConePrepass = config.bFractalConePrepass;
+    SetFractalBudgetMs(config.fractalBudgetMs);
+    fractalRenderer = std::make_unique<FractalRenderer>(fractalParams);
+    deepZoomView.formula = config.bDeepZoomJulia ? DeepZoomFormula::Julia : DeepZoomFormula::Mandelbrot;
+    deepZoomView.juliaX = config.deepZoomJulia.x;
+    deepZoomView.juliaY = config.deepZoomJulia.y;
+    SetDeepZoomScale(config.deepZoomScale);
+    SetDeepZoomIterations(config.deepZoomIterations);
+    if (!deepZoomView.SetCenter(config.deepZoomX, config.deepZoomY)) {
+        std::cerr << "Invalid deep zoom center " << config.deepZoomX << ", " << config.deepZoomY << std::endl;
+    }
+    if (config.fractalBackend != FractalBackend::None && config.bDeepZoom) {
+        std::cout << "Deep zoom: " << DeepZoomFormulaToString(deepZoomView.formula) << " at scale " << deepZoomView.scale << ", "
+                  << FixedPoint::LimbsForScale(deepZoomView.scale) << " limbs" << std::endl;
+        // Benchmarks measure frames around a finished orbit, not the first one
+        if (benchmark) {
+            MEMORY_SCOPE(MemoryTag::Assets);
+            orbitCache.BuildNow(deepZoomView);
+        }
+    }
+    else if (config.fractalBackend != FractalBackend::None) {
+        std::cout << "Fractal kernel: " << FormulaKernelName(SelectFormulaKernel(fractalParams, fractalSettings.bSpecializedKernels))
+                  << std::endl;
+    }
+    if (config.bShadows) {
+        shadowCache = std::make_unique<ShadowCache>();
+        shadowCache->Configure(config.shadowMapSize, config.shadowBudget, ShadowCache::DEFAULT_MAX_DISTANCE);
+        shadowRenderer = std::make_unique<ShadowRenderer>();
+    }
+    meshRenderer->EnableShadows(config.bShadows);
+
+    if (!meshRenderer->LoadShaders("pbr.vert", "pbr.frag")) {
+        std::cerr << "Failed to load PBR shaders" << std::endl;
+        return false;
+    }
     
     std::cout << "Creating keyboard and mouse" << std::endl;
     keyboard = std::make_unique<Keyboard>();
     mouse = std::make_unique<Mouse>();
 
     #ifndef __EMSCRIPTEN__
-    glfwSetKeyCallback(window->GetWindow(), HandleKeyboardInput);
-    glfwSetCursorPosCallback(window->GetWindow(), HandleMouseMoveEvent);
-    glfwSetMouseButtonCallback(window->GetWindow(), HandleMouseButtonEvent);
+    if (window->GetWindow()) {
+        glfwSetKeyCallback(window->GetWindow(), HandleKeyboardInput);
+        glfwSetCursorPosCallback(window->GetWindow(), HandleMouseMoveEvent);
+        glfwSetMouseButtonCallback(window->GetWindow(), HandleMouseButtonEvent);
+    }
     #endif
-    // Load default model
-    std::string modelPath = "columns.fbx";
-    LoadModel(modelPath);
-
     
     // Initialize OpenGL state
     glEnable(GL_DEPTH_TEST);
@@ -99,18 +400,53 @@ bool Engine::InitializeCommon() {
     std::cout << "Camera setup complete" << std::endl;
     #endif
     
-    // Setup renderers
-    if (!meshRenderer->LoadShaders("pbr.vert", "pbr.frag")) {
-        std::cerr << "Failed to load PBR shaders" << std::endl;
-        return false;
+    // Load default model while the driver compiles the submitted programs
+    std::string modelPath = benchmark ? benchmark->GetScene().model : "columns.fbx";
+    if (config.fractalMeshResolution > 0) {
+        LoadFractalMesh(config.fractalMeshResolution);
     }
-    
-    #ifdef __EMSCRIPTEN__
-    std::cout << "Shaders loaded successfully" << std::endl;
-    #endif
+    else if (config.animationPath.empty()) {
+        LoadModel(modelPath);
+    }
+
+    // Make sure every program is linked before the first frame
+    {
+        PROFILE_ZONE("ShaderProgram::FinishPending");
+        ShaderProgram::FinishPending();
+    }
+    float shaderTime = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - shaderStart).count();
+    std::cout << "Shaders and default model ready in " << shaderTime << " ms" << std::endl;
     
     // Setup default scene
-    SetupDefaultScene();
+    if (benchmark) {
+        SetupBenchmarkScene();
+    }
+    else {
+        SetupDefaultScene();
+    }
+
+    // Nothing to blend with before the first step
+    renderCamera = std::make_unique<Camera>(*camera);
+    SaveSimState(previousState);
+    viewportWidth = window->GetWidth();
+    viewportHeight = window->GetHeight();
+
+    if (config.bRenderThread) {
+        StartRenderThread();
+    }
+    if (benchmark) {
+        benchmark->SetRenderThreaded(IsRenderThreaded());
+        benchmark->SetMergedGeometry(config.bMergedGeometry, GeometryPool::GetInstance()->HasMultiDraw());
+        benchmark->SetShadows(config.bShadows);
+        benchmark->SetFractal(config.fractalBackend, FormulaKernelName(SelectFormulaKernel(fractalParams, fractalSettings.bSpecializedKernels)),
+                              CpuRayMarcher::PACKET_WIDTH, JobSystem::GetInstance()->GetConcurrency());
+        if (config.bDeepZoom && orbitCache.GetOrbit()) {
+            benchmark->SetDeepZoom(deepZoomView, *orbitCache.GetOrbit());
+        }
+        if (config.fractalMeshResolution > 0) {
+            benchmark->SetFractalMesh(surfaceMesher.GetStats());
+        }
+    }
     
     #ifdef __EMSCRIPTEN__
     std::cout << "Default scene setup complete" << std::endl;
@@ -120,6 +456,59 @@ bool Engine::InitializeCommon() {
     return true;
 }
 
+void Engine::ConfigureFrameTiming() {
+    // Scripted runs simulate one step of exactly fixedTimestep per frame
+    double step = config.fixedTimestep > 0.0f ? config.fixedTimestep : 1.0 / std::max(config.simulationRate, 1.0f);
+    frameClock.SetStep(step);
+    frameClock.SetMaxSteps(config.maxCatchUpSteps);
+    framePacer.SetTargetFps(config.targetFps);
+    ConfigureResolutionScaler();
+}
+
+void Engine::ConfigureResolutionScaler() {
+    resolutionScaler.SetBounds(config.minRenderScale, config.maxRenderScale);
+    float budgetMs = config.targetGpuMs;
+    if (budgetMs <= 0.0f) {
+        budgetMs = 1000.0f / (config.targetFps > 0.0f ? config.targetFps : 60.0f);
+    }
+    resolutionScaler.SetTargetMs(budgetMs);
+    resolutionScaler.Reset();
+}
+
+void Engine::UpdateResolutionScale() {
+    if (!config.bDynamicResolution) {
+        return;
+    }
+
+    const ProfileFrameSummary& summary = Profiler::GetInstance()->GetFrameSummary();
+    if (Profiler::GetInstance()->HasGpuTimers()) {
+        resolutionScaler.SetHeadroom(0.85f);
+        resolutionScaler.Update(summary.gpuFrameIndex, summary.gpuFrameMs, summary.frameIndex);
+    }
+    else {
+        // Without timer queries the frame interval is the only signal. It can't
+        // drop below the vsync interval, so anything near the budget counts as headroom.
+        resolutionScaler.SetHeadroom(1.05f);
+        resolutionScaler.Update(summary.frameIndex, framePacer.GetAverageFrameMs(), summary.frameIndex);
+    }
+}
+
+void Engine::SetDynamicResolution(bool bEnabled) {
+    config.bDynamicResolution = bEnabled;
+    resolutionScaler.Reset();
+}
+
+void Engine::SetRenderScaleBounds(float minScale, float maxScale) {
+    config.minRenderScale = minScale;
+    config.maxRenderScale = maxScale;
+    ConfigureResolutionScaler();
+}
+
+void Engine::SetTargetGpuMs(float ms) {
+    config.targetGpuMs = ms;
+    ConfigureResolutionScaler();
+}
+
 void Engine::SetupDefaultScene() {
     // Add mesh instances
     MeshInstance instance;
@@ -137,9 +526,44 @@ void Engine::SetupDefaultScene() {
     triangleRenderer->SetModelMatrix(glm::mat4(1.0f));
 }
 
+void Engine::SetupBenchmarkScene() {
+    const BenchmarkScene& scene = benchmark->GetScene();
+
+    // The first model is the renderer's mesh, the rest are only used by this scene
+    std::vector<Mesh*> models = { nullptr };
+    for (size_t i = 1; i < scene.models.size(); i++) {
+        std::unique_ptr<Mesh> loaded = std::make_unique<Mesh>(scene.models[i]);
+        if (loaded->vertices.empty()) {
+            std::cerr << "Failed to load " << scene.models[i] << std::endl;
+            continue;
+        }
+        models.push_back(loaded.get());
+        sceneMeshes.push_back(std::move(loaded));
+    }
+
+    MeshInstance instance;
+    std::vector<glm::mat4> transforms = scene.GetInstanceTransforms();
+    for (size_t i = 0; i < transforms.size(); i++) {
+        instance.transform = transforms[i];
+        instance.mesh = models[i % models.size()];
+        meshRenderer->AddInstance(instance);
+    }
+
+    lights = scene.CreateLights();
+    meshRenderer->SetLights(lights);
+    triangleRenderer->SetModelMatrix(glm::mat4(1.0f));
+
+    // Large grids reach well past the interactive far plane
+    float viewDistance = scene.GetViewDistance();
+    camera->setPerspective(45.0f, (float)window->GetWidth() / (float)window->GetHeight(), viewDistance * 0.0005f, viewDistance);
+    benchmark->UpdateCamera(*camera, 0.0f);
+}
+
 void Engine::ProcessEvents() {
     #ifndef __EMSCRIPTEN__
-    glfwPollEvents();
+    if (!window->IsHeadless()) {
+        glfwPollEvents();
+    }
     #endif
     
     // Update input device states for frame transitions
@@ -151,102 +575,643 @@ void Engine::ProcessEvents() {
     }
 }
 
+void Engine::Frame(float frameDt) {
+    double elapsed = frameDt;
+    #ifdef __EMSCRIPTEN__
+    // requestAnimationFrame paces the browser; the cap only drops callbacks
+    if (!framePacer.ShouldRunFrame(frameDt, elapsed)) {
+        return;
+    }
+    #endif
+
+    // Last frame's transient data is dead; with a render thread its arena is reset there
+    FrameArena::GetThreadArena().Reset();
+
+    Profiler::GetInstance()->BeginFrame();
+    {
+        PROFILE_ZONE("Engine::Simulate");
+        MEMORY_SCOPE(MemoryTag::Simulation);
+
+        // Process events from input devices and window
+        ProcessEvents();
+        ApplyMouseLook();
+
+        // Scripted runs step exactly once per frame
+        if (config.fixedTimestep > 0.0f) {
+            elapsed = config.fixedTimestep;
+        }
+
+        int steps = frameClock.Advance(elapsed);
+        for (int i = 0; i < steps; i++) {
+            SaveSimState(previousState);
+            Update((float)frameClock.GetStep());
+        }
+        interpolationAlpha = frameClock.GetAlpha();
+    }
+    Render();
+}
+
+float Engine::WaitForNextFrame() {
+    return (float)framePacer.WaitForNextFrame();
+}
+
 void Engine::Update(float dt) {
+    PROFILE_ZONE("Engine::Update");
 
-    // Process events from input devices and windew
-    ProcessEvents();
+    // Engine time only moves with dt so scripted runs are repeatable
+    engineTime += dt;
+    float time = (float)engineTime;
     
     // Update light animations
-    float time = std::chrono::duration<float>(std::chrono::high_resolution_clock::now() - startTime).count();
     UpdateLightAnimation(time);
-    
-    // Handle camera movement with input
-    if (keyboard && camera) {
-        float moveSpeed = 5.0f;
-        /*
-        // WASD movement - using IsButtonDown for continuous movement
-        if (keyboard->IsButtonDown(GLFW_KEY_W)) {
-            camera->moveForward(moveSpeed * dt);
-        }
-        if (keyboard->IsButtonDown(GLFW_KEY_S)) {
-            camera->moveForward(-moveSpeed * dt);
-        }
-        if (keyboard->IsButtonDown(GLFW_KEY_A)) {
-            camera->moveRight(-moveSpeed * dt);
-        }
-        if (keyboard->IsButtonDown(GLFW_KEY_D)) {
-            camera->moveRight(moveSpeed * dt);
-        }
-        if (keyboard->IsButtonDown(GLFW_KEY_Q)) {
-            camera->moveUp(-moveSpeed * dt);
-        }
-        if (keyboard->IsButtonDown(GLFW_KEY_E)) {
-            camera->moveUp(moveSpeed * dt);
-        }
-        
-        // Example: Print when a key is first pressed (not held)
-        if (keyboard->IsButtonPressed(GLFW_KEY_SPACE)) {
-            std::cout << "Space key was just pressed!" << std::endl;
-        }
-            */
-    }
-    /*
-    // Handle mouse camera rotation
-    if (mouse && camera) {
-        static bool firstMouse = true;
-        static double lastX = 0, lastY = 0;
-        
-        // Manual button mapping since we don't have GLFW in web
-        const int MOUSE_BUTTON_LEFT = 0;
-        const int MOUSE_BUTTON_RIGHT = 1;
-        
-        if (mouse->IsButtonDown(MOUSE_BUTTON_LEFT)) { // Use left mouse button for rotation
-            double currentX = mouse->GetX();
-            double currentY = mouse->GetY();
-            
-            if (firstMouse) {
-                lastX = currentX;
-                lastY = currentY;
-                firstMouse = false;
-            }
-            
-            double deltaX = lastX - currentX;
-            double deltaY = lastY - currentY;
-            
-            float rotateSpeed = 0.5f; // Reduced sensitivity
-            camera->rotateYaw(deltaX * rotateSpeed * dt);
-            camera->rotatePitch(deltaY * rotateSpeed * dt);
-            
-            lastX = currentX;
-            lastY = currentY;
-        } else {
-            firstMouse = true;
+
+    if (benchmark) {
+        benchmark->UpdateCamera(*camera, time);
+    }
+    else {
+        ApplyCameraInput(dt);
+        if (!config.recordPath.empty() && engineTime >= nextRecordTime) {
+            // A keyframe every quarter second is dense enough for the spline to follow
+            recordedPath.AddKeyframe(time, camera->getPosition(), camera->getPosition() + camera->getLocalForward());
+            nextRecordTime = engineTime + 0.25;
+        }
+    }
+}
+
+void Engine::ApplyCameraInput(float dt) {
+    if (!keyboard || !camera) {
+        return;
+    }
+
+    // Letter key codes are the same for GLFW and the web key mapping
+    const float moveSpeed = 5.0f;
+    glm::vec3 direction(0.0f);
+    if (keyboard->IsButtonDown('W')) {
+        direction += camera->getLocalForward();
+    }
+    if (keyboard->IsButtonDown('S')) {
+        direction -= camera->getLocalForward();
+    }
+    if (keyboard->IsButtonDown('A')) {
+        direction -= camera->getLocalRight();
+    }
+    if (keyboard->IsButtonDown('D')) {
+        direction += camera->getLocalRight();
+    }
+    if (keyboard->IsButtonDown('Q')) {
+        direction += camera->getLocalUp();
+    }
+    if (keyboard->IsButtonDown('E')) {
+        direction -= camera->getLocalUp();
+    }
+    glm::vec3 displacement = direction * (moveSpeed * dt);
+
+    // Over a fractal the move is swept against its surface; deep zoom is a 2D view
+    bool bCollide = config.bFractalCollision && config.fractalBackend != FractalBackend::None && !config.bDeepZoom;
+    if (!bCollide) {
+        camera->setPosition(camera->getPosition() + displacement);
+        return;
+    }
+    fractalCollider.SetScene(fractalParams);
+    camera->setPosition(cameraController.Move(fractalCollider, camera->getPosition(), displacement));
+}
+
+void Engine::ApplyMouseLook() {
+    if (!mouse || !camera || benchmark) {
+        return;
+    }
+
+    #ifdef __EMSCRIPTEN__
+    const int lookButton = 0;   // right click opens the browser context menu
+    #else
+    const int lookButton = GLFW_MOUSE_BUTTON_RIGHT;
+    #endif
+
+    // Look is applied once per rendered frame from absolute cursor positions,
+    // so it is independent of how many simulation steps run
+    double x = mouse->GetX();
+    double y = mouse->GetY();
+    if (mouse->IsButtonDown(lookButton) && !mouse->IsButtonPressed(lookButton)) {
+        const float sensitivity = 0.003f;   // radians per pixel
+        camera->rotateYaw((float)(lookLastX - x) * sensitivity);
+        camera->rotatePitch((float)(lookLastY - y) * sensitivity);
+
+        // Don't blend the look direction; it would only add a frame of lag
+        previousState.cameraRotation = camera->getOrientation();
+    }
+    lookLastX = x;
+    lookLastY = y;
+}
+
+void Engine::SaveSimState(SimState& state) const {
+    state.cameraPosition = camera->getPosition();
+    state.cameraRotation = camera->getOrientation();
+    state.lightPositions.resize(lights.size());
+    for (size_t i = 0; i < lights.size(); i++) {
+        state.lightPositions[i] = lights[i].getPosition();
+    }
+}
+
+void Engine::InterpolateRenderState() {
+    // Blend the last two simulation states by the accumulator remainder
+    float alpha = interpolationAlpha;
+    *renderCamera = *camera;
+    renderCamera->setPosition(glm::mix(previousState.cameraPosition, camera->getPosition(), alpha));
+    renderCamera->setOrientation(glm::slerp(previousState.cameraRotation, camera->getOrientation(), alpha));
+
+    renderLights = lights;
+    if (previousState.lightPositions.size() == lights.size()) {
+        for (size_t i = 0; i < lights.size(); i++) {
+            renderLights[i].setPosition(glm::mix(previousState.lightPositions[i], lights[i].getPosition(), alpha));
         }
     }
-    */
 }
 
 void Engine::Render() {
-    
+    {
+        PROFILE_ZONE("Engine::Render");
+        if (renderThread.joinable()) {
+            BuildFramePacket(frameMailbox.GetWriteSlot());
+
+            // Waits only if the render thread hasn't picked up the previous packet yet
+            PROFILE_ZONE("Engine::PublishFrame");
+            frameMailbox.Publish();
+        }
+        else {
+            BuildFramePacket(immediatePacket);
+            RenderPacket(immediatePacket);
+        }
+    }
+    Profiler::GetInstance()->EndFrame();
+    UpdateResolutionScale();
+
+    if (benchmark) {
+        benchmark->RecordFrame(Profiler::GetInstance()->GetFrameSummary());
+    }
+}
+
+void Engine::BuildFramePacket(FramePacket& packet) {
+    PROFILE_ZONE("Engine::BuildFramePacket");
+    MEMORY_SCOPE(MemoryTag::FramePacket);
+
+    InterpolateRenderState();
+    packet.frameIndex = Profiler::GetInstance()->GetFrameIndex();
+    packet.width = viewportWidth;
+    packet.height = viewportHeight;
+    packet.view = renderCamera->getViewMatrix();
+    packet.projection = renderCamera->getProjectionMatrix();
+    packet.viewPos = renderCamera->getPosition();
+    packet.lights = renderLights;
+    packet.renderScale = GetRenderScale();
+    packet.maxRenderScale = config.maxRenderScale;
+    packet.sharpness = config.sharpness;
+    UpdateFractal(packet.fractal);
+    if (packet.fractal.IsEnabled()) {
+        // The fractal replaces the mesh scene
+        packet.instances.clear();
+    }
+    else {
+        CullInstances(packet.projection * packet.view, packet.instances);
+    }
+    UpdateShadows(packet.shadows);
+
+    packet.commands.clear();
+    packet.commands.swap(pendingRenderCommands);
+
+    // Frame limit for headless and scripted runs; the capture happens before the swap
+    frameCount++;
+    packet.bCapture = false;
+    if (config.frameLimit > 0 && frameCount >= config.frameLimit) {
+        packet.bCapture = !config.capturePath.empty();
+        window->Close();
+    }
+}
+
+void Engine::CullInstances(const glm::mat4& viewProjection, std::vector<MeshInstance>& visible) {
+    PROFILE_ZONE("Engine::CullInstances");
+
+    glm::vec3 center;
+    float radius;
+    {
+        std::lock_guard<std::mutex> lock(meshBoundsMutex);
+        center = meshBoundsCenter;
+        radius = meshBoundsRadius;
+    }
+
+    // Reuses the packet's storage, so steady state doesn't allocate
+    visible.clear();
+    Frustum frustum(viewProjection);
+    for (const MeshInstance& instance : meshRenderer->GetInstances()) {
+        // Scene meshes never change after setup; only the default mesh can be swapped
+        const glm::vec3& localCenter = instance.mesh ? instance.mesh->boundsCenter : center;
+        float localRadius = instance.mesh ? instance.mesh->boundsRadius : radius;
+
+        const glm::mat4& transform = instance.transform;
+        float scale = std::max(glm::length(glm::vec3(transform[0])), std::max(glm::length(glm::vec3(transform[1])), glm::length(glm::vec3(transform[2]))));
+        glm::vec3 worldCenter = glm::vec3(transform * glm::vec4(localCenter, 1.0f));
+        if (frustum.IntersectsSphere(worldCenter, localRadius * scale)) {
+            visible.push_back(instance);
+        }
+    }
+}
+
+void Engine::UpdateShadows(ShadowFrame& shadows) {
+    if (!shadowCache) {
+        shadows.bEnabled = false;
+        meshRenderer->ClearMovedInstances();
+        return;
+    }
+
+    glm::vec3 center;
+    float radius;
+    {
+        std::lock_guard<std::mutex> lock(meshBoundsMutex);
+        center = meshBoundsCenter;
+        radius = meshBoundsRadius;
+    }
+    // Casters come from every instance, not just the visible ones
+    shadowCache->Update(renderLights, *renderCamera, meshRenderer->GetInstances(), meshRenderer->GetInstanceVersion(),
+                        meshRenderer->GetMovedInstances(), center, radius, shadows);
+    meshRenderer->ClearMovedInstances();
+}
+
+void Engine::UpdateFractal(FractalFrame& fractal) {
+    fractal.backend = config.fractalBackend;
+    if (!fractal.IsEnabled()) {
+        return;
+    }
+    PROFILE_ZONE("Engine::UpdateFractal");
+    fractal.bDeepZoom = config.bDeepZoom;
+    if (fractal.bDeepZoom) {
+        UpdateDeepZoom(fractal);
+        return;
+    }
+
+    fractal.view = FractalView::FromCamera(*renderCamera);
+    fractal.params = fractalParams;
+    fractal.settings = fractalSettings;
+    fractal.bTemporal = config.bFractalTemporal;
+    fractal.temporal = temporalRenderer.GetSettings();
+    if (fractal.backend != FractalBackend::Cpu) {
+        return;
+    }
+
+    // Traced below native resolution, then stretched over the viewport by the upscale pass
+    float scale = std::clamp(config.fractalScale, 0.05f, 1.0f);
+    fractal.width = std::max(1, (int)std::lround(viewportWidth * scale));
+    fractal.height = std::max(1, (int)std::lround(viewportHeight * scale));
+    if (config.bFractalProgressive) {
+        progressiveRenderer.Update(fractal.view, fractal.params, fractal.settings, fractal.width, fractal.height);
+        Profiler::SetGauge(ProfileGauge::FractalCompletion, progressiveRenderer.GetCompletion());
+        // The packet keeps its own copy; the renderer goes on refining while it is drawn
+        const std::vector<uint32_t>& image = progressiveRenderer.GetPixels();
+        fractal.width = progressiveRenderer.GetImageWidth();
+        fractal.height = progressiveRenderer.GetImageHeight();
+        fractal.pixels.assign(image.begin(), image.end());
+        return;
+    }
+    if (config.bFractalTemporal) {
+        temporalRenderer.Update(fractal.view, fractal.params, fractal.settings, fractal.width, fractal.height);
+        const std::vector<uint32_t>& image = temporalRenderer.GetPixels();
+        fractal.pixels.assign(image.begin(), image.end());
+        Profiler::SetGauge(ProfileGauge::FractalCompletion, 1.0f);
+        return;
+    }
+    fractal.pixels.resize((size_t)fractal.width * (size_t)fractal.height);
+    cpuRayMarcher.Render(fractal.view, fractal.params, fractal.settings, fractal.width, fractal.height, fractal.pixels.data());
+    Profiler::SetGauge(ProfileGauge::FractalCompletion, 1.0f);
+}
+
+void Engine::UpdateDeepZoom(FractalFrame& fractal) {
+    // The camera's heading turns the image, so scripted orbits rotate the view
+    FractalView view = FractalView::FromCamera(*renderCamera);
+    deepZoomView.angle = std::atan2(view.right.z, view.right.x);
+    deepZoomView.aspect = (float)viewportWidth / (float)std::max(viewportHeight, 1);
+    {
+        // Allocates only when a new orbit is started or collected
+        MEMORY_SCOPE(MemoryTag::Assets);
+        orbitCache.Update(deepZoomView);
+    }
+    fractal.deepZoom = deepZoomView;
+    fractal.orbit = orbitCache.GetOrbit();
+    Profiler::SetGauge(ProfileGauge::FractalCompletion, fractal.orbit && fractal.orbit->Fits(deepZoomView) ? 1.0f : 0.0f);
+    if (fractal.backend != FractalBackend::Cpu) {
+        return;
+    }
+
+    float scale = std::clamp(config.fractalScale, 0.05f, 1.0f);
+    fractal.width = std::max(1, (int)std::lround(viewportWidth * scale));
+    fractal.height = std::max(1, (int)std::lround(viewportHeight * scale));
+    fractal.pixels.resize((size_t)fractal.width * (size_t)fractal.height);
+    if (!fractal.orbit) {
+        std::fill(fractal.pixels.begin(), fractal.pixels.end(), 0xFF000000u);
+        return;
+    }
+    cpuDeepZoom.Render(fractal.deepZoom, *fractal.orbit, fractal.width, fractal.height, fractal.pixels.data());
+}
+
+void Engine::SetDeepZoomScale(double scale) {
+    deepZoomView.scale = std::clamp(scale, CpuDeepZoom::MIN_SCALE, 4.0);
+}
+
+void Engine::SetDeepZoomIterations(int iterations) {
+    deepZoomView.iterations = std::max(iterations, 1);
+}
+
+int Engine::GetDeepZoomDigits() const {
+    // A few digits past the pixel spacing of a 4K tall view
+    return std::max(1, (int)std::ceil(-std::log10(deepZoomView.scale / 2048.0)) + 2);
+}
+
+void Engine::SetFractalBudgetMs(float ms) {
+    config.fractalBudgetMs = ms;
+    ProgressiveSettings settings = progressiveRenderer.GetSettings();
+    settings.budgetMs = std::max(ms, 0.0f);
+    progressiveRenderer.SetSettings(settings);
+}
+
+float Engine::GetFractalCompletion() const {
+    if (config.fractalBackend != FractalBackend::Cpu || !config.bFractalProgressive) {
+        return 1.0f;
+    }
+    return progressiveRenderer.GetCompletion();
+}
+
+void Engine::RenderFractal(FractalFrame& fractal, int width, int height) {
+    if (fractal.bDeepZoom && fractal.backend == FractalBackend::Gpu) {
+        // Until the first orbit is done the cleared scene shows through
+        if (fractal.orbit) {
+            fractalRenderer->RenderDeepZoom(fractal.deepZoom, *fractal.orbit, width, height);
+        }
+        return;
+    }
+    if (fractal.backend == FractalBackend::Gpu && fractal.bTemporal) {
+        // Drawn offscreen, where the next frame can read it back as history
+        fractalRenderer->RenderTemporal(fractal.view, fractal.params, fractal.settings, fractal.temporal, width, height);
+        upscalePass->Render(fractalRenderer->GetTemporalTexture(), width, height, width, height, 0.0f);
+        return;
+    }
+    if (fractal.backend == FractalBackend::Gpu) {
+        fractalRenderer->Render(fractal.view, fractal.params, fractal.settings, width, height);
+        return;
+    }
+    fractalRenderer->Upload(fractal.pixels.data(), fractal.width, fractal.height);
+    upscalePass->Render(fractalRenderer->GetImageTexture(), fractal.width, fractal.height, fractal.width, fractal.height, 0.0f);
+}
+
+void Engine::RenderPacket(FramePacket& packet) {
+    PROFILE_ZONE("Engine::RenderPacket");
+    MEMORY_SCOPE(MemoryTag::Render);
+
+    {
+        // Loads queued by the main thread are expected to allocate
+        MEMORY_SCOPE(MemoryTag::Assets);
+        for (auto& command : packet.commands) {
+            command();
+        }
+        packet.commands.clear();
+        // Link variants requested since the last frame that have finished compiling
+        ShaderProgram::FinishReady();
+    }
+
+    if (packet.width != window->GetWidth() || packet.height != window->GetHeight()) {
+        window->Resize(packet.width, packet.height);
+    }
+
+    // Per-frame uniform and instance data is streamed; this waits if the GPU
+    // still holds the region from REGION_COUNT frames ago
+    StreamBuffer::GetInstance()->BeginFrame();
+
+    // Close holes left by unloaded meshes a little at a time
+    GeometryPool::GetInstance()->Defragment();
+
+    // Shadow maps first, they are sampled by the scene pass below
+    if (shadowRenderer && packet.shadows.bEnabled) {
+        shadowRenderer->Render(packet.shadows, meshRenderer->GetMesh());
+        window->BindBackBuffer();
+        meshRenderer->SetShadows(&packet.shadows.sampling, shadowRenderer->GetTexture());
+    }
+
+    // Scaled frames draw into the lower-left corner of the scene target and are
+    // upscaled into the back buffer; at full scale the scene draws there directly
+    int sceneWidth = packet.width;
+    int sceneHeight = packet.height;
+    bool bScaled = packet.renderScale < 1.0f;
+    if (bScaled) {
+        if (!sceneTarget) {
+            sceneTarget = std::make_unique<RenderTarget>();
+        }
+        int targetWidth = std::max(1, (int)std::ceil(packet.width * packet.maxRenderScale));
+        int targetHeight = std::max(1, (int)std::ceil(packet.height * packet.maxRenderScale));
+        if (!sceneTarget->Resize(targetWidth, targetHeight)) {
+            bScaled = false;
+        }
+        else {
+            sceneWidth = std::clamp((int)std::lround(packet.width * packet.renderScale), 1, targetWidth);
+            sceneHeight = std::clamp((int)std::lround(packet.height * packet.renderScale), 1, targetHeight);
+            sceneTarget->Bind();
+            glViewport(0, 0, sceneWidth, sceneHeight);
+        }
+    }
+
     window->Clear();
+
+    if (packet.fractal.IsEnabled()) {
+        RenderFractal(packet.fractal, sceneWidth, sceneHeight);
+    }
+    else {
+        // Render mesh
+        meshRenderer->SetLights(packet.lights);
+        meshRenderer->Render(packet.instances, packet.view, packet.projection, packet.viewPos);
+
+        // Render light spheres
+        lightRenderer->Render(packet.lights, packet.view, packet.projection);
+
+        // Render triangle
+        triangleRenderer->SetViewMatrix(packet.view);
+        triangleRenderer->SetProjectionMatrix(packet.projection);
+        triangleRenderer->Render();
+    }
+    // The packet's sampling data goes away with the packet
+    meshRenderer->SetShadows(nullptr, 0);
+
+    if (bScaled) {
+        window->BindBackBuffer();
+        upscalePass->Render(*sceneTarget, sceneWidth, sceneHeight, packet.sharpness);
+    }
+
+    // Read back before the swap
+    if (packet.bCapture) {
+        SaveFrame(config.capturePath);
+    }
+    StreamBuffer::GetInstance()->EndFrame();
     
-    // Render mesh
-    meshRenderer->SetLights(lights);
-    meshRenderer->Render(camera->getViewMatrix(), camera->getProjectionMatrix(), camera->getPosition());
-    
-    // Render light spheres
-    lightRenderer->Render(lights, camera->getViewMatrix(), camera->getProjectionMatrix());
-    
-    // Render triangle
-    triangleRenderer->SetViewMatrix(camera->getViewMatrix());
-    triangleRenderer->SetProjectionMatrix(camera->getProjectionMatrix());
-    triangleRenderer->Render();
-    
+    PROFILE_ZONE("Window::SwapBuffers");
     window->SwapBuffers();
 }
 
+void Engine::HandleResize(int width, int height) {
+    if (width <= 0 || height <= 0) {
+        return;
+    }
+    viewportWidth = width;
+    viewportHeight = height;
+    if (camera) {
+        camera->setPerspective(camera->getFOV(), (float)width / (float)height, camera->getNear(), camera->getFar());
+    }
+}
+
+void Engine::StartRenderThread() {
+    #ifndef __EMSCRIPTEN__
+    // GPU query frames move to the render thread along with the context
+    Profiler::GetInstance()->SetExternalGpuFrames(true);
+    frameMailbox.Reset();
+    window->ReleaseCurrent();
+    renderThread = std::thread(&Engine::RenderThreadMain, this);
+    std::cout << "Render thread started" << std::endl;
+    #endif
+}
+
+void Engine::StopRenderThread() {
+    if (!renderThread.joinable()) {
+        return;
+    }
+
+    // The render thread draws the last published packet before it exits
+    frameMailbox.Close();
+    renderThread.join();
+
+    // Shutdown and the destructors free GL objects from this thread
+    window->MakeCurrent();
+    Profiler::GetInstance()->SetExternalGpuFrames(false);
+    for (auto& command : pendingRenderCommands) {
+        command();
+    }
+    pendingRenderCommands.clear();
+}
+
+void Engine::RenderThreadMain() {
+    Profiler::GetInstance()->SetThreadName("Render");
+    window->MakeCurrent();
+    while (FramePacket* packet = frameMailbox.Acquire()) {
+        Profiler::GetInstance()->BeginGpuFrame(packet->frameIndex);
+        FrameArena::GetThreadArena().Reset();
+        RenderPacket(*packet);
+    }
+    window->ReleaseCurrent();
+}
+
 void Engine::Shutdown() {
     // Cleanup will be handled by unique_ptr destructors
+    StopRenderThread();
+    JobSystem::GetInstance()->Stop();
+    // The profiler outlives the engine; its queries belong to this engine's context
+    Profiler::GetInstance()->ShutdownGpuTimers();
+    if (benchmark) {
+        if (config.benchmarkOutput.empty()) {
+            std::cout << benchmark->GetReportJson(config.width, config.height, config.fixedTimestep);
+        }
+        else {
+            benchmark->WriteReport(config.benchmarkOutput, config.width, config.height, config.fixedTimestep);
+        }
+        benchmark.reset();
+    }
+    if (!config.recordPath.empty() && !recordedPath.IsEmpty()) {
+        if (recordedPath.Save(config.recordPath)) {
+            std::cout << "Camera path with " << recordedPath.GetKeyframeCount() << " keyframes written to " << config.recordPath << std::endl;
+        }
+        recordedPath.Clear();
+    }
+    if (!config.tracePath.empty()) {
+        Profiler::GetInstance()->StopCapture();
+        Profiler::GetInstance()->WriteTrace(config.tracePath);
+        config.tracePath.clear();
+    }
+}
+
+StreamBufferStats Engine::GetStreamBufferStats() const {
+    // Written by the render thread; only a snapshot while it is running
+    return StreamBuffer::GetInstance()->GetStats();
+}
+
+ProfileFrameSummary Engine::GetFrameSummary() const {
+    return Profiler::GetInstance()->GetFrameSummary();
+}
+
+std::vector<ProfileZoneStat> Engine::GetProfileZones() const {
+    return Profiler::GetInstance()->GetZoneStats();
+}
+
+void Engine::StartTrace() {
+    Profiler::GetInstance()->StartCapture();
+}
+
+std::string Engine::StopTrace() {
+    Profiler::GetInstance()->StopCapture();
+    return Profiler::GetInstance()->GetTraceJson();
+}
+
+bool Engine::SaveFrame(const std::string& path) {
+    PROFILE_ZONE("Engine::SaveFrame");
+    std::vector<unsigned char> pixels;
+    if (!window || !window->ReadPixels(pixels)) {
+        std::cerr << "Failed to read back frame" << std::endl;
+        return false;
+    }
+
+    // Binary PPM, RGB only
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open " << path << " for writing" << std::endl;
+        return false;
+    }
+    file << "P6\n" << window->GetWidth() << " " << window->GetHeight() << "\n255\n";
+    for (size_t i = 0; i < pixels.size(); i += 4) {
+        file.write(reinterpret_cast<const char*>(&pixels[i]), 3);
+    }
+    std::cout << "Saved frame to " << path << std::endl;
+    return (bool)file;
+}
+
+bool Engine::RenderAnimation() {
+    PROFILE_ZONE("Engine::RenderAnimation");
+    FractalAnimation animation;
+    if (!animation.Load(config.animationPath)) {
+        return false;
+    }
+
+    AnimationRenderSettings settings;
+    settings.outputDirectory = config.animationOutput;
+    settings.width = config.width;
+    settings.height = config.height;
+    settings.samples = std::max(config.animationSamples, 1);
+    const float aspect = (float)settings.width / (float)settings.height;
+    std::cout << "Animation " << config.animationPath << ": " << animation.GetFrameCount() << " frames at " << animation.GetFps()
+              << " fps, " << settings.width << "x" << settings.height << ", " << settings.samples << " samples on the "
+              << FractalBackendToString(config.fractalBackend) << " backend into " << settings.outputDirectory << std::endl;
+
+    if (config.fractalBackend == FractalBackend::Gpu) {
+        // fractal.frag traces one ray per pixel; samples become a supersampled grid
+        // the encoder jobs resolve, capped where the targets get unreasonably large
+        int factor = std::clamp((int)std::ceil(std::sqrt((float)settings.samples) - 0.001f), 1, 4);
+        return animationRenderer.Render(animation, settings,
+            [this, &settings, aspect, factor](const FractalAnimationFrame& frame, int slot, AnimationImage&) {
+                return fractalRenderer->BeginReadback(frame.GetView(aspect), frame.params, fractalSettings,
+                                                      settings.width * factor, settings.height * factor, slot);
+            },
+            [this](int slot, AnimationImage& image) {
+                return fractalRenderer->FinishReadback(slot, image.pixels, image.width, image.height);
+            });
+    }
+    return animationRenderer.Render(animation, settings,
+        [this, &settings, aspect](const FractalAnimationFrame& frame, int, AnimationImage& image) {
+            image.width = settings.width;
+            image.height = settings.height;
+            image.pixels.resize((size_t)image.width * (size_t)image.height);
+            cpuRayMarcher.RenderSamples(frame.GetView(aspect), frame.params, fractalSettings, image.width, image.height,
+                                        settings.samples, image.pixels.data());
+            return true;
+        });
 }
 
 
@@ -256,6 +1221,11 @@ void Engine::Shutdown() {
 
 
 void Engine::UpdateLightAnimation(float time) {
+    if (benchmark) {
+        benchmark->GetScene().AnimateLights(lights, time);
+        return;
+    }
+
     float t = std::sin(time);
 
     // Light 0: oscillate in y
@@ -272,12 +1242,77 @@ void Engine::UpdateLightAnimation(float time) {
 }
 
 void Engine::LoadModel(const std::string& path) {
-    mesh = std::make_unique<Mesh>(path);
-    if (!mesh || mesh->vertices.empty()) {
+    if (renderThread.joinable()) {
+        // Loading uploads buffers and textures, so it runs where the context lives
+        pendingRenderCommands.push_back([this, path]() { LoadModelNow(path); });
+        return;
+    }
+    LoadModelNow(path);
+}
+
+void Engine::LoadModelNow(const std::string& path) {
+    PROFILE_ZONE("Engine::LoadModel");
+    std::unique_ptr<Mesh> loaded = std::make_unique<Mesh>(path);
+    if (loaded->vertices.empty()) {
         std::cerr << "Failed to load " << path << std::endl;
         return;
     }
+    SetMeshNow(std::move(loaded));
+}
+
+void Engine::LoadFractalMesh(int resolution) {
+    PROFILE_ZONE("Engine::LoadFractalMesh");
+    SurfaceMeshSettings settings;
+    settings.resolution = resolution;
+    std::shared_ptr<SurfaceMesh> surface;
+    {
+        MEMORY_SCOPE(MemoryTag::Assets);
+        surface = std::make_shared<SurfaceMesh>(surfaceMesher.Extract(fractalParams, settings));
+    }
+    const SurfaceMeshStats& stats = surfaceMesher.GetStats();
+    std::cout << "Fractal mesh: " << stats.triangles << " triangles at " << stats.resolution << "^3 in " << stats.ms << " ms ("
+              << stats.trianglesPerSecond / 1.0e6f << " Mtris/s), peak " << (double)stats.peakBytes / (1024.0 * 1024.0) << " MB"
+              << std::endl;
+    if (surface->indices.empty()) {
+        std::cerr << "Fractal mesh: no surface at resolution " << resolution << std::endl;
+        return;
+    }
+    if (!config.fractalMeshPath.empty()) {
+        surface->SaveObj(config.fractalMeshPath);
+    }
+
+    auto build = [this, surface]() {
+        // Roughly the size of the default model, so the scene's instances keep their spacing
+        const float FRACTAL_MESH_SCALE = 4.0f;
+        std::vector<Vertex> vertices(surface->positions.size());
+        for (size_t i = 0; i < vertices.size(); i++) {
+            Vertex& vertex = vertices[i];
+            vertex.position = surface->positions[i] * FRACTAL_MESH_SCALE;
+            vertex.normal = surface->normals[i];
+            vertex.texCoords = glm::vec2(0.0f);
+            // Any frame around the normal; the mesh has no normal map to follow
+            glm::vec3 axis = std::fabs(vertex.normal.y) < 0.9f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+            vertex.tangent = glm::normalize(glm::cross(axis, vertex.normal));
+            vertex.bitangent = glm::cross(vertex.normal, vertex.tangent);
+        }
+        std::vector<unsigned int> indices(surface->indices.begin(), surface->indices.end());
+        SetMeshNow(std::make_unique<Mesh>(std::move(vertices), std::move(indices)));
+    };
+    if (renderThread.joinable()) {
+        // The upload runs where the context lives
+        pendingRenderCommands.push_back(build);
+        return;
+    }
+    build();
+}
+
+void Engine::SetMeshNow(std::unique_ptr<Mesh> loaded) {
+    mesh = std::move(loaded);
     meshRenderer->SetMesh(mesh.get());
+
+    std::lock_guard<std::mutex> lock(meshBoundsMutex);
+    meshBoundsCenter = mesh->boundsCenter;
+    meshBoundsRadius = mesh->boundsRadius;
 }
 
 void Engine::HandleFileDrop(const std::string& filePath) {
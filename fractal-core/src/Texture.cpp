@@ -1,4 +1,5 @@
 #include "Texture.h"
+#include "profiler.h"
 
 Texture::Texture() {
     this->type = TextureType::UNKNOWN;
@@ -47,6 +48,7 @@ void Texture::CreateTextureFromData(const TextureData& data, const TextureParame
     0, 
     this->data.format, 
     GL_UNSIGNED_BYTE, this->data.pixels);
+    Profiler::CountUpload((uint64_t)this->data.width * this->data.height * this->data.channels);
 
     GLenum error = glGetError();
     if (error != GL_NO_ERROR) {
@@ -9,6 +9,7 @@
 #include "TextureManager.h"
 #include "Texture.h"
 #include "assetutils.h"
+#include "profiler.h"
 
 
 TextureManager* TextureManager::instance = nullptr;
@@ -35,6 +36,7 @@ TextureManager::~TextureManager() {
 
 
 std::shared_ptr<Texture> TextureManager::LoadTexture(const std::string& path, TextureType type) {
+    PROFILE_ZONE("TextureManager::LoadTexture");
     //check if texture is already loaded
     std::shared_ptr<Texture> texture = GetTexture(path);
     if(texture != nullptr) {
@@ -62,6 +62,10 @@ std::string AssetUtils::getShadersDir() {
     return getAssetsRoot() + "/shaders";
 }
 
+std::string AssetUtils::getBenchmarksDir() {
+    return getAssetsRoot() + "/benchmarks";
+}
+
 std::string AssetUtils::resolveAssetPath(const std::string& relativePath) {
     if (relativePath.empty()) {
         return "";
@@ -129,6 +133,24 @@ std::string AssetUtils::resolveShaderPath(const std::string& shaderName) {
     return normalizePath(fullPath);
 }
 
+std::string AssetUtils::resolveBenchmarkPath(const std::string& sceneName) {
+    if (sceneName.empty()) {
+        return "";
+    }
+
+    // Paths that exist as given (relative to the working directory) win
+    if (::fileExists(sceneName)) {
+        return normalizePath(sceneName);
+    }
+
+    // Otherwise treat it as a scene name, with or without the extension
+    std::string fileName = sceneName;
+    if (fileName.size() < 6 || fileName.substr(fileName.size() - 6) != ".scene") {
+        fileName += ".scene";
+    }
+    return normalizePath(getBenchmarksDir() + "/" + fileName);
+}
+
 bool AssetUtils::fileExists(const std::string& path) {
     return ::fileExists(path);
 }
@@ -0,0 +1,413 @@
+// benchmark.cpp
+
+// C++ standard library
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#ifdef __EMSCRIPTEN__
+#include <emscripten/heap.h>
+#else
+#include <sys/resource.h>
+#endif
+
+// glm
+#include <glm/gtc/matrix_transform.hpp>
+
+// local headers
+#include "benchmark.h"
+#include "streambuffer.h"
+#include "geometrypool.h"
+#include "assetutils.h"
+
+bool BenchmarkScene::Load(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open benchmark scene: " << path << std::endl;
+        return false;
+    }
+
+    // Scene name defaults to the file name
+    name = path.substr(path.find_last_of("/\\") + 1);
+    name = name.substr(0, name.find_last_of('.'));
+
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        std::istringstream stream(line);
+        std::string keyword;
+        if (!(stream >> keyword) || keyword[0] == '#') {
+            continue;
+        }
+
+        bool bOk = true;
+        if (keyword == "name") {
+            bOk = (bool)(stream >> name);
+        }
+        else if (keyword == "model") {
+            bOk = (bool)(stream >> model);
+            if (bOk) {
+                models.push_back(model);
+            }
+        }
+        else if (keyword == "instances") {
+            bOk = (bool)(stream >> instanceCount);
+            stream >> instanceSpacing;
+        }
+        else if (keyword == "lights") {
+            bOk = (bool)(stream >> lightCount);
+            stream >> lightRadius >> lightHeight >> lightIntensity >> lightSpeed;
+        }
+        else if (keyword == "spots") {
+            bOk = (bool)(stream >> spotCount);
+            stream >> spotAngle;
+        }
+        else if (keyword == "sun") {
+            bOk = (bool)(stream >> sunDirection.x >> sunDirection.y >> sunDirection.z);
+            stream >> sunIntensity;
+            bSun = bOk && glm::length(sunDirection) > 0.0f;
+            bOk = bOk && bSun;
+        }
+        else if (keyword == "shadows") {
+            bShadows = true;
+        }
+        else if (keyword == "fractal") {
+            std::string backend, type;
+            bOk = (bool)(stream >> backend) && (backend == "cpu" || backend == "gpu");
+            fractalBackend = backend == "cpu" ? FractalBackend::Cpu : FractalBackend::Gpu;
+            if (stream >> type) {
+                bOk = bOk && (type == "mandelbulb" || type == "julia");
+                fractalType = type == "julia" ? FractalType::QuaternionJulia : FractalType::Mandelbulb;
+            }
+        }
+        else if (keyword == "deepzoom") {
+            bOk = (bool)(stream >> deepZoomX >> deepZoomY >> deepZoomScale) && deepZoomScale > 0.0;
+            stream >> deepZoomIterations;
+            bDeepZoom = bOk;
+        }
+        else if (keyword == "orbit") {
+            float radius, height, period, targetY = 0.0f;
+            bOk = (bool)(stream >> radius >> height >> period);
+            stream >> targetY;
+            if (bOk) {
+                AddOrbit(radius, height, period, targetY);
+            }
+        }
+        else if (keyword == "camera") {
+            CameraKeyframe key;
+            bOk = (bool)(stream >> key.time >> key.position.x >> key.position.y >> key.position.z
+                               >> key.target.x >> key.target.y >> key.target.z);
+            if (bOk) {
+                cameraPath.AddKeyframe(key.time, key.position, key.target);
+            }
+        }
+        else if (keyword == "path") {
+            std::string pathFile;
+            bOk = (bool)(stream >> pathFile);
+            if (bOk) {
+                std::string resolved = AssetUtils::fileExists(pathFile) ? pathFile : AssetUtils::getBenchmarksDir() + "/" + pathFile;
+                bOk = cameraPath.Load(resolved);
+            }
+        }
+        else {
+            std::cerr << path << ":" << lineNumber << ": unknown keyword '" << keyword << "'" << std::endl;
+            return false;
+        }
+
+        if (!bOk) {
+            std::cerr << path << ":" << lineNumber << ": malformed '" << keyword << "' line" << std::endl;
+            return false;
+        }
+    }
+
+    if (models.empty()) {
+        models.push_back(model);
+    }
+    model = models.front();
+
+    // No camera given: orbit the instance grid
+    if (cameraPath.IsEmpty()) {
+        float side = std::ceil(std::sqrt((float)std::max(instanceCount, 1u)));
+        float radius = std::max(side * instanceSpacing, 40.0f);
+        AddOrbit(radius, radius * 0.4f, 20.0f, 0.0f);
+    }
+    return true;
+}
+
+float BenchmarkScene::GetViewDistance() const {
+    float side = std::ceil(std::sqrt((float)std::max(instanceCount, 1u))) * instanceSpacing;
+    float farthest = 0.0f;
+    for (const CameraKeyframe& keyframe : cameraPath.GetKeyframes()) {
+        farthest = std::max(farthest, glm::length(keyframe.position));
+    }
+    return std::max(100.0f, farthest + side);
+}
+
+void BenchmarkScene::AddOrbit(float radius, float height, float period, float targetY) {
+    // Eight segments are plenty for Catmull-Rom to trace a smooth circle
+    const int segments = 8;
+    cameraPath.Clear();
+    for (int i = 0; i <= segments; i++) {
+        float angle = glm::two_pi<float>() * (float)i / (float)segments;
+        glm::vec3 position(radius * std::sin(angle), height, radius * std::cos(angle));
+        cameraPath.AddKeyframe(period * (float)i / (float)segments, position, glm::vec3(0.0f, targetY, 0.0f));
+    }
+    cameraPath.SetLooping(true);
+}
+
+std::vector<glm::mat4> BenchmarkScene::GetInstanceTransforms() const {
+    std::vector<glm::mat4> transforms;
+    transforms.reserve(instanceCount);
+
+    unsigned int side = (unsigned int)std::ceil(std::sqrt((float)instanceCount));
+    float offset = (float)(side - 1) * 0.5f;
+    for (unsigned int i = 0; i < instanceCount; i++) {
+        float x = ((float)(i % side) - offset) * instanceSpacing;
+        float z = ((float)(i / side) - offset) * instanceSpacing;
+        glm::mat4 transform = glm::translate(glm::mat4(1.0f), glm::vec3(x, 0.0f, z));
+        // Same orientation as the default scene
+        transform = glm::rotate(transform, glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
+        transforms.push_back(transform);
+    }
+    return transforms;
+}
+
+std::vector<Light> BenchmarkScene::CreateLights() const {
+    std::vector<Light> lights;
+    lights.reserve(lightCount);
+    for (unsigned int i = 0; i < lightCount; i++) {
+        // Spread hues evenly so every light is distinguishable in captures
+        float hue = (float)i / (float)std::max(lightCount, 1u);
+        glm::vec3 color(
+            0.5f + 0.5f * std::cos(glm::two_pi<float>() * hue),
+            0.5f + 0.5f * std::cos(glm::two_pi<float>() * (hue - 1.0f / 3.0f)),
+            0.5f + 0.5f * std::cos(glm::two_pi<float>() * (hue - 2.0f / 3.0f)));
+        Light::Type type = i < spotCount ? Light::Type::Spot : Light::Type::Point;
+        lights.push_back(Light(type, glm::vec3(0.0f), glm::vec3(0.0f, -1.0f, 0.0f), color, lightIntensity, 10.0f));
+        lights.back().setSpotAngle(spotAngle);
+    }
+    // The sun comes after the ring and never moves
+    if (bSun) {
+        lights.push_back(Light(Light::Type::Directional, glm::vec3(0.0f), glm::normalize(sunDirection), glm::vec3(1.0f, 0.95f, 0.85f), sunIntensity));
+    }
+    AnimateLights(lights, 0.0f);
+    return lights;
+}
+
+void BenchmarkScene::AnimateLights(std::vector<Light>& lights, float time) const {
+    // Only the ring moves
+    size_t count = std::min(lights.size(), (size_t)lightCount);
+    for (size_t i = 0; i < count; i++) {
+        float phase = glm::two_pi<float>() * (float)i / (float)count;
+        float angle = phase + time * lightSpeed;
+        float bob = std::sin(time + phase) * lightHeight * 0.25f;
+        glm::vec3 position(lightRadius * std::sin(angle), lightHeight + bob, lightRadius * std::cos(angle));
+        lights[i].setPosition(position);
+        if (lights[i].getType() == Light::Type::Spot) {
+            lights[i].setDirection(glm::normalize(-position));
+        }
+    }
+}
+
+BenchmarkStats BenchmarkStats::FromSamples(std::vector<float> samples) {
+    BenchmarkStats stats;
+    stats.samples = (unsigned int)samples.size();
+    if (samples.empty()) {
+        return stats;
+    }
+
+    std::sort(samples.begin(), samples.end());
+    double sum = 0.0;
+    for (float sample : samples) {
+        sum += sample;
+    }
+    auto percentile = [&samples](float p) {
+        size_t rank = (size_t)std::ceil(p * (float)samples.size());
+        return samples[std::min(std::max(rank, (size_t)1), samples.size()) - 1];
+    };
+
+    stats.mean = (float)(sum / samples.size());
+    stats.p50 = percentile(0.50f);
+    stats.p95 = percentile(0.95f);
+    stats.p99 = percentile(0.99f);
+    stats.max = samples.back();
+    return stats;
+}
+
+Benchmark::Benchmark(const BenchmarkScene& scene, unsigned int warmupFrames)
+    : scene(scene), warmupFrames(warmupFrames)
+{
+}
+
+void Benchmark::ReserveFrames(unsigned int frames) {
+    cpuFrameMs.reserve(frames);
+    gpuFrameMs.reserve(frames);
+    drawCalls.reserve(frames);
+    triangles.reserve(frames);
+    stateChanges.reserve(frames);
+    heapAllocations.reserve(frames);
+    shadowUpdates.reserve(frames);
+    cpuMraysPerSecond.reserve(frames);
+}
+
+void Benchmark::UpdateCamera(Camera& camera, float time) const {
+    if (scene.cameraPath.IsEmpty()) {
+        return;
+    }
+    glm::vec3 position;
+    glm::vec3 target;
+    scene.cameraPath.Evaluate(time, position, target);
+    camera.setPosition(position);
+    camera.lookAt(target);
+}
+
+void Benchmark::RecordFrame(const ProfileFrameSummary& summary) {
+    seenFrames++;
+    if (seenFrames <= warmupFrames) {
+        return;
+    }
+    lastMeasuredTime = std::chrono::steady_clock::now();
+    if (cpuFrameMs.empty()) {
+        firstMeasuredFrame = summary.frameIndex;
+        firstMeasuredTime = lastMeasuredTime;
+    }
+
+    cpuFrameMs.push_back(summary.cpuFrameMs);
+    drawCalls.push_back((float)summary.drawCalls);
+    triangles.push_back((float)summary.triangles);
+    stateChanges.push_back((float)summary.stateChanges);
+    heapAllocations.push_back((float)summary.heapAllocations);
+    shadowUpdates.push_back((float)summary.shadowUpdates);
+    if (fractalBackend == FractalBackend::Cpu) {
+        cpuMraysPerSecond.push_back(summary.cpuMraysPerSecond);
+    }
+    uploadBytes += summary.uploadBytes;
+
+    // GPU results trail the CPU; only count frames from the measured range
+    if (summary.gpuFrameIndex >= firstMeasuredFrame && summary.gpuFrameMs > 0.0f) {
+        gpuFrameMs.push_back(summary.gpuFrameMs);
+    }
+}
+
+uint64_t Benchmark::GetPeakMemoryKB() {
+    #ifdef __EMSCRIPTEN__
+    return emscripten_get_heap_size() / 1024;
+    #else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+    return (uint64_t)usage.ru_maxrss;   // kilobytes on Linux
+    #endif
+}
+
+namespace {
+void WriteStats(std::ostream& out, const char* name, const BenchmarkStats& stats, bool bLast = false) {
+    out << "    \"" << name << "\": { "
+        << "\"mean\": " << stats.mean << ", "
+        << "\"p50\": " << stats.p50 << ", "
+        << "\"p95\": " << stats.p95 << ", "
+        << "\"p99\": " << stats.p99 << ", "
+        << "\"max\": " << stats.max << ", "
+        << "\"samples\": " << stats.samples << " }" << (bLast ? "\n" : ",\n");
+}
+}
+
+std::string Benchmark::GetReportJson(int width, int height, float fixedTimestep) const {
+    std::ostringstream out;
+    out << "{\n";
+    out << "  \"scene\": \"" << scene.name << "\",\n";
+    out << "  \"model\": \"" << scene.model << "\",\n";
+    out << "  \"instances\": " << scene.instanceCount << ",\n";
+    out << "  \"lights\": " << scene.lightCount << ",\n";
+    out << "  \"width\": " << width << ",\n";
+    out << "  \"height\": " << height << ",\n";
+    out << "  \"fixedTimestep\": " << fixedTimestep << ",\n";
+    out << "  \"warmupFrames\": " << warmupFrames << ",\n";
+    out << "  \"measuredFrames\": " << cpuFrameMs.size() << ",\n";
+    out << "  \"renderThread\": " << (bRenderThreaded ? "true" : "false") << ",\n";
+    out << "  \"models\": " << scene.models.size() << ",\n";
+    out << "  \"mergedGeometry\": " << (bMergedGeometry ? "true" : "false") << ",\n";
+    out << "  \"multiDraw\": " << (bMultiDraw ? "true" : "false") << ",\n";
+    out << "  \"shadows\": " << (bShadows ? "true" : "false") << ",\n";
+    out << "  \"fractal\": \"" << FractalBackendToString(fractalBackend) << "\",\n";
+    if (bFractalMesh) {
+        out << "  \"fractalMesh\": { \"resolution\": " << meshStats.resolution
+            << ", \"triangles\": " << meshStats.triangles
+            << ", \"vertices\": " << meshStats.vertices
+            << ", \"ms\": " << meshStats.ms
+            << ", \"trianglesPerSecond\": " << meshStats.trianglesPerSecond
+            << ", \"peakMegabytes\": " << (double)meshStats.peakBytes / (1024.0 * 1024.0) << " },\n";
+    }
+    if (fractalBackend != FractalBackend::None) {
+        out << "  \"fractalType\": \"" << FractalTypeToString(scene.fractalType) << "\",\n";
+        out << "  \"fractalKernel\": \"" << fractalKernel << "\",\n";
+        out << "  \"simdWidth\": " << simdWidth << ",\n";
+        out << "  \"jobThreads\": " << jobThreads << ",\n";
+        if (bDeepZoom) {
+            out << "  \"deepZoom\": { \"scale\": " << deepZoomScale
+                << ", \"iterations\": " << deepZoomIterations
+                << ", \"limbs\": " << deepZoomLimbs
+                << ", \"referenceMs\": " << deepZoomReferenceMs
+                << ", \"referenceLength\": " << deepZoomReferenceLength << " },\n";
+        }
+    }
+
+    // Frames completed per second of wall clock; with a render thread this is
+    // the pipelined rate, which the per-frame CPU time alone doesn't show
+    double measuredSeconds = std::chrono::duration<double>(lastMeasuredTime - firstMeasuredTime).count();
+    double framesPerSecond = cpuFrameMs.size() > 1 && measuredSeconds > 0.0 ? (cpuFrameMs.size() - 1) / measuredSeconds : 0.0;
+    out << "  \"framesPerSecond\": " << framesPerSecond << ",\n";
+    out << "  \"gpuTimersAvailable\": " << (gpuFrameMs.empty() ? "false" : "true") << ",\n";
+    out << "  \"stats\": {\n";
+    WriteStats(out, "cpuFrameMs", BenchmarkStats::FromSamples(cpuFrameMs));
+    WriteStats(out, "gpuFrameMs", BenchmarkStats::FromSamples(gpuFrameMs));
+    WriteStats(out, "drawCalls", BenchmarkStats::FromSamples(drawCalls));
+    WriteStats(out, "triangles", BenchmarkStats::FromSamples(triangles));
+    WriteStats(out, "stateChanges", BenchmarkStats::FromSamples(stateChanges));
+    WriteStats(out, "heapAllocations", BenchmarkStats::FromSamples(heapAllocations));
+    WriteStats(out, "shadowUpdates", BenchmarkStats::FromSamples(shadowUpdates));
+    WriteStats(out, "cpuMraysPerSecond", BenchmarkStats::FromSamples(cpuMraysPerSecond), true);
+    out << "  },\n";
+    out << "  \"uploadBytes\": " << uploadBytes << ",\n";
+
+    // Report runs after the render thread has stopped, so the stats are final
+    const StreamBufferStats& stream = StreamBuffer::GetInstance()->GetStats();
+    out << "  \"streamBuffer\": { "
+        << "\"persistent\": " << (stream.bPersistent ? "true" : "false") << ", "
+        << "\"regionBytes\": " << stream.regionBytes << ", "
+        << "\"peakFrameBytes\": " << stream.peakFrameBytes << ", "
+        << "\"grows\": " << stream.grows << ", "
+        << "\"fenceWaits\": " << stream.fenceWaits << ", "
+        << "\"totalWaitMs\": " << stream.totalWaitMs << ", "
+        << "\"maxWaitMs\": " << stream.maxWaitMs << " },\n";
+    const GeometryPoolStats geometry = GeometryPool::GetInstance()->GetStats();
+    out << "  \"geometryPool\": { "
+        << "\"meshes\": " << geometry.meshes << ", "
+        << "\"vertexUsed\": " << geometry.vertexUsed << ", "
+        << "\"vertexCapacity\": " << geometry.vertexCapacity << ", "
+        << "\"indexUsed\": " << geometry.indexUsed << ", "
+        << "\"indexCapacity\": " << geometry.indexCapacity << ", "
+        << "\"occupancy\": " << geometry.occupancy << ", "
+        << "\"fragmentation\": " << geometry.fragmentation << ", "
+        << "\"grows\": " << geometry.grows << ", "
+        << "\"moves\": " << geometry.moves << ", "
+        << "\"movedBytes\": " << geometry.movedBytes << " },\n";
+    out << "  \"peakMemoryKB\": " << GetPeakMemoryKB() << "\n";
+    out << "}\n";
+    return out.str();
+}
+
+bool Benchmark::WriteReport(const std::string& path, int width, int height, float fixedTimestep) const {
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Failed to write benchmark report: " << path << std::endl;
+        return false;
+    }
+    file << GetReportJson(width, height, fixedTimestep);
+    std::cout << "Benchmark report written to " << path << std::endl;
+    return (bool)file;
+}
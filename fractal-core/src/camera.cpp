@@ -47,6 +47,14 @@ glm::vec3 Camera::getScale() const {
     return m_scale;
 }
 
+void Camera::setOrientation(const glm::quat& orientation) {
+    m_rotation = glm::normalize(orientation);
+}
+
+glm::quat Camera::getOrientation() const {
+    return m_rotation;
+}
+
 // First-person movement methods
 void Camera::moveForward(float distance) {
     m_position += getLocalForward() * distance;
@@ -65,6 +73,14 @@ void Camera::moveLocal(const glm::vec3& direction, float distance) {
 }
 
 // First-person rotation methods
+void Camera::lookAt(const glm::vec3& target) {
+    glm::vec3 direction = target - m_position;
+    if (glm::dot(direction, direction) < 1e-8f) {
+        return;
+    }
+    m_rotation = glm::quatLookAt(glm::normalize(direction), WORLD_UP);
+}
+
 void Camera::rotateYaw(float angle) {
     // Rotate around world up vector
     glm::quat yawRotation = glm::angleAxis(angle, WORLD_UP);
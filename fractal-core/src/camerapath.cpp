@@ -0,0 +1,141 @@
+// camerapath.cpp
+
+// C++ standard library
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+// local headers
+#include "camerapath.h"
+
+namespace {
+glm::vec3 CatmullRom(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3, float u) {
+    float u2 = u * u;
+    float u3 = u2 * u;
+    return 0.5f * ((2.0f * p1) +
+                   (p2 - p0) * u +
+                   (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * u2 +
+                   (3.0f * p1 - p0 - 3.0f * p2 + p3) * u3);
+}
+}
+
+void CameraPath::AddKeyframe(float time, const glm::vec3& position, const glm::vec3& target) {
+    CameraKeyframe key;
+    key.time = time;
+    key.position = position;
+    key.target = target;
+
+    // Keep keys sorted so Evaluate can binary search
+    auto it = std::upper_bound(keyframes.begin(), keyframes.end(), time,
+        [](float t, const CameraKeyframe& k) { return t < k.time; });
+    keyframes.insert(it, key);
+}
+
+float CameraPath::GetDuration() const {
+    if (keyframes.size() < 2) {
+        return 0.0f;
+    }
+    return keyframes.back().time - keyframes.front().time;
+}
+
+void CameraPath::Evaluate(float time, glm::vec3& position, glm::vec3& target) const {
+    if (keyframes.empty()) {
+        return;
+    }
+    if (keyframes.size() == 1) {
+        position = keyframes[0].position;
+        target = keyframes[0].target;
+        return;
+    }
+
+    const float start = keyframes.front().time;
+    const float end = keyframes.back().time;
+    const float duration = end - start;
+    if (bLoop && duration > 0.0f) {
+        time = start + std::fmod(std::fmod(time - start, duration) + duration, duration);
+    }
+    time = std::min(std::max(time, start), end);
+
+    // Segment [i, i + 1] containing time
+    auto it = std::upper_bound(keyframes.begin(), keyframes.end(), time,
+        [](float t, const CameraKeyframe& k) { return t < k.time; });
+    int count = (int)keyframes.size();
+    int i = std::min(std::max((int)(it - keyframes.begin()) - 1, 0), count - 2);
+
+    // Neighbours clamp at the ends, or wrap past the duplicated closing key when looping
+    int i0 = i - 1;
+    int i3 = i + 2;
+    if (bLoop && count > 2) {
+        if (i0 < 0) i0 = count - 2;
+        if (i3 > count - 1) i3 = 1;
+    }
+    else {
+        i0 = std::max(i0, 0);
+        i3 = std::min(i3, count - 1);
+    }
+
+    const CameraKeyframe& k0 = keyframes[i0];
+    const CameraKeyframe& k1 = keyframes[i];
+    const CameraKeyframe& k2 = keyframes[i + 1];
+    const CameraKeyframe& k3 = keyframes[i3];
+
+    float span = k2.time - k1.time;
+    float u = span > 0.0f ? (time - k1.time) / span : 0.0f;
+
+    position = CatmullRom(k0.position, k1.position, k2.position, k3.position, u);
+    target = CatmullRom(k0.target, k1.target, k2.target, k3.target, u);
+}
+
+bool CameraPath::Load(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open camera path: " << path << std::endl;
+        return false;
+    }
+
+    keyframes.clear();
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        std::istringstream stream(line);
+        std::string keyword;
+        if (!(stream >> keyword) || keyword[0] == '#') {
+            continue;
+        }
+        if (keyword == "loop") {
+            int loop = 0;
+            stream >> loop;
+            bLoop = loop != 0;
+            continue;
+        }
+        CameraKeyframe key;
+        if (keyword != "key" ||
+            !(stream >> key.time >> key.position.x >> key.position.y >> key.position.z
+                     >> key.target.x >> key.target.y >> key.target.z)) {
+            std::cerr << path << ":" << lineNumber << ": expected 'key <time> <px> <py> <pz> <tx> <ty> <tz>'" << std::endl;
+            return false;
+        }
+        AddKeyframe(key.time, key.position, key.target);
+    }
+    return !keyframes.empty();
+}
+
+bool CameraPath::Save(const std::string& path) const {
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Failed to write camera path: " << path << std::endl;
+        return false;
+    }
+
+    file << "# key <time> <position xyz> <target xyz>\n";
+    file << "loop " << (bLoop ? 1 : 0) << "\n";
+    for (const CameraKeyframe& key : keyframes) {
+        file << "key " << key.time << " "
+             << key.position.x << " " << key.position.y << " " << key.position.z << " "
+             << key.target.x << " " << key.target.y << " " << key.target.z << "\n";
+    }
+    return (bool)file;
+}
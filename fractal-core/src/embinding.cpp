@@ -15,6 +15,7 @@
 #include "light.h"
 #include "meshrenderer.h"
 #include "Engine.h"
+#include "profiler.h"
 
 EMSCRIPTEN_BINDINGS(my_module) {
 
@@ -121,6 +122,15 @@ EMSCRIPTEN_BINDINGS(my_module) {
         .value("Directional", Light::Type::Directional)
         .value("Spot", Light::Type::Spot);
     
+    emscripten::enum_<FractalBackend>("FractalBackend")
+        .value("None", FractalBackend::None)
+        .value("Cpu", FractalBackend::Cpu)
+        .value("Gpu", FractalBackend::Gpu);
+
+    emscripten::enum_<FractalType>("FractalType")
+        .value("Mandelbulb", FractalType::Mandelbulb)
+        .value("QuaternionJulia", FractalType::QuaternionJulia);
+    
     // Mesh class
     emscripten::class_<Mesh>("Mesh")
         .constructor<const std::string&>()
@@ -139,7 +149,7 @@ EMSCRIPTEN_BINDINGS(my_module) {
         .function("setMaterial", &MeshRenderer::SetMaterial)
         .function("setLight", &MeshRenderer::SetLight)
         .function("setLights", &MeshRenderer::SetLights)
-        .function("render", &MeshRenderer::Render)
+        .function("render", emscripten::select_overload<void(const glm::mat4&, const glm::mat4&, const glm::vec3&)>(&MeshRenderer::Render))
         .function("loadShaders", &MeshRenderer::LoadShaders)
         .function("useShader", &MeshRenderer::UseShader);
 
@@ -176,6 +186,46 @@ EMSCRIPTEN_BINDINGS(my_module) {
         .function("getDeltaX", &Mouse::GetDeltaX)
         .function("getDeltaY", &Mouse::GetDeltaY);
     
+    // Profiler results
+    emscripten::value_object<ProfileFrameSummary>("ProfileFrameSummary")
+        .field("frameIndex", &ProfileFrameSummary::frameIndex)
+        .field("cpuFrameMs", &ProfileFrameSummary::cpuFrameMs)
+        .field("gpuFrameIndex", &ProfileFrameSummary::gpuFrameIndex)
+        .field("gpuFrameMs", &ProfileFrameSummary::gpuFrameMs)
+        .field("drawCalls", &ProfileFrameSummary::drawCalls)
+        .field("triangles", &ProfileFrameSummary::triangles)
+        .field("stateChanges", &ProfileFrameSummary::stateChanges)
+        .field("bufferUploads", &ProfileFrameSummary::bufferUploads)
+        .field("uploadBytes", &ProfileFrameSummary::uploadBytes)
+        .field("defragmentBytes", &ProfileFrameSummary::defragmentBytes)
+        .field("shadowUpdates", &ProfileFrameSummary::shadowUpdates)
+        .field("geometryOccupancy", &ProfileFrameSummary::geometryOccupancy)
+        .field("geometryFragmentation", &ProfileFrameSummary::geometryFragmentation)
+        .field("cpuMraysPerSecond", &ProfileFrameSummary::cpuMraysPerSecond)
+        .field("fractalCompletion", &ProfileFrameSummary::fractalCompletion)
+        .field("heapAllocations", &ProfileFrameSummary::heapAllocations)
+        .field("heapBytes", &ProfileFrameSummary::heapBytes);
+
+    emscripten::value_object<ProfileZoneStat>("ProfileZoneStat")
+        .field("name", &ProfileZoneStat::name)
+        .field("cpuMs", &ProfileZoneStat::cpuMs)
+        .field("gpuMs", &ProfileZoneStat::gpuMs)
+        .field("calls", &ProfileZoneStat::calls);
+
+    emscripten::register_vector<ProfileZoneStat>("ProfileZoneStatVector");
+
+    emscripten::value_object<StreamBufferStats>("StreamBufferStats")
+        .field("frames", &StreamBufferStats::frames)
+        .field("fenceWaits", &StreamBufferStats::fenceWaits)
+        .field("lastWaitMs", &StreamBufferStats::lastWaitMs)
+        .field("totalWaitMs", &StreamBufferStats::totalWaitMs)
+        .field("maxWaitMs", &StreamBufferStats::maxWaitMs)
+        .field("lastFrameBytes", &StreamBufferStats::lastFrameBytes)
+        .field("peakFrameBytes", &StreamBufferStats::peakFrameBytes)
+        .field("regionBytes", &StreamBufferStats::regionBytes)
+        .field("grows", &StreamBufferStats::grows)
+        .field("persistent", &StreamBufferStats::bPersistent);
+
     // Engine class
     emscripten::class_<Engine>("Engine")
         .constructor<>()
@@ -184,13 +234,43 @@ EMSCRIPTEN_BINDINGS(my_module) {
         .function("handleKeyboardInput", &Engine::HandleKeyboardInput)
         .function("handleMouseMoveEvent", &Engine::HandleMouseMoveEvent)
         .function("handleMouseButtonEvent", &Engine::HandleMouseButtonEvent)
-        .function("update", &Engine::Update)
-        .function("render", &Engine::Render)
+        .function("frame", &Engine::Frame)
+        .function("setTargetFps", &Engine::SetTargetFps)
+        .function("getFrameJitterMs", &Engine::GetFrameJitterMs)
+        .function("getRenderScale", &Engine::GetRenderScale)
+        .function("setDynamicResolution", &Engine::SetDynamicResolution)
+        .function("setRenderScaleBounds", &Engine::SetRenderScaleBounds)
+        .function("setTargetGpuMs", &Engine::SetTargetGpuMs)
+        .function("setFractalBackend", &Engine::SetFractalBackend)
+        .function("getFractalBackend", &Engine::GetFractalBackend)
+        .function("setFractalType", &Engine::SetFractalType)
+        .function("setFractalPower", &Engine::SetFractalPower)
+        .function("setFractalSpecializedKernels", &Engine::SetFractalSpecializedKernels)
+        .function("setFractalProgressive", &Engine::SetFractalProgressive)
+        .function("setFractalTemporal", &Engine::SetFractalTemporal)
+        .function("setFractalCollision", &Engine::SetFractalCollision)
+        .function("setFractalBudgetMs", &Engine::SetFractalBudgetMs)
+        .function("getFractalCompletion", &Engine::GetFractalCompletion)
+        .function("setFractalConePrepass", &Engine::SetFractalConePrepass)
+        .function("setDeepZoom", &Engine::SetDeepZoom)
+        .function("setDeepZoomCenter", &Engine::SetDeepZoomCenter)
+        .function("setDeepZoomScale", &Engine::SetDeepZoomScale)
+        .function("setDeepZoomIterations", &Engine::SetDeepZoomIterations)
+        .function("zoomDeepZoom", &Engine::ZoomDeepZoom)
+        .function("getDeepZoomCenterX", &Engine::GetDeepZoomCenterX)
+        .function("getDeepZoomCenterY", &Engine::GetDeepZoomCenterY)
+        .function("getDeepZoomScale", &Engine::GetDeepZoomScale)
         .function("loadModel", &Engine::LoadModel)
+        .function("loadFractalMesh", &Engine::LoadFractalMesh)
         .function("handleFileDrop", &Engine::HandleFileDrop)
         .function("getKeyboard", &Engine::GetKeyboard, emscripten::allow_raw_pointers())
         .function("getMouse", &Engine::GetMouse, emscripten::allow_raw_pointers())
-        .function("getCamera", &Engine::GetCamera, emscripten::allow_raw_pointers());
+        .function("getCamera", &Engine::GetCamera, emscripten::allow_raw_pointers())
+        .function("getFrameSummary", &Engine::GetFrameSummary)
+        .function("getProfileZones", &Engine::GetProfileZones)
+        .function("getStreamBufferStats", &Engine::GetStreamBufferStats)
+        .function("startTrace", &Engine::StartTrace)
+        .function("stopTrace", &Engine::StopTrace);
 
 }
 
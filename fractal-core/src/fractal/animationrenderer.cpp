@@ -0,0 +1,234 @@
+// animationrenderer.cpp
+
+// C++ standard library
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+// local headers
+#include "fractal/animationrenderer.h"
+#include "fractal/cpuraymarcher.h"
+#include "pngencoder.h"
+#include "profiler.h"
+
+namespace {
+float MillisecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool IsOnDisk(const std::string& path)
+{
+    std::error_code error;
+    return std::filesystem::is_regular_file(path, error) && std::filesystem::file_size(path, error) > 0 && !error;
+}
+}
+
+std::string AnimationRenderer::GetFramePath(const std::string& directory, int frame)
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "frame_%05d.png", frame);
+    return (std::filesystem::path(directory) / name).string();
+}
+
+bool AnimationRenderer::Resolve(const AnimationImage& image, int width, int height, AnimationImage& resolved)
+{
+    if (width <= 0 || height <= 0 || image.width % width != 0 || image.height % height != 0 ||
+        image.pixels.size() != (size_t)image.width * (size_t)image.height) {
+        return false;
+    }
+    int factorX = image.width / width;
+    int factorY = image.height / height;
+    resolved.width = width;
+    resolved.height = height;
+    resolved.pixels.resize((size_t)width * (size_t)height);
+
+    // The pixels hold square roots of linear light, so square before averaging
+    float linear[256];
+    for (int i = 0; i < 256; i++) {
+        float value = (float)i / 255.0f;
+        linear[i] = value * value;
+    }
+    float weight = 1.0f / (float)(factorX * factorY);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            glm::vec3 sum(0.0f);
+            for (int sy = 0; sy < factorY; sy++) {
+                const uint32_t* row = image.pixels.data() + (size_t)(y * factorY + sy) * (size_t)image.width + (size_t)x * factorX;
+                for (int sx = 0; sx < factorX; sx++) {
+                    uint32_t pixel = row[sx];
+                    sum += glm::vec3(linear[pixel & 0xFF], linear[(pixel >> 8) & 0xFF], linear[(pixel >> 16) & 0xFF]);
+                }
+            }
+            resolved.pixels[(size_t)y * (size_t)width + (size_t)x] = CpuRayMarcher::PackPixel(sum * weight);
+        }
+    }
+    return true;
+}
+
+void AnimationRenderer::EncodeJob(void* context, size_t, size_t)
+{
+    PROFILE_ZONE("AnimationRenderer::EncodeJob");
+    Slot& slot = *static_cast<Slot*>(context);
+    auto start = std::chrono::steady_clock::now();
+    const AnimationImage* image = &slot.image;
+    if (image->width != slot.width || image->height != slot.height) {
+        if (!Resolve(slot.image, slot.width, slot.height, slot.resolved)) {
+            std::cerr << "Can't resolve a " << slot.image.width << "x" << slot.image.height << " image to "
+                      << slot.width << "x" << slot.height << " for " << slot.path << std::endl;
+            slot.bFailed = true;
+            return;
+        }
+        image = &slot.resolved;
+    }
+    if (!EncodePng(image->pixels.data(), image->width, image->height, slot.png, slot.level)) {
+        std::cerr << "Failed to encode " << slot.path << std::endl;
+        slot.bFailed = true;
+        return;
+    }
+    slot.encodeMs = MillisecondsSince(start);
+
+    // Renamed only once complete, so a frame on disk is always a whole one
+    start = std::chrono::steady_clock::now();
+    std::string tempPath = slot.path + ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(slot.png.data()), (std::streamsize)slot.png.size());
+        if (!out) {
+            std::cerr << "Failed to write " << tempPath << std::endl;
+            slot.bFailed = true;
+            return;
+        }
+    }
+    if (std::rename(tempPath.c_str(), slot.path.c_str()) != 0) {
+        std::cerr << "Failed to rename " << tempPath << " to " << slot.path << std::endl;
+        slot.bFailed = true;
+        return;
+    }
+    slot.writeMs = MillisecondsSince(start);
+}
+
+void AnimationRenderer::Submit(Slot& slot)
+{
+    slot.bPending = true;
+    if (!slot.bFailed) {
+        JobSystem::GetInstance()->Submit(&EncodeJob, &slot, 1, 1, slot.counter);
+    }
+}
+
+void AnimationRenderer::Collect(Slot& slot)
+{
+    if (!slot.bPending) {
+        return;
+    }
+    JobSystem::GetInstance()->Wait(slot.counter);
+    slot.bPending = false;
+    if (slot.bFailed) {
+        stats.failed++;
+        return;
+    }
+    stats.rendered++;
+    stats.encodeMs += slot.encodeMs;
+    stats.writeMs += slot.writeMs;
+    stats.bytes += slot.png.size();
+}
+
+bool AnimationRenderer::Render(const FractalAnimation& animation, const AnimationRenderSettings& settings,
+                               const RenderFunction& render, const ReadFunction& read)
+{
+    PROFILE_ZONE("AnimationRenderer::Render");
+    auto start = std::chrono::steady_clock::now();
+    stats = AnimationRenderStats();
+    stats.frames = animation.GetFrameCount();
+    if (settings.width <= 0 || settings.height <= 0) {
+        std::cerr << "Invalid animation size " << settings.width << "x" << settings.height << std::endl;
+        return false;
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(settings.outputDirectory, error);
+    if (error) {
+        std::cerr << "Failed to create " << settings.outputDirectory << ": " << error.message() << std::endl;
+        return false;
+    }
+
+    // Slots hold job counters, which can't move
+    int slotCount = std::clamp(settings.framesInFlight, 2, MAX_FRAMES_IN_FLIGHT);
+    std::vector<std::unique_ptr<Slot>> slots;
+    for (int i = 0; i < slotCount; i++) {
+        slots.push_back(std::make_unique<Slot>());
+    }
+    auto finish = [this, &slots, &read](int index) {
+        Slot& slot = *slots[index];
+        if (!slot.bFailed && !read(index, slot.image)) {
+            slot.bFailed = true;
+        }
+        Submit(slot);
+    };
+
+    int next = 0;
+    // Slot whose frame waits for the read hook
+    int reading = -1;
+    for (int frame = 0; frame < stats.frames; frame++) {
+        std::string path = GetFramePath(settings.outputDirectory, frame);
+        if (IsOnDisk(path)) {
+            stats.skipped++;
+            continue;
+        }
+
+        // The slot's last frame has to be out of the encoder before it draws again
+        Slot& slot = *slots[next];
+        Collect(slot);
+        slot.path = path;
+        slot.width = settings.width;
+        slot.height = settings.height;
+        slot.level = settings.pngLevel;
+        slot.bFailed = false;
+
+        auto renderStart = std::chrono::steady_clock::now();
+        if (!render(animation.EvaluateFrame(frame), next, slot.image)) {
+            std::cerr << "Failed to render frame " << frame << std::endl;
+            slot.bFailed = true;
+        }
+        if (!read) {
+            Submit(slot);
+        }
+        else {
+            if (reading >= 0) {
+                finish(reading);
+            }
+            reading = next;
+        }
+        stats.renderMs += MillisecondsSince(renderStart);
+        next = (next + 1) % slotCount;
+
+        int done = frame + 1 - stats.skipped;
+        float secondsPerFrame = MillisecondsSince(start) / 1000.0f / (float)done;
+        int left = stats.frames - frame - 1;
+        std::cout << "Frame " << frame + 1 << "/" << stats.frames << ": " << secondsPerFrame << " s/frame, "
+                  << std::lround(secondsPerFrame * (float)left) << " s left" << std::endl;
+    }
+    if (reading >= 0) {
+        finish(reading);
+    }
+    for (const std::unique_ptr<Slot>& slot : slots) {
+        Collect(*slot);
+    }
+
+    stats.totalMs = MillisecondsSince(start);
+    int attempted = stats.rendered + stats.failed;
+    stats.secondsPerFrame = attempted > 0 ? stats.totalMs / 1000.0f / (float)attempted : 0.0f;
+    std::cout << "Animation: " << stats.rendered << " of " << stats.frames << " frames rendered, " << stats.skipped
+              << " already on disk, " << stats.failed << " failed; " << stats.secondsPerFrame << " s/frame" << std::endl;
+    if (attempted > 0) {
+        float perFrame = 1.0f / (float)attempted;
+        std::cout << "  per frame: render " << stats.renderMs * perFrame << " ms, encode " << stats.encodeMs * perFrame
+                  << " ms, write " << stats.writeMs * perFrame << " ms, "
+                  << (float)stats.bytes * perFrame / 1024.0f << " KB" << std::endl;
+    }
+    return stats.failed == 0;
+}
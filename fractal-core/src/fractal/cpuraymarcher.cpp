@@ -0,0 +1,509 @@
+// cpuraymarcher.cpp
+
+// C++ standard library
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+// local headers
+#include "fractal/cpuraymarcher.h"
+#include "fractal/formula.h"
+#include "jobsystem.h"
+#include "profiler.h"
+
+namespace {
+// Shading constants, mirrored in fractal.frag
+const glm::vec3 LIGHT_DIRECTION(0.50508f, 0.80812f, 0.30305f);
+const glm::vec3 KEY_COLOR(1.0f, 0.92f, 0.8f);
+const glm::vec3 SKY_COLOR(0.25f, 0.3f, 0.4f);
+const glm::vec3 ALBEDO(0.85f, 0.72f, 0.55f);
+const glm::vec3 BACKGROUND_BOTTOM(0.04f, 0.045f, 0.06f);
+const glm::vec3 BACKGROUND_TOP(0.32f, 0.38f, 0.48f);
+// Smallest hit distance, for rays that start right at the surface
+const float MIN_EPSILON = 1e-5f;
+// Cone pre-pass depth of a cell whose cone left the bailout sphere without touching it
+const float CONE_MISS_DEPTH = 1e30f;
+
+template<typename V>
+simd::Vec3<V> Splat(const glm::vec3& v)
+{
+    return simd::Vec3<V>(V(v.x), V(v.y), V(v.z));
+}
+
+// Sphere trace a packet from origin along dir, no nearer than start. Returns the
+// hit mask and leaves the hit (or last) distance in t and the estimator
+// evaluations per lane in steps.
+template<typename V, typename Kernel>
+V MarchPacket(const simd::Vec3<V>& origin, const simd::Vec3<V>& dir, const FractalParams& params, const Kernel& kernel,
+              const RayMarchSettings& settings, float pixelFootprint, const V& start, V& t, V& steps)
+{
+    // Only the bailout sphere can contain the set
+    V b = simd::Dot(origin, dir);
+    V c = simd::Dot(origin, origin) - V(params.bailout * params.bailout);
+    V discriminant = b * b - c;
+    V root = simd::Sqrt(simd::Max(discriminant, V(0.0f)));
+    V tExit = -b + root;
+    t = simd::Max(simd::Max(-b - root, V(0.0f)), start);
+    steps = V(0.0f);
+
+    V active = (discriminant > V(0.0f)) & (t < tExit);
+    V hit(0.0f);
+    for (int i = 0; i < settings.maxSteps && simd::Any(active); i++) {
+        V distance = kernel(origin + dir * t);
+        steps += simd::MaskToOne(active);
+
+        V epsilon = simd::Max(t * V(pixelFootprint), V(MIN_EPSILON));
+        V hitNow = active & (distance < epsilon);
+        hit = hit | hitNow;
+        active = simd::AndNot(active, hitNow);
+        t = simd::Select(active, simd::MulAdd(distance, V(settings.stepScale), t), t);
+        active = active & (t < tExit);
+    }
+    return hit;
+}
+
+// March a packet of cones with apex at origin, each slope * t wide at depth t
+// along its axis dir, starting from start. A step only goes as far as keeps the
+// whole cone clear of the surface, and the march stops once that is less than
+// the cone is wide. Returns the depth reached, CONE_MISS_DEPTH for cones that
+// left the bailout sphere untouched, and the steps per lane in steps. Of those,
+// advances counts the ones that moved on inside the sphere, where a ray would
+// have stepped too.
+template<typename V, typename Kernel>
+V MarchCone(const simd::Vec3<V>& origin, const simd::Vec3<V>& dir, const V& start, float slope, const FractalParams& params,
+            const Kernel& kernel, const RayMarchSettings& settings, V& steps, V& advances)
+{
+    const V bailout(params.bailout);
+    const V coneSlope(slope);
+    // The cone widens as it advances, so only part of the clearance is a safe step
+    const V advance(1.0f / (1.0f + slope));
+    V b = simd::Dot(origin, dir);
+    V t = start;
+    V active = t < V(CONE_MISS_DEPTH);
+    V missed = simd::AndNot(V(0.0f) <= V(0.0f), active);
+    steps = V(0.0f);
+    advances = V(0.0f);
+    for (int i = 0; i < settings.maxSteps && simd::Any(active); i++) {
+        simd::Vec3<V> position = origin + dir * t;
+        V length = simd::Length(position);
+        V outside = length > bailout;
+        // The set lies inside the bailout sphere, so the distance to the sphere is
+        // a bound too; outside it the estimate escapes at once and is cheap
+        V distance = simd::Max(length - bailout, kernel(position) * V(settings.stepScale));
+        steps += simd::MaskToOne(active);
+
+        V radius = t * coneSlope;
+        V clearance = distance - radius;
+        // Outside the sphere and moving away from it faster than the cone widens,
+        // so it never comes back
+        V leaving = outside & (clearance > V(0.0f)) & ((b + t) > length * coneSlope);
+        missed = missed | (active & leaving);
+        active = simd::AndNot(active, leaving | (clearance < radius));
+        advances += simd::MaskToOne(simd::AndNot(active, outside));
+        t = simd::Select(active, simd::MulAdd(clearance, advance, t), t);
+    }
+    return simd::Select(missed, V(CONE_MISS_DEPTH), t);
+}
+
+// Lambert key light plus a sky term, darkened by the step count as a cheap
+// occlusion estimate; misses get the background gradient and a zero normal
+template<typename V, typename Kernel>
+simd::Vec3<V> ShadePacket(const simd::Vec3<V>& origin, const simd::Vec3<V>& dir, const V& hit, const V& t, const V& steps,
+                          const Kernel& kernel, const RayMarchSettings& settings, float pixelFootprint,
+                          simd::Vec3<V>& normal)
+{
+    V gradient = simd::MulAdd(dir.y, V(0.5f), V(0.5f));
+    simd::Vec3<V> background = Splat<V>(BACKGROUND_BOTTOM) + Splat<V>(BACKGROUND_TOP - BACKGROUND_BOTTOM) * gradient;
+    normal = simd::Vec3<V>(0.0f);
+    if (!simd::Any(hit)) {
+        return background;
+    }
+
+    simd::Vec3<V> position = origin + dir * t;
+    V h = simd::Max(t * V(pixelFootprint), V(MIN_EPSILON));
+    normal = simd::Select(hit, FractalNormal(position, h, kernel), normal);
+    V diffuse = simd::Max(simd::Dot(normal, Splat<V>(LIGHT_DIRECTION)), V(0.0f));
+    V sky = simd::MulAdd(normal.y, V(0.5f), V(0.5f));
+    V occlusion = simd::Clamp(V(1.0f) - steps * V(1.0f / (float)settings.maxSteps), V(0.0f), V(1.0f));
+
+    simd::Vec3<V> light = Splat<V>(KEY_COLOR) * diffuse + Splat<V>(SKY_COLOR) * sky;
+    simd::Vec3<V> color(light.x * V(ALBEDO.x), light.y * V(ALBEDO.y), light.z * V(ALBEDO.z));
+    return simd::Select(hit, color * occlusion, background);
+}
+
+// Angle one pixel subtends, scaled to the hit threshold
+inline float PixelFootprint(const FractalView& view, const RayMarchSettings& settings, int height)
+{
+    return 2.0f * view.tanHalfFov / (float)height * settings.pixelEpsilon;
+}
+
+template<typename V, typename Kernel>
+void TracePackets(const FractalView& view, const FractalParams& params, const Kernel& kernel, const RayMarchSettings& settings,
+                  int width, int height, const float* x, const float* y, int count, RaySample* samples)
+{
+    constexpr int WIDTH = V::WIDTH;
+    float scaleX = 2.0f / (float)width;
+    float scaleY = 2.0f / (float)height;
+    float extentX = view.tanHalfFov * view.aspect;
+    float extentY = view.tanHalfFov;
+    float pixelFootprint = PixelFootprint(view, settings, height);
+    const simd::Vec3<V> origin = Splat<V>(view.position);
+
+    float laneX[WIDTH], laneY[WIDTH];
+    float red[WIDTH], green[WIDTH], blue[WIDTH], normalX[WIDTH], normalY[WIDTH], normalZ[WIDTH], depth[WIDTH], laneSteps[WIDTH];
+    for (int first = 0; first < count; first += WIDTH) {
+        int lanes = std::min(WIDTH, count - first);
+        for (int lane = 0; lane < WIDTH; lane++) {
+            // Spare lanes repeat the last ray
+            int source = first + std::min(lane, lanes - 1);
+            laneX[lane] = x[source];
+            laneY[lane] = y[source];
+        }
+        V planeX = simd::MulAdd(V::Load(laneX), V(scaleX), V(-1.0f)) * V(extentX);
+        V planeY = simd::MulAdd(V::Load(laneY), V(scaleY), V(-1.0f)) * V(extentY);
+        simd::Vec3<V> dir = simd::Normalize(Splat<V>(view.forward) + Splat<V>(view.up) * planeY + Splat<V>(view.right) * planeX);
+
+        V t, steps;
+        V hit = MarchPacket(origin, dir, params, kernel, settings, pixelFootprint, V(0.0f), t, steps);
+        simd::Vec3<V> normal;
+        simd::Vec3<V> color = ShadePacket(origin, dir, hit, t, steps, kernel, settings, pixelFootprint, normal);
+
+        color.x.Store(red);
+        color.y.Store(green);
+        color.z.Store(blue);
+        normal.x.Store(normalX);
+        normal.y.Store(normalY);
+        normal.z.Store(normalZ);
+        simd::Select(hit, t, V(-1.0f)).Store(depth);
+        steps.Store(laneSteps);
+        for (int lane = 0; lane < lanes; lane++) {
+            RaySample& sample = samples[first + lane];
+            sample.color = glm::vec3(red[lane], green[lane], blue[lane]);
+            sample.normal = glm::vec3(normalX[lane], normalY[lane], normalZ[lane]);
+            sample.depth = depth[lane];
+            sample.steps = (uint32_t)laneSteps[lane];
+        }
+    }
+}
+
+inline uint32_t PackColor(float r, float g, float b)
+{
+    // sqrt as a cheap gamma 2 encode, same as the shader
+    auto channel = [](float value) {
+        return (uint32_t)(std::sqrt(std::min(std::max(value, 0.0f), 1.0f)) * 255.0f + 0.5f);
+    };
+    // RGBA bytes in memory on little endian targets
+    return channel(r) | (channel(g) << 8) | (channel(b) << 16) | 0xFF000000u;
+}
+}
+
+uint32_t CpuRayMarcher::PackPixel(const glm::vec3& color)
+{
+    return PackColor(color.x, color.y, color.z);
+}
+
+glm::vec2 CpuRayMarcher::SampleOffset(int sample)
+{
+    float x = 0.5f + 0.7548776662f * (float)sample;
+    float y = 0.5f + 0.5698402910f * (float)sample;
+    return glm::vec2(x - std::floor(x), y - std::floor(y));
+}
+
+void CpuRayMarcher::TraceRays(const FractalView& view, const FractalParams& params, const RayMarchSettings& settings,
+                              int width, int height, const float* x, const float* y, int count, RaySample* samples)
+{
+    if (width <= 0 || height <= 0 || count <= 0) {
+        return;
+    }
+    FormulaKernel formula = SelectFormulaKernel(params, settings.bSpecializedKernels);
+    VisitFormulaKernel(params, formula, [&](const auto& kernel) {
+        TracePackets<simd::FloatNative>(view, params, kernel, settings, width, height, x, y, count, samples);
+    });
+}
+
+void CpuRayMarcher::SetupFrame(Frame& frame, const FractalView& view, const FractalParams& params, const RayMarchSettings& settings,
+                               int width, int height, uint32_t* pixels)
+{
+    frame.view = view;
+    frame.params = params;
+    frame.settings = settings;
+    frame.width = width;
+    frame.height = height;
+    frame.tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+    frame.pixels = pixels;
+    frame.formula = SelectFormulaKernel(params, settings.bSpecializedKernels);
+    frame.cone = nullptr;
+    frame.steps = 0;
+    frame.coneSteps = 0;
+}
+
+void CpuRayMarcher::FinishFrame(const Frame& frame, float ms)
+{
+    stats.rays = (uint64_t)frame.width * (uint64_t)frame.height;
+    stats.steps = frame.steps.load();
+    stats.coneSteps = frame.coneSteps.load();
+    stats.ms = ms;
+    stats.formula = frame.formula;
+    stats.mraysPerSecond = ms > 0.0f ? (float)((double)stats.rays / (ms * 1000.0)) : 0.0f;
+    Profiler::SetGauge(ProfileGauge::CpuMraysPerSecond, stats.mraysPerSecond);
+}
+
+void CpuRayMarcher::Render(const FractalView& view, const FractalParams& params, const RayMarchSettings& settings,
+                           int width, int height, uint32_t* pixels)
+{
+    if (width <= 0 || height <= 0 || !pixels) {
+        return;
+    }
+    PROFILE_ZONE("CpuRayMarcher::Render");
+    auto start = std::chrono::steady_clock::now();
+
+    Frame frame;
+    SetupFrame(frame, view, params, settings, width, height, pixels);
+    int tileCount = frame.tilesX * ((height + TILE_SIZE - 1) / TILE_SIZE);
+    float coneMs = 0.0f;
+    VisitFormulaKernel(frame.params, frame.formula, [this, &frame, &coneMs, start, tileCount](const auto& kernel) {
+        if (frame.settings.bConePrepass) {
+            RunConePrepass<simd::FloatNative>(frame, kernel);
+            coneMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+        JobSystem::GetInstance()->ParallelFor((size_t)tileCount, 1, [&frame, &kernel](size_t tile) {
+            RenderTile<simd::FloatNative>(frame, (int)tile, kernel);
+        });
+    });
+
+    FinishFrame(frame, std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count());
+    stats.coneMs = coneMs;
+}
+
+void CpuRayMarcher::RenderSamples(const FractalView& view, const FractalParams& params, const RayMarchSettings& settings,
+                                  int width, int height, int samples, uint32_t* pixels)
+{
+    if (samples <= 1) {
+        Render(view, params, settings, width, height, pixels);
+        return;
+    }
+    if (width <= 0 || height <= 0 || !pixels) {
+        return;
+    }
+    PROFILE_ZONE("CpuRayMarcher::RenderSamples");
+    auto start = std::chrono::steady_clock::now();
+
+    // Every sample of a tile goes through the packet tracer before the next, so the
+    // tile's sums stay on the stack
+    int tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+    int tileCount = tilesX * ((height + TILE_SIZE - 1) / TILE_SIZE);
+    std::atomic<uint64_t> steps{0};
+    JobSystem::GetInstance()->ParallelFor((size_t)tileCount, 1, [&](size_t tile) {
+        int x0 = ((int)tile % tilesX) * TILE_SIZE;
+        int y0 = ((int)tile / tilesX) * TILE_SIZE;
+        int x1 = std::min(x0 + TILE_SIZE, width);
+        int y1 = std::min(y0 + TILE_SIZE, height);
+        int count = (x1 - x0) * (y1 - y0);
+
+        float sampleX[TILE_SIZE * TILE_SIZE];
+        float sampleY[TILE_SIZE * TILE_SIZE];
+        glm::vec3 sums[TILE_SIZE * TILE_SIZE];
+        RaySample rays[TILE_SIZE * TILE_SIZE];
+        std::fill(sums, sums + count, glm::vec3(0.0f));
+        uint64_t tileSteps = 0;
+        for (int sample = 0; sample < samples; sample++) {
+            glm::vec2 offset = SampleOffset(sample);
+            int i = 0;
+            for (int y = y0; y < y1; y++) {
+                for (int x = x0; x < x1; x++, i++) {
+                    sampleX[i] = (float)x + offset.x;
+                    sampleY[i] = (float)y + offset.y;
+                }
+            }
+            TraceRays(view, params, settings, width, height, sampleX, sampleY, count, rays);
+            for (i = 0; i < count; i++) {
+                sums[i] += rays[i].color;
+                tileSteps += rays[i].steps;
+            }
+        }
+
+        float weight = 1.0f / (float)samples;
+        int i = 0;
+        for (int y = y0; y < y1; y++) {
+            for (int x = x0; x < x1; x++, i++) {
+                pixels[(size_t)y * (size_t)width + (size_t)x] = PackPixel(sums[i] * weight);
+            }
+        }
+        steps += tileSteps;
+    });
+
+    float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    stats = CpuRayMarchStats();
+    stats.rays = (uint64_t)width * (uint64_t)height * (uint64_t)samples;
+    stats.steps = steps.load();
+    stats.ms = ms;
+    stats.formula = SelectFormulaKernel(params, settings.bSpecializedKernels);
+    stats.mraysPerSecond = ms > 0.0f ? (float)((double)stats.rays / (ms * 1000.0)) : 0.0f;
+    Profiler::SetGauge(ProfileGauge::CpuMraysPerSecond, stats.mraysPerSecond);
+}
+
+void CpuRayMarcher::RenderReference(const FractalView& view, const FractalParams& params, const RayMarchSettings& settings,
+                                    int width, int height, uint32_t* pixels)
+{
+    if (width <= 0 || height <= 0 || !pixels) {
+        return;
+    }
+    PROFILE_ZONE("CpuRayMarcher::RenderReference");
+    auto start = std::chrono::steady_clock::now();
+
+    Frame frame;
+    SetupFrame(frame, view, params, settings, width, height, pixels);
+    int tileCount = frame.tilesX * ((height + TILE_SIZE - 1) / TILE_SIZE);
+    VisitFormulaKernel(frame.params, frame.formula, [&frame, tileCount](const auto& kernel) {
+        for (int tile = 0; tile < tileCount; tile++) {
+            RenderTile<simd::Float1>(frame, tile, kernel);
+        }
+    });
+
+    FinishFrame(frame, std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count());
+    stats.coneMs = 0.0f;
+}
+
+template<typename V, typename Kernel>
+void CpuRayMarcher::RunConePrepass(Frame& frame, const Kernel& kernel)
+{
+    PROFILE_ZONE("CpuRayMarcher::ConePrepass");
+    const ConeLevel* input = nullptr;
+    for (int i = 0; i < CONE_LEVELS; i++) {
+        ConeLevel& level = coneLevels[i];
+        level.cellSize = CONE_CELL_SIZES[i];
+        level.width = (frame.width + level.cellSize - 1) / level.cellSize;
+        level.height = (frame.height + level.cellSize - 1) / level.cellSize;
+        level.depth.resize((size_t)level.width * (size_t)level.height);
+        level.steps.resize(level.depth.size());
+        JobSystem::GetInstance()->ParallelFor((size_t)level.height, 1, [&frame, &level, input, &kernel](size_t row) {
+            ConeRow<V>(frame, level, input, (int)row, kernel);
+        });
+        input = &level;
+    }
+    frame.cone = input;
+}
+
+template<typename V, typename Kernel>
+void CpuRayMarcher::ConeRow(Frame& frame, ConeLevel& level, const ConeLevel* input, int row, const Kernel& kernel)
+{
+    constexpr int WIDTH = V::WIDTH;
+    const FractalView& view = frame.view;
+    const int cellSize = level.cellSize;
+    float scaleX = 2.0f / (float)frame.width;
+    float scaleY = 2.0f / (float)frame.height;
+    float extentX = view.tanHalfFov * view.aspect;
+    float extentY = view.tanHalfFov;
+    // Rays of a cell pierce the image plane, at distance one, within half a cell
+    // diagonal of its centre ray, which bounds the angle between them
+    float halfDiagonal = 0.5f * (float)cellSize * std::sqrt(scaleX * extentX * scaleX * extentX + scaleY * extentY * scaleY * extentY);
+    float slope = std::tan(std::min(halfDiagonal, 1.0f));
+
+    float planeY = (((float)row + 0.5f) * (float)cellSize * scaleY - 1.0f) * extentY;
+    simd::Vec3<V> rowDirection = Splat<V>(view.forward + view.up * planeY);
+    const simd::Vec3<V> origin = Splat<V>(view.position);
+    float* depths = level.depth.data() + (size_t)row * (size_t)level.width;
+    float* cellSteps = level.steps.data() + (size_t)row * (size_t)level.width;
+
+    float centers[WIDTH], starts[WIDTH], inputSteps[WIDTH], depth[WIDTH], laneSteps[WIDTH], laneAdvances[WIDTH];
+    uint64_t rowSteps = 0;
+    for (int x = 0; x < level.width; x += WIDTH) {
+        int lanes = std::min(WIDTH, level.width - x);
+        for (int lane = 0; lane < WIDTH; lane++) {
+            // Spare lanes repeat the last cell
+            int cell = x + std::min(lane, lanes - 1);
+            centers[lane] = ((float)cell + 0.5f) * (float)cellSize;
+            starts[lane] = 0.0f;
+            inputSteps[lane] = 0.0f;
+            if (input) {
+                size_t source = (size_t)(row * cellSize / input->cellSize) * (size_t)input->width + (size_t)(cell * cellSize / input->cellSize);
+                starts[lane] = input->depth[source];
+                inputSteps[lane] = input->steps[source];
+            }
+        }
+        V planeX = simd::MulAdd(V::Load(centers), V(scaleX), V(-1.0f)) * V(extentX);
+        simd::Vec3<V> dir = simd::Normalize(rowDirection + Splat<V>(view.right) * planeX);
+
+        V steps, advances;
+        V t = MarchCone(origin, dir, V::Load(starts), slope, frame.params, kernel, frame.settings, steps, advances);
+        t.Store(depth);
+        steps.Store(laneSteps);
+        advances.Store(laneAdvances);
+        for (int lane = 0; lane < lanes; lane++) {
+            depths[x + lane] = depth[lane];
+            cellSteps[x + lane] = inputSteps[lane] + laneAdvances[lane];
+            rowSteps += (uint64_t)laneSteps[lane];
+        }
+    }
+    frame.coneSteps.fetch_add(rowSteps, std::memory_order_relaxed);
+}
+
+template<typename V, typename Kernel>
+void CpuRayMarcher::RenderTile(Frame& frame, int tile, const Kernel& kernel)
+{
+    constexpr int WIDTH = V::WIDTH;
+    const FractalView& view = frame.view;
+    int x0 = (tile % frame.tilesX) * TILE_SIZE;
+    int y0 = (tile / frame.tilesX) * TILE_SIZE;
+    int x1 = std::min(x0 + TILE_SIZE, frame.width);
+    int y1 = std::min(y0 + TILE_SIZE, frame.height);
+
+    // Pixel centres map to [-1, 1] across the image plane, bottom row first
+    float scaleX = 2.0f / (float)frame.width;
+    float scaleY = 2.0f / (float)frame.height;
+    float extentX = view.tanHalfFov * view.aspect;
+    float extentY = view.tanHalfFov;
+    float pixelFootprint = PixelFootprint(view, frame.settings, frame.height);
+
+    float laneOffsets[WIDTH];
+    for (int lane = 0; lane < WIDTH; lane++) {
+        laneOffsets[lane] = (float)lane;
+    }
+    const V laneOffset = V::Load(laneOffsets);
+    const simd::Vec3<V> origin = Splat<V>(view.position);
+
+    float red[WIDTH], green[WIDTH], blue[WIDTH], laneSteps[WIDTH], starts[WIDTH], coneSteps[WIDTH];
+    const ConeLevel* cone = frame.cone;
+    uint64_t tileSteps = 0;
+    for (int y = y0; y < y1; y++) {
+        float planeY = (((float)y + 0.5f) * scaleY - 1.0f) * extentY;
+        simd::Vec3<V> rowDirection = Splat<V>(view.forward + view.up * planeY);
+        uint32_t* row = frame.pixels + (size_t)y * (size_t)frame.width;
+
+        for (int x = x0; x < x1; x += WIDTH) {
+            V planeX = (simd::MulAdd(V((float)x + 0.5f) + laneOffset, V(scaleX), V(-1.0f))) * V(extentX);
+            simd::Vec3<V> dir = simd::Normalize(rowDirection + Splat<V>(view.right) * planeX);
+
+            // Rays start where their cell's cone stopped, and the cone's steps
+            // darken them as if the ray had taken them itself
+            V start(0.0f);
+            V startSteps(0.0f);
+            if (cone) {
+                const size_t coneRow = (size_t)(y / cone->cellSize) * (size_t)cone->width;
+                for (int lane = 0; lane < WIDTH; lane++) {
+                    size_t cell = coneRow + (size_t)(std::min(x + lane, frame.width - 1) / cone->cellSize);
+                    starts[lane] = cone->depth[cell];
+                    coneSteps[lane] = cone->steps[cell];
+                }
+                start = V::Load(starts);
+                startSteps = V::Load(coneSteps);
+            }
+
+            V t, steps;
+            V hit = MarchPacket(origin, dir, frame.params, kernel, frame.settings, pixelFootprint, start, t, steps);
+            simd::Vec3<V> normal;
+            simd::Vec3<V> color = ShadePacket(origin, dir, hit, t, steps + startSteps, kernel, frame.settings, pixelFootprint, normal);
+
+            color.x.Store(red);
+            color.y.Store(green);
+            color.z.Store(blue);
+            steps.Store(laneSteps);
+            int count = std::min(WIDTH, x1 - x);
+            for (int lane = 0; lane < count; lane++) {
+                row[x + lane] = PackColor(red[lane], green[lane], blue[lane]);
+                tileSteps += (uint64_t)laneSteps[lane];
+            }
+        }
+    }
+    frame.steps.fetch_add(tileSteps, std::memory_order_relaxed);
+}
@@ -0,0 +1,512 @@
+// deepzoom.cpp
+
+// C++ standard library
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+// local headers
+#include "fractal/cpuraymarcher.h"
+#include "fractal/deepzoom.h"
+#include "fractal/simd.h"
+#include "fractal/simdmath.h"
+#include "profiler.h"
+
+namespace {
+// A reference further from the view centre than this many view heights is
+// replaced; pixel offsets that large still keep sub-pixel float precision
+const float REBUILD_OFFSET = 64.0f;
+// Beyond this the offsets lose pixels and the orbit is not drawn at all
+const float MAX_OFFSET = 4096.0f;
+// Smooth iterations per palette cycle, mirrored in deepzoom.frag
+const float PALETTE_PERIOD = 48.0f;
+
+std::atomic<uint64_t> nextOrbitId{1};
+
+// Cosine palette over the smooth escape count, the same curve as deepzoom.frag
+template<typename V>
+simd::Vec3<V> PaletteLanes(const V& smoothIterations)
+{
+    const float TAU = 6.28318531f;
+    V phase = smoothIterations * V(TAU / PALETTE_PERIOD);
+    return simd::Vec3<V>(simd::MulAdd(simd::Cos(phase), V(0.5f), V(0.5f)),
+                         simd::MulAdd(simd::Cos(phase + V(TAU * 0.15f)), V(0.5f), V(0.5f)),
+                         simd::MulAdd(simd::Cos(phase + V(TAU * 0.3f)), V(0.5f), V(0.5f)));
+}
+
+// Appends the orbit of z0 under z^2 + c until it escapes or has iterations steps
+void IterateOrbit(FixedPoint zx, FixedPoint zy, const FixedPoint& cx, const FixedPoint& cy, int iterations,
+                  std::vector<glm::vec2>& points)
+{
+    points.push_back(glm::vec2((float)zx.ToDouble(), (float)zy.ToDouble()));
+    for (int i = 0; i < iterations; i++) {
+        FixedPoint xx = zx * zx;
+        FixedPoint yy = zy * zy;
+        FixedPoint xy = zx * zy;
+        zx = xx - yy + cx;
+        zy = xy + xy + cy;
+        double x = zx.ToDouble();
+        double y = zy.ToDouble();
+        if (x * x + y * y > (double)CpuDeepZoom::ESCAPE_RADIUS_SQUARED) {
+            break;
+        }
+        points.push_back(glm::vec2((float)x, (float)y));
+    }
+}
+
+// State of one packet of pixels iterated around the orbit
+template<typename V>
+struct PerturbLanes {
+    static constexpr int WIDTH = V::WIDTH;
+    // Scaled deltas, and what is added to them every step: the pixel offset dc
+    // for the Mandelbrot set, nothing for a Julia set, which starts from it
+    V dx, dy;
+    V addX, addY;
+    V Zx, Zy;
+    V alive;
+    // Iteration each lane escaped at, 0 for lanes that never did, and |z|^2 then
+    V escapeIteration;
+    V magnitude;
+    V iterationCount;
+    V rebaseCount;
+    // Until a lane rebases on its own every lane is at the same orbit index, and
+    // Z is one broadcast load; after that each lane loads its own
+    bool bLockstep;
+    bool bDone;
+    int index;
+    int end;
+    int laneIndex[WIDTH] = {};
+    int laneEnd[WIDTH] = {};
+};
+
+template<typename V>
+void StartLanes(PerturbLanes<V>& lanes, const ReferenceOrbit& orbit, const V& dcx, const V& dcy)
+{
+    const bool bJulia = orbit.formula == DeepZoomFormula::Julia;
+    lanes.addX = bJulia ? V(0.0f) : dcx;
+    lanes.addY = bJulia ? V(0.0f) : dcy;
+    lanes.dx = bJulia ? dcx : V(0.0f);
+    lanes.dy = bJulia ? dcy : V(0.0f);
+    lanes.Zx = V(orbit.points[0].x);
+    lanes.Zy = V(orbit.points[0].y);
+    lanes.alive = V(0.0f) <= V(0.0f);
+    lanes.escapeIteration = V(0.0f);
+    lanes.magnitude = V(0.0f);
+    lanes.iterationCount = V(0.0f);
+    lanes.rebaseCount = V(0.0f);
+    lanes.bLockstep = true;
+    lanes.bDone = false;
+    lanes.index = 0;
+    lanes.end = orbit.referenceLength;
+}
+
+// Iteration i of one packet
+template<typename V>
+inline void StepLanes(PerturbLanes<V>& lanes, const ReferenceOrbit& orbit, const V& s, const V& inverseScale, int i)
+{
+    constexpr int WIDTH = V::WIDTH;
+    const glm::vec2* points = orbit.points.data();
+    float zx[WIDTH], zy[WIDTH], flags[WIDTH];
+
+    // d' = (2 Z + s d) d + dc, with s d d kept in range by scaling d first
+    V ax = simd::MulAdd(s, lanes.dx, lanes.Zx + lanes.Zx);
+    V ay = simd::MulAdd(s, lanes.dy, lanes.Zy + lanes.Zy);
+    V nextX = ax * lanes.dx - ay * lanes.dy + lanes.addX;
+    V dy = ax * lanes.dy + ay * lanes.dx + lanes.addY;
+    V dx = nextX;
+    lanes.dx = dx;
+    lanes.dy = dy;
+    lanes.iterationCount += simd::MaskToOne(lanes.alive);
+
+    V Zx, Zy;
+    if (lanes.bLockstep) {
+        lanes.index++;
+        Zx = V(points[lanes.index].x);
+        Zy = V(points[lanes.index].y);
+    }
+    else {
+        int alive = simd::MoveMask(lanes.alive);
+        for (int lane = 0; lane < WIDTH; lane++) {
+            if (alive & (1 << lane)) {
+                const glm::vec2& point = points[++lanes.laneIndex[lane]];
+                zx[lane] = point.x;
+                zy[lane] = point.y;
+            }
+            else {
+                zx[lane] = 0.0f;
+                zy[lane] = 0.0f;
+            }
+        }
+        Zx = V::Load(zx);
+        Zy = V::Load(zy);
+    }
+    lanes.Zx = Zx;
+    lanes.Zy = Zy;
+
+    // The full value z / s, and z itself for the escape test
+    V ux = simd::MulAdd(Zx, inverseScale, dx);
+    V uy = simd::MulAdd(Zy, inverseScale, dy);
+    V wx = ux * s;
+    V wy = uy * s;
+    V length = wx * wx + wy * wy;
+    V escaped = lanes.alive & (length > V(CpuDeepZoom::ESCAPE_RADIUS_SQUARED));
+    if (simd::Any(escaped)) {
+        lanes.escapeIteration = simd::Select(escaped, V((float)i), lanes.escapeIteration);
+        lanes.magnitude = simd::Select(escaped, length, lanes.magnitude);
+        lanes.alive = simd::AndNot(lanes.alive, escaped);
+        if (!simd::Any(lanes.alive)) {
+            lanes.bDone = true;
+            return;
+        }
+    }
+
+    // Rebase where z got smaller than its delta, or the orbit has no next point.
+    // Max norms, since squares of z / s overflow long before z gets large.
+    V rebase = lanes.alive & (simd::Max(simd::Abs(ux), simd::Abs(uy)) < simd::Max(simd::Abs(dx), simd::Abs(dy)));
+    if (lanes.bLockstep) {
+        if (lanes.index + 1 >= lanes.end) {
+            rebase = lanes.alive;
+        }
+    }
+    else {
+        for (int lane = 0; lane < WIDTH; lane++) {
+            flags[lane] = lanes.laneIndex[lane] + 1 >= lanes.laneEnd[lane] ? 1.0f : 0.0f;
+        }
+        rebase = rebase | (lanes.alive & (V::Load(flags) > V(0.0f)));
+    }
+    if (!simd::Any(rebase)) {
+        return;
+    }
+    const int criticalEnd = orbit.criticalStart + orbit.criticalLength;
+    lanes.rebaseCount += simd::MaskToOne(rebase);
+    lanes.dx = simd::Select(rebase, ux, dx);
+    lanes.dy = simd::Select(rebase, uy, dy);
+    lanes.Zx = simd::Select(rebase, V(points[orbit.criticalStart].x), Zx);
+    lanes.Zy = simd::Select(rebase, V(points[orbit.criticalStart].y), Zy);
+
+    int rebased = simd::MoveMask(rebase);
+    if (lanes.bLockstep && rebased == simd::MoveMask(lanes.alive)) {
+        lanes.index = orbit.criticalStart;
+        lanes.end = criticalEnd;
+        return;
+    }
+    if (lanes.bLockstep) {
+        for (int lane = 0; lane < WIDTH; lane++) {
+            lanes.laneIndex[lane] = lanes.index;
+            lanes.laneEnd[lane] = lanes.end;
+        }
+        lanes.bLockstep = false;
+    }
+    for (int lane = 0; lane < WIDTH; lane++) {
+        if (rebased & (1 << lane)) {
+            lanes.laneIndex[lane] = orbit.criticalStart;
+            lanes.laneEnd[lane] = criticalEnd;
+        }
+    }
+}
+
+// Iterates PACKETS independent packets side by side. Each step is a short chain
+// of dependent multiplies, so one packet alone leaves the core waiting on latency.
+template<typename V, int PACKETS>
+void PerturbPackets(PerturbLanes<V>* lanes, const ReferenceOrbit& orbit, int iterations, float scale)
+{
+    const V s(scale);
+    const V inverseScale(1.0f / scale);
+    for (int i = 1; i <= iterations; i++) {
+        bool bDone = true;
+        for (int packet = 0; packet < PACKETS; packet++) {
+            if (!lanes[packet].bDone) {
+                StepLanes(lanes[packet], orbit, s, inverseScale, i);
+                bDone = false;
+            }
+        }
+        if (bDone) {
+            break;
+        }
+    }
+}
+}
+
+const char* DeepZoomFormulaToString(DeepZoomFormula formula)
+{
+    switch (formula) {
+        case DeepZoomFormula::Mandelbrot: return "mandelbrot";
+        case DeepZoomFormula::Julia: return "julia";
+    }
+    return "unknown";
+}
+
+void DeepZoomView::ZoomAt(float x, float y, double factor)
+{
+    double newScale = std::max(scale / factor, CpuDeepZoom::MIN_SCALE);
+    int limbs = FixedPoint::LimbsForScale(newScale);
+    double planeX = (double)x * (double)aspect * scale;
+    double planeY = (double)y * scale;
+    double c = std::cos((double)angle);
+    double s = std::sin((double)angle);
+    centerX = centerX.WithLimbs(limbs) + FixedPoint::FromDouble(planeX * c - planeY * s, limbs);
+    centerY = centerY.WithLimbs(limbs) + FixedPoint::FromDouble(planeX * s + planeY * c, limbs);
+    scale = newScale;
+}
+
+bool DeepZoomView::SetCenter(const std::string& x, const std::string& y)
+{
+    int limbs = FixedPoint::LimbsForScale(scale);
+    FixedPoint newX, newY;
+    if (!FixedPoint::Parse(x, limbs, newX) || !FixedPoint::Parse(y, limbs, newY)) {
+        return false;
+    }
+    centerX = newX;
+    centerY = newY;
+    return true;
+}
+
+bool ReferenceOrbit::Fits(const DeepZoomView& view) const
+{
+    if (view.formula != formula || iterations < view.iterations || limbs < FixedPoint::LimbsForScale(view.scale)) {
+        return false;
+    }
+    if (formula == DeepZoomFormula::Julia && (view.juliaX != juliaX || view.juliaY != juliaY)) {
+        return false;
+    }
+    glm::vec2 offset = GetOffset(view);
+    return std::max(std::fabs(offset.x), std::fabs(offset.y)) <= REBUILD_OFFSET;
+}
+
+glm::vec2 ReferenceOrbit::GetOffset(const DeepZoomView& view) const
+{
+    return glm::vec2((float)((view.centerX - x).ToDouble() / view.scale), (float)((view.centerY - y).ToDouble() / view.scale));
+}
+
+std::shared_ptr<ReferenceOrbit> ComputeReferenceOrbit(const DeepZoomView& view)
+{
+    PROFILE_ZONE("ComputeReferenceOrbit");
+    auto start = std::chrono::steady_clock::now();
+
+    std::shared_ptr<ReferenceOrbit> orbit = std::make_shared<ReferenceOrbit>();
+    orbit->id = nextOrbitId.fetch_add(1, std::memory_order_relaxed);
+    orbit->formula = view.formula;
+    orbit->limbs = FixedPoint::LimbsForScale(view.scale);
+    orbit->x = view.centerX.WithLimbs(orbit->limbs);
+    orbit->y = view.centerY.WithLimbs(orbit->limbs);
+    orbit->iterations = std::max(view.iterations, 1);
+    orbit->points.reserve((size_t)orbit->iterations + 1);
+
+    FixedPoint zero = FixedPoint::FromDouble(0.0, orbit->limbs);
+    if (view.formula == DeepZoomFormula::Mandelbrot) {
+        IterateOrbit(zero, zero, orbit->x, orbit->y, orbit->iterations, orbit->points);
+        orbit->referenceLength = (int)orbit->points.size();
+        orbit->criticalStart = 0;
+        orbit->criticalLength = orbit->referenceLength;
+    }
+    else {
+        orbit->juliaX = view.juliaX;
+        orbit->juliaY = view.juliaY;
+        FixedPoint cx = FixedPoint::FromDouble(view.juliaX, orbit->limbs);
+        FixedPoint cy = FixedPoint::FromDouble(view.juliaY, orbit->limbs);
+        IterateOrbit(orbit->x, orbit->y, cx, cy, orbit->iterations, orbit->points);
+        orbit->referenceLength = (int)orbit->points.size();
+        orbit->criticalStart = orbit->referenceLength;
+        IterateOrbit(zero, zero, cx, cy, orbit->iterations, orbit->points);
+        orbit->criticalLength = (int)orbit->points.size() - orbit->criticalStart;
+    }
+
+    orbit->ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return orbit;
+}
+
+ReferenceOrbitCache::~ReferenceOrbitCache()
+{
+    Collect(true);
+}
+
+void ReferenceOrbitCache::Update(const DeepZoomView& view)
+{
+    Collect(false);
+    // An orbit of another formula or too far away draws nothing useful
+    if (orbit && (orbit->formula != view.formula ||
+                  (view.formula == DeepZoomFormula::Julia && (orbit->juliaX != view.juliaX || orbit->juliaY != view.juliaY)))) {
+        orbit.reset();
+    }
+    if (orbit) {
+        glm::vec2 offset = orbit->GetOffset(view);
+        if (!(std::max(std::fabs(offset.x), std::fabs(offset.y)) <= MAX_OFFSET)) {
+            orbit.reset();
+        }
+    }
+    if (bComputing || (orbit && orbit->Fits(view))) {
+        return;
+    }
+
+    pendingView = view;
+    bComputing = true;
+    JobSystem::GetInstance()->Submit(&ReferenceOrbitCache::ComputeJob, this, 1, 1, counter);
+    if (JobSystem::GetInstance()->GetWorkerCount() == 0) {
+        Collect(true);
+    }
+}
+
+void ReferenceOrbitCache::BuildNow(const DeepZoomView& view)
+{
+    Collect(true);
+    Update(view);
+    Collect(true);
+}
+
+void ReferenceOrbitCache::ComputeJob(void* context, size_t, size_t)
+{
+    ReferenceOrbitCache* cache = static_cast<ReferenceOrbitCache*>(context);
+    cache->pending = ComputeReferenceOrbit(cache->pendingView);
+}
+
+void ReferenceOrbitCache::Collect(bool bWait)
+{
+    if (!bComputing || (!bWait && !counter.IsDone())) {
+        return;
+    }
+    JobSystem::GetInstance()->Wait(counter);
+    bComputing = false;
+    orbit = std::move(pending);
+    pending.reset();
+}
+
+glm::vec3 CpuDeepZoom::Palette(float smoothIterations)
+{
+    simd::Vec3<simd::Float1> color = PaletteLanes(simd::Float1(smoothIterations));
+    return glm::vec3(color.x.Lane(0), color.y.Lane(0), color.z.Lane(0));
+}
+
+void CpuDeepZoom::SetupFrame(Frame& frame, const DeepZoomView& view, const ReferenceOrbit& orbit, int width, int height,
+                             uint32_t* pixels)
+{
+    frame.orbit = &orbit;
+    frame.width = width;
+    frame.height = height;
+    frame.tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+    frame.pixels = pixels;
+    frame.iterations = std::min(view.iterations, orbit.iterations);
+    frame.scale = (float)std::max(view.scale, MIN_SCALE);
+    frame.offset = orbit.GetOffset(view);
+    frame.rotation = glm::vec2(std::cos(view.angle), std::sin(view.angle));
+    frame.aspect = (float)width / (float)height;
+    frame.iterationCount = 0;
+    frame.rebases = 0;
+}
+
+void CpuDeepZoom::FinishFrame(const Frame& frame, float ms)
+{
+    stats.pixels = (uint64_t)frame.width * (uint64_t)frame.height;
+    stats.iterations = frame.iterationCount.load();
+    stats.rebases = frame.rebases.load();
+    stats.ms = ms;
+    stats.referenceMs = frame.orbit->ms;
+    stats.referenceLength = frame.orbit->referenceLength;
+    stats.limbs = frame.orbit->limbs;
+}
+
+void CpuDeepZoom::Render(const DeepZoomView& view, const ReferenceOrbit& orbit, int width, int height, uint32_t* pixels)
+{
+    if (width <= 0 || height <= 0 || !pixels || orbit.points.empty()) {
+        return;
+    }
+    PROFILE_ZONE("CpuDeepZoom::Render");
+    auto start = std::chrono::steady_clock::now();
+
+    Frame frame;
+    SetupFrame(frame, view, orbit, width, height, pixels);
+    int tileCount = frame.tilesX * ((height + TILE_SIZE - 1) / TILE_SIZE);
+    JobSystem::GetInstance()->ParallelFor((size_t)tileCount, 1, [&frame](size_t tile) {
+        RenderTile<simd::FloatNative>(frame, (int)tile);
+    });
+
+    FinishFrame(frame, std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count());
+}
+
+void CpuDeepZoom::RenderReference(const DeepZoomView& view, const ReferenceOrbit& orbit, int width, int height, uint32_t* pixels)
+{
+    if (width <= 0 || height <= 0 || !pixels || orbit.points.empty()) {
+        return;
+    }
+    PROFILE_ZONE("CpuDeepZoom::RenderReference");
+    auto start = std::chrono::steady_clock::now();
+
+    Frame frame;
+    SetupFrame(frame, view, orbit, width, height, pixels);
+    int tileCount = frame.tilesX * ((height + TILE_SIZE - 1) / TILE_SIZE);
+    for (int tile = 0; tile < tileCount; tile++) {
+        RenderTile<simd::Float1>(frame, tile);
+    }
+
+    FinishFrame(frame, std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count());
+}
+
+template<typename V>
+void CpuDeepZoom::RenderTile(Frame& frame, int tile)
+{
+    constexpr int WIDTH = V::WIDTH;
+    // Two packets in flight hide most of the multiply latency; one pixel at a
+    // time stays one pixel at a time
+    constexpr int PACKETS = WIDTH > 1 ? 2 : 1;
+    int x0 = (tile % frame.tilesX) * TILE_SIZE;
+    int y0 = (tile / frame.tilesX) * TILE_SIZE;
+    int x1 = std::min(x0 + TILE_SIZE, frame.width);
+    int y1 = std::min(y0 + TILE_SIZE, frame.height);
+
+    // Pixel centres map to [-aspect, aspect] x [-1, 1], bottom row first, then
+    // rotate and move to the reference point
+    float scaleX = 2.0f / (float)frame.width;
+    float scaleY = 2.0f / (float)frame.height;
+    float laneOffsets[WIDTH];
+    for (int lane = 0; lane < WIDTH; lane++) {
+        laneOffsets[lane] = (float)lane;
+    }
+    const V laneOffset = V::Load(laneOffsets);
+    const V cosine(frame.rotation.x);
+    const V sine(frame.rotation.y);
+
+    const float LN2 = 0.69314718f;
+    float red[WIDTH], green[WIDTH], blue[WIDTH], laneIterations[WIDTH], laneRebases[WIDTH];
+    uint64_t tileIterations = 0;
+    uint64_t tileRebases = 0;
+    for (int y = y0; y < y1; y++) {
+        V planeY(((float)y + 0.5f) * scaleY - 1.0f);
+        uint32_t* row = frame.pixels + (size_t)y * (size_t)frame.width;
+
+        // Runs of PACKETS adjacent packets go through the orbit together
+        for (int x = x0; x < x1; x += WIDTH * PACKETS) {
+            PerturbLanes<V> lanes[PACKETS];
+            for (int packet = 0; packet < PACKETS; packet++) {
+                V packetX((float)(x + packet * WIDTH) + 0.5f);
+                V planeX = simd::MulAdd(packetX + laneOffset, V(scaleX), V(-1.0f)) * V(frame.aspect);
+                V dcx = planeX * cosine - planeY * sine + V(frame.offset.x);
+                V dcy = planeX * sine + planeY * cosine + V(frame.offset.y);
+                StartLanes(lanes[packet], *frame.orbit, dcx, dcy);
+            }
+            PerturbPackets<V, PACKETS>(lanes, *frame.orbit, frame.iterations, frame.scale);
+
+            for (int packet = 0; packet < PACKETS; packet++) {
+                const PerturbLanes<V>& result = lanes[packet];
+                // Continuous escape count, n + 1 - log2(log2 |z|); pixels that never escaped are black
+                V escaped = result.escapeIteration > V(0.0f);
+                V logMagnitude = simd::Log(simd::Max(result.magnitude, V(ESCAPE_RADIUS_SQUARED)));
+                V smooth = result.escapeIteration + V(1.0f) - simd::Log(logMagnitude * V(0.5f / LN2)) * V(1.0f / LN2);
+                simd::Vec3<V> color = simd::Select(escaped, PaletteLanes(smooth), simd::Vec3<V>(0.0f));
+
+                color.x.Store(red);
+                color.y.Store(green);
+                color.z.Store(blue);
+                result.iterationCount.Store(laneIterations);
+                result.rebaseCount.Store(laneRebases);
+                int packetX = x + packet * WIDTH;
+                int count = std::min(WIDTH, x1 - packetX);
+                for (int lane = 0; lane < count; lane++) {
+                    row[packetX + lane] = CpuRayMarcher::PackPixel(glm::vec3(red[lane], green[lane], blue[lane]));
+                    tileIterations += (uint64_t)laneIterations[lane];
+                    tileRebases += (uint64_t)laneRebases[lane];
+                }
+            }
+        }
+    }
+    frame.iterationCount.fetch_add(tileIterations, std::memory_order_relaxed);
+    frame.rebases.fetch_add(tileRebases, std::memory_order_relaxed);
+}
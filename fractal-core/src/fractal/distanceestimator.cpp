@@ -0,0 +1,18 @@
+// distanceestimator.cpp
+
+// local headers
+#include "fractal/distanceestimator.h"
+
+float EstimateDistance(const glm::vec3& p, const FractalParams& params)
+{
+    simd::Vec3<simd::Float1> lanes(p.x, p.y, p.z);
+    return FractalDistance(lanes, params).Lane(0);
+}
+
+glm::vec3 EstimateNormal(const glm::vec3& p, float h, const FractalParams& params)
+{
+    simd::Vec3<simd::Float1> lanes(p.x, p.y, p.z);
+    auto distance = [&params](const simd::Vec3<simd::Float1>& q) { return FractalDistance(q, params); };
+    simd::Vec3<simd::Float1> normal = FractalNormal(lanes, simd::Float1(h), distance);
+    return glm::vec3(normal.x.Lane(0), normal.y.Lane(0), normal.z.Lane(0));
+}
@@ -0,0 +1,207 @@
+// fixedpoint.cpp
+
+// C++ standard library
+#include <algorithm>
+#include <cmath>
+
+// local headers
+#include "fractal/fixedpoint.h"
+
+namespace {
+// Bits kept beyond what separates neighbouring pixels, for the rounding error the
+// orbit accumulates over its iterations
+const int GUARD_BITS = 64;
+// Pixels across the view height the precision is sized for
+const double PIXELS_PER_SCALE = 4096.0;
+
+int ClampLimbs(int limbs)
+{
+    return std::min(std::max(limbs, 1), FixedPoint::MAX_LIMBS);
+}
+}
+
+FixedPoint FixedPoint::FromDouble(double value, int limbs)
+{
+    FixedPoint result;
+    result.limbCount = ClampLimbs(limbs);
+    double magnitude = std::fabs(value);
+    double whole = std::floor(magnitude);
+    result.limbs[0] = (uint32_t)whole;
+    double fraction = magnitude - whole;
+    for (int i = 1; i < result.limbCount && fraction > 0.0; i++) {
+        fraction *= 4294967296.0;
+        double limb = std::floor(fraction);
+        result.limbs[i] = (uint32_t)limb;
+        fraction -= limb;
+    }
+    return value < 0.0 ? -result : result;
+}
+
+bool FixedPoint::Parse(const std::string& text, int limbs, FixedPoint& result)
+{
+    size_t i = 0;
+    bool bNegative = false;
+    if (i < text.size() && (text[i] == '-' || text[i] == '+')) {
+        bNegative = text[i] == '-';
+        i++;
+    }
+    uint32_t whole = 0;
+    size_t digits = 0;
+    for (; i < text.size() && text[i] >= '0' && text[i] <= '9'; i++, digits++) {
+        whole = whole * 10 + (uint32_t)(text[i] - '0');
+        if (whole >= 0x8000u) {
+            return false;
+        }
+    }
+    size_t fractionBegin = text.size();
+    if (i < text.size() && text[i] == '.') {
+        fractionBegin = ++i;
+        for (; i < text.size() && text[i] >= '0' && text[i] <= '9'; i++, digits++) {
+        }
+    }
+    if (i != text.size() || digits == 0) {
+        return false;
+    }
+
+    // The fraction is built from its last digit up, a tenth at a time
+    FixedPoint value;
+    value.limbCount = ClampLimbs(limbs);
+    for (size_t digit = text.size(); digit > fractionBegin; digit--) {
+        value.limbs[0] += (uint32_t)(text[digit - 1] - '0');
+        value.DivideSmall(10);
+    }
+    value.limbs[0] = whole;
+    result = bNegative ? -value : value;
+    return true;
+}
+
+int FixedPoint::LimbsForScale(double scale)
+{
+    double pixel = std::fabs(scale) / PIXELS_PER_SCALE;
+    int bits = pixel > 0.0 ? (int)std::ceil(-std::log2(pixel)) : MAX_LIMBS * FRACTION_BITS_PER_LIMB;
+    bits = std::max(bits, 0) + GUARD_BITS;
+    return ClampLimbs(1 + (bits + FRACTION_BITS_PER_LIMB - 1) / FRACTION_BITS_PER_LIMB);
+}
+
+double FixedPoint::ToDouble() const
+{
+    FixedPoint magnitude = IsNegative() ? -*this : *this;
+    double value = 0.0;
+    double weight = 1.0;
+    // Every limb counts, small values keep their precision in the exponent
+    for (int i = 0; i < limbCount; i++) {
+        value += (double)magnitude.limbs[i] * weight;
+        weight *= 1.0 / 4294967296.0;
+    }
+    return IsNegative() ? -value : value;
+}
+
+std::string FixedPoint::ToString(int digits) const
+{
+    FixedPoint fraction = IsNegative() ? -*this : *this;
+    std::string text = IsNegative() ? "-" : "";
+    text += std::to_string(fraction.limbs[0]);
+    if (digits > 0) {
+        text += '.';
+    }
+    fraction.limbs[0] = 0;
+    for (int i = 0; i < digits; i++) {
+        fraction.MultiplySmall(10);
+        text += (char)('0' + fraction.limbs[0]);
+        fraction.limbs[0] = 0;
+    }
+    return text;
+}
+
+FixedPoint FixedPoint::WithLimbs(int newLimbs) const
+{
+    newLimbs = ClampLimbs(newLimbs);
+    // Dropping limbs of a two's complement value rounds down, so shorten the magnitude
+    if (newLimbs < limbCount && IsNegative()) {
+        return -(-*this).WithLimbs(newLimbs);
+    }
+    FixedPoint result = *this;
+    result.limbCount = newLimbs;
+    for (int i = newLimbs; i < limbCount; i++) {
+        result.limbs[i] = 0;
+    }
+    return result;
+}
+
+FixedPoint FixedPoint::operator+(const FixedPoint& other) const
+{
+    int count = std::max(limbCount, other.limbCount);
+    FixedPoint a = WithLimbs(count);
+    FixedPoint b = other.WithLimbs(count);
+    uint64_t carry = 0;
+    for (int i = count - 1; i >= 0; i--) {
+        uint64_t sum = (uint64_t)a.limbs[i] + (uint64_t)b.limbs[i] + carry;
+        a.limbs[i] = (uint32_t)sum;
+        carry = sum >> 32;
+    }
+    return a;
+}
+
+FixedPoint FixedPoint::operator-(const FixedPoint& other) const
+{
+    return *this + (-other);
+}
+
+FixedPoint FixedPoint::operator-() const
+{
+    FixedPoint result = *this;
+    uint64_t carry = 1;
+    for (int i = limbCount - 1; i >= 0; i--) {
+        uint64_t sum = (uint64_t)(~limbs[i]) + carry;
+        result.limbs[i] = (uint32_t)sum;
+        carry = sum >> 32;
+    }
+    return result;
+}
+
+FixedPoint FixedPoint::operator*(const FixedPoint& other) const
+{
+    int count = std::max(limbCount, other.limbCount);
+    FixedPoint a = IsNegative() ? -WithLimbs(count) : WithLimbs(count);
+    FixedPoint b = other.IsNegative() ? -other.WithLimbs(count) : other.WithLimbs(count);
+
+    // Schoolbook product of the magnitudes, least significant limb first; the
+    // result is the window of count limbs that lines up with the integer limb
+    uint32_t product[2 * MAX_LIMBS] = {};
+    for (int i = 0; i < count; i++) {
+        uint64_t carry = 0;
+        uint32_t ai = a.limbs[count - 1 - i];
+        for (int j = 0; j < count; j++) {
+            uint64_t term = (uint64_t)ai * (uint64_t)b.limbs[count - 1 - j] + (uint64_t)product[i + j] + carry;
+            product[i + j] = (uint32_t)term;
+            carry = term >> 32;
+        }
+        product[i + count] = (uint32_t)carry;
+    }
+    FixedPoint result;
+    result.limbCount = count;
+    for (int i = 0; i < count; i++) {
+        result.limbs[i] = product[2 * count - 2 - i];
+    }
+    return IsNegative() != other.IsNegative() ? -result : result;
+}
+
+void FixedPoint::MultiplySmall(uint32_t factor)
+{
+    uint64_t carry = 0;
+    for (int i = limbCount - 1; i >= 0; i--) {
+        uint64_t term = (uint64_t)limbs[i] * factor + carry;
+        limbs[i] = (uint32_t)term;
+        carry = term >> 32;
+    }
+}
+
+void FixedPoint::DivideSmall(uint32_t divisor)
+{
+    uint64_t remainder = 0;
+    for (int i = 0; i < limbCount; i++) {
+        uint64_t current = (remainder << 32) | limbs[i];
+        limbs[i] = (uint32_t)(current / divisor);
+        remainder = current % divisor;
+    }
+}
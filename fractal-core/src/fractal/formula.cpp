@@ -0,0 +1,39 @@
+// formula.cpp
+
+// C++ standard library
+#include <cmath>
+
+// local headers
+#include "fractal/formula.h"
+
+FormulaKernel SelectFormulaKernel(const FractalParams& params, bool bSpecialized)
+{
+    FormulaKernel kernel;
+    kernel.type = params.type;
+    // Whole powers only; the bound keeps the int conversion defined
+    bool bWholePower = std::floor(params.power) == params.power && std::fabs(params.power) < 1024.0f;
+    if (!bSpecialized || params.type != FractalType::Mandelbulb || !bWholePower) {
+        return kernel;
+    }
+    switch ((int)params.power) {
+        #define FRACTAL_SELECT_POWER(N) case N:
+        FRACTAL_SPECIALIZED_POWERS(FRACTAL_SELECT_POWER)
+        #undef FRACTAL_SELECT_POWER
+            kernel.power = (int)params.power;
+            break;
+        default:
+            break;
+    }
+    return kernel;
+}
+
+std::string FormulaKernelName(const FormulaKernel& kernel)
+{
+    if (kernel.type == FractalType::QuaternionJulia) {
+        return "julia";
+    }
+    if (kernel.IsSpecialized()) {
+        return "mandelbulb" + std::to_string(kernel.power);
+    }
+    return "mandelbulb";
+}
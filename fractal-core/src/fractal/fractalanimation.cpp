@@ -0,0 +1,302 @@
+// fractalanimation.cpp
+
+// C++ standard library
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+// local headers
+#include "fractal/fractalanimation.h"
+
+namespace {
+// Parses the optional curve word at the end of a value line
+bool ReadCurve(std::istringstream& stream, AnimationCurve& curve)
+{
+    std::string word;
+    if (!(stream >> word)) {
+        return true;
+    }
+    return ParseAnimationCurve(word, curve);
+}
+
+template<typename T>
+float LastTime(const AnimationTrack<T>& track)
+{
+    return track.keys.empty() ? 0.0f : track.keys.back().time;
+}
+
+template<typename T>
+const typename AnimationTrack<T>::Key* FindKey(const AnimationTrack<T>& track, float time)
+{
+    for (const auto& key : track.keys) {
+        if (key.time == time) {
+            return &key;
+        }
+    }
+    return nullptr;
+}
+
+void WriteValue(std::ostream& out, float value) { out << " " << value; }
+void WriteValue(std::ostream& out, const glm::vec3& value) { out << " " << value.x << " " << value.y << " " << value.z; }
+void WriteValue(std::ostream& out, const glm::vec4& value) { out << " " << value.x << " " << value.y << " " << value.z << " " << value.w; }
+
+template<typename T>
+void WriteKey(std::ostream& out, const char* name, const AnimationTrack<T>& track, float time)
+{
+    const auto* key = FindKey(track, time);
+    if (key) {
+        out << name;
+        WriteValue(out, key->value);
+        out << " " << AnimationCurveToString(key->curve) << "\n";
+    }
+}
+}
+
+const char* AnimationCurveToString(AnimationCurve curve)
+{
+    switch (curve) {
+        case AnimationCurve::Step: return "step";
+        case AnimationCurve::Linear: return "linear";
+        case AnimationCurve::Smooth: return "smooth";
+        case AnimationCurve::Spline: return "spline";
+    }
+    return "unknown";
+}
+
+bool ParseAnimationCurve(const std::string& text, AnimationCurve& curve)
+{
+    for (AnimationCurve candidate : { AnimationCurve::Step, AnimationCurve::Linear, AnimationCurve::Smooth, AnimationCurve::Spline }) {
+        if (text == AnimationCurveToString(candidate)) {
+            curve = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+template<typename T>
+void AnimationTrack<T>::AddKey(float time, const T& value, AnimationCurve curve)
+{
+    auto it = std::lower_bound(keys.begin(), keys.end(), time, [](const Key& k, float t) { return k.time < t; });
+    if (it != keys.end() && it->time == time) {
+        *it = Key{ time, value, curve };
+        return;
+    }
+    keys.insert(it, Key{ time, value, curve });
+}
+
+template<typename T>
+T AnimationTrack<T>::Evaluate(float time, const T& fallback) const
+{
+    if (keys.empty()) {
+        return fallback;
+    }
+    if (time <= keys.front().time) {
+        return keys.front().value;
+    }
+    if (time >= keys.back().time) {
+        return keys.back().value;
+    }
+
+    // Segment [i, i + 1] containing time
+    auto it = std::upper_bound(keys.begin(), keys.end(), time, [](float t, const Key& k) { return t < k.time; });
+    int count = (int)keys.size();
+    int i = std::min(std::max((int)(it - keys.begin()) - 1, 0), count - 2);
+    const Key& k1 = keys[i];
+    const Key& k2 = keys[i + 1];
+    float span = k2.time - k1.time;
+    float u = span > 0.0f ? (time - k1.time) / span : 0.0f;
+
+    switch (k1.curve) {
+        case AnimationCurve::Step:
+            return k1.value;
+        case AnimationCurve::Linear:
+            return k1.value + (k2.value - k1.value) * u;
+        case AnimationCurve::Smooth:
+            return k1.value + (k2.value - k1.value) * (u * u * (3.0f - 2.0f * u));
+        case AnimationCurve::Spline:
+            break;
+    }
+
+    // Cubic Hermite with Catmull-Rom tangents taken over time, so unevenly spaced
+    // keys keep a steady velocity through each key; the ends have one-sided tangents
+    const Key& k0 = keys[std::max(i - 1, 0)];
+    const Key& k3 = keys[std::min(i + 2, count - 1)];
+    T m1 = (k2.value - k0.value) * (span / std::max(k2.time - k0.time, 1e-6f));
+    T m2 = (k3.value - k1.value) * (span / std::max(k3.time - k1.time, 1e-6f));
+    float u2 = u * u;
+    float u3 = u2 * u;
+    return k1.value * (2.0f * u3 - 3.0f * u2 + 1.0f) + m1 * (u3 - 2.0f * u2 + u) +
+           k2.value * (3.0f * u2 - 2.0f * u3) + m2 * (u3 - u2);
+}
+
+template struct AnimationTrack<float>;
+template struct AnimationTrack<glm::vec3>;
+template struct AnimationTrack<glm::vec4>;
+
+float FractalAnimation::GetDuration() const
+{
+    if (duration > 0.0f) {
+        return duration;
+    }
+    return std::max({ LastTime(position), LastTime(target), LastTime(fov), LastTime(power), LastTime(iterations),
+                      LastTime(bailout), LastTime(juliaC) });
+}
+
+int FractalAnimation::GetFrameCount() const
+{
+    if (fps <= 0.0f) {
+        return 1;
+    }
+    return (int)std::floor(GetDuration() * fps + 1e-3f) + 1;
+}
+
+FractalAnimationFrame FractalAnimation::Evaluate(float time) const
+{
+    FractalAnimationFrame frame;
+    frame.time = time;
+    frame.position = position.Evaluate(time, frame.position);
+    frame.target = target.Evaluate(time, frame.target);
+    frame.fov = fov.Evaluate(time, frame.fov);
+    frame.params.type = type;
+    frame.params.power = power.Evaluate(time, frame.params.power);
+    frame.params.iterations = std::max(1, (int)std::lround(iterations.Evaluate(time, (float)frame.params.iterations)));
+    frame.params.bailout = bailout.Evaluate(time, frame.params.bailout);
+    frame.params.juliaC = juliaC.Evaluate(time, frame.params.juliaC);
+    return frame;
+}
+
+FractalAnimationFrame FractalAnimation::EvaluateFrame(int index) const
+{
+    FractalAnimationFrame frame = Evaluate(fps > 0.0f ? (float)index / fps : 0.0f);
+    frame.index = index;
+    return frame;
+}
+
+bool FractalAnimation::Load(const std::string& path)
+{
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open fractal animation: " << path << std::endl;
+        return false;
+    }
+
+    *this = FractalAnimation();
+    float keyTime = 0.0f;
+    AnimationCurve keyCurve = AnimationCurve::Linear;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        std::istringstream stream(line);
+        std::string keyword;
+        if (!(stream >> keyword) || keyword[0] == '#') {
+            continue;
+        }
+
+        bool bValid = true;
+        AnimationCurve curve = keyCurve;
+        if (keyword == "type") {
+            std::string name;
+            stream >> name;
+            bValid = name == "mandelbulb" || name == "julia";
+            type = name == "julia" ? FractalType::QuaternionJulia : FractalType::Mandelbulb;
+        }
+        else if (keyword == "fps") {
+            bValid = (bool)(stream >> fps) && fps > 0.0f;
+        }
+        else if (keyword == "duration") {
+            bValid = (bool)(stream >> duration) && duration >= 0.0f;
+        }
+        else if (keyword == "key") {
+            keyCurve = AnimationCurve::Linear;
+            bValid = (bool)(stream >> keyTime) && keyTime >= 0.0f && ReadCurve(stream, keyCurve);
+        }
+        else if (keyword == "camera") {
+            glm::vec3 from;
+            glm::vec3 to;
+            bValid = (bool)(stream >> from.x >> from.y >> from.z >> to.x >> to.y >> to.z) && ReadCurve(stream, curve);
+            if (bValid) {
+                position.AddKey(keyTime, from, curve);
+                target.AddKey(keyTime, to, curve);
+            }
+        }
+        else if (keyword == "julia") {
+            glm::vec4 c;
+            bValid = (bool)(stream >> c.x >> c.y >> c.z >> c.w) && ReadCurve(stream, curve);
+            if (bValid) {
+                juliaC.AddKey(keyTime, c, curve);
+            }
+        }
+        else if (keyword == "fov" || keyword == "power" || keyword == "iterations" || keyword == "bailout") {
+            AnimationTrack<float>& track = keyword == "fov" ? fov :
+                                           keyword == "power" ? power :
+                                           keyword == "iterations" ? iterations : bailout;
+            float value = 0.0f;
+            bValid = (bool)(stream >> value) && ReadCurve(stream, curve);
+            if (bValid) {
+                track.AddKey(keyTime, value, curve);
+            }
+        }
+        else {
+            std::cerr << path << ":" << lineNumber << ": unknown keyword '" << keyword << "'" << std::endl;
+            return false;
+        }
+        if (!bValid) {
+            std::cerr << path << ":" << lineNumber << ": invalid '" << keyword << "' line" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool FractalAnimation::Save(const std::string& path) const
+{
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Failed to write fractal animation: " << path << std::endl;
+        return false;
+    }
+
+    file << "type " << FractalTypeToString(type) << "\n";
+    file << "fps " << fps << "\n";
+    if (duration > 0.0f) {
+        file << "duration " << duration << "\n";
+    }
+
+    // One key line per distinct time, every value with its own curve
+    std::vector<float> times;
+    auto addTimes = [&times](const auto& track) {
+        for (const auto& key : track.keys) {
+            times.push_back(key.time);
+        }
+    };
+    addTimes(position);
+    addTimes(fov);
+    addTimes(power);
+    addTimes(iterations);
+    addTimes(bailout);
+    addTimes(juliaC);
+    std::sort(times.begin(), times.end());
+    times.erase(std::unique(times.begin(), times.end()), times.end());
+
+    for (float time : times) {
+        file << "key " << time << "\n";
+        const auto* from = FindKey(position, time);
+        const auto* to = FindKey(target, time);
+        if (from && to) {
+            file << "camera";
+            WriteValue(file, from->value);
+            WriteValue(file, to->value);
+            file << " " << AnimationCurveToString(from->curve) << "\n";
+        }
+        WriteKey(file, "fov", fov, time);
+        WriteKey(file, "power", power, time);
+        WriteKey(file, "iterations", iterations, time);
+        WriteKey(file, "bailout", bailout, time);
+        WriteKey(file, "julia", juliaC, time);
+    }
+    return (bool)file;
+}
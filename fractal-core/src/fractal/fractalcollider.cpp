@@ -0,0 +1,252 @@
+// fractalcollider.cpp
+
+// C++ standard library
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+
+// local headers
+#include "fractal/fractalcollider.h"
+#include "fractal/formula.h"
+#include "jobsystem.h"
+#include "profiler.h"
+
+namespace {
+// Estimate at p, or the distance to the bailout sphere where that is larger;
+// both bound the distance to the set
+template<typename V, typename Kernel>
+V BoundedDistance(const simd::Vec3<V>& p, const FractalParams& params, const Kernel& kernel)
+{
+    return simd::Max(simd::Length(p) - V(params.bailout), kernel(p));
+}
+
+template<typename V, typename Kernel>
+void SpherePacket(const SphereQuery* spheres, int count, ProximityResult* results, const FractalParams& params,
+                  const Kernel& kernel, const CollisionSettings& settings)
+{
+    constexpr int WIDTH = V::WIDTH;
+    float x[WIDTH], y[WIDTH], z[WIDTH], radius[WIDTH];
+    float distance[WIDTH], normalX[WIDTH], normalY[WIDTH], normalZ[WIDTH];
+    for (int first = 0; first < count; first += WIDTH) {
+        int lanes = std::min(WIDTH, count - first);
+        for (int lane = 0; lane < WIDTH; lane++) {
+            // Spare lanes repeat the last sphere
+            const SphereQuery& sphere = spheres[first + std::min(lane, lanes - 1)];
+            x[lane] = sphere.center.x;
+            y[lane] = sphere.center.y;
+            z[lane] = sphere.center.z;
+            radius[lane] = sphere.radius;
+        }
+        simd::Vec3<V> center(V::Load(x), V::Load(y), V::Load(z));
+        V sphereRadius = V::Load(radius);
+        V h = simd::Max(sphereRadius * V(0.25f), V(settings.normalStep));
+        V centreDistance = BoundedDistance(center, params, kernel);
+        simd::Vec3<V> normal = FractalNormal(center, h, kernel);
+
+        (centreDistance - sphereRadius).Store(distance);
+        normal.x.Store(normalX);
+        normal.y.Store(normalY);
+        normal.z.Store(normalZ);
+        for (int lane = 0; lane < lanes; lane++) {
+            ProximityResult& result = results[first + lane];
+            result.distance = distance[lane];
+            result.normal = glm::vec3(normalX[lane], normalY[lane], normalZ[lane]);
+            result.point = spheres[first + lane].center - result.normal * (distance[lane] + radius[lane]);
+        }
+    }
+}
+
+// Sphere traces a packet of swept spheres; returns the hit mask, lanes out of
+// steps included, and leaves the distance each centre reached in t and the
+// steps per lane in steps
+template<typename V, typename Kernel>
+V CastPacket(const simd::Vec3<V>& origin, const simd::Vec3<V>& dir, const V& maxDistance, const V& radius,
+             const FractalParams& params, const Kernel& kernel, const CollisionSettings& settings, V& t, V& steps)
+{
+    // The set lies inside the bailout sphere, so only that sphere grown by the
+    // radius has to be crossed
+    V reach = V(params.bailout) + radius;
+    V b = simd::Dot(origin, dir);
+    V c = simd::Dot(origin, origin) - reach * reach;
+    V discriminant = b * b - c;
+    V root = simd::Sqrt(simd::Max(discriminant, V(0.0f)));
+    V tExit = simd::Min(-b + root, maxDistance);
+    t = simd::Max(-b - root, V(0.0f));
+    steps = V(0.0f);
+
+    V active = (discriminant > V(0.0f)) & (t <= tExit);
+    V hit(0.0f);
+    for (int i = 0; i < settings.maxSteps && simd::Any(active); i++) {
+        simd::Vec3<V> position = origin + dir * t;
+        steps += simd::MaskToOne(active);
+        V distance = BoundedDistance(position, params, kernel) - radius;
+
+        V hitNow = active & (distance < V(settings.hitDistance));
+        hit = hit | hitNow;
+        active = simd::AndNot(active, hitNow);
+        t = simd::Select(active, simd::MulAdd(distance, V(settings.stepScale), t), t);
+        active = active & (t <= tExit);
+    }
+    return hit | active;
+}
+
+template<typename V, typename Kernel>
+void CastPackets(const SphereCast* casts, int count, CastResult* results, const FractalParams& params, const Kernel& kernel,
+                 const CollisionSettings& settings, uint64_t& steps)
+{
+    constexpr int WIDTH = V::WIDTH;
+    float originX[WIDTH], originY[WIDTH], originZ[WIDTH], dirX[WIDTH], dirY[WIDTH], dirZ[WIDTH];
+    float maxDistance[WIDTH], radius[WIDTH];
+    float distance[WIDTH], hits[WIDTH], normalX[WIDTH], normalY[WIDTH], normalZ[WIDTH], laneSteps[WIDTH];
+    for (int first = 0; first < count; first += WIDTH) {
+        int lanes = std::min(WIDTH, count - first);
+        for (int lane = 0; lane < WIDTH; lane++) {
+            const SphereCast& cast = casts[first + std::min(lane, lanes - 1)];
+            originX[lane] = cast.origin.x;
+            originY[lane] = cast.origin.y;
+            originZ[lane] = cast.origin.z;
+            dirX[lane] = cast.direction.x;
+            dirY[lane] = cast.direction.y;
+            dirZ[lane] = cast.direction.z;
+            maxDistance[lane] = cast.maxDistance;
+            radius[lane] = cast.radius;
+        }
+        simd::Vec3<V> origin(V::Load(originX), V::Load(originY), V::Load(originZ));
+        simd::Vec3<V> dir(V::Load(dirX), V::Load(dirY), V::Load(dirZ));
+        V castRadius = V::Load(radius);
+        V t, packetSteps;
+        V hit = CastPacket(origin, dir, V::Load(maxDistance), castRadius, params, kernel, settings, t, packetSteps);
+
+        simd::Vec3<V> normal(0.0f);
+        if (simd::Any(hit)) {
+            V h = simd::Max(castRadius * V(0.25f), V(settings.normalStep));
+            normal = simd::Select(hit, FractalNormal(origin + dir * t, h, kernel), normal);
+        }
+        t.Store(distance);
+        simd::MaskToOne(hit).Store(hits);
+        normal.x.Store(normalX);
+        normal.y.Store(normalY);
+        normal.z.Store(normalZ);
+        packetSteps.Store(laneSteps);
+        for (int lane = 0; lane < lanes; lane++) {
+            steps += (uint64_t)laneSteps[lane];
+            const SphereCast& cast = casts[first + lane];
+            CastResult& result = results[first + lane];
+            result.bHit = hits[lane] > 0.0f;
+            result.distance = result.bHit ? distance[lane] : cast.maxDistance;
+            result.normal = glm::vec3(normalX[lane], normalY[lane], normalZ[lane]);
+            glm::vec3 centre = cast.origin + cast.direction * result.distance;
+            result.point = result.bHit ? centre - result.normal * cast.radius : centre;
+        }
+    }
+}
+
+// body(first, count) over [0, count) in batches, as jobs when there is more than one
+template<typename F>
+void ForEachBatch(int count, int batchSize, const F& body)
+{
+    int batches = (count + batchSize - 1) / batchSize;
+    if (batches <= 1) {
+        body(0, count);
+        return;
+    }
+    JobSystem::GetInstance()->ParallelFor((size_t)batches, 1, [&](size_t batch) {
+        int first = (int)batch * batchSize;
+        body(first, std::min(batchSize, count - first));
+    });
+}
+}
+
+void FractalCollider::QuerySpheres(const SphereQuery* spheres, int count, ProximityResult* results)
+{
+    stats = CollisionStats();
+    if (count <= 0) {
+        return;
+    }
+    PROFILE_ZONE("FractalCollider::QuerySpheres");
+    auto start = std::chrono::steady_clock::now();
+    VisitFormulaKernel(params, SelectFormulaKernel(params, settings.bSpecializedKernels), [&](const auto& kernel) {
+        ForEachBatch(count, std::max(settings.batchSize, 1), [&](int first, int batchCount) {
+            // A lone query takes one lane instead of repeating itself over a packet
+            if (batchCount < simd::FloatNative::WIDTH / 2) {
+                SpherePacket<simd::Float1>(spheres + first, batchCount, results + first, params, kernel, settings);
+            }
+            else {
+                SpherePacket<simd::FloatNative>(spheres + first, batchCount, results + first, params, kernel, settings);
+            }
+        });
+    });
+    stats.spheres = (uint64_t)count;
+    stats.ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void FractalCollider::CastSpheres(const SphereCast* casts, int count, CastResult* results)
+{
+    stats = CollisionStats();
+    if (count <= 0) {
+        return;
+    }
+    PROFILE_ZONE("FractalCollider::CastSpheres");
+    auto start = std::chrono::steady_clock::now();
+    std::atomic<uint64_t> steps{0};
+    VisitFormulaKernel(params, SelectFormulaKernel(params, settings.bSpecializedKernels), [&](const auto& kernel) {
+        ForEachBatch(count, std::max(settings.batchSize, 1), [&](int first, int batchCount) {
+            uint64_t batchSteps = 0;
+            if (batchCount < simd::FloatNative::WIDTH / 2) {
+                CastPackets<simd::Float1>(casts + first, batchCount, results + first, params, kernel, settings, batchSteps);
+            }
+            else {
+                CastPackets<simd::FloatNative>(casts + first, batchCount, results + first, params, kernel, settings,
+                                               batchSteps);
+            }
+            steps += batchSteps;
+        });
+    });
+    stats.casts = (uint64_t)count;
+    stats.steps = steps.load();
+    stats.ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+glm::vec3 SweptSphereController::Move(FractalCollider& collider, const glm::vec3& position, const glm::vec3& displacement)
+{
+    bTouching = false;
+    glm::vec3 current = position;
+
+    SphereQuery sphere;
+    sphere.center = current;
+    sphere.radius = settings.radius;
+    ProximityResult proximity;
+    collider.QuerySpheres(&sphere, 1, &proximity);
+    if (proximity.distance < 0.0f) {
+        current += proximity.normal * (settings.skin - proximity.distance);
+        bTouching = true;
+    }
+
+    glm::vec3 remaining = displacement;
+    for (int slide = 0; slide <= settings.maxSlides; slide++) {
+        float length = glm::length(remaining);
+        if (length <= 1e-7f) {
+            break;
+        }
+        SphereCast cast;
+        cast.origin = current;
+        cast.direction = remaining / length;
+        cast.maxDistance = length + settings.skin;
+        cast.radius = settings.radius;
+        CastResult hit;
+        collider.CastSpheres(&cast, 1, &hit);
+        // Already touching and moving away is free to go
+        if (!hit.bHit || (hit.distance <= 0.0f && glm::dot(cast.direction, hit.normal) >= 0.0f)) {
+            current += remaining;
+            break;
+        }
+        bTouching = true;
+        float travel = std::max(hit.distance - settings.skin, 0.0f);
+        current += cast.direction * travel;
+        // What is left goes on along the surface
+        remaining = cast.direction * (length - travel);
+        remaining -= hit.normal * std::min(glm::dot(remaining, hit.normal), 0.0f);
+    }
+    return current;
+}
@@ -0,0 +1,61 @@
+// fractalparams.cpp
+
+// C++ standard library
+#include <cmath>
+
+// glm
+#include <glm/glm.hpp>
+
+// local headers
+#include "fractal/fractalparams.h"
+
+const char* FractalTypeToString(FractalType type)
+{
+    switch (type) {
+        case FractalType::Mandelbulb: return "mandelbulb";
+        case FractalType::QuaternionJulia: return "julia";
+    }
+    return "unknown";
+}
+
+const char* FractalBackendToString(FractalBackend backend)
+{
+    switch (backend) {
+        case FractalBackend::None: return "none";
+        case FractalBackend::Cpu: return "cpu";
+        case FractalBackend::Gpu: return "gpu";
+    }
+    return "unknown";
+}
+
+FractalView FractalView::FromCamera(const Camera& camera)
+{
+    FractalView view;
+    view.position = camera.getPosition();
+    view.right = camera.getLocalRight();
+    view.up = camera.getLocalUp();
+    view.forward = camera.getLocalForward();
+    view.tanHalfFov = std::tan(glm::radians(camera.getFOV()) * 0.5f);
+    view.aspect = camera.getAspect();
+    return view;
+}
+
+FractalView FractalView::LookAt(const glm::vec3& position, const glm::vec3& target, float fovDegrees, float aspect)
+{
+    FractalView view;
+    view.position = position;
+    glm::vec3 forward = target - position;
+    if (glm::dot(forward, forward) > 0.0f) {
+        view.forward = glm::normalize(forward);
+    }
+    // Looking straight up or down, z stands in for the world up
+    glm::vec3 right = glm::cross(view.forward, glm::vec3(0.0f, 1.0f, 0.0f));
+    if (glm::dot(right, right) < 1e-8f) {
+        right = glm::cross(view.forward, glm::vec3(0.0f, 0.0f, -1.0f));
+    }
+    view.right = glm::normalize(right);
+    view.up = glm::cross(view.right, view.forward);
+    view.tanHalfFov = std::tan(glm::radians(fovDegrees) * 0.5f);
+    view.aspect = aspect;
+    return view;
+}
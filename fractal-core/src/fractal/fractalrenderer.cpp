@@ -0,0 +1,512 @@
+// fractalrenderer.cpp
+
+// C++ standard library
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+// glm
+#include <glm/gtc/type_ptr.hpp>
+
+// local headers
+#include "fractal/fractalrenderer.h"
+#include "memorytracker.h"
+#include "shadervariantcache.h"
+#include "profiler.h"
+
+namespace {
+ShaderVariantCache* fractalShaders = nullptr;
+// Created with the first deep zoom, most sessions never need it
+ShaderVariantCache* deepZoomShaders = nullptr;
+
+// Texture unit the cone level read by a pass is bound to
+const int CONE_TEXTURE_UNIT = 0;
+
+// Texture units of the history a temporal pass reprojects from
+const int HISTORY_COLOR_UNIT = 1;
+const int HISTORY_GEOMETRY_UNIT = 2;
+
+// The fractal.frag variant of a kernel, mirroring what the CPU instantiates
+ShaderDefines GetFormulaDefines(const FormulaKernel& formula, bool bConePass = false, bool bConeStart = false, bool bTemporal = false)
+{
+    ShaderDefines defines;
+    defines.Set("FRACTAL_TYPE", (int)formula.type);
+    if (formula.IsSpecialized()) {
+        defines.Set("MANDELBULB_POWER", formula.power);
+    }
+    if (bConePass) {
+        defines.Set("CONE_PASS", 1);
+    }
+    if (bConeStart) {
+        defines.Set("CONE_START", 1);
+    }
+    if (bTemporal) {
+        defines.Set("TEMPORAL", 1);
+    }
+    return defines;
+}
+
+// Depth a cone level encodes as its largest value: past the far side of the
+// bailout sphere from anywhere the camera can be
+float ConeRange(const FractalView& view, const FractalParams& params)
+{
+    return glm::length(view.position) + params.bailout;
+}
+}
+
+FractalRenderer::FractalRenderer(const FractalParams& params)
+{
+    // The likely variants are submitted here so they compile alongside the other
+    // programs before the first frame; any other kernel compiles on first use
+    if (!fractalShaders) {
+        fractalShaders = new ShaderVariantCache("upscale.vert", "fractal.frag");
+        FractalParams julia = params;
+        julia.type = FractalType::QuaternionJulia;
+        fractalShaders->WarmUp({
+            GetFormulaDefines(SelectFormulaKernel(params, true)),
+            GetFormulaDefines(SelectFormulaKernel(params, false)),
+            GetFormulaDefines(SelectFormulaKernel(julia, true))
+        });
+    }
+}
+
+FractalRenderer::~FractalRenderer()
+{
+    if (emptyVAO) {
+        glDeleteVertexArrays(1, &emptyVAO);
+    }
+    if (imageTexture) {
+        glDeleteTextures(1, &imageTexture);
+    }
+    if (orbitTexture) {
+        glDeleteTextures(1, &orbitTexture);
+    }
+    for (Readback& readback : readbacks) {
+        if (readback.buffer) {
+            glDeleteBuffers(1, &readback.buffer);
+        }
+    }
+}
+
+void FractalRenderer::Render(const FractalView& view, const FractalParams& params, const RayMarchSettings& settings, int width, int height)
+{
+    PROFILE_ZONE("FractalRenderer::Render");
+    PROFILE_GPU_ZONE("Fractal");
+    RenderPass(view, params, settings, width, height, nullptr);
+}
+
+void FractalRenderer::RenderTemporal(const FractalView& view, const FractalParams& params, const RayMarchSettings& settings,
+                                     const TemporalSettings& temporalSettings, int width, int height)
+{
+    if (width <= 0 || height <= 0) {
+        return;
+    }
+    PROFILE_ZONE("FractalRenderer::RenderTemporal");
+    PROFILE_GPU_ZONE("FractalTemporal");
+
+    // Same reset as TemporalRenderer::Update
+    bool bReset = !bTemporalValid || params != temporalParams || settings != temporalMarchSettings ||
+                  width != temporalTargets[temporalCurrent].GetWidth() || height != temporalTargets[temporalCurrent].GetHeight();
+    int next = 1 - temporalCurrent;
+    // Creating a target unbinds the caller's framebuffer, so it is saved first
+    GLint framebuffer = 0;
+    GLint viewport[4] = {0, 0, 0, 0};
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &framebuffer);
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    for (RenderTarget& target : temporalTargets) {
+        if (target.GetWidth() != width || target.GetHeight() != height || !target.IsValid()) {
+            MEMORY_SCOPE(MemoryTag::Assets);
+            if (!target.Create(width, height, false, 2)) {
+                std::cerr << "Failed to create a " << width << "x" << height << " temporal fractal target" << std::endl;
+                bTemporalValid = false;
+                glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)framebuffer);
+                return;
+            }
+        }
+    }
+
+    TemporalPass pass;
+    pass.settings = temporalSettings;
+    pass.reprojection.Setup(temporalView, view, width, height);
+    pass.cell = bReset ? -1 : TemporalRenderer::GetPatternCell(temporalFrame);
+    pass.range = ConeRange(view, params);
+    pass.historyRange = temporalRange;
+    pass.historyColor = temporalTargets[temporalCurrent].GetColorTexture(0);
+    pass.historyGeometry = temporalTargets[temporalCurrent].GetColorTexture(1);
+
+    temporalTargets[next].Bind();
+    RenderPass(view, params, settings, width, height, &pass);
+    glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)framebuffer);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+
+    temporalCurrent = next;
+    temporalView = view;
+    temporalParams = params;
+    temporalMarchSettings = settings;
+    temporalRange = pass.range;
+    temporalFrame = bReset ? 0 : temporalFrame + 1;
+    bTemporalValid = true;
+}
+
+void FractalRenderer::RenderPass(const FractalView& view, const FractalParams& params, const RayMarchSettings& settings, int width, int height,
+                                 const TemporalPass* temporal)
+{
+    if (!emptyVAO) {
+        glGenVertexArrays(1, &emptyVAO);
+    }
+
+    // Variant lookups build a key string, so only when the kernel changes
+    FormulaKernel formula = SelectFormulaKernel(params, settings.bSpecializedKernels);
+    if (formula != shaderFormula) {
+        shader = nullptr;
+        std::fill(std::begin(coneShaders), std::end(coneShaders), nullptr);
+        shaderFormula = formula;
+    }
+
+    glDisable(GL_DEPTH_TEST);
+    // Without its targets the pass marches every ray from the sphere
+    bool bCones = settings.bConePrepass && RenderCones(view, params, settings, width, height);
+    bool bTemporal = temporal != nullptr;
+    if (!shader || bCones != bShaderCones || bTemporal != bShaderTemporal) {
+        shader = fractalShaders->Get(GetFormulaDefines(formula, false, bCones, bTemporal));
+        bShaderCones = bCones;
+        bShaderTemporal = bTemporal;
+    }
+
+    GLuint program = shader->programId;
+    shader->Use();
+    SetViewUniforms(program, view, params, settings, width, height);
+    if (bCones) {
+        const int FINEST = CpuRayMarcher::CONE_LEVELS - 1;
+        glActiveTexture(GL_TEXTURE0 + CONE_TEXTURE_UNIT);
+        glBindTexture(GL_TEXTURE_2D, coneTargets[FINEST].GetColorTexture());
+        glActiveTexture(GL_TEXTURE0);
+        glUniform1i(glGetUniformLocation(program, "uConeInput"), CONE_TEXTURE_UNIT);
+        glUniform1i(glGetUniformLocation(program, "uConeInputCellSize"), CpuRayMarcher::CONE_CELL_SIZES[FINEST]);
+        glUniform1f(glGetUniformLocation(program, "uConeRange"), ConeRange(view, params));
+    }
+    if (bTemporal) {
+        SetTemporalUniforms(program, *temporal);
+    }
+
+    glBindVertexArray(emptyVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    Profiler::CountDraw(1);
+    Profiler::Count(ProfileCounter::StateChanges, 2);
+    glBindVertexArray(0);
+    if (bCones) {
+        glActiveTexture(GL_TEXTURE0 + CONE_TEXTURE_UNIT);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glActiveTexture(GL_TEXTURE0);
+    }
+    if (bTemporal) {
+        glActiveTexture(GL_TEXTURE0 + HISTORY_GEOMETRY_UNIT);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glActiveTexture(GL_TEXTURE0 + HISTORY_COLOR_UNIT);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glActiveTexture(GL_TEXTURE0);
+    }
+    glEnable(GL_DEPTH_TEST);
+}
+
+void FractalRenderer::SetTemporalUniforms(GLuint program, const TemporalPass& temporal)
+{
+    glActiveTexture(GL_TEXTURE0 + HISTORY_COLOR_UNIT);
+    glBindTexture(GL_TEXTURE_2D, temporal.historyColor);
+    glActiveTexture(GL_TEXTURE0 + HISTORY_GEOMETRY_UNIT);
+    glBindTexture(GL_TEXTURE_2D, temporal.historyGeometry);
+    glActiveTexture(GL_TEXTURE0);
+    glUniform1i(glGetUniformLocation(program, "uHistoryColor"), HISTORY_COLOR_UNIT);
+    glUniform1i(glGetUniformLocation(program, "uHistoryGeometry"), HISTORY_GEOMETRY_UNIT);
+    glUniform1f(glGetUniformLocation(program, "uHistoryRange"), temporal.historyRange);
+    glUniform1f(glGetUniformLocation(program, "uTemporalRange"), temporal.range);
+    glUniform1i(glGetUniformLocation(program, "uTemporalCell"), temporal.cell);
+
+    const TemporalReprojection& reprojection = temporal.reprojection;
+    glUniform3fv(glGetUniformLocation(program, "uReprojectOrigin"), 1, glm::value_ptr(reprojection.origin));
+    glUniform3fv(glGetUniformLocation(program, "uReprojectBase"), 1, glm::value_ptr(reprojection.base));
+    glUniform3fv(glGetUniformLocation(program, "uReprojectStepX"), 1, glm::value_ptr(reprojection.stepX));
+    glUniform3fv(glGetUniformLocation(program, "uReprojectStepY"), 1, glm::value_ptr(reprojection.stepY));
+    glUniform2fv(glGetUniformLocation(program, "uReprojectScale"), 1, glm::value_ptr(reprojection.scale));
+
+    const TemporalSettings& settings = temporal.settings;
+    glUniform1i(glGetUniformLocation(program, "uTemporalIterations"), std::max(settings.iterations, 0));
+    glUniform1f(glGetUniformLocation(program, "uTemporalMaxError"), settings.maxError);
+    glUniform1f(glGetUniformLocation(program, "uTemporalDepthThreshold"), settings.depthThreshold);
+    glUniform1f(glGetUniformLocation(program, "uTemporalMaxParallax"), settings.maxParallax);
+    glUniform1f(glGetUniformLocation(program, "uTemporalMinFacing"), settings.minFacing);
+    Profiler::Count(ProfileCounter::StateChanges, 2);
+}
+
+void FractalRenderer::SetViewUniforms(GLuint program, const FractalView& view, const FractalParams& params, const RayMarchSettings& settings,
+                                      int width, int height)
+{
+    // The vertex stage is shared with the upscale pass; its UVs go unused here
+    glUniform2f(glGetUniformLocation(program, "uUvScale"), 1.0f, 1.0f);
+    glUniform2f(glGetUniformLocation(program, "uResolution"), (float)width, (float)height);
+    glUniform3fv(glGetUniformLocation(program, "uCameraPosition"), 1, glm::value_ptr(view.position));
+    glUniform3fv(glGetUniformLocation(program, "uCameraRight"), 1, glm::value_ptr(view.right));
+    glUniform3fv(glGetUniformLocation(program, "uCameraUp"), 1, glm::value_ptr(view.up));
+    glUniform3fv(glGetUniformLocation(program, "uCameraForward"), 1, glm::value_ptr(view.forward));
+    glUniform2f(glGetUniformLocation(program, "uPlaneExtent"), view.tanHalfFov * view.aspect, view.tanHalfFov);
+
+    glUniform1f(glGetUniformLocation(program, "uPower"), params.power);
+    glUniform1i(glGetUniformLocation(program, "uIterations"), params.iterations);
+    glUniform1f(glGetUniformLocation(program, "uBailout"), params.bailout);
+    glUniform4fv(glGetUniformLocation(program, "uJuliaC"), 1, glm::value_ptr(params.juliaC));
+
+    // Same footprint as CpuRayMarcher::RenderTile
+    glUniform1i(glGetUniformLocation(program, "uMaxSteps"), settings.maxSteps);
+    glUniform1f(glGetUniformLocation(program, "uPixelFootprint"), 2.0f * view.tanHalfFov / (float)height * settings.pixelEpsilon);
+    glUniform1f(glGetUniformLocation(program, "uStepScale"), settings.stepScale);
+}
+
+bool FractalRenderer::BeginReadback(const FractalView& view, const FractalParams& params, const RayMarchSettings& settings,
+                                    int width, int height, int slot)
+{
+    PROFILE_ZONE("FractalRenderer::BeginReadback");
+    if (width <= 0 || height <= 0 || slot < 0) {
+        return false;
+    }
+    if ((int)readbacks.size() <= slot) {
+        readbacks.resize((size_t)slot + 1);
+    }
+    Readback& readback = readbacks[(size_t)slot];
+    // Creating the target unbinds the caller's framebuffer, so it is saved first
+    GLint framebuffer = 0;
+    GLint viewport[4] = {0, 0, 0, 0};
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &framebuffer);
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    if (readbackTarget.GetWidth() != width || readbackTarget.GetHeight() != height || !readbackTarget.IsValid()) {
+        MEMORY_SCOPE(MemoryTag::Assets);
+        if (!readbackTarget.Create(width, height, false)) {
+            std::cerr << "Failed to create a " << width << "x" << height << " fractal target" << std::endl;
+            glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)framebuffer);
+            return false;
+        }
+    }
+
+    readbackTarget.Bind();
+    Render(view, params, settings, width, height);
+
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    size_t size = (size_t)width * (size_t)height * sizeof(uint32_t);
+    #ifdef __EMSCRIPTEN__
+    readback.pixels.resize((size_t)width * (size_t)height);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, readback.pixels.data());
+    #else
+    if (!readback.buffer) {
+        glGenBuffers(1, &readback.buffer);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+    if (readback.bufferSize != size) {
+        MEMORY_SCOPE(MemoryTag::Assets);
+        glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)size, nullptr, GL_STREAM_READ);
+        readback.bufferSize = size;
+    }
+    // Returns at once; the copy happens on the GPU after the pass
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glFlush();
+    #endif
+
+    glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)framebuffer);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    readback.width = width;
+    readback.height = height;
+    readback.bPending = glGetError() == GL_NO_ERROR;
+    return readback.bPending;
+}
+
+bool FractalRenderer::FinishReadback(int slot, std::vector<uint32_t>& pixels, int& width, int& height)
+{
+    PROFILE_ZONE("FractalRenderer::FinishReadback");
+    if (slot < 0 || slot >= (int)readbacks.size() || !readbacks[(size_t)slot].bPending) {
+        return false;
+    }
+    Readback& readback = readbacks[(size_t)slot];
+    readback.bPending = false;
+    width = readback.width;
+    height = readback.height;
+    #ifdef __EMSCRIPTEN__
+    pixels.swap(readback.pixels);
+    return true;
+    #else
+    pixels.resize((size_t)width * (size_t)height);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+    const void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)readback.bufferSize, GL_MAP_READ_BIT);
+    if (mapped) {
+        std::copy_n(static_cast<const uint32_t*>(mapped), pixels.size(), pixels.data());
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    if (!mapped) {
+        std::cerr << "Failed to map the fractal readback buffer" << std::endl;
+    }
+    return mapped != nullptr;
+    #endif
+}
+
+bool FractalRenderer::RenderCones(const FractalView& view, const FractalParams& params, const RayMarchSettings& settings, int width, int height)
+{
+    PROFILE_ZONE("FractalRenderer::RenderCones");
+
+    // The full resolution pass draws to whatever the caller bound
+    GLint framebuffer = 0;
+    GLint viewport[4] = {0, 0, 0, 0};
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &framebuffer);
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    float scaleX = 2.0f / (float)width;
+    float scaleY = 2.0f / (float)height;
+    float extentX = view.tanHalfFov * view.aspect;
+    float extentY = view.tanHalfFov;
+    bool bValid = true;
+    glBindVertexArray(emptyVAO);
+    for (int level = 0; level < CpuRayMarcher::CONE_LEVELS; level++) {
+        const int cellSize = CpuRayMarcher::CONE_CELL_SIZES[level];
+        RenderTarget& target = coneTargets[level];
+        int levelWidth = (width + cellSize - 1) / cellSize;
+        int levelHeight = (height + cellSize - 1) / cellSize;
+        if (target.GetWidth() != levelWidth || target.GetHeight() != levelHeight || !target.IsValid()) {
+            MEMORY_SCOPE(MemoryTag::Assets);
+            if (!target.Create(levelWidth, levelHeight, false)) {
+                std::cerr << "Cone pre-pass: no " << levelWidth << "x" << levelHeight << " target, marching without it" << std::endl;
+                bValid = false;
+                break;
+            }
+        }
+        if (!coneShaders[level]) {
+            coneShaders[level] = fractalShaders->Get(GetFormulaDefines(shaderFormula, true, level > 0));
+        }
+
+        GLuint program = coneShaders[level]->programId;
+        target.Bind();
+        coneShaders[level]->Use();
+        SetViewUniforms(program, view, params, settings, width, height);
+        // Same cone as CpuRayMarcher::ConeRow
+        float halfDiagonal = 0.5f * (float)cellSize * std::sqrt(scaleX * extentX * scaleX * extentX + scaleY * extentY * scaleY * extentY);
+        glUniform1f(glGetUniformLocation(program, "uConeSlope"), std::tan(std::min(halfDiagonal, 1.0f)));
+        glUniform1f(glGetUniformLocation(program, "uConeCellSize"), (float)cellSize);
+        glUniform1f(glGetUniformLocation(program, "uConeRange"), ConeRange(view, params));
+        if (level > 0) {
+            glActiveTexture(GL_TEXTURE0 + CONE_TEXTURE_UNIT);
+            glBindTexture(GL_TEXTURE_2D, coneTargets[level - 1].GetColorTexture());
+            glActiveTexture(GL_TEXTURE0);
+            glUniform1i(glGetUniformLocation(program, "uConeInput"), CONE_TEXTURE_UNIT);
+            glUniform1i(glGetUniformLocation(program, "uConeInputCellSize"), CpuRayMarcher::CONE_CELL_SIZES[level - 1]);
+        }
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        Profiler::CountDraw(1);
+        Profiler::Count(ProfileCounter::StateChanges, 3);
+    }
+    glBindVertexArray(0);
+    glActiveTexture(GL_TEXTURE0 + CONE_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glActiveTexture(GL_TEXTURE0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)framebuffer);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    return bValid;
+}
+
+void FractalRenderer::RenderDeepZoom(const DeepZoomView& view, const ReferenceOrbit& orbit, int width, int height)
+{
+    if (orbit.points.empty()) {
+        return;
+    }
+    PROFILE_ZONE("FractalRenderer::RenderDeepZoom");
+    PROFILE_GPU_ZONE("DeepZoom");
+
+    if (!emptyVAO) {
+        glGenVertexArrays(1, &emptyVAO);
+    }
+    if (!deepZoomShaders) {
+        deepZoomShaders = new ShaderVariantCache("upscale.vert", "deepzoom.frag");
+    }
+    if (orbit.id != orbitId) {
+        UploadOrbit(orbit);
+    }
+
+    // Same frame setup as CpuDeepZoom::SetupFrame
+    float scale = (float)std::max(view.scale, CpuDeepZoom::MIN_SCALE);
+    glm::vec2 offset = orbit.GetOffset(view);
+    ShaderProgram* program = deepZoomShaders->Get(ShaderDefines());
+    GLuint id = program->programId;
+    glDisable(GL_DEPTH_TEST);
+    program->Use();
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, orbitTexture);
+    glUniform1i(glGetUniformLocation(id, "uOrbit"), 0);
+    glUniform1i(glGetUniformLocation(id, "uReferenceEnd"), orbit.referenceLength);
+    glUniform1i(glGetUniformLocation(id, "uCriticalStart"), orbit.criticalStart);
+    glUniform1i(glGetUniformLocation(id, "uCriticalEnd"), orbit.criticalStart + orbit.criticalLength);
+    glUniform1i(glGetUniformLocation(id, "uIterations"), std::min(view.iterations, orbit.iterations));
+    glUniform2f(glGetUniformLocation(id, "uUvScale"), 1.0f, 1.0f);
+    glUniform2f(glGetUniformLocation(id, "uResolution"), (float)width, (float)height);
+    glUniform1f(glGetUniformLocation(id, "uScale"), scale);
+    glUniform1f(glGetUniformLocation(id, "uInvScale"), 1.0f / scale);
+    glUniform2f(glGetUniformLocation(id, "uOffset"), offset.x, offset.y);
+    glUniform2f(glGetUniformLocation(id, "uRotation"), std::cos(view.angle), std::sin(view.angle));
+    glUniform1f(glGetUniformLocation(id, "uJulia"), orbit.formula == DeepZoomFormula::Julia ? 1.0f : 0.0f);
+
+    glBindVertexArray(emptyVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    Profiler::CountDraw(1);
+    Profiler::Count(ProfileCounter::StateChanges, 3);
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glEnable(GL_DEPTH_TEST);
+}
+
+void FractalRenderer::UploadOrbit(const ReferenceOrbit& orbit)
+{
+    PROFILE_ZONE("FractalRenderer::UploadOrbit");
+    MEMORY_SCOPE(MemoryTag::Assets);
+    // Padded to whole rows; the shader never reads past the orbit
+    int rows = ((int)orbit.points.size() + ORBIT_WIDTH - 1) / ORBIT_WIDTH;
+    std::vector<glm::vec2> texels((size_t)rows * ORBIT_WIDTH, glm::vec2(0.0f));
+    std::copy(orbit.points.begin(), orbit.points.end(), texels.begin());
+
+    if (!orbitTexture) {
+        glGenTextures(1, &orbitTexture);
+    }
+    glBindTexture(GL_TEXTURE_2D, orbitTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32F, ORBIT_WIDTH, rows, 0, GL_RG, GL_FLOAT, texels.data());
+    // Float textures are only fetched, never filtered
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    orbitId = orbit.id;
+    Profiler::CountUpload((uint64_t)texels.size() * sizeof(glm::vec2));
+}
+
+void FractalRenderer::Upload(const uint32_t* pixels, int width, int height)
+{
+    if (!pixels || width <= 0 || height <= 0) {
+        return;
+    }
+    PROFILE_ZONE("FractalRenderer::Upload");
+
+    if (!imageTexture) {
+        glGenTextures(1, &imageTexture);
+    }
+    glBindTexture(GL_TEXTURE_2D, imageTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    if (width != imageWidth || height != imageHeight) {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        imageWidth = width;
+        imageHeight = height;
+    }
+    else {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    Profiler::CountUpload((uint64_t)width * (uint64_t)height * 4);
+}
@@ -0,0 +1,274 @@
+// progressiverenderer.cpp
+
+// C++ standard library
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+// local headers
+#include "fractal/progressiverenderer.h"
+#include "jobsystem.h"
+#include "profiler.h"
+
+namespace {
+const int TILE_SIZE = CpuRayMarcher::TILE_SIZE;
+// Sample counts are kept in a byte per pixel
+const int MAX_SAMPLES = 255;
+}
+
+void ProgressiveRenderer::Resize(int newWidth, int newHeight)
+{
+    width = newWidth;
+    height = newHeight;
+    size_t pixelCount = (size_t)width * (size_t)height;
+    colorSums.assign(pixelCount, glm::vec3(0.0f));
+    sampleCounts.assign(pixelCount, 0);
+    depths.assign(pixelCount, -1.0f);
+    normals.assign(pixelCount, glm::vec3(0.0f));
+    edges.assign(pixelCount, 0);
+    pixels.assign(pixelCount, 0);
+
+    tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+    tileCount = tilesX * ((height + TILE_SIZE - 1) / TILE_SIZE);
+    tileEdges.assign((size_t)tileCount, 0);
+    batchTiles.reserve((size_t)tileCount);
+}
+
+void ProgressiveRenderer::Update(const FractalView& newView, const FractalParams& newParams, const RayMarchSettings& newSettings,
+                                 int newWidth, int newHeight)
+{
+    if (newWidth <= 0 || newHeight <= 0) {
+        return;
+    }
+    PROFILE_ZONE("ProgressiveRenderer::Update");
+    auto start = std::chrono::steady_clock::now();
+    auto elapsedMs = [&start]() {
+        return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+    stats.frameRays = 0;
+
+    bool bChanged = !bValid || newView != view || newParams != params || newSettings != marchSettings ||
+                    newWidth != width || newHeight != height;
+    if (bChanged) {
+        if (newWidth != width || newHeight != height) {
+            Resize(newWidth, newHeight);
+        }
+        view = newView;
+        params = newParams;
+        marchSettings = newSettings;
+        bValid = true;
+        RenderPreview();
+        stats.frameMs = elapsedMs();
+        return;
+    }
+
+    if (bShowPreview) {
+        BeginRefinement();
+    }
+    stats.bPreview = false;
+
+    JobSystem* jobs = JobSystem::GetInstance();
+    // Enough tiles per batch to keep every thread busy between budget checks
+    size_t batchSize = (size_t)std::max(1, jobs->GetConcurrency()) * 2;
+    while (!stats.bComplete) {
+        batchTiles.clear();
+        while (nextTile < tileCount && batchTiles.size() < batchSize) {
+            int samples = GetTileSamples(nextTile);
+            if (samples > 0) {
+                batchTiles.push_back(nextTile);
+                stats.frameRays += (uint64_t)samples;
+            }
+            nextTile++;
+        }
+        jobs->ParallelFor(batchTiles.size(), 1, [this](size_t i) {
+            RefineTile(batchTiles[i]);
+        });
+        if (nextTile == tileCount) {
+            FinishPass();
+        }
+        if (elapsedMs() >= settings.budgetMs) {
+            break;
+        }
+    }
+    stats.samplesDone += stats.frameRays;
+    stats.frameMs = elapsedMs();
+}
+
+float ProgressiveRenderer::GetCompletion() const
+{
+    if (stats.bComplete) {
+        return 1.0f;
+    }
+    if (stats.bPreview || stats.samplesPlanned == 0) {
+        return 0.0f;
+    }
+    return std::min(1.0f, (float)((double)stats.samplesDone / (double)stats.samplesPlanned));
+}
+
+int ProgressiveRenderer::GetBaseSamples() const
+{
+    return std::clamp(settings.baseSamples, 1, MAX_SAMPLES);
+}
+
+int ProgressiveRenderer::GetEdgeSamples() const
+{
+    return std::clamp(settings.edgeSamples, GetBaseSamples(), MAX_SAMPLES);
+}
+
+void ProgressiveRenderer::RenderPreview()
+{
+    int divisor = std::max(1, settings.previewDivisor);
+    int newPreviewWidth = std::max(1, width / divisor);
+    int newPreviewHeight = std::max(1, height / divisor);
+    if (newPreviewWidth != previewWidth || newPreviewHeight != previewHeight) {
+        previewWidth = newPreviewWidth;
+        previewHeight = newPreviewHeight;
+        previewPixels.assign((size_t)previewWidth * (size_t)previewHeight, 0);
+    }
+
+    FractalParams previewParams = params;
+    previewParams.iterations = std::min(params.iterations, std::max(1, settings.previewIterations));
+    previewMarcher.Render(view, previewParams, marchSettings, previewWidth, previewHeight, previewPixels.data());
+
+    bShowPreview = true;
+    stats = ProgressiveStats();
+    stats.bPreview = true;
+    stats.frameRays = (uint64_t)previewWidth * (uint64_t)previewHeight;
+}
+
+void ProgressiveRenderer::BeginRefinement()
+{
+    PROFILE_ZONE("ProgressiveRenderer::BeginRefinement");
+    bShowPreview = false;
+    std::fill(colorSums.begin(), colorSums.end(), glm::vec3(0.0f));
+    std::fill(sampleCounts.begin(), sampleCounts.end(), 0);
+    std::fill(edges.begin(), edges.end(), 0);
+    std::fill(tileEdges.begin(), tileEdges.end(), 0);
+    nextTile = 0;
+    stats.pass = 0;
+    stats.edgePixels = 0;
+    stats.samplesDone = 0;
+    // Every pixel counts as an edge until pass 0 has found the real ones, so the
+    // plan only shrinks and completion only moves forward
+    stats.samplesPlanned = (uint64_t)width * (uint64_t)height * (uint64_t)GetEdgeSamples();
+    stats.bComplete = false;
+
+    // Until pass 0 reaches them, pixels show the preview stretched over the image
+    JobSystem::GetInstance()->ParallelFor((size_t)height, 16, [this](size_t y) {
+        const uint32_t* source = previewPixels.data() + (y * (size_t)previewHeight / (size_t)height) * (size_t)previewWidth;
+        uint32_t* row = pixels.data() + y * (size_t)width;
+        for (int x = 0; x < width; x++) {
+            row[x] = source[(size_t)x * (size_t)previewWidth / (size_t)width];
+        }
+    });
+}
+
+int ProgressiveRenderer::GetTileSamples(int tile) const
+{
+    if (stats.pass < GetBaseSamples()) {
+        int x0 = (tile % tilesX) * TILE_SIZE;
+        int y0 = (tile / tilesX) * TILE_SIZE;
+        return (std::min(x0 + TILE_SIZE, width) - x0) * (std::min(y0 + TILE_SIZE, height) - y0);
+    }
+    return tileEdges[(size_t)tile];
+}
+
+void ProgressiveRenderer::RefineTile(int tile)
+{
+    const int pass = stats.pass;
+    const bool bEdgesOnly = pass >= GetBaseSamples();
+    const glm::vec2 offset = CpuRayMarcher::SampleOffset(pass);
+    int x0 = (tile % tilesX) * TILE_SIZE;
+    int y0 = (tile / tilesX) * TILE_SIZE;
+    int x1 = std::min(x0 + TILE_SIZE, width);
+    int y1 = std::min(y0 + TILE_SIZE, height);
+
+    float sampleX[TILE_SIZE * TILE_SIZE];
+    float sampleY[TILE_SIZE * TILE_SIZE];
+    uint32_t indices[TILE_SIZE * TILE_SIZE];
+    int count = 0;
+    for (int y = y0; y < y1; y++) {
+        for (int x = x0; x < x1; x++) {
+            uint32_t index = (uint32_t)y * (uint32_t)width + (uint32_t)x;
+            if (bEdgesOnly && !edges[index]) {
+                continue;
+            }
+            sampleX[count] = (float)x + offset.x;
+            sampleY[count] = (float)y + offset.y;
+            indices[count] = index;
+            count++;
+        }
+    }
+
+    RaySample samples[TILE_SIZE * TILE_SIZE];
+    CpuRayMarcher::TraceRays(view, params, marchSettings, width, height, sampleX, sampleY, count, samples);
+    for (int i = 0; i < count; i++) {
+        uint32_t index = indices[i];
+        if (pass == 0) {
+            depths[index] = samples[i].depth;
+            normals[index] = samples[i].normal;
+        }
+        colorSums[index] += samples[i].color;
+        sampleCounts[index]++;
+        pixels[index] = CpuRayMarcher::PackPixel(colorSums[index] * (1.0f / (float)sampleCounts[index]));
+    }
+}
+
+bool ProgressiveRenderer::IsDiscontinuity(uint32_t a, uint32_t b) const
+{
+    bool bHitA = depths[a] >= 0.0f;
+    bool bHitB = depths[b] >= 0.0f;
+    if (bHitA != bHitB) {
+        return true;
+    }
+    if (!bHitA) {
+        return false;
+    }
+    if (std::fabs(depths[a] - depths[b]) > settings.depthThreshold * std::min(depths[a], depths[b])) {
+        return true;
+    }
+    return glm::dot(normals[a], normals[b]) < settings.normalThreshold;
+}
+
+void ProgressiveRenderer::DetectEdges()
+{
+    PROFILE_ZONE("ProgressiveRenderer::DetectEdges");
+    // Each tile flags only its own pixels, reading neighbours across tile borders
+    JobSystem::GetInstance()->ParallelFor((size_t)tileCount, 4, [this](size_t tile) {
+        int x0 = ((int)tile % tilesX) * TILE_SIZE;
+        int y0 = ((int)tile / tilesX) * TILE_SIZE;
+        int x1 = std::min(x0 + TILE_SIZE, width);
+        int y1 = std::min(y0 + TILE_SIZE, height);
+        uint16_t count = 0;
+        for (int y = y0; y < y1; y++) {
+            for (int x = x0; x < x1; x++) {
+                uint32_t index = (uint32_t)y * (uint32_t)width + (uint32_t)x;
+                bool bEdge = (x > 0 && IsDiscontinuity(index, index - 1)) ||
+                             (x + 1 < width && IsDiscontinuity(index, index + 1)) ||
+                             (y > 0 && IsDiscontinuity(index, index - (uint32_t)width)) ||
+                             (y + 1 < height && IsDiscontinuity(index, index + (uint32_t)width));
+                edges[index] = bEdge ? 1 : 0;
+                count += bEdge ? 1 : 0;
+            }
+        }
+        tileEdges[tile] = count;
+    });
+
+    stats.edgePixels = 0;
+    for (uint16_t count : tileEdges) {
+        stats.edgePixels += count;
+    }
+}
+
+void ProgressiveRenderer::FinishPass()
+{
+    if (stats.pass == 0) {
+        DetectEdges();
+        stats.samplesPlanned = (uint64_t)width * (uint64_t)height * (uint64_t)GetBaseSamples() +
+                               (uint64_t)stats.edgePixels * (uint64_t)(GetEdgeSamples() - GetBaseSamples());
+    }
+    stats.pass++;
+    nextTile = 0;
+    int passCount = stats.edgePixels > 0 ? GetEdgeSamples() : GetBaseSamples();
+    stats.bComplete = stats.pass >= passCount;
+}
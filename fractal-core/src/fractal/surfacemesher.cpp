@@ -0,0 +1,476 @@
+// surfacemesher.cpp
+
+// C++ standard library
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+
+// local headers
+#include "fractal/formula.h"
+#include "fractal/simd.h"
+#include "fractal/surfacemesher.h"
+#include "jobsystem.h"
+#include "profiler.h"
+
+namespace {
+// Quad corners that live in another chunk are stored as an index into the
+// chunk's external cells with this bit set
+const uint32_t EXTERNAL_BIT = 0x80000000u;
+// A corner in the chunk's own cells that has no vertex
+const uint32_t MISSING = EXTERNAL_BIT - 1;
+// A box of cells is empty when its centre estimate exceeds its half diagonal by
+// this factor; the Julia estimator overshoots a little, so the bound gets some slack
+const float EMPTY_MARGIN = 1.25f;
+// Cells per axis of the blocks a chunk tests before sampling them
+const int BLOCK_CELLS = 8;
+
+// Corner offsets of a cell, and the corner pairs of its twelve edges
+const int CORNERS[8][3] = {
+    {0, 0, 0}, {1, 0, 0}, {0, 1, 0}, {1, 1, 0}, {0, 0, 1}, {1, 0, 1}, {0, 1, 1}, {1, 1, 1}
+};
+const int EDGES[12][2] = {
+    {0, 1}, {2, 3}, {4, 5}, {6, 7},
+    {0, 2}, {1, 3}, {4, 6}, {5, 7},
+    {0, 4}, {1, 5}, {2, 6}, {3, 7}
+};
+
+struct Chunk {
+    // First cell and cells per axis
+    glm::ivec3 origin;
+    glm::ivec3 size;
+    bool bEmpty = false;
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> normals;
+    // Four corner references per quad, counter-clockwise from outside
+    std::vector<uint32_t> quads;
+    std::vector<glm::ivec3> external;
+    // Vertex of every cell on the upper face along each axis, -1 where there is none
+    std::vector<int32_t> faces[3];
+    std::vector<uint32_t> indices;
+    uint32_t vertexBase = 0;
+    size_t indexBase = 0;
+};
+
+// Bytes held by chunk buffers and the output, and the most held at once
+class ByteCounter
+{
+    public:
+        void Add(uint64_t bytes)
+        {
+            uint64_t now = current.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+            uint64_t previous = peak.load(std::memory_order_relaxed);
+            while (now > previous && !peak.compare_exchange_weak(previous, now, std::memory_order_relaxed)) {
+            }
+        }
+        void Remove(uint64_t bytes) { current.fetch_sub(bytes, std::memory_order_relaxed); }
+        uint64_t GetPeak() const { return peak.load(std::memory_order_relaxed); }
+
+    private:
+        std::atomic<uint64_t> current{0};
+        std::atomic<uint64_t> peak{0};
+};
+
+template<typename T>
+uint64_t VectorBytes(const std::vector<T>& values)
+{
+    return (uint64_t)values.capacity() * sizeof(T);
+}
+
+struct Grid {
+    int resolution;
+    int chunkCells;
+    glm::ivec3 chunkCounts;
+    float bounds;
+    float cellSize;
+    float iso;
+    std::vector<Chunk> chunks;
+    std::atomic<uint64_t> samples{0};
+    ByteCounter bytes;
+
+    float Coordinate(int index) const { return -bounds + (float)index * cellSize; }
+    size_t ChunkIndex(const glm::ivec3& chunk) const
+    {
+        return ((size_t)chunk.z * (size_t)chunkCounts.y + (size_t)chunk.y) * (size_t)chunkCounts.x + (size_t)chunk.x;
+    }
+};
+
+// Whether the estimate proves the surface misses the cells [first, first + cells)
+template<typename Kernel>
+bool IsEmptyBox(const Grid& grid, const glm::ivec3& first, const glm::ivec3& cells, const Kernel& kernel)
+{
+    // Every corner of the box lies within its half diagonal of the centre
+    glm::vec3 centre = glm::vec3(grid.Coordinate(first.x), grid.Coordinate(first.y), grid.Coordinate(first.z)) +
+                       glm::vec3(cells) * (0.5f * grid.cellSize);
+    float halfDiagonal = 0.5f * grid.cellSize * glm::length(glm::vec3(cells));
+    float distance = kernel(simd::Vec3<simd::Float1>(centre.x, centre.y, centre.z)).Lane(0) - grid.iso;
+    return distance > halfDiagonal * EMPTY_MARGIN;
+}
+
+int FaceIndex(const Chunk& chunk, int axis, const glm::ivec3& local)
+{
+    int b = (axis + 1) % 3;
+    int c = (axis + 2) % 3;
+    return local[c] * chunk.size[b] + local[b];
+}
+
+// Estimate minus the iso value at the corners [first, last] of the chunk's
+// cells, into the chunk's corner array, x fastest. Returns the corners sampled.
+template<typename V, typename Kernel>
+uint64_t SampleBox(const Grid& grid, const Chunk& chunk, const glm::ivec3& first, const glm::ivec3& last, const Kernel& kernel,
+                   std::vector<float>& values)
+{
+    constexpr int WIDTH = V::WIDTH;
+    const glm::ivec3 points = chunk.size + 1;
+    float laneX[WIDTH], distances[WIDTH];
+    for (int z = first.z; z <= last.z; z++) {
+        V pz(grid.Coordinate(chunk.origin.z + z));
+        for (int y = first.y; y <= last.y; y++) {
+            V py(grid.Coordinate(chunk.origin.y + y));
+            float* row = values.data() + ((size_t)z * (size_t)points.y + (size_t)y) * (size_t)points.x;
+            for (int x = first.x; x <= last.x; x += WIDTH) {
+                int lanes = std::min(WIDTH, last.x + 1 - x);
+                for (int lane = 0; lane < WIDTH; lane++) {
+                    // Spare lanes repeat the last point
+                    laneX[lane] = grid.Coordinate(chunk.origin.x + x + std::min(lane, lanes - 1));
+                }
+                V distance = kernel(simd::Vec3<V>(V::Load(laneX), py, pz)) - V(grid.iso);
+                distance.Store(distances);
+                std::copy(distances, distances + lanes, row + x);
+            }
+        }
+    }
+    glm::ivec3 count = last - first + 1;
+    return (uint64_t)count.x * (uint64_t)count.y * (uint64_t)count.z;
+}
+
+// Gradients of the estimate at the chunk's vertices, a packet at a time
+template<typename V, typename Kernel>
+void ComputeNormals(const Grid& grid, Chunk& chunk, const Kernel& kernel)
+{
+    constexpr int WIDTH = V::WIDTH;
+    const V h(0.25f * grid.cellSize);
+    float x[WIDTH], y[WIDTH], z[WIDTH], normalX[WIDTH], normalY[WIDTH], normalZ[WIDTH];
+    size_t count = chunk.positions.size();
+    chunk.normals.resize(count);
+    for (size_t first = 0; first < count; first += WIDTH) {
+        int lanes = (int)std::min((size_t)WIDTH, count - first);
+        for (int lane = 0; lane < WIDTH; lane++) {
+            const glm::vec3& p = chunk.positions[first + (size_t)std::min(lane, lanes - 1)];
+            x[lane] = p.x;
+            y[lane] = p.y;
+            z[lane] = p.z;
+        }
+        simd::Vec3<V> normal = FractalNormal(simd::Vec3<V>(V::Load(x), V::Load(y), V::Load(z)), h, kernel);
+        normal.x.Store(normalX);
+        normal.y.Store(normalY);
+        normal.z.Store(normalZ);
+        for (int lane = 0; lane < lanes; lane++) {
+            chunk.normals[first + (size_t)lane] = glm::vec3(normalX[lane], normalY[lane], normalZ[lane]);
+        }
+    }
+}
+
+// Samples a chunk, places the vertices of its cells and collects the quads of
+// its edges
+template<typename V, typename Kernel>
+void BuildChunk(Grid& grid, Chunk& chunk, const Kernel& kernel)
+{
+    const glm::ivec3 size = chunk.size;
+    const glm::ivec3 points = size + 1;
+    if (IsEmptyBox(grid, chunk.origin, size, kernel)) {
+        chunk.bEmpty = true;
+        return;
+    }
+
+    // Blocks of the chunk the surface misses keep their corners outside and
+    // are never sampled, one level of an octree over the grid
+    std::vector<float> values((size_t)points.x * (size_t)points.y * (size_t)points.z, grid.cellSize);
+    std::vector<int32_t> cellVertices((size_t)size.x * (size_t)size.y * (size_t)size.z, -1);
+    uint64_t scratchBytes = VectorBytes(values) + VectorBytes(cellVertices);
+    grid.bytes.Add(scratchBytes);
+    uint64_t samples = 0;
+    glm::ivec3 block;
+    for (block.z = 0; block.z < size.z; block.z += BLOCK_CELLS) {
+        for (block.y = 0; block.y < size.y; block.y += BLOCK_CELLS) {
+            // Runs of sampled blocks along x go together, so rows fill whole packets
+            glm::ivec3 cells = glm::min(glm::ivec3(BLOCK_CELLS), size - block);
+            int runStart = -1;
+            for (block.x = 0; block.x < size.x + BLOCK_CELLS; block.x += BLOCK_CELLS) {
+                block.x = std::min(block.x, size.x);
+                bool bEmpty = block.x == size.x ||
+                              IsEmptyBox(grid, chunk.origin + block, glm::ivec3(std::min(BLOCK_CELLS, size.x - block.x), cells.y, cells.z), kernel);
+                if (!bEmpty && runStart < 0) {
+                    runStart = block.x;
+                }
+                else if (bEmpty && runStart >= 0) {
+                    glm::ivec3 first(runStart, block.y, block.z);
+                    glm::ivec3 last(block.x, block.y + cells.y, block.z + cells.z);
+                    samples += SampleBox<V>(grid, chunk, first, last, kernel, values);
+                    runStart = -1;
+                }
+            }
+        }
+    }
+    grid.samples.fetch_add(samples, std::memory_order_relaxed);
+    auto value = [&values, &points](int x, int y, int z) {
+        return values[((size_t)z * (size_t)points.y + (size_t)y) * (size_t)points.x + (size_t)x];
+    };
+
+    // One vertex per cell the surface passes through, at the mean of its edge crossings
+    for (int z = 0; z < size.z; z++) {
+        for (int y = 0; y < size.y; y++) {
+            for (int x = 0; x < size.x; x++) {
+                float corners[8];
+                int inside = 0;
+                for (int i = 0; i < 8; i++) {
+                    corners[i] = value(x + CORNERS[i][0], y + CORNERS[i][1], z + CORNERS[i][2]);
+                    inside += corners[i] < 0.0f ? 1 : 0;
+                }
+                if (inside == 0 || inside == 8) {
+                    continue;
+                }
+                glm::vec3 sum(0.0f);
+                int crossings = 0;
+                for (const int* edge : EDGES) {
+                    float a = corners[edge[0]];
+                    float b = corners[edge[1]];
+                    if ((a < 0.0f) == (b < 0.0f)) {
+                        continue;
+                    }
+                    float t = a / (a - b);
+                    glm::vec3 from(CORNERS[edge[0]][0], CORNERS[edge[0]][1], CORNERS[edge[0]][2]);
+                    glm::vec3 to(CORNERS[edge[1]][0], CORNERS[edge[1]][1], CORNERS[edge[1]][2]);
+                    sum += from + (to - from) * t;
+                    crossings++;
+                }
+                glm::vec3 local = glm::vec3((float)x, (float)y, (float)z) + sum / (float)crossings;
+                glm::vec3 position = glm::vec3(grid.Coordinate(chunk.origin.x), grid.Coordinate(chunk.origin.y),
+                                               grid.Coordinate(chunk.origin.z)) + local * grid.cellSize;
+                cellVertices[((size_t)z * (size_t)size.y + (size_t)y) * (size_t)size.x + (size_t)x] = (int32_t)chunk.positions.size();
+                chunk.positions.push_back(position);
+            }
+        }
+    }
+    ComputeNormals<V>(grid, chunk, kernel);
+
+    // Vertices on the upper faces, for the chunks above to weld to
+    for (int axis = 0; axis < 3; axis++) {
+        if (chunk.origin[axis] + size[axis] >= grid.resolution) {
+            continue;
+        }
+        int b = (axis + 1) % 3;
+        int c = (axis + 2) % 3;
+        chunk.faces[axis].assign((size_t)size[b] * (size_t)size[c], -1);
+        glm::ivec3 local(0);
+        local[axis] = size[axis] - 1;
+        for (local[c] = 0; local[c] < size[c]; local[c]++) {
+            for (local[b] = 0; local[b] < size[b]; local[b]++) {
+                size_t cell = ((size_t)local.z * (size_t)size.y + (size_t)local.y) * (size_t)size.x + (size_t)local.x;
+                chunk.faces[axis][(size_t)FaceIndex(chunk, axis, local)] = cellVertices[cell];
+            }
+        }
+    }
+
+    // A quad around every edge the surface crosses, from the lower corners the
+    // chunk owns. Edges on the cube's faces have no cells on one side.
+    auto reference = [&](const glm::ivec3& cell) -> uint32_t {
+        glm::ivec3 local = cell - chunk.origin;
+        if (local.x >= 0 && local.y >= 0 && local.z >= 0) {
+            int32_t vertex = cellVertices[((size_t)local.z * (size_t)size.y + (size_t)local.y) * (size_t)size.x + (size_t)local.x];
+            return vertex < 0 ? MISSING : (uint32_t)vertex;
+        }
+        chunk.external.push_back(cell);
+        return EXTERNAL_BIT | (uint32_t)(chunk.external.size() - 1);
+    };
+    const int last = grid.resolution - 1;
+    for (int z = 0; z < size.z; z++) {
+        for (int y = 0; y < size.y; y++) {
+            for (int x = 0; x < size.x; x++) {
+                glm::ivec3 g = chunk.origin + glm::ivec3(x, y, z);
+                bool bInside = value(x, y, z) < 0.0f;
+                for (int axis = 0; axis < 3; axis++) {
+                    int b = (axis + 1) % 3;
+                    int c = (axis + 2) % 3;
+                    if (g[b] < 1 || g[b] > last || g[c] < 1 || g[c] > last) {
+                        continue;
+                    }
+                    glm::ivec3 next(x, y, z);
+                    next[axis]++;
+                    if ((value(next.x, next.y, next.z) < 0.0f) == bInside) {
+                        continue;
+                    }
+                    // Around the edge counter-clockwise seen from +axis, which is
+                    // outside when the lower corner is inside
+                    glm::ivec3 cells[4] = {g, g, g, g};
+                    cells[0][b]--;
+                    cells[0][c]--;
+                    cells[1][c]--;
+                    cells[3][b]--;
+                    uint32_t quad[4];
+                    for (int i = 0; i < 4; i++) {
+                        quad[i] = reference(cells[i]);
+                    }
+                    if (!bInside) {
+                        std::swap(quad[1], quad[3]);
+                    }
+                    chunk.quads.insert(chunk.quads.end(), quad, quad + 4);
+                }
+            }
+        }
+    }
+
+    grid.bytes.Remove(scratchBytes);
+    grid.bytes.Add(VectorBytes(chunk.positions) + VectorBytes(chunk.normals) + VectorBytes(chunk.quads) + VectorBytes(chunk.external) +
+                   VectorBytes(chunk.faces[0]) + VectorBytes(chunk.faces[1]) + VectorBytes(chunk.faces[2]));
+}
+
+// Global index of a quad corner once every chunk's vertex base is known, false
+// for a cell with no vertex
+bool ResolveReference(const Grid& grid, const Chunk& chunk, uint32_t reference, uint32_t& index)
+{
+    if (reference == MISSING) {
+        return false;
+    }
+    if ((reference & EXTERNAL_BIT) == 0) {
+        index = chunk.vertexBase + reference;
+        return true;
+    }
+    const glm::ivec3& cell = chunk.external[reference & ~EXTERNAL_BIT];
+    const Chunk& owner = grid.chunks[grid.ChunkIndex(cell / grid.chunkCells)];
+    glm::ivec3 local = cell - owner.origin;
+    // The cell sits below this chunk along some axis, so on the owner's upper face there
+    for (int axis = 0; axis < 3; axis++) {
+        if (local[axis] != owner.size[axis] - 1 || owner.faces[axis].empty()) {
+            continue;
+        }
+        int32_t vertex = owner.faces[axis][(size_t)FaceIndex(owner, axis, local)];
+        if (vertex < 0) {
+            return false;
+        }
+        index = owner.vertexBase + (uint32_t)vertex;
+        return true;
+    }
+    return false;
+}
+
+// Two triangles per quad with every corner welded; quads reaching into a chunk
+// the empty test skipped are dropped
+void ResolveChunk(const Grid& grid, Chunk& chunk)
+{
+    chunk.indices.reserve(chunk.quads.size() / 4 * 6);
+    for (size_t quad = 0; quad < chunk.quads.size(); quad += 4) {
+        uint32_t corners[4];
+        bool bValid = true;
+        for (int i = 0; i < 4 && bValid; i++) {
+            bValid = ResolveReference(grid, chunk, chunk.quads[quad + (size_t)i], corners[i]);
+        }
+        if (!bValid) {
+            continue;
+        }
+        const uint32_t triangles[6] = {corners[0], corners[1], corners[2], corners[0], corners[2], corners[3]};
+        chunk.indices.insert(chunk.indices.end(), triangles, triangles + 6);
+    }
+}
+}
+
+SurfaceMesh SurfaceMesher::Extract(const FractalParams& params, const SurfaceMeshSettings& settings)
+{
+    PROFILE_ZONE("SurfaceMesher::Extract");
+    auto start = std::chrono::steady_clock::now();
+    stats = SurfaceMeshStats();
+
+    Grid grid;
+    grid.resolution = std::max(settings.resolution, 2);
+    grid.chunkCells = std::max(settings.chunkCells, 2);
+    int chunksPerAxis = (grid.resolution + grid.chunkCells - 1) / grid.chunkCells;
+    grid.chunkCounts = glm::ivec3(chunksPerAxis);
+    grid.bounds = settings.bounds;
+    grid.cellSize = 2.0f * settings.bounds / (float)grid.resolution;
+    grid.iso = settings.isoCells * grid.cellSize;
+    grid.chunks.resize((size_t)chunksPerAxis * (size_t)chunksPerAxis * (size_t)chunksPerAxis);
+    for (int z = 0; z < chunksPerAxis; z++) {
+        for (int y = 0; y < chunksPerAxis; y++) {
+            for (int x = 0; x < chunksPerAxis; x++) {
+                Chunk& chunk = grid.chunks[grid.ChunkIndex(glm::ivec3(x, y, z))];
+                chunk.origin = glm::ivec3(x, y, z) * grid.chunkCells;
+                chunk.size = glm::min(glm::ivec3(grid.chunkCells), glm::ivec3(grid.resolution) - chunk.origin);
+            }
+        }
+    }
+
+    JobSystem* jobs = JobSystem::GetInstance();
+    VisitFormulaKernel(params, SelectFormulaKernel(params, true), [&](const auto& kernel) {
+        jobs->ParallelFor(grid.chunks.size(), 1, [&](size_t i) {
+            BuildChunk<simd::FloatNative>(grid, grid.chunks[i], kernel);
+        });
+    });
+
+    // Vertices go out chunk by chunk, so a prefix sum places every chunk's block
+    uint32_t vertexCount = 0;
+    for (Chunk& chunk : grid.chunks) {
+        chunk.vertexBase = vertexCount;
+        vertexCount += (uint32_t)chunk.positions.size();
+    }
+    jobs->ParallelFor(grid.chunks.size(), 1, [&grid](size_t i) {
+        ResolveChunk(grid, grid.chunks[i]);
+    });
+    size_t indexCount = 0;
+    for (Chunk& chunk : grid.chunks) {
+        chunk.indexBase = indexCount;
+        indexCount += chunk.indices.size();
+        grid.bytes.Add(VectorBytes(chunk.indices));
+    }
+
+    SurfaceMesh mesh;
+    mesh.positions.resize(vertexCount);
+    mesh.normals.resize(vertexCount);
+    mesh.indices.resize(indexCount);
+    grid.bytes.Add(VectorBytes(mesh.positions) + VectorBytes(mesh.normals) + VectorBytes(mesh.indices));
+    jobs->ParallelFor(grid.chunks.size(), 1, [&grid, &mesh](size_t i) {
+        const Chunk& chunk = grid.chunks[i];
+        std::copy(chunk.positions.begin(), chunk.positions.end(), mesh.positions.begin() + chunk.vertexBase);
+        std::copy(chunk.normals.begin(), chunk.normals.end(), mesh.normals.begin() + chunk.vertexBase);
+        std::copy(chunk.indices.begin(), chunk.indices.end(), mesh.indices.begin() + (std::ptrdiff_t)chunk.indexBase);
+    });
+
+    stats.resolution = grid.resolution;
+    stats.chunks = (uint32_t)grid.chunks.size();
+    for (const Chunk& chunk : grid.chunks) {
+        stats.emptyChunks += chunk.bEmpty ? 1 : 0;
+    }
+    stats.samples = grid.samples.load();
+    stats.vertices = vertexCount;
+    stats.triangles = (uint32_t)(indexCount / 3);
+    stats.ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    stats.trianglesPerSecond = stats.ms > 0.0f ? (float)stats.triangles * 1000.0f / stats.ms : 0.0f;
+    stats.peakBytes = grid.bytes.GetPeak();
+    return mesh;
+}
+
+bool SurfaceMesh::SaveObj(const std::string& path) const
+{
+    std::ofstream file(path);
+    if (!file) {
+        std::cerr << "Failed to write " << path << std::endl;
+        return false;
+    }
+    for (const glm::vec3& p : positions) {
+        file << "v " << p.x << ' ' << p.y << ' ' << p.z << '\n';
+    }
+    for (const glm::vec3& n : normals) {
+        file << "vn " << n.x << ' ' << n.y << ' ' << n.z << '\n';
+    }
+    // OBJ indices start at one
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        file << 'f';
+        for (size_t j = 0; j < 3; j++) {
+            uint32_t index = indices[i + j] + 1;
+            file << ' ' << index << "//" << index;
+        }
+        file << '\n';
+    }
+    return (bool)file;
+}
@@ -0,0 +1,270 @@
+// temporalrenderer.cpp
+
+// C++ standard library
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+
+// local headers
+#include "fractal/temporalrenderer.h"
+#include "jobsystem.h"
+#include "profiler.h"
+
+namespace {
+const int TILE_SIZE = CpuRayMarcher::TILE_SIZE;
+// Block cells in the order frames trace them, mirrored in fractal.frag
+const int PATTERN_ORDER[TemporalRenderer::PATTERN_CELLS] = {0, 3, 1, 2};
+
+inline int PatternCellAt(int x, int y)
+{
+    return (x & 1) | ((y & 1) << 1);
+}
+
+// Right, up and forward components of a world vector in view's camera space
+glm::vec3 ToCamera(const FractalView& view, const glm::vec3& v)
+{
+    return glm::vec3(glm::dot(v, view.right), glm::dot(v, view.up), glm::dot(v, view.forward));
+}
+}
+
+int TemporalRenderer::GetPatternCell(uint32_t frame)
+{
+    return PATTERN_ORDER[frame % PATTERN_CELLS];
+}
+
+void TemporalReprojection::Setup(const FractalView& from, const FractalView& to, int width, int height)
+{
+    float extentX = from.tanHalfFov * from.aspect;
+    float extentY = from.tanHalfFov;
+    origin = ToCamera(to, from.position - to.position);
+    // The ray through image point (x, y) is forward + right * plane x + up * plane y,
+    // affine in x and y, so the whole old image plane maps over at once
+    base = ToCamera(to, from.forward - from.right * extentX - from.up * extentY);
+    stepX = ToCamera(to, from.right * (2.0f * extentX / (float)width));
+    stepY = ToCamera(to, from.up * (2.0f * extentY / (float)height));
+    halfSize = glm::vec2(0.5f * (float)width, 0.5f * (float)height);
+    scale = halfSize / glm::vec2(to.tanHalfFov * to.aspect, to.tanHalfFov);
+}
+
+void TemporalRenderer::Resize(int newWidth, int newHeight)
+{
+    width = newWidth;
+    height = newHeight;
+    size_t pixelCount = (size_t)width * (size_t)height;
+    for (Frame& frame : frames) {
+        frame.pixels.assign(pixelCount, 0);
+        frame.depths.assign(pixelCount, -1.0f);
+        frame.normals.assign(pixelCount, glm::vec3(0.0f));
+        frame.traced.assign(pixelCount, 0);
+    }
+    tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+    tileCount = tilesX * ((height + TILE_SIZE - 1) / TILE_SIZE);
+}
+
+void TemporalRenderer::Update(const FractalView& view, const FractalParams& newParams, const RayMarchSettings& newSettings,
+                              int newWidth, int newHeight)
+{
+    if (newWidth <= 0 || newHeight <= 0) {
+        return;
+    }
+    PROFILE_ZONE("TemporalRenderer::Update");
+    auto start = std::chrono::steady_clock::now();
+
+    bool bReset = !bValid || newParams != params || newSettings != marchSettings || newWidth != width || newHeight != height;
+    if (newWidth != width || newHeight != height) {
+        Resize(newWidth, newHeight);
+    }
+    params = newParams;
+    marchSettings = newSettings;
+    bValid = true;
+
+    bool bStill = !bReset && view == frames[current].view;
+    reprojection.Setup(frames[current].view, view, width, height);
+    current = 1 - current;
+    frames[current].view = view;
+    int cell = GetPatternCell(frameIndex++);
+
+    std::atomic<uint64_t> rays{0};
+    std::atomic<uint64_t> reprojected{0};
+    std::atomic<uint64_t> rejected{0};
+    JobSystem::GetInstance()->ParallelFor((size_t)tileCount, 1, [&](size_t tile) {
+        uint64_t tileRays = 0;
+        uint64_t tileReprojected = 0;
+        uint64_t tileRejected = 0;
+        RenderTile((int)tile, bReset, bStill, cell, tileRays, tileReprojected, tileRejected);
+        rays += tileRays;
+        reprojected += tileReprojected;
+        rejected += tileRejected;
+    });
+
+    stats.rays = rays.load();
+    stats.reprojected = reprojected.load();
+    stats.rejected = rejected.load();
+    stats.phase = cell;
+    stats.bReset = bReset;
+    stats.ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void TemporalRenderer::RenderTile(int tile, bool bReset, bool bStill, int cell, uint64_t& rays, uint64_t& reprojected,
+                                  uint64_t& rejected)
+{
+    const Frame& previous = frames[1 - current];
+    Frame& frame = frames[current];
+    int x0 = (tile % tilesX) * TILE_SIZE;
+    int y0 = (tile / tilesX) * TILE_SIZE;
+    int x1 = std::min(x0 + TILE_SIZE, width);
+    int y1 = std::min(y0 + TILE_SIZE, height);
+
+    float sampleX[TILE_SIZE * TILE_SIZE];
+    float sampleY[TILE_SIZE * TILE_SIZE];
+    uint32_t indices[TILE_SIZE * TILE_SIZE];
+    int count = 0;
+    for (int y = y0; y < y1; y++) {
+        // Neighbours mostly move alike, so each search starts from the last motion found
+        glm::vec2 motion(0.0f);
+        for (int x = x0; x < x1; x++) {
+            uint32_t index = (uint32_t)y * (uint32_t)width + (uint32_t)x;
+            bool bPattern = bReset || PatternCellAt(x, y) == cell;
+            // A still view only traces the pixels reprojection left behind, one cell at a time
+            if (bStill && (!bPattern || previous.traced[index])) {
+                frame.pixels[index] = previous.pixels[index];
+                frame.depths[index] = previous.depths[index];
+                frame.normals[index] = previous.normals[index];
+                frame.traced[index] = previous.traced[index];
+                reprojected++;
+                continue;
+            }
+            if (!bPattern) {
+                if (Reproject(x, y, index, motion)) {
+                    reprojected++;
+                    continue;
+                }
+                rejected++;
+            }
+            sampleX[count] = (float)x + 0.5f;
+            sampleY[count] = (float)y + 0.5f;
+            indices[count] = index;
+            count++;
+        }
+    }
+
+    RaySample samples[TILE_SIZE * TILE_SIZE];
+    CpuRayMarcher::TraceRays(frame.view, params, marchSettings, width, height, sampleX, sampleY, count, samples);
+    float extentX = frame.view.tanHalfFov * frame.view.aspect;
+    float extentY = frame.view.tanHalfFov;
+    for (int i = 0; i < count; i++) {
+        uint32_t index = indices[i];
+        // Ray distance to view depth: the ray's forward component is one before normalising
+        float planeX = (sampleX[i] * (2.0f / (float)width) - 1.0f) * extentX;
+        float planeY = (sampleY[i] * (2.0f / (float)height) - 1.0f) * extentY;
+        float depth = samples[i].depth;
+        frame.pixels[index] = CpuRayMarcher::PackPixel(samples[i].color);
+        frame.depths[index] = depth >= 0.0f ? depth / std::sqrt(1.0f + planeX * planeX + planeY * planeY) : -1.0f;
+        frame.normals[index] = samples[i].normal;
+        frame.traced[index] = 1;
+    }
+    rays += (uint64_t)count;
+}
+
+bool TemporalRenderer::Land(uint32_t source, glm::vec3& point, glm::vec2& motion) const
+{
+    glm::vec2 sourceCentre((float)(source % (uint32_t)width) + 0.5f, (float)(source / (uint32_t)width) + 0.5f);
+    glm::vec3 ray = reprojection.base + reprojection.stepX * sourceCentre.x + reprojection.stepY * sourceCentre.y;
+    float depth = frames[1 - current].depths[source];
+    // Misses are points at infinity, only turning the camera moves them
+    point = depth >= 0.0f ? reprojection.origin + ray * depth : ray;
+    if (point.z <= 0.0f) {
+        return false;
+    }
+    glm::vec2 landed = glm::vec2(point.x, point.y) * (1.0f / point.z) * reprojection.scale + reprojection.halfSize;
+    motion = landed - sourceCentre;
+    return true;
+}
+
+bool TemporalRenderer::Reproject(int x, int y, uint32_t index, glm::vec2& motion)
+{
+    const Frame& previous = frames[1 - current];
+    Frame& frame = frames[current];
+    const glm::vec2 centre((float)x + 0.5f, (float)y + 0.5f);
+
+    // Fixed point iteration for the history pixel whose point lands on centre: step
+    // back from centre by the motion of the last guess
+    glm::vec3 point(0.0f);
+    uint32_t source = 0;
+    bool bLanded = false;
+    for (int i = 0; i <= std::max(settings.iterations, 0) && !bLanded; i++) {
+        glm::vec2 guess = centre - motion;
+        int sourceX = std::clamp((int)std::floor(guess.x), 0, width - 1);
+        int sourceY = std::clamp((int)std::floor(guess.y), 0, height - 1);
+        source = (uint32_t)sourceY * (uint32_t)width + (uint32_t)sourceX;
+        if (!Land(source, point, motion)) {
+            motion = glm::vec2(0.0f);
+            return false;
+        }
+        glm::vec2 error = glm::vec2((float)sourceX + 0.5f, (float)sourceY + 0.5f) + motion - centre;
+        bLanded = std::max(std::fabs(error.x), std::fabs(error.y)) <= settings.maxError;
+    }
+    if (!bLanded) {
+        return false;
+    }
+
+    // Depth test: across a depth edge of the history, a neighbour that moves apart
+    // from this pixel is another surface sliding over it or uncovering what it hid
+    uint32_t sourceX = source % (uint32_t)width;
+    uint32_t sourceY = source / (uint32_t)width;
+    uint32_t neighbours[4];
+    int neighbourCount = 0;
+    if (sourceX > 0) {
+        neighbours[neighbourCount++] = source - 1;
+    }
+    if (sourceX + 1 < (uint32_t)width) {
+        neighbours[neighbourCount++] = source + 1;
+    }
+    if (sourceY > 0) {
+        neighbours[neighbourCount++] = source - (uint32_t)width;
+    }
+    if (sourceY + 1 < (uint32_t)height) {
+        neighbours[neighbourCount++] = source + (uint32_t)width;
+    }
+    for (int i = 0; i < neighbourCount; i++) {
+        if (!IsDepthEdge(previous, source, neighbours[i])) {
+            continue;
+        }
+        glm::vec3 neighbourPoint;
+        glm::vec2 neighbourMotion;
+        if (!Land(neighbours[i], neighbourPoint, neighbourMotion)) {
+            return false;
+        }
+        glm::vec2 parallax = neighbourMotion - motion;
+        if (std::max(std::fabs(parallax.x), std::fabs(parallax.y)) > settings.maxParallax) {
+            return false;
+        }
+    }
+
+    // Normal test: a surface turned away from the new view, or seen so edge on
+    // that one history pixel would be stretched over several
+    float depth = previous.depths[source];
+    const glm::vec3& normal = previous.normals[source];
+    if (depth >= 0.0f) {
+        glm::vec3 offset = frame.view.right * point.x + frame.view.up * point.y + frame.view.forward * point.z;
+        if (-glm::dot(normal, offset) < settings.minFacing * glm::length(offset)) {
+            return false;
+        }
+    }
+    frame.pixels[index] = previous.pixels[source];
+    frame.depths[index] = depth >= 0.0f ? point.z : -1.0f;
+    frame.normals[index] = normal;
+    frame.traced[index] = 0;
+    return true;
+}
+
+bool TemporalRenderer::IsDepthEdge(const Frame& frame, uint32_t a, uint32_t b) const
+{
+    bool bHitA = frame.depths[a] >= 0.0f;
+    bool bHitB = frame.depths[b] >= 0.0f;
+    if (bHitA != bHitB) {
+        return true;
+    }
+    return bHitA && std::fabs(frame.depths[a] - frame.depths[b]) > settings.depthThreshold * std::min(frame.depths[a], frame.depths[b]);
+}
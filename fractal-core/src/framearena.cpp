@@ -0,0 +1,92 @@
+// framearena.cpp
+
+// C standard library
+#include <cstdlib>
+
+// C++ standard library
+#include <new>
+
+// local headers
+#include "framearena.h"
+
+FrameArena::FrameArena(size_t initialCapacity)
+{
+    capacity = initialCapacity;
+    buffer = capacity > 0 ? static_cast<unsigned char*>(std::malloc(capacity)) : nullptr;
+    if (!buffer) {
+        capacity = 0;
+    }
+}
+
+FrameArena::~FrameArena()
+{
+    Reset();
+    std::free(buffer);
+}
+
+FrameArena& FrameArena::GetThreadArena()
+{
+    static thread_local FrameArena arena;
+    return arena;
+}
+
+uintptr_t FrameArena::AlignUp(uintptr_t value, size_t alignment)
+{
+    return (value + alignment - 1) & ~(uintptr_t)(alignment - 1);
+}
+
+void* FrameArena::Allocate(size_t size, size_t alignment)
+{
+    if (size == 0) {
+        size = 1;
+    }
+
+    if (buffer) {
+        uintptr_t start = AlignUp((uintptr_t)buffer + offset, alignment);
+        size_t end = (size_t)(start - (uintptr_t)buffer) + size;
+        if (end <= capacity) {
+            used += end - offset;
+            offset = end;
+            return (void*)start;
+        }
+    }
+
+    // Out of room this frame: a chunk of its own, with the list link in front
+    size_t header = AlignUp(sizeof(Overflow), alignment);
+    Overflow* chunk = static_cast<Overflow*>(std::malloc(header + size + alignment));
+    if (!chunk) {
+        throw std::bad_alloc();
+    }
+    chunk->next = overflow;
+    overflow = chunk;
+    used += size;
+    return (void*)AlignUp((uintptr_t)chunk + header, alignment);
+}
+
+void FrameArena::Reset()
+{
+    if (used > peak) {
+        peak = used;
+    }
+
+    bool bOverflowed = overflow != nullptr;
+    while (overflow) {
+        Overflow* next = overflow->next;
+        std::free(overflow);
+        overflow = next;
+    }
+
+    // Size the block for the busiest frame seen, with room for alignment padding
+    if (bOverflowed) {
+        size_t newCapacity = peak + peak / 4;
+        unsigned char* newBuffer = static_cast<unsigned char*>(std::malloc(newCapacity));
+        if (newBuffer) {
+            std::free(buffer);
+            buffer = newBuffer;
+            capacity = newCapacity;
+        }
+    }
+
+    offset = 0;
+    used = 0;
+}
@@ -0,0 +1,30 @@
+// frameclock.cpp
+
+// C++ standard library
+#include <algorithm>
+#include <cmath>
+
+// local headers
+#include "frameclock.h"
+
+FrameClock::FrameClock(double step, int maxSteps)
+    : step(step > 0.0 ? step : 1.0 / 60.0), maxSteps(maxSteps > 0 ? maxSteps : 1)
+{
+}
+
+int FrameClock::Advance(double frameSeconds) {
+    accumulator += std::min(std::max(frameSeconds, 0.0), MAX_FRAME_TIME);
+
+    int steps = (int)std::floor(accumulator / step);
+    if (steps > maxSteps) {
+        // Falling behind: run what we can afford and forget the rest rather
+        // than spiralling into ever longer frames
+        droppedSteps += (unsigned int)(steps - maxSteps);
+        steps = maxSteps;
+        accumulator = std::fmod(accumulator, step);
+    }
+    else {
+        accumulator -= steps * step;
+    }
+    return steps;
+}
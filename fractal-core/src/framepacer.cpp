@@ -0,0 +1,90 @@
+// framepacer.cpp
+
+// C++ standard library
+#include <cmath>
+#include <thread>
+
+// local headers
+#include "framepacer.h"
+
+double FramePacer::WaitForNextFrame() {
+    Clock::time_point now = Clock::now();
+    if (!bStarted) {
+        bStarted = true;
+        lastFrameStart = now;
+        nextFrameTime = now;
+        return 0.0;
+    }
+
+    if (targetFps > 0.0f) {
+        auto interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / targetFps));
+        nextFrameTime += interval;
+
+        // More than a frame late: start over instead of bursting to catch up
+        if (nextFrameTime + interval < now) {
+            nextFrameTime = now;
+        }
+
+        // Coarse sleep, then spin the remainder for an accurate wake-up
+        auto sleepUntil = nextFrameTime - std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(spinThreshold));
+        if (now < sleepUntil) {
+            std::this_thread::sleep_until(sleepUntil);
+        }
+        while (Clock::now() < nextFrameTime) {
+            std::this_thread::yield();
+        }
+        now = Clock::now();
+    }
+
+    double elapsed = std::chrono::duration<double>(now - lastFrameStart).count();
+    lastFrameStart = now;
+    RecordInterval(elapsed);
+    return elapsed;
+}
+
+bool FramePacer::ShouldRunFrame(double frameSeconds, double& elapsedSeconds) {
+    pendingSeconds += frameSeconds;
+    if (targetFps > 0.0f) {
+        // Small tolerance so a 60 Hz display capped at 30 doesn't miss every other slot
+        double interval = 1.0 / targetFps;
+        if (pendingSeconds + 0.002 < interval) {
+            return false;
+        }
+    }
+    elapsedSeconds = pendingSeconds;
+    pendingSeconds = 0.0;
+    RecordInterval(elapsedSeconds);
+    return true;
+}
+
+void FramePacer::RecordInterval(double seconds) {
+    intervals[intervalIndex] = seconds;
+    intervalIndex = (intervalIndex + 1) % JITTER_WINDOW;
+    if (intervalCount < JITTER_WINDOW) {
+        intervalCount++;
+    }
+}
+
+float FramePacer::GetAverageFrameMs() const {
+    if (intervalCount == 0) {
+        return 0.0f;
+    }
+    double sum = 0.0;
+    for (int i = 0; i < intervalCount; i++) {
+        sum += intervals[i];
+    }
+    return (float)(sum / intervalCount * 1000.0);
+}
+
+float FramePacer::GetJitterMs() const {
+    if (intervalCount < 2) {
+        return 0.0f;
+    }
+    double mean = GetAverageFrameMs() / 1000.0;
+    double variance = 0.0;
+    for (int i = 0; i < intervalCount; i++) {
+        double d = intervals[i] - mean;
+        variance += d * d;
+    }
+    return (float)(std::sqrt(variance / intervalCount) * 1000.0);
+}
@@ -0,0 +1,63 @@
+#include "frustum.h"
+
+Frustum::Frustum() {
+    for (int i = 0; i < PLANE_COUNT; i++) {
+        planes[i] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    }
+}
+
+Frustum::Frustum(const glm::mat4& viewProjection) {
+    ExtractFromMatrix(viewProjection);
+}
+
+void Frustum::ExtractFromMatrix(const glm::mat4& m) {
+    // Gribb/Hartmann plane extraction, glm matrices are column-major so row i is (m[0][i], m[1][i], m[2][i], m[3][i])
+    glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+    glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+    glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+    glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+    planes[Left]   = row3 + row0;
+    planes[Right]  = row3 - row0;
+    planes[Bottom] = row3 + row1;
+    planes[Top]    = row3 - row1;
+    planes[Near]   = row3 + row2;
+    planes[Far]    = row3 - row2;
+
+    for (int i = 0; i < PLANE_COUNT; i++) {
+        float length = glm::length(glm::vec3(planes[i].x, planes[i].y, planes[i].z));
+        if (length > 0.0f) {
+            planes[i] /= length;
+        }
+    }
+}
+
+bool Frustum::ContainsPoint(const glm::vec3& point) const {
+    return IntersectsSphere(point, 0.0f);
+}
+
+bool Frustum::IntersectsSphere(const glm::vec3& center, float radius) const {
+    for (int i = 0; i < PLANE_COUNT; i++) {
+        float distance = planes[i].x * center.x + planes[i].y * center.y + planes[i].z * center.z + planes[i].w;
+        if (distance < -radius) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Frustum::IntersectsAABB(const glm::vec3& min, const glm::vec3& max) const {
+    for (int i = 0; i < PLANE_COUNT; i++) {
+        // Test the box corner furthest along the plane normal
+        glm::vec3 positive(
+            planes[i].x >= 0.0f ? max.x : min.x,
+            planes[i].y >= 0.0f ? max.y : min.y,
+            planes[i].z >= 0.0f ? max.z : min.z
+        );
+        float distance = planes[i].x * positive.x + planes[i].y * positive.y + planes[i].z * positive.z + planes[i].w;
+        if (distance < 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
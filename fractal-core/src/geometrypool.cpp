@@ -0,0 +1,475 @@
+// geometrypool.cpp
+
+// C++ standard library
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+#ifdef __EMSCRIPTEN__
+#include <webgl/webgl2_ext.h>
+#endif
+
+// local headers
+#include "framearena.h"
+#include "geometrypool.h"
+#include "mesh.h"
+#include "profiler.h"
+
+GeometryPool* GeometryPool::instance = nullptr;
+
+GeometryPool* GeometryPool::GetInstance()
+{
+    if (instance == nullptr) {
+        instance = new GeometryPool();
+    }
+    return instance;
+}
+
+GeometryPool::GeometryPool()
+{
+    // GL objects are created on first use, on the thread that owns the context
+    if (instance == nullptr) {
+        instance = this;
+    }
+}
+
+GeometryPool::~GeometryPool()
+{
+    if (vao) {
+        glDeleteVertexArrays(1, &vao);
+    }
+    if (vbo) {
+        glDeleteBuffers(1, &vbo);
+    }
+    if (ebo) {
+        glDeleteBuffers(1, &ebo);
+    }
+    if (instance == this) {
+        instance = nullptr;
+    }
+}
+
+void GeometryPool::DetectCapabilities()
+{
+    #ifdef __EMSCRIPTEN__
+    EMSCRIPTEN_WEBGL_CONTEXT_HANDLE context = emscripten_webgl_get_current_context();
+    bBaseInstance = emscripten_webgl_enable_WEBGL_draw_instanced_base_vertex_base_instance(context);
+    bMultiDraw = bBaseInstance && emscripten_webgl_enable_WEBGL_multi_draw_instanced_base_vertex_base_instance(context);
+    // WebGL2 itself has no base vertex draws
+    bBaseVertex = bBaseInstance;
+    #else
+    bBaseVertex = true;
+    bBaseInstance = GLEW_VERSION_4_2 || GLEW_ARB_base_instance;
+    bMultiDraw = bBaseInstance && (GLEW_VERSION_4_3 || GLEW_ARB_multi_draw_indirect);
+    #endif
+
+    std::cout << "Geometry pool: " << (bMultiDraw ? "multi-draw" : bBaseInstance ? "per-mesh base instance draws" : "per-mesh draws")
+              << (bBaseVertex ? "" : ", rebased indices") << std::endl;
+}
+
+void GeometryPool::Create()
+{
+    bCreated = true;
+    DetectCapabilities();
+    glGenVertexArrays(1, &vao);
+    Reserve(DEFAULT_VERTEX_CAPACITY, DEFAULT_INDEX_CAPACITY);
+}
+
+void GeometryPool::Reserve(size_t vertices, size_t indices)
+{
+    size_t vertexCapacity = vertexArena.GetCapacity();
+    size_t indexCapacity = indexArena.GetCapacity();
+    if (vbo && vertices <= vertexCapacity && indices <= indexCapacity) {
+        return;
+    }
+    PROFILE_ZONE("GeometryPool::Reserve");
+
+    size_t newVertexCapacity = std::max(vertexCapacity, DEFAULT_VERTEX_CAPACITY);
+    while (newVertexCapacity < vertices) {
+        newVertexCapacity *= 2;
+    }
+    size_t newIndexCapacity = std::max(indexCapacity, DEFAULT_INDEX_CAPACITY);
+    while (newIndexCapacity < indices) {
+        newIndexCapacity *= 2;
+    }
+
+    // The element buffer binding is VAO state
+    glBindVertexArray(vao);
+
+    GLuint newVbo = 0;
+    GLuint newEbo = 0;
+    glGenBuffers(1, &newVbo);
+    glGenBuffers(1, &newEbo);
+
+    glBindBuffer(GL_ARRAY_BUFFER, newVbo);
+    glBufferData(GL_ARRAY_BUFFER, newVertexCapacity * sizeof(Vertex), nullptr, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, newEbo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, newIndexCapacity * sizeof(unsigned int), nullptr, GL_STATIC_DRAW);
+
+    // Allocations keep their offsets, so copy the whole arenas over on the GPU
+    if (vbo) {
+        glBindBuffer(GL_COPY_READ_BUFFER, vbo);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_ARRAY_BUFFER, 0, 0, vertexCapacity * sizeof(Vertex));
+        glBindBuffer(GL_COPY_READ_BUFFER, ebo);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_ELEMENT_ARRAY_BUFFER, 0, 0, indexCapacity * sizeof(unsigned int));
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glDeleteBuffers(1, &vbo);
+        glDeleteBuffers(1, &ebo);
+        grows++;
+        std::cout << "Geometry pool grown to " << newVertexCapacity << " vertices, " << newIndexCapacity << " indices" << std::endl;
+    }
+
+    vbo = newVbo;
+    ebo = newEbo;
+    vertexArena.Grow((uint32_t)newVertexCapacity);
+    indexArena.Grow((uint32_t)newIndexCapacity);
+    SetupVertexAttributes();
+
+    glBindVertexArray(0);
+}
+
+uint32_t GeometryPool::AllocateBlock(TlsfAllocator& arena, uint32_t size, bool bVertices)
+{
+    uint32_t block = arena.Allocate(size);
+    if (block != TlsfAllocator::INVALID) {
+        return block;
+    }
+
+    // No hole is big enough; grow so the request fits even in the worst case
+    size_t needed = (size_t)arena.GetCapacity() + size;
+    if (bVertices) {
+        Reserve(needed, indexArena.GetCapacity());
+    }
+    else {
+        Reserve(vertexArena.GetCapacity(), needed);
+    }
+    return arena.Allocate(size);
+}
+
+void GeometryPool::SetupVertexAttributes()
+{
+    // Same layout as a standalone Mesh, expects the VAO and vbo bound
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texCoords));
+    glEnableVertexAttribArray(3);
+    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, tangent));
+    glEnableVertexAttribArray(4);
+    glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, bitangent));
+}
+
+void GeometryPool::PointInstanceAttributes(GLuint buffer, GLintptr offset)
+{
+    // Expects the VAO bound. mat4 and mat3 take one location per column.
+    const GLuint location = INSTANCE_ATTRIBUTE_LOCATION;
+    const GLsizei stride = sizeof(InstanceVertex);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    for (GLuint column = 0; column < 4; column++) {
+        glVertexAttribPointer(location + column, 4, GL_FLOAT, GL_FALSE, stride, (void*)(offset + offsetof(InstanceVertex, model) + column * sizeof(glm::vec4)));
+    }
+    for (GLuint column = 0; column < 3; column++) {
+        glVertexAttribPointer(location + 4 + column, 3, GL_FLOAT, GL_FALSE, stride, (void*)(offset + offsetof(InstanceVertex, normalMatrix) + column * sizeof(glm::vec3)));
+    }
+    glVertexAttribPointer(location + 7, 4, GL_FLOAT, GL_FALSE, stride, (void*)(offset + offsetof(InstanceVertex, albedoMetallic)));
+    glVertexAttribPointer(location + 8, 2, GL_FLOAT, GL_FALSE, stride, (void*)(offset + offsetof(InstanceVertex, roughnessAo)));
+
+    if (!bInstanceAttributesEnabled) {
+        bInstanceAttributesEnabled = true;
+        for (GLuint i = 0; i < 9; i++) {
+            glEnableVertexAttribArray(location + i);
+            glVertexAttribDivisor(location + i, 1);
+        }
+    }
+}
+
+GeometryHandle GeometryPool::Add(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices)
+{
+    if (vertices.empty() || indices.empty()) {
+        return INVALID_HANDLE;
+    }
+    if (!bCreated) {
+        Create();
+    }
+    PROFILE_ZONE("GeometryPool::Add");
+
+    GeometryHandle handle = entries.Create();
+    Entry& entry = entries[handle];
+    entry.vertexBlock = AllocateBlock(vertexArena, (uint32_t)vertices.size(), true);
+    entry.indexBlock = AllocateBlock(indexArena, (uint32_t)indices.size(), false);
+    if (entry.vertexBlock == TlsfAllocator::INVALID || entry.indexBlock == TlsfAllocator::INVALID) {
+        std::cerr << "Geometry pool has no room for " << vertices.size() << " vertices, " << indices.size() << " indices" << std::endl;
+        vertexArena.Free(entry.vertexBlock);
+        indexArena.Free(entry.indexBlock);
+        entries.Destroy(handle);
+        return INVALID_HANDLE;
+    }
+    vertexArena.SetUserData(entry.vertexBlock, handle);
+    indexArena.SetUserData(entry.indexBlock, handle);
+
+    uint32_t baseVertex = vertexArena.GetOffset(entry.vertexBlock);
+    uint32_t firstIndex = indexArena.GetOffset(entry.indexBlock);
+
+    const unsigned int* indexData = indices.data();
+    if (!bBaseVertex) {
+        // No base vertex in the draw calls, so bake it into the indices
+        rebasedIndices.resize(indices.size());
+        for (size_t i = 0; i < indices.size(); i++) {
+            rebasedIndices[i] = indices[i] + baseVertex;
+        }
+        indexData = rebasedIndices.data();
+    }
+
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferSubData(GL_ARRAY_BUFFER, baseVertex * sizeof(Vertex), vertices.size() * sizeof(Vertex), vertices.data());
+    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, firstIndex * sizeof(unsigned int), indices.size() * sizeof(unsigned int), indexData);
+    glBindVertexArray(0);
+    Profiler::CountUpload(vertices.size() * sizeof(Vertex));
+    Profiler::CountUpload(indices.size() * sizeof(unsigned int));
+
+    rebasedIndices.clear();
+    return handle;
+}
+
+void GeometryPool::Remove(GeometryHandle handle)
+{
+    if (!entries.IsAlive(handle)) {
+        return;
+    }
+    // Draws already submitted still read the old data; GL orders any reuse after them
+    vertexArena.Free(entries[handle].vertexBlock);
+    indexArena.Free(entries[handle].indexBlock);
+    entries.Destroy(handle);
+}
+
+GeometryRange GeometryPool::GetRange(GeometryHandle handle) const
+{
+    GeometryRange range;
+    if (!entries.IsAlive(handle)) {
+        return range;
+    }
+    const Entry& entry = entries[handle];
+    range.baseVertex = (GLint)vertexArena.GetOffset(entry.vertexBlock);
+    range.firstIndex = indexArena.GetOffset(entry.indexBlock);
+    range.indexCount = (GLsizei)indexArena.GetSize(entry.indexBlock);
+    range.vertexCount = (GLsizei)vertexArena.GetSize(entry.vertexBlock);
+    return range;
+}
+
+size_t GeometryPool::MoveLastBlock(TlsfAllocator& arena, bool bVertices)
+{
+    uint32_t block = arena.GetLastUsedBlock();
+    if (block == TlsfAllocator::INVALID) {
+        return 0;
+    }
+    uint32_t size = arena.GetSize(block);
+    uint32_t offset = arena.GetOffset(block);
+
+    // Only worth it if the copy lands lower; the trailing space then merges
+    uint32_t target = arena.Allocate(size);
+    if (target == TlsfAllocator::INVALID) {
+        return 0;
+    }
+    uint32_t targetOffset = arena.GetOffset(target);
+    if (targetOffset > offset) {
+        arena.Free(target);
+        return 0;
+    }
+
+    size_t elementSize = bVertices ? sizeof(Vertex) : sizeof(unsigned int);
+    GLuint buffer = bVertices ? vbo : ebo;
+    glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, offset * elementSize, targetOffset * elementSize, size * elementSize);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    GeometryHandle handle = arena.GetUserData(block);
+    arena.SetUserData(target, handle);
+    if (bVertices) {
+        entries[handle].vertexBlock = target;
+    }
+    else {
+        entries[handle].indexBlock = target;
+    }
+    arena.Free(block);
+
+    size_t bytes = size * elementSize;
+    moves++;
+    movedBytes += bytes;
+    Profiler::Count(ProfileCounter::DefragmentBytes, bytes);
+    return bytes;
+}
+
+void GeometryPool::Defragment(size_t maxBytes)
+{
+    if (!bCreated) {
+        return;
+    }
+    PROFILE_ZONE("GeometryPool::Defragment");
+
+    // Moving vertices would invalidate indices that have the base vertex baked in
+    bool bMoveVertices = bBaseVertex;
+
+    size_t copied = 0;
+    while (copied < maxBytes) {
+        size_t bytes = 0;
+        if (bMoveVertices && vertexArena.GetFragmentation() > 0.0f) {
+            bytes += MoveLastBlock(vertexArena, true);
+        }
+        if (indexArena.GetFragmentation() > 0.0f) {
+            bytes += MoveLastBlock(indexArena, false);
+        }
+        if (bytes == 0) {
+            break;
+        }
+        copied += bytes;
+    }
+    PublishStats();
+}
+
+void GeometryPool::Compact()
+{
+    Defragment(SIZE_MAX);
+}
+
+GeometryPoolStats GeometryPool::GetStats() const
+{
+    GeometryPoolStats stats;
+    stats.meshes = (unsigned int)entries.GetSize();
+    stats.vertexCapacity = vertexArena.GetCapacity();
+    stats.vertexUsed = vertexArena.GetUsed();
+    stats.indexCapacity = indexArena.GetCapacity();
+    stats.indexUsed = indexArena.GetUsed();
+
+    uint64_t capacityBytes = (uint64_t)stats.vertexCapacity * sizeof(Vertex) + (uint64_t)stats.indexCapacity * sizeof(unsigned int);
+    uint64_t usedBytes = (uint64_t)stats.vertexUsed * sizeof(Vertex) + (uint64_t)stats.indexUsed * sizeof(unsigned int);
+    stats.occupancy = capacityBytes > 0 ? (float)((double)usedBytes / (double)capacityBytes) : 0.0f;
+    stats.fragmentation = std::max(vertexArena.GetFragmentation(), indexArena.GetFragmentation());
+    stats.grows = grows;
+    stats.moves = moves;
+    stats.movedBytes = movedBytes;
+    return stats;
+}
+
+void GeometryPool::PublishStats() const
+{
+    GeometryPoolStats stats = GetStats();
+    Profiler::SetGauge(ProfileGauge::GeometryOccupancy, stats.occupancy);
+    Profiler::SetGauge(ProfileGauge::GeometryFragmentation, stats.fragmentation);
+}
+
+void GeometryPool::Draw(const GeometryRange& range)
+{
+    if (!range.IsValid()) {
+        return;
+    }
+    const void* indexOffset = (const void*)(range.firstIndex * sizeof(unsigned int));
+
+    glBindVertexArray(vao);
+    #ifdef __EMSCRIPTEN__
+    if (bBaseVertex) {
+        glDrawElementsInstancedBaseVertexBaseInstanceWEBGL(GL_TRIANGLES, range.indexCount, GL_UNSIGNED_INT, indexOffset, 1, range.baseVertex, 0);
+    }
+    else {
+        glDrawElements(GL_TRIANGLES, range.indexCount, GL_UNSIGNED_INT, indexOffset);
+    }
+    #else
+    glDrawElementsBaseVertex(GL_TRIANGLES, range.indexCount, GL_UNSIGNED_INT, indexOffset, range.baseVertex);
+    #endif
+    glBindVertexArray(0);
+    Profiler::Count(ProfileCounter::StateChanges);
+    Profiler::CountDraw(range.indexCount / 3);
+}
+
+void GeometryPool::DrawBatch(const GeometryDraw* draws, size_t drawCount, const StreamAllocation& instanceData)
+{
+    if (drawCount == 0 || !instanceData.IsValid()) {
+        return;
+    }
+
+    glBindVertexArray(vao);
+    Profiler::Count(ProfileCounter::StateChanges);
+
+    if (bMultiDraw) {
+        PointInstanceAttributes(instanceData.buffer, instanceData.offset);
+        uint64_t triangles = 0;
+
+        #ifdef __EMSCRIPTEN__
+        // The entry point wants the draws split into parallel arrays
+        FrameArena& arena = FrameArena::GetThreadArena();
+        GLsizei* drawCounts = arena.AllocateArray<GLsizei>(drawCount);
+        const void** drawOffsets = arena.AllocateArray<const void*>(drawCount);
+        GLsizei* drawInstanceCounts = arena.AllocateArray<GLsizei>(drawCount);
+        GLint* drawBaseVertices = arena.AllocateArray<GLint>(drawCount);
+        GLuint* drawBaseInstances = arena.AllocateArray<GLuint>(drawCount);
+        for (size_t i = 0; i < drawCount; i++) {
+            const GeometryDraw& draw = draws[i];
+            drawCounts[i] = draw.range.indexCount;
+            drawOffsets[i] = (const void*)(draw.range.firstIndex * sizeof(unsigned int));
+            drawInstanceCounts[i] = (GLsizei)draw.instanceCount;
+            drawBaseVertices[i] = draw.range.baseVertex;
+            drawBaseInstances[i] = draw.baseInstance;
+            triangles += (uint64_t)(draw.range.indexCount / 3) * draw.instanceCount;
+        }
+        glMultiDrawElementsInstancedBaseVertexBaseInstanceWEBGL(GL_TRIANGLES, drawCounts, GL_UNSIGNED_INT, drawOffsets,
+            drawInstanceCounts, drawBaseVertices, drawBaseInstances, (GLsizei)drawCount);
+        #else
+        // Commands go through the stream buffer like any other per-frame data
+        StreamBuffer* stream = StreamBuffer::GetInstance();
+        StreamAllocation commands = stream->Allocate(drawCount * sizeof(IndirectCommand), sizeof(GLuint));
+        if (!commands.IsValid()) {
+            glBindVertexArray(0);
+            return;
+        }
+        for (size_t i = 0; i < drawCount; i++) {
+            const GeometryDraw& draw = draws[i];
+            IndirectCommand command = { (GLuint)draw.range.indexCount, draw.instanceCount, draw.range.firstIndex, draw.range.baseVertex, draw.baseInstance };
+            memcpy(commands.data + i * sizeof(IndirectCommand), &command, sizeof(command));
+            triangles += (uint64_t)(draw.range.indexCount / 3) * draw.instanceCount;
+        }
+        stream->Flush(commands);
+
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commands.buffer);
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (const void*)commands.offset, (GLsizei)drawCount, 0);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        #endif
+
+        Profiler::CountDraw(triangles);
+    }
+    else {
+        if (bBaseInstance) {
+            PointInstanceAttributes(instanceData.buffer, instanceData.offset);
+        }
+        for (size_t i = 0; i < drawCount; i++) {
+            const GeometryDraw& draw = draws[i];
+            const void* indexOffset = (const void*)(draw.range.firstIndex * sizeof(unsigned int));
+            if (bBaseInstance) {
+                #ifdef __EMSCRIPTEN__
+                glDrawElementsInstancedBaseVertexBaseInstanceWEBGL(GL_TRIANGLES, draw.range.indexCount, GL_UNSIGNED_INT, indexOffset,
+                    (GLsizei)draw.instanceCount, draw.range.baseVertex, draw.baseInstance);
+                #else
+                glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, draw.range.indexCount, GL_UNSIGNED_INT, indexOffset,
+                    (GLsizei)draw.instanceCount, draw.range.baseVertex, draw.baseInstance);
+                #endif
+            }
+            else {
+                // No base instance: move the attributes to this mesh's first instance instead
+                PointInstanceAttributes(instanceData.buffer, instanceData.offset + draw.baseInstance * sizeof(InstanceVertex));
+                #ifdef __EMSCRIPTEN__
+                glDrawElementsInstanced(GL_TRIANGLES, draw.range.indexCount, GL_UNSIGNED_INT, indexOffset, (GLsizei)draw.instanceCount);
+                #else
+                glDrawElementsInstancedBaseVertex(GL_TRIANGLES, draw.range.indexCount, GL_UNSIGNED_INT, indexOffset,
+                    (GLsizei)draw.instanceCount, draw.range.baseVertex);
+                #endif
+            }
+            Profiler::CountDraw((uint64_t)(draw.range.indexCount / 3) * draw.instanceCount);
+        }
+    }
+
+    glBindVertexArray(0);
+}
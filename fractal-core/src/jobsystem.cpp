@@ -0,0 +1,230 @@
+// jobsystem.cpp
+
+// C++ standard library
+#include <algorithm>
+#include <string>
+
+// local headers
+#include "jobsystem.h"
+#include "profiler.h"
+
+namespace {
+// Pool and worker index of the calling thread, null and -1 outside any pool
+thread_local const JobSystem* currentSystem = nullptr;
+thread_local int currentWorker = -1;
+}
+
+void JobSystem::WorkQueue::Push(const Job& job)
+{
+    if (count == ring.size()) {
+        // Unwrap into a larger ring
+        std::vector<Job> grown(std::max(ring.size() * 2, INITIAL_QUEUE_CAPACITY));
+        for (size_t i = 0; i < count; i++) {
+            grown[i] = ring[(head + i) % ring.size()];
+        }
+        ring.swap(grown);
+        head = 0;
+    }
+    ring[(head + count) % ring.size()] = job;
+    count++;
+}
+
+bool JobSystem::WorkQueue::PopBack(Job& job)
+{
+    if (count == 0) {
+        return false;
+    }
+    count--;
+    job = ring[(head + count) % ring.size()];
+    return true;
+}
+
+bool JobSystem::WorkQueue::PopFront(Job& job)
+{
+    if (count == 0) {
+        return false;
+    }
+    job = ring[head];
+    head = (head + 1) % ring.size();
+    count--;
+    return true;
+}
+
+JobSystem* JobSystem::GetInstance()
+{
+    static JobSystem instance;
+    return &instance;
+}
+
+JobSystem::JobSystem()
+{
+    // The outside queue exists before Start() so Submit/Wait work without workers
+    queues.push_back(std::make_unique<WorkQueue>());
+    queues.back()->ring.resize(INITIAL_QUEUE_CAPACITY);
+}
+
+JobSystem::~JobSystem()
+{
+    Stop();
+}
+
+void JobSystem::Start(int workerCount)
+{
+    Stop();
+
+    #if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+    workerCount = 0;
+    #else
+    if (workerCount < 0) {
+        workerCount = std::max(1, (int)std::thread::hardware_concurrency()) - 1;
+    }
+    #endif
+
+    queues.clear();
+    for (int i = 0; i <= workerCount; i++) {
+        queues.push_back(std::make_unique<WorkQueue>());
+        queues.back()->ring.resize(INITIAL_QUEUE_CAPACITY);
+    }
+    bRunning = true;
+    for (int i = 0; i < workerCount; i++) {
+        workers.emplace_back(&JobSystem::WorkerMain, this, i);
+    }
+}
+
+void JobSystem::Stop()
+{
+    if (workers.empty()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        bRunning = false;
+    }
+    wakeCondition.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+
+    // Whatever was left in worker queues moves to the outside queue, where Wait() finds it
+    std::unique_ptr<WorkQueue> outside = std::move(queues.back());
+    for (size_t i = 0; i + 1 < queues.size(); i++) {
+        Job job;
+        while (queues[i]->PopFront(job)) {
+            outside->Push(job);
+        }
+    }
+    queues.clear();
+    queues.push_back(std::move(outside));
+}
+
+size_t JobSystem::GetOwnQueue() const
+{
+    return currentSystem == this ? (size_t)currentWorker : queues.size() - 1;
+}
+
+void JobSystem::Submit(JobFunction function, void* context, size_t count, size_t grain, JobCounter& counter)
+{
+    if (count == 0) {
+        return;
+    }
+    grain = std::max<size_t>(grain, 1);
+    size_t jobCount = (count + grain - 1) / grain;
+    counter.pending.fetch_add((uint32_t)jobCount, std::memory_order_relaxed);
+
+    // Workers submitting nested work keep it local; outside submissions are dealt
+    // round robin so every worker has something of its own before stealing starts
+    bool bFromWorker = currentSystem == this;
+    size_t workerQueues = queues.size() - 1;
+    for (size_t i = 0; i < jobCount; i++) {
+        Job job;
+        job.function = function;
+        job.context = context;
+        job.begin = i * grain;
+        job.end = std::min(count, job.begin + grain);
+        job.counter = &counter;
+
+        size_t target = GetOwnQueue();
+        if (!bFromWorker && workerQueues > 0) {
+            target = nextQueue.fetch_add(1, std::memory_order_relaxed) % workerQueues;
+        }
+        WorkQueue& queue = *queues[target];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.Push(job);
+    }
+    queuedJobs.fetch_add((int)jobCount, std::memory_order_release);
+
+    if (!workers.empty()) {
+        // Taking the lock orders the count above before any worker's sleep check
+        { std::lock_guard<std::mutex> lock(sleepMutex); }
+        wakeCondition.notify_all();
+    }
+}
+
+bool JobSystem::TakeJob(size_t ownQueue, Job& job)
+{
+    if (queuedJobs.load(std::memory_order_acquire) <= 0) {
+        return false;
+    }
+    {
+        WorkQueue& queue = *queues[ownQueue];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.PopBack(job)) {
+            queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    // Steal the oldest job, starting after our own queue so thieves spread out
+    for (size_t offset = 1; offset < queues.size(); offset++) {
+        WorkQueue& victim = *queues[(ownQueue + offset) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.PopFront(job)) {
+            queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void JobSystem::Execute(const Job& job)
+{
+    job.function(job.context, job.begin, job.end);
+    job.counter->pending.fetch_sub(1, std::memory_order_release);
+}
+
+void JobSystem::Wait(JobCounter& counter)
+{
+    size_t ownQueue = GetOwnQueue();
+    while (!counter.IsDone()) {
+        Job job;
+        if (TakeJob(ownQueue, job)) {
+            Execute(job);
+        }
+        else {
+            // Only the last few jobs are still running elsewhere
+            std::this_thread::yield();
+        }
+    }
+}
+
+void JobSystem::WorkerMain(int index)
+{
+    currentSystem = this;
+    currentWorker = index;
+    Profiler::GetInstance()->SetThreadName(("Job " + std::to_string(index)).c_str());
+
+    while (true) {
+        Job job;
+        if (TakeJob((size_t)index, job)) {
+            Execute(job);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wakeCondition.wait(lock, [this] { return !bRunning || queuedJobs.load(std::memory_order_acquire) > 0; });
+        if (!bRunning) {
+            break;
+        }
+    }
+    currentSystem = nullptr;
+    currentWorker = -1;
+}
@@ -51,4 +51,20 @@ float Light::getRange() const {
 
 Light::Type Light::getType() const {
     return m_type;
-} 
\ No newline at end of file
+}
+
+void Light::setSpotAngle(float degrees) {
+    m_spotAngle = degrees;
+}
+
+void Light::setCastsShadows(bool bCastsShadows) {
+    m_bCastsShadows = bCastsShadows;
+}
+
+float Light::getSpotAngle() const {
+    return m_spotAngle;
+}
+
+bool Light::getCastsShadows() const {
+    return m_bCastsShadows;
+}
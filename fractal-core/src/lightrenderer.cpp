@@ -1,4 +1,10 @@
+#include <cstddef>
+
+#include <cstring>
+
 #include "lightrenderer.h"
+#include "profiler.h"
+#include "streambuffer.h"
 
 LightRenderer::LightRenderer()
 {
@@ -17,7 +23,7 @@ void LightRenderer::Init()
     std::vector<unsigned int> indices;
 
     //generate a fibonacci sphere from a number of points
-    const float radius = 0.3f;
+    const float radius = gizmoRadius;
     const float numPoints = 100;
     const float PI = 3.1415926f;
     const float PHI = 1.618033988749f; // Golden ratio
@@ -40,7 +46,7 @@ void LightRenderer::Init()
     shader = new ShaderProgram();
     shader->AttachShaderFromFile("light.vert", GL_VERTEX_SHADER);
     shader->AttachShaderFromFile("passthrough.frag", GL_FRAGMENT_SHADER);
-    shader->Link();
+    shader->Submit();
 
     //create VAO
     glGenVertexArrays(1, &VAO);
@@ -55,43 +61,69 @@ void LightRenderer::Init()
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
     glEnableVertexAttribArray(0);
 
+    //per-light instance attributes, pointed at this frame's stream buffer range in Render
+    glEnableVertexAttribArray(1);
+    glVertexAttribDivisor(1, 1);
+    glEnableVertexAttribArray(2);
+    glVertexAttribDivisor(2, 1);
+    glEnableVertexAttribArray(3);
+    glVertexAttribDivisor(3, 1);
+
     //unbind VAO
     glBindVertexArray(0);
 }
 
 void LightRenderer::Render(const std::vector<Light>& lights, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix)
 {
-    //bind VAO
-    glBindVertexArray(VAO);
+    PROFILE_ZONE("LightRenderer::Render");
 
-    //bind shader
-    shader->Use();
+    //cull lights against the view frustum before upload
+    frustum.ExtractFromMatrix(projectionMatrix * viewMatrix);
+    instances.clear();
+    for(const auto& light : lights) {
+        if(!frustum.IntersectsSphere(light.getPosition(), gizmoRadius)) {
+            continue;
+        }
+        instances.push_back({ light.getPosition(), light.getColor(), light.getIntensity() });
+    }
+    if(instances.empty()) {
+        return;
+    }
 
-    //set up uniforms
-    shader->SetUniformMat4("uView", viewMatrix);
-    shader->SetUniformMat4("uProjection", projectionMatrix);
+    PROFILE_GPU_ZONE("LightRenderer");
 
-    glm::vec3 cameraRight = glm::vec3(viewMatrix[0][0], viewMatrix[1][0], viewMatrix[2][0]);
-    glm::vec3 cameraUp = glm::vec3(viewMatrix[0][1], viewMatrix[1][1], viewMatrix[2][1]);
-    glm::vec3 cameraForward = glm::vec3(viewMatrix[0][2], viewMatrix[1][2], viewMatrix[2][2]);
+    //stream the instance data; the ring never hands out a range the GPU is still reading
+    StreamBuffer* stream = StreamBuffer::GetInstance();
+    StreamAllocation instanceData = stream->Allocate(instances.size() * sizeof(LightInstance), sizeof(float));
+    if(!instanceData.IsValid()) {
+        return;
+    }
+    memcpy(instanceData.data, instances.data(), instances.size() * sizeof(LightInstance));
+    stream->Flush(instanceData);
 
-    //draw spheres
-    for(const auto& light : lights) {
-         // Create billboard matrix
-         glm::mat4 billboardMatrix = glm::mat4(
-            glm::vec4(cameraRight, 0.0f),
-            glm::vec4(cameraUp, 0.0f),
-            glm::vec4(cameraForward, 0.0f),
-            glm::vec4(light.getPosition(), 1.0f)
-         );
-
-        shader->SetUniformMat4("uModel", billboardMatrix);
-        shader->SetUniformVec3("uColor", light.getColor());
-        shader->SetUniformFloat("uIntensity", light.getIntensity());
-
-        glDrawArrays(GL_LINE_STRIP, 0, numVertices);
+    //bind shader
+    shader->Use();
+    if(!bLocationsCached) {
+        viewLocation = glGetUniformLocation(shader->programId, "uView");
+        projectionLocation = glGetUniformLocation(shader->programId, "uProjection");
+        bLocationsCached = true;
     }
 
+    //the billboard is built from the view matrix in light.vert
+    glUniformMatrix4fv(viewLocation, 1, GL_FALSE, &viewMatrix[0][0]);
+    glUniformMatrix4fv(projectionLocation, 1, GL_FALSE, &projectionMatrix[0][0]);
+
+    //draw every visible gizmo at once
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceData.buffer);
+    const char* base = reinterpret_cast<const char*>(instanceData.offset);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(LightInstance), base + offsetof(LightInstance, position));
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(LightInstance), base + offsetof(LightInstance, color));
+    glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, sizeof(LightInstance), base + offsetof(LightInstance, intensity));
+    glDrawArraysInstanced(GL_LINE_STRIP, 0, numVertices, (GLsizei)instances.size());
+    Profiler::CountDraw(0);
+    Profiler::Count(ProfileCounter::StateChanges, 2);
+
     //unbind VAO
     glBindVertexArray(0);
-}
\ No newline at end of file
+}
@@ -25,60 +25,21 @@ int main(int argc, char** argv) {
         return 1;
     }
 
-    // Timing variables - calculate delta time each frame
-    float dt = 0.0f;
-    auto lastTime = std::chrono::high_resolution_clock::now();
-    float CameraSpeed = 5.0f;
-    float lastX = 0.0f;
-    float lastY = 0.0f;
+    // Batch animation renders run to completion without a frame loop
+    if (!engine->GetConfig().animationPath.empty()) {
+        bool bRendered = engine->RenderAnimation();
+        delete engine;
+        return bRendered ? 0 : 1;
+    }
 
+    // The engine runs the fixed-step simulation; the pacer decides when a frame starts
     while (!engine->GetWindow()->ShouldClose()) 
     {
-        auto thisTime = std::chrono::high_resolution_clock::now();
-        dt = std::chrono::duration<float>(thisTime - lastTime).count();
-        lastTime = thisTime;
-        #ifndef __EMSCRIPTEN__
+        float dt = engine->WaitForNextFrame();
         if(engine->GetKeyboard()->IsButtonDown(GLFW_KEY_ESCAPE)) {
             engine->GetWindow()->Close();
         }
-        if(engine->GetKeyboard()->IsButtonDown(GLFW_KEY_W)) {
-            engine->GetCamera()->moveForward(CameraSpeed * dt);
-        }
-        if(engine->GetKeyboard()->IsButtonDown(GLFW_KEY_S)) {
-            engine->GetCamera()->moveBackward(CameraSpeed * dt);
-        }
-        if(engine->GetKeyboard()->IsButtonDown(GLFW_KEY_A)) {
-            engine->GetCamera()->moveLeft(CameraSpeed * dt);
-        }
-        if(engine->GetKeyboard()->IsButtonDown(GLFW_KEY_D)) {
-            engine->GetCamera()->moveRight(CameraSpeed * dt);
-        }
-        if(engine->GetKeyboard()->IsButtonDown(GLFW_KEY_Q)) {
-            engine->GetCamera()->moveUp(CameraSpeed * dt);
-        }
-        if(engine->GetKeyboard()->IsButtonDown(GLFW_KEY_E)) {
-            engine->GetCamera()->moveDown(CameraSpeed * dt);
-        }
-
-        if(engine->GetMouse()->IsButtonPressed(GLFW_MOUSE_BUTTON_RIGHT)) 
-        {
-            lastX = engine->GetMouse()->GetX();
-            lastY = engine->GetMouse()->GetY();
-        }
-        if(engine->GetMouse()->IsButtonDown(GLFW_MOUSE_BUTTON_RIGHT)) 
-        {
-            float xpos = engine->GetMouse()->GetX();
-            float ypos = engine->GetMouse()->GetY();
-            float xoffset = lastX - xpos;
-            float yoffset = lastY - ypos;
-            lastX = xpos;
-            lastY = ypos;
-            engine->GetCamera()->rotateYaw(xoffset * 1.0f * dt);
-            engine->GetCamera()->rotatePitch(yoffset * 1.0f * dt);
-        }
-        #endif
-        engine->Update(dt);
-        engine->Render();
+        engine->Frame(dt);
     }
     
     delete engine;
@@ -95,8 +56,10 @@ bool init(int argc, char** argv) {
         return false;
     }
 
-    // Set up resize callback
-    glfwSetWindowSizeCallback(engine->GetWindow()->GetWindow(), resizeCallback);
+    // Set up resize callback, headless runs have no GLFW window
+    if (engine->GetWindow()->GetWindow()) {
+        glfwSetWindowSizeCallback(engine->GetWindow()->GetWindow(), resizeCallback);
+    }
 
     return true;
 }
@@ -108,12 +71,10 @@ void resizeCallback(GLFWwindow* window, int width, int height) {
             std::cerr << "Window is nullptr in resizeCallback" << std::endl;
             return;
         }
-        // Update viewport
-        glViewport(0, 0, width, height);
-        
-        // Update camera aspect ratio
-        if (engine && engine->GetCamera()) {
-            engine->GetCamera()->setPerspective(45.0f, (float)width / (float)height, 0.1f, 100.0f);
+        // The engine owns the viewport; with a render thread there is no
+        // context on this thread to call glViewport on
+        if (engine) {
+            engine->HandleResize(width, height);
         }
     }
 }
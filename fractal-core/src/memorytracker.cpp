@@ -0,0 +1,182 @@
+// memorytracker.cpp
+
+// C standard library
+#include <cstdlib>
+
+// C++ standard library
+#include <atomic>
+#include <new>
+
+// local headers
+#include "memorytracker.h"
+
+namespace {
+constexpr size_t TAG_COUNT = (size_t)MemoryTag::Count;
+
+// Constant initialised, so allocations made before main() are safe to count
+thread_local MemoryTag currentTag = MemoryTag::Untagged;
+
+std::atomic<uint64_t> frameAllocations[TAG_COUNT];
+std::atomic<uint64_t> frameBytes[TAG_COUNT];
+std::atomic<uint64_t> lastFrameAllocations[TAG_COUNT];
+std::atomic<uint64_t> lastFrameBytes[TAG_COUNT];
+std::atomic<uint64_t> totalAllocations;
+
+void* Allocate(size_t size)
+{
+    MemoryTracker::RecordAllocation(size);
+    return std::malloc(size ? size : 1);
+}
+
+void* AllocateAligned(size_t size, std::align_val_t alignment)
+{
+    MemoryTracker::RecordAllocation(size);
+    // aligned_alloc wants the size to be a multiple of the alignment
+    size_t align = (size_t)alignment;
+    size_t rounded = (size + align - 1) / align * align;
+    return std::aligned_alloc(align, rounded ? rounded : align);
+}
+}
+
+const char* MemoryTagToString(MemoryTag tag)
+{
+    switch (tag) {
+        case MemoryTag::Untagged: return "Untagged";
+        case MemoryTag::Simulation: return "Simulation";
+        case MemoryTag::FramePacket: return "FramePacket";
+        case MemoryTag::Render: return "Render";
+        case MemoryTag::Assets: return "Assets";
+        default: return "Unknown";
+    }
+}
+
+void MemoryTracker::EndFrame()
+{
+    for (size_t i = 0; i < TAG_COUNT; i++) {
+        lastFrameAllocations[i].store(frameAllocations[i].exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+        lastFrameBytes[i].store(frameBytes[i].exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+}
+
+uint64_t MemoryTracker::GetFrameAllocations(MemoryTag tag)
+{
+    return lastFrameAllocations[(size_t)tag].load(std::memory_order_relaxed);
+}
+
+uint64_t MemoryTracker::GetFrameBytes(MemoryTag tag)
+{
+    return lastFrameBytes[(size_t)tag].load(std::memory_order_relaxed);
+}
+
+uint64_t MemoryTracker::GetFrameAllocations()
+{
+    uint64_t sum = 0;
+    for (size_t i = 0; i < TAG_COUNT; i++) {
+        sum += lastFrameAllocations[i].load(std::memory_order_relaxed);
+    }
+    return sum;
+}
+
+uint64_t MemoryTracker::GetFrameBytes()
+{
+    uint64_t sum = 0;
+    for (size_t i = 0; i < TAG_COUNT; i++) {
+        sum += lastFrameBytes[i].load(std::memory_order_relaxed);
+    }
+    return sum;
+}
+
+uint64_t MemoryTracker::GetTotalAllocations()
+{
+    return totalAllocations.load(std::memory_order_relaxed);
+}
+
+MemoryTag MemoryTracker::GetCurrentTag()
+{
+    return currentTag;
+}
+
+void MemoryTracker::SetCurrentTag(MemoryTag tag)
+{
+    currentTag = tag;
+}
+
+void MemoryTracker::RecordAllocation(size_t size)
+{
+    size_t tag = (size_t)currentTag;
+    frameAllocations[tag].fetch_add(1, std::memory_order_relaxed);
+    frameBytes[tag].fetch_add(size, std::memory_order_relaxed);
+    totalAllocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Replacement global allocation functions. Everything goes through malloc and
+// free; the sized and aligned deletes only exist to match the news.
+
+void* operator new(size_t size)
+{
+    void* pointer = Allocate(size);
+    if (!pointer) {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void* operator new[](size_t size)
+{
+    void* pointer = Allocate(size);
+    if (!pointer) {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    return Allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return Allocate(size);
+}
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+    void* pointer = AllocateAligned(size, alignment);
+    if (!pointer) {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+    void* pointer = AllocateAligned(size, alignment);
+    if (!pointer) {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return AllocateAligned(size, alignment);
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return AllocateAligned(size, alignment);
+}
+
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+void operator delete[](void* pointer) noexcept { std::free(pointer); }
+void operator delete(void* pointer, size_t) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, size_t) noexcept { std::free(pointer); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::align_val_t) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, std::align_val_t) noexcept { std::free(pointer); }
+void operator delete(void* pointer, size_t, std::align_val_t) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, size_t, std::align_val_t) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::align_val_t, const std::nothrow_t&) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, std::align_val_t, const std::nothrow_t&) noexcept { std::free(pointer); }
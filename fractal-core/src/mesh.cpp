@@ -9,9 +9,11 @@
 #include "assetutils.h"
 #include "mesh.h"
 #include "TextureManager.h"
+#include "profiler.h"
 
 Mesh::Mesh(const std::string& filename) 
     : albedo(1.0f, 0.0f, 1.0f), metallic(0.0f), roughness(0.5f), ao(1.0f) {
+    PROFILE_ZONE("Mesh::Load");
     
     // Resolve the full path using AssetUtils
     std::string filepath = AssetUtils::resolveModelPath(filename);
@@ -29,10 +31,41 @@ Mesh::Mesh(const std::string& filename)
     }
     
     ProcessNode(scene->mRootNode, scene);
+    ComputeBounds();
     SetupMesh();
 }
 
+Mesh::Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices)
+    : vertices(std::move(vertices)), indices(std::move(indices)),
+      albedo(1.0f, 1.0f, 1.0f), metallic(0.0f), roughness(0.5f), ao(1.0f) {
+    if (this->vertices.empty()) {
+        return;
+    }
+    ComputeBounds();
+    SetupMesh();
+}
+
+void Mesh::ComputeBounds() {
+    if (vertices.empty()) {
+        return;
+    }
+
+    // Sphere around the AABB; looser than a minimal sphere but cheap to test
+    glm::vec3 minPos = vertices[0].position;
+    glm::vec3 maxPos = vertices[0].position;
+    for (const Vertex& vertex : vertices) {
+        minPos = glm::min(minPos, vertex.position);
+        maxPos = glm::max(maxPos, vertex.position);
+    }
+    boundsCenter = (minPos + maxPos) * 0.5f;
+    boundsRadius = glm::length(maxPos - boundsCenter);
+}
+
 Mesh::~Mesh() {
+    if (IsPooled()) {
+        GeometryPool::GetInstance()->Remove(poolHandle);
+        return;
+    }
     glDeleteVertexArrays(1, &VAO);
     glDeleteBuffers(1, &VBO);
     glDeleteBuffers(1, &EBO);
@@ -168,6 +201,11 @@ void Mesh::ProcessMesh(aiMesh* mesh, const aiScene* scene) {
 
 void Mesh::SetupMesh() 
 {
+    poolHandle = GeometryPool::GetInstance()->Add(vertices, indices);
+    if (IsPooled()) {
+        return;
+    }
+
     glGenVertexArrays(1, &VAO);
     glGenBuffers(1, &VBO);
     glGenBuffers(1, &EBO);
@@ -179,6 +217,8 @@ void Mesh::SetupMesh()
     
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+    Profiler::CountUpload(vertices.size() * sizeof(Vertex));
+    Profiler::CountUpload(indices.size() * sizeof(unsigned int));
     
     // Position attribute
     glEnableVertexAttribArray(0);
@@ -205,9 +245,15 @@ void Mesh::SetupMesh()
 
 void Mesh::Draw() const 
 {
+    if (IsPooled()) {
+        GeometryPool::GetInstance()->Draw(GetPoolRange());
+        return;
+    }
     glBindVertexArray(VAO);
     glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
     glBindVertexArray(0);
+    Profiler::Count(ProfileCounter::StateChanges);
+    Profiler::CountDraw(indices.size() / 3);
 }
 
 
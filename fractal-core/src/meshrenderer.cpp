@@ -1,12 +1,25 @@
 #include "meshrenderer.h"
 #include <iostream>
+#include <algorithm>
 #include "glreq.h"
+#include "framearena.h"
+#include "profiler.h"
+#include "shadowcache.h"
+#include <cmath>
+#include <cstring>
 #include <glm/gtc/type_ptr.hpp>
 
+namespace {
+// Fills the light slots no scene light uses without contributing anything
+Light UnusedLight() {
+    return Light(Light::Type::Point, glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f), 0.0f);
+}
+}
+
 MeshRenderer::MeshRenderer() {
     // Initialize with default lights
-    m_lights.resize(4);
-    for (int i = 0; i < 4; i++) {
+    m_lights.resize(m_lightCount);
+    for (int i = 0; i < m_lightCount; i++) {
         m_lights[i] = Light();
     }
 }
@@ -17,19 +30,27 @@ MeshRenderer::~MeshRenderer() {
 
 void MeshRenderer::SetMesh(Mesh* mesh) {
     m_mesh = mesh;
+    SelectShaderVariant();
+    SubmitLightVariants();
 }
 
 void MeshRenderer::AddInstance(const MeshInstance& instance) {
     m_instances.push_back(instance);
+    m_instances.back().normalMatrix = glm::transpose(glm::inverse(glm::mat3(instance.transform)));
+    m_instanceVersion++;
 }
 
 void MeshRenderer::ClearInstances() {
     m_instances.clear();
+    m_movedInstances.clear();
+    m_instanceVersion++;
 }
 
 void MeshRenderer::SetTransform(long unsigned int instanceIndex, const glm::mat4& transform) {
     if (instanceIndex < m_instances.size()) {
         m_instances[instanceIndex].transform = transform;
+        m_instances[instanceIndex].normalMatrix = glm::transpose(glm::inverse(glm::mat3(transform)));
+        m_movedInstances.push_back(instanceIndex);
     }
 }
 
@@ -43,20 +64,41 @@ void MeshRenderer::SetMaterial(long unsigned int instanceIndex, const glm::vec3&
 }
 
 void MeshRenderer::SetLights(const std::vector<Light>& lights) {
-    m_lights = lights;
-    if (m_lights.size() != 4) {
-        m_lights.resize(4);
+    int lightCount = GetLightBucket(lights.size());
+    if (lights.size() > (size_t)MAX_LIGHTS && m_requestedLightCount != lightCount) {
+        std::cerr << "MeshRenderer: " << lights.size() << " lights exceed MAX_LIGHTS, using the first " << MAX_LIGHTS << std::endl;
     }
+
+    m_lights.assign(lights.begin(), lights.begin() + std::min(lights.size(), (size_t)lightCount));
+    // Unused slots must not contribute any light
+    m_lights.resize(std::max(lightCount, m_lightCount), UnusedLight());
+
+    if (lightCount != m_requestedLightCount) {
+        m_requestedLightCount = lightCount;
+        SubmitLightVariants();
+    }
+    UpdateLightCount();
 }
 
 void MeshRenderer::SetLight(int index, const Light& light) {
-    if (index >= 0 && index < 4) {
+    if (index >= 0 && index < m_lightCount) {
         m_lights[index] = light;
     }
 }
 
+void MeshRenderer::SetShadows(const ShadowSampling* sampling, GLuint shadowTexture) {
+    m_shadowSampling = sampling;
+    m_shadowTexture = shadowTexture;
+}
+
 void MeshRenderer::Render(const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix, const glm::vec3& viewPos) {
-    if (!m_mesh) return;
+    Render(m_instances, viewMatrix, projectionMatrix, viewPos);
+}
+
+void MeshRenderer::Render(const std::vector<MeshInstance>& instances, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix, const glm::vec3& viewPos) {
+    if (!m_mesh || !m_shaderVariants) return;
+    PROFILE_ZONE("MeshRenderer::Render");
+    PROFILE_GPU_ZONE("MeshRenderer");
 
     if(bFirstRender) {
         bFirstRender = false;
@@ -67,16 +109,93 @@ void MeshRenderer::Render(const glm::mat4& viewMatrix, const glm::mat4& projecti
             }
         }
     }
-    
-    m_shaderProgram.Use();
-    
-    // Set view position
-    glUniform3fv(glGetUniformLocation(m_shaderProgram.programId, "viewPos"), 1, glm::value_ptr(viewPos));
-    
-    // Set light uniforms
-    SetLightUniforms();
 
-    std::vector<const char*> textureNames = {
+    UpdateLightCount();
+
+    // Camera and lights for the whole pass; the binding point outlives program switches
+    StreamAllocation frameBlock = WriteFrameBlock(viewMatrix, projectionMatrix, viewPos);
+    if (!frameBlock.IsValid()) return;
+    glBindBufferRange(GL_UNIFORM_BUFFER, FRAME_DATA_BINDING, frameBlock.buffer, frameBlock.offset, frameBlock.size);
+
+    if (IsShadowing()) {
+        StreamBuffer* stream = StreamBuffer::GetInstance();
+        StreamAllocation shadowBlock = stream->Allocate(sizeof(ShadowSampling), stream->GetUniformAlignment());
+        if (!shadowBlock.IsValid()) return;
+        memcpy(shadowBlock.data, m_shadowSampling, sizeof(ShadowSampling));
+        stream->Flush(shadowBlock);
+        glBindBufferRange(GL_UNIFORM_BUFFER, SHADOW_DATA_BINDING, shadowBlock.buffer, shadowBlock.offset, shadowBlock.size);
+
+        glActiveTexture(GL_TEXTURE0 + SHADOW_MAP_UNIT);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, m_shadowTexture);
+        Profiler::Count(ProfileCounter::StateChanges);
+    }
+
+    if (instances.empty()) return;
+    BuildBatches(instances);
+
+    for (size_t b = 0; b < m_batchCount; b++) {
+        const Batch& batch = m_batches[b];
+        ShaderProgram* shader = GetVariant(batch.material);
+        if (!shader) continue;
+        shader->Use();
+        Profiler::Count(ProfileCounter::StateChanges);
+        BindUniformBlocks(shader);
+        BindTextures(shader, batch.material);
+
+        if (batch.material->IsPooled() && GeometryPool::GetInstance()->IsBatching()) {
+            DrawPooled(batch);
+        }
+        else {
+            DrawWithInstanceBlocks(batch);
+        }
+    }
+}
+
+bool MeshRenderer::SameMaterial(const Mesh* a, const Mesh* b) {
+    if (a == b) return true;
+    return a->IsPooled() == b->IsPooled() && memcmp(a->textureIndex, b->textureIndex, sizeof(a->textureIndex)) == 0;
+}
+
+void MeshRenderer::BuildBatches(const std::vector<MeshInstance>& instances) {
+    // At most one batch per instance; both arrays go away with the frame
+    FrameArena& arena = FrameArena::GetThreadArena();
+    m_sortedInstances = arena.AllocateArray<const MeshInstance*>(instances.size());
+    m_batches = arena.AllocateArray<Batch>(instances.size());
+    m_sortedCount = 0;
+    m_batchCount = 0;
+
+    bool bSingleMesh = true;
+    for (const MeshInstance& instance : instances) {
+        if (!MeshOf(instance)) continue;
+        bSingleMesh = bSingleMesh && MeshOf(instance) == MeshOf(instances.front());
+        m_sortedInstances[m_sortedCount++] = &instance;
+    }
+    if (m_sortedCount == 0) return;
+
+    // Group by material first so each variant and texture set is bound once,
+    // then by mesh so every mesh's instances are contiguous within a batch
+    if (!bSingleMesh) {
+        std::sort(m_sortedInstances, m_sortedInstances + m_sortedCount, [this](const MeshInstance* a, const MeshInstance* b) {
+            const Mesh* meshA = MeshOf(*a);
+            const Mesh* meshB = MeshOf(*b);
+            if (meshA->IsPooled() != meshB->IsPooled()) return meshA->IsPooled() < meshB->IsPooled();
+            int order = memcmp(meshA->textureIndex, meshB->textureIndex, sizeof(meshA->textureIndex));
+            if (order != 0) return order < 0;
+            return std::less<const Mesh*>()(meshA, meshB);
+        });
+    }
+
+    for (size_t i = 0; i < m_sortedCount; i++) {
+        const Mesh* mesh = MeshOf(*m_sortedInstances[i]);
+        if (m_batchCount == 0 || !SameMaterial(m_batches[m_batchCount - 1].material, mesh)) {
+            m_batches[m_batchCount++] = { i, i, mesh };
+        }
+        m_batches[m_batchCount - 1].end = i + 1;
+    }
+}
+
+void MeshRenderer::BindTextures(ShaderProgram* shader, const Mesh* mesh) {
+    static const char* textureNames[(unsigned long)TextureType::MAX_TEXTURE_TYPES] = {
         "albedoMap",
         "normalMap",
         "metallicMap",
@@ -85,33 +204,90 @@ void MeshRenderer::Render(const glm::mat4& viewMatrix, const glm::mat4& projecti
     };
 
     for(unsigned int i = 0; i < (unsigned long)TextureType::MAX_TEXTURE_TYPES; i++) {
-        if(m_mesh->textureIndex[i] != 0) {
+        if(mesh->textureIndex[i] != 0) {
             glActiveTexture(GL_TEXTURE0 + i);
-            glBindTexture(GL_TEXTURE_2D, m_mesh->textureIndex[i]);
-            glUniform1i(glGetUniformLocation(m_shaderProgram.programId, textureNames[i]), i);
+            glBindTexture(GL_TEXTURE_2D, mesh->textureIndex[i]);
+            Profiler::Count(ProfileCounter::StateChanges);
+            glUniform1i(glGetUniformLocation(shader->programId, textureNames[i]), i);
+        }
+    }
+}
+
+void MeshRenderer::DrawPooled(const Batch& batch) {
+    // One instance attribute stream for the batch, one draw entry per mesh
+    StreamBuffer* stream = StreamBuffer::GetInstance();
+    StreamAllocation instanceData = stream->Allocate(sizeof(InstanceVertex) * (batch.end - batch.begin));
+    if (!instanceData.IsValid()) return;
+
+    GeometryDraw* draws = FrameArena::GetThreadArena().AllocateArray<GeometryDraw>(batch.end - batch.begin);
+    size_t drawCount = 0;
+    const Mesh* drawMesh = nullptr;
+    for (size_t i = batch.begin; i < batch.end; i++) {
+        const MeshInstance& instance = *m_sortedInstances[i];
+        WriteInstanceVertex(instance, instanceData.data + (i - batch.begin) * sizeof(InstanceVertex));
+
+        if (MeshOf(instance) != drawMesh) {
+            drawMesh = MeshOf(instance);
+            GeometryDraw draw;
+            draw.range = drawMesh->GetPoolRange();
+            draw.baseInstance = (GLuint)(i - batch.begin);
+            draws[drawCount++] = draw;
         }
+        draws[drawCount - 1].instanceCount++;
+    }
+    stream->Flush(instanceData);
+
+    GeometryPool::GetInstance()->DrawBatch(draws, drawCount, instanceData);
+}
+
+void MeshRenderer::DrawWithInstanceBlocks(const Batch& batch) {
+    // Every instance block is written up front in one allocation, so the
+    // fallback path uploads once per batch instead of once per draw
+    StreamBuffer* stream = StreamBuffer::GetInstance();
+    size_t stride = AlignUp(sizeof(InstanceBlock), stream->GetUniformAlignment());
+    StreamAllocation instanceBlocks = stream->Allocate(stride * (batch.end - batch.begin), stream->GetUniformAlignment());
+    if (!instanceBlocks.IsValid()) return;
+    for (size_t i = batch.begin; i < batch.end; i++) {
+        WriteInstanceBlock(*m_sortedInstances[i], instanceBlocks.data + (i - batch.begin) * stride);
     }
+    stream->Flush(instanceBlocks);
     
     // Render each instance
-    for (const auto& instance : m_instances) {
-        // Set material uniforms
-        SetMaterialUniforms(instance);
-        
-        // Set matrix uniforms
-        SetMatrixUniforms(instance.transform, viewMatrix, projectionMatrix);
-        
-        
+    for (size_t i = batch.begin; i < batch.end; i++) {
+        glBindBufferRange(GL_UNIFORM_BUFFER, INSTANCE_DATA_BINDING, instanceBlocks.buffer, instanceBlocks.offset + (i - batch.begin) * stride, sizeof(InstanceBlock));
 
         // Draw mesh
-        m_mesh->Draw();
+        MeshOf(*m_sortedInstances[i])->Draw();
     }
 }
 
 bool MeshRenderer::LoadShaders(const std::string& vertexPath, const std::string& fragmentPath) {
     try {
-        m_shaderProgram.AttachShaderFromFile(vertexPath.c_str(), GL_VERTEX_SHADER);
-        m_shaderProgram.AttachShaderFromFile(fragmentPath.c_str(), GL_FRAGMENT_SHADER);
-        m_shaderProgram.Link();
+        m_shaderVariants = std::make_unique<ShaderVariantCache>(vertexPath, fragmentPath);
+        m_variantLookup.clear();
+        m_blocksBoundShaders.clear();
+        m_requestedVariants.clear();
+
+        // Warm up the untextured and fully textured variants so neither hitches on first use
+        ShaderDefines untextured;
+        untextured.Set("NUM_LIGHTS", NUM_LIGHTS);
+        ShaderDefines fullyTextured = untextured;
+        fullyTextured.Set("HAS_ALBEDO_MAP").Set("HAS_NORMAL_MAP").Set("HAS_METALLIC_MAP").Set("HAS_ROUGHNESS_MAP").Set("HAS_AO_MAP");
+        std::vector<ShaderDefines> warmUp = { untextured, fullyTextured };
+        if (GeometryPool::GetInstance()->IsBatching()) {
+            warmUp.push_back(ShaderDefines(untextured).Set("USE_INSTANCE_ATTRIBUTES"));
+            warmUp.push_back(ShaderDefines(fullyTextured).Set("USE_INSTANCE_ATTRIBUTES"));
+        }
+        if (m_bShadowsEnabled) {
+            size_t unshadowed = warmUp.size();
+            for (size_t i = 0; i < unshadowed; i++) {
+                warmUp.push_back(ShaderDefines(warmUp[i]).Set("USE_SHADOWS"));
+            }
+        }
+        m_shaderVariants->WarmUp(warmUp);
+
+        SelectShaderVariant();
+        SubmitLightVariants();
         return true;
     } catch (...) {
         return false;
@@ -119,29 +295,189 @@ bool MeshRenderer::LoadShaders(const std::string& vertexPath, const std::string&
 }
 
 void MeshRenderer::UseShader() {
-    m_shaderProgram.Use();
+    if (m_activeShader) {
+        m_activeShader->Use();
+    }
+}
+
+int MeshRenderer::GetLightBucket(size_t lightCount) {
+    // Power of two buckets keep the number of variants small
+    int bucket = NUM_LIGHTS;
+    while (bucket < MAX_LIGHTS && (size_t)bucket < lightCount) {
+        bucket *= 2;
+    }
+    return bucket;
+}
+
+ShaderDefines MeshRenderer::GetMeshDefines(const Mesh* mesh, int lightCount, bool bShadows) {
+    static const char* textureDefines[(unsigned long)TextureType::MAX_TEXTURE_TYPES] = {
+        "HAS_ALBEDO_MAP",
+        "HAS_NORMAL_MAP",
+        "HAS_METALLIC_MAP",
+        "HAS_ROUGHNESS_MAP",
+        "HAS_AO_MAP"
+    };
+
+    ShaderDefines defines;
+    defines.Set("NUM_LIGHTS", lightCount);
+    if (bShadows) {
+        defines.Set("USE_SHADOWS");
+    }
+    if (mesh) {
+        for(unsigned int i = 0; i < (unsigned long)TextureType::MAX_TEXTURE_TYPES; i++) {
+            if(mesh->textureIndex[i] != 0) {
+                defines.Set(textureDefines[i]);
+            }
+        }
+        if (mesh->IsPooled() && GeometryPool::GetInstance()->IsBatching()) {
+            defines.Set("USE_INSTANCE_ATTRIBUTES");
+        }
+    }
+    return defines;
+}
+
+uint32_t MeshRenderer::GetVariantKey(const Mesh* mesh, int lightCount, bool bShadows) {
+    // Same inputs as GetMeshDefines: one bit per texture map, one each for
+    // shadows and instance attributes, the light count above them
+    uint32_t key = (uint32_t)lightCount << 8;
+    if (bShadows) {
+        key |= 1u << 6;
+    }
+    if (mesh) {
+        for(unsigned int i = 0; i < (unsigned long)TextureType::MAX_TEXTURE_TYPES; i++) {
+            if(mesh->textureIndex[i] != 0) {
+                key |= 1u << i;
+            }
+        }
+        if (mesh->IsPooled() && GeometryPool::GetInstance()->IsBatching()) {
+            key |= 1u << 7;
+        }
+    }
+    return key;
 }
 
-void MeshRenderer::SetMaterialUniforms(const MeshInstance& instance) {
-    glUniform3fv(glGetUniformLocation(m_shaderProgram.programId, "albedo"), 1, glm::value_ptr(instance.albedo));
-    glUniform1f(glGetUniformLocation(m_shaderProgram.programId, "metallic"), instance.metallic);
-    glUniform1f(glGetUniformLocation(m_shaderProgram.programId, "roughness"), instance.roughness);
-    glUniform1f(glGetUniformLocation(m_shaderProgram.programId, "ao"), instance.ao);
+ShaderProgram* MeshRenderer::GetVariant(const Mesh* mesh) {
+    bool bShadows = IsShadowing();
+    uint32_t key = GetVariantKey(mesh, m_lightCount, bShadows);
+    auto found = m_variantLookup.find(key);
+    if (found != m_variantLookup.end()) {
+        return found->second;
+    }
+    ShaderProgram* shader = m_shaderVariants->Get(GetMeshDefines(mesh, m_lightCount, bShadows));
+    m_variantLookup[key] = shader;
+    return shader;
+}
+
+void MeshRenderer::SubmitLightVariants() {
+    m_requestedVariants.clear();
+    if (!m_shaderVariants || m_requestedLightCount == m_lightCount) return;
+    // Each variant drawn so far, with the new light count; the frame block layout
+    // follows the light count, so they all switch together
+    for (const auto& entry : m_variantLookup) {
+        if ((entry.first >> 8) != (uint32_t)m_lightCount) continue;
+        ShaderDefines defines = entry.second->GetDefines();
+        defines.Set("NUM_LIGHTS", m_requestedLightCount);
+        m_requestedVariants.push_back(m_shaderVariants->Get(defines));
+    }
+    m_requestedVariants.push_back(m_shaderVariants->Get(GetMeshDefines(m_mesh, m_requestedLightCount)));
+}
+
+void MeshRenderer::UpdateLightCount() {
+    if (m_requestedLightCount == m_lightCount) return;
+    // Before the first frame there is nothing to keep on screen, so Use() may as well wait
+    if (!bFirstRender) {
+        for (ShaderProgram* shader : m_requestedVariants) {
+            if (!shader->IsReady()) return;
+        }
+    }
+    m_lightCount = m_requestedLightCount;
+    m_lights.resize(m_lightCount, UnusedLight());
+    m_requestedVariants.clear();
+    SelectShaderVariant();
+}
+
+void MeshRenderer::SelectShaderVariant() {
+    // Compiles the mesh's variant at load time if it wasn't part of the warm-up list
+    if (!m_shaderVariants) return;
+    m_activeShader = m_shaderVariants->Get(GetMeshDefines(m_mesh, m_lightCount));
+}
+
+size_t MeshRenderer::AlignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
 }
 
-void MeshRenderer::SetLightUniforms() {
-    for (int i = 0; i < 4; i++) {
-        std::string posName = "lightPositions[" + std::to_string(i) + "]";
-        std::string colorName = "lightColors[" + std::to_string(i) + "]";
-        glUniform3fv(glGetUniformLocation(m_shaderProgram.programId, posName.c_str()), 1, 
-                    glm::value_ptr(m_lights[i].getPosition()));
-        glUniform3fv(glGetUniformLocation(m_shaderProgram.programId, colorName.c_str()), 1, 
-                    glm::value_ptr(m_lights[i].getColor() * m_lights[i].getIntensity()));
+void MeshRenderer::BindUniformBlocks(ShaderProgram* shader) {
+    // Block bindings are program state, set once per variant
+    if (std::find(m_blocksBoundShaders.begin(), m_blocksBoundShaders.end(), shader) != m_blocksBoundShaders.end()) return;
+    GLuint program = shader->programId;
+    GLuint frameIndex = glGetUniformBlockIndex(program, "FrameData");
+    if (frameIndex != GL_INVALID_INDEX) {
+        glUniformBlockBinding(program, frameIndex, FRAME_DATA_BINDING);
     }
+    GLuint instanceIndex = glGetUniformBlockIndex(program, "InstanceData");
+    if (instanceIndex != GL_INVALID_INDEX) {
+        glUniformBlockBinding(program, instanceIndex, INSTANCE_DATA_BINDING);
+    }
+    GLuint shadowIndex = glGetUniformBlockIndex(program, "ShadowData");
+    if (shadowIndex != GL_INVALID_INDEX) {
+        glUniformBlockBinding(program, shadowIndex, SHADOW_DATA_BINDING);
+        glUniform1i(glGetUniformLocation(program, "shadowMap"), SHADOW_MAP_UNIT);
+    }
+    m_blocksBoundShaders.push_back(shader);
+}
+
+StreamAllocation MeshRenderer::WriteFrameBlock(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& viewPos) {
+    // std140: header, then lightPositions, lightColors and lightDirections, m_lightCount vec4s each
+    static_assert(sizeof(FrameBlockHeader) == 144, "FrameBlockHeader must match the std140 FrameData layout");
+    StreamBuffer* stream = StreamBuffer::GetInstance();
+    size_t size = sizeof(FrameBlockHeader) + sizeof(glm::vec4) * 3 * m_lightCount;
+    StreamAllocation block = stream->Allocate(size, stream->GetUniformAlignment());
+    if (!block.IsValid()) return block;
+
+    FrameBlockHeader header;
+    header.view = view;
+    header.projection = projection;
+    header.viewPos = glm::vec4(viewPos, 1.0f);
+    memcpy(block.data, &header, sizeof(header));
+
+    unsigned char* positions = block.data + sizeof(FrameBlockHeader);
+    unsigned char* colors = positions + sizeof(glm::vec4) * m_lightCount;
+    unsigned char* directions = colors + sizeof(glm::vec4) * m_lightCount;
+    for (int i = 0; i < m_lightCount; i++) {
+        const Light& light = m_lights[i];
+        // Spot cones fade over the outer fifth of their half-angle
+        float halfAngle = glm::radians(light.getSpotAngle() * 0.5f);
+        glm::vec4 position(light.getPosition(), (float)light.getType());
+        glm::vec4 color(light.getColor() * light.getIntensity(), std::cos(halfAngle * 0.8f));
+        glm::vec4 direction(light.getDirection(), std::cos(halfAngle));
+        memcpy(positions + i * sizeof(glm::vec4), &position, sizeof(position));
+        memcpy(colors + i * sizeof(glm::vec4), &color, sizeof(color));
+        memcpy(directions + i * sizeof(glm::vec4), &direction, sizeof(direction));
+    }
+    stream->Flush(block);
+    return block;
+}
+
+void MeshRenderer::WriteInstanceBlock(const MeshInstance& instance, unsigned char* destination) {
+    // Built on the stack and copied, the destination may be write-combined memory
+    static_assert(sizeof(InstanceBlock) == 144, "InstanceBlock must match the std140 InstanceData layout");
+    InstanceBlock block;
+    block.model = instance.transform;
+    for (int column = 0; column < 3; column++) {
+        block.normalMatrix[column] = glm::vec4(instance.normalMatrix[column], 0.0f);
+    }
+    block.albedoMetallic = glm::vec4(instance.albedo, instance.metallic);
+    block.roughnessAo = glm::vec4(instance.roughness, instance.ao, 0.0f, 0.0f);
+    memcpy(destination, &block, sizeof(block));
 }
 
-void MeshRenderer::SetMatrixUniforms(const glm::mat4& model, const glm::mat4& view, const glm::mat4& projection) {
-    glUniformMatrix4fv(glGetUniformLocation(m_shaderProgram.programId, "model"), 1, GL_FALSE, glm::value_ptr(model));
-    glUniformMatrix4fv(glGetUniformLocation(m_shaderProgram.programId, "view"), 1, GL_FALSE, glm::value_ptr(view));
-    glUniformMatrix4fv(glGetUniformLocation(m_shaderProgram.programId, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-} 
\ No newline at end of file
+void MeshRenderer::WriteInstanceVertex(const MeshInstance& instance, unsigned char* destination) {
+    InstanceVertex vertex;
+    vertex.model = instance.transform;
+    for (int column = 0; column < 3; column++) {
+        vertex.normalMatrix[column] = instance.normalMatrix[column];
+    }
+    vertex.albedoMetallic = glm::vec4(instance.albedo, instance.metallic);
+    vertex.roughnessAo = glm::vec2(instance.roughness, instance.ao);
+    memcpy(destination, &vertex, sizeof(vertex));
+}
@@ -0,0 +1,141 @@
+// pngencoder.cpp
+
+// C++ standard library
+#include <cstdlib>
+#include <cstring>
+
+// zlib
+#include <zlib.h>
+
+// local headers
+#include "pngencoder.h"
+
+namespace {
+const int CHANNELS = 3;
+const int FILTER_COUNT = 5;
+
+void PutUint32(std::vector<uint8_t>& out, uint32_t value)
+{
+    out.push_back((uint8_t)(value >> 24));
+    out.push_back((uint8_t)(value >> 16));
+    out.push_back((uint8_t)(value >> 8));
+    out.push_back((uint8_t)value);
+}
+
+void PutChunk(std::vector<uint8_t>& out, const char* type, const uint8_t* data, size_t size)
+{
+    PutUint32(out, (uint32_t)size);
+    size_t start = out.size();
+    out.insert(out.end(), type, type + 4);
+    if (size > 0) {
+        out.insert(out.end(), data, data + size);
+    }
+    // The CRC covers the type and the data
+    uint32_t crc = (uint32_t)crc32(0L, out.data() + start, (uInt)(size + 4));
+    PutUint32(out, crc);
+}
+
+uint8_t Paeth(int a, int b, int c)
+{
+    int p = a + b - c;
+    int pa = std::abs(p - a);
+    int pb = std::abs(p - b);
+    int pc = std::abs(p - c);
+    if (pa <= pb && pa <= pc) {
+        return (uint8_t)a;
+    }
+    return (uint8_t)(pb <= pc ? b : c);
+}
+
+// Filters row against the row above (zeros for the first) into out
+void FilterRow(int filter, const uint8_t* row, const uint8_t* above, size_t size, uint8_t* out)
+{
+    for (size_t i = 0; i < size; i++) {
+        int left = i >= CHANNELS ? row[i - CHANNELS] : 0;
+        int up = above[i];
+        int upLeft = i >= CHANNELS ? above[i - CHANNELS] : 0;
+        int predicted = 0;
+        switch (filter) {
+            case 1: predicted = left; break;
+            case 2: predicted = up; break;
+            case 3: predicted = (left + up) / 2; break;
+            case 4: predicted = Paeth(left, up, upLeft); break;
+        }
+        out[i] = (uint8_t)(row[i] - predicted);
+    }
+}
+
+// The usual heuristic: residuals read as signed bytes, smallest sum of magnitudes wins
+uint64_t ResidualCost(const uint8_t* filtered, size_t size)
+{
+    uint64_t cost = 0;
+    for (size_t i = 0; i < size; i++) {
+        cost += (uint64_t)std::abs((int)(int8_t)filtered[i]);
+    }
+    return cost;
+}
+}
+
+bool EncodePng(const uint32_t* pixels, int width, int height, std::vector<uint8_t>& png, int level)
+{
+    png.clear();
+    if (!pixels || width <= 0 || height <= 0) {
+        return false;
+    }
+
+    // Filtered scanlines top row first, each led by its filter byte
+    size_t rowSize = (size_t)width * CHANNELS;
+    std::vector<uint8_t> scanlines((rowSize + 1) * (size_t)height);
+    // This row and the one above, which starts out as the zeros above the first
+    std::vector<uint8_t> rows[2] = { std::vector<uint8_t>(rowSize, 0), std::vector<uint8_t>(rowSize, 0) };
+    std::vector<uint8_t> candidates[FILTER_COUNT];
+    for (std::vector<uint8_t>& candidate : candidates) {
+        candidate.resize(rowSize);
+    }
+    for (int y = 0; y < height; y++) {
+        std::vector<uint8_t>& row = rows[y & 1];
+        const std::vector<uint8_t>& above = rows[(y & 1) ^ 1];
+        const uint32_t* source = pixels + (size_t)(height - 1 - y) * (size_t)width;
+        for (int x = 0; x < width; x++) {
+            uint32_t pixel = source[x];
+            row[(size_t)x * CHANNELS + 0] = (uint8_t)pixel;
+            row[(size_t)x * CHANNELS + 1] = (uint8_t)(pixel >> 8);
+            row[(size_t)x * CHANNELS + 2] = (uint8_t)(pixel >> 16);
+        }
+
+        int best = 0;
+        uint64_t bestCost = UINT64_MAX;
+        for (int filter = 0; filter < FILTER_COUNT; filter++) {
+            FilterRow(filter, row.data(), above.data(), rowSize, candidates[filter].data());
+            uint64_t cost = ResidualCost(candidates[filter].data(), rowSize);
+            if (cost < bestCost) {
+                bestCost = cost;
+                best = filter;
+            }
+        }
+        uint8_t* scanline = scanlines.data() + (size_t)y * (rowSize + 1);
+        scanline[0] = (uint8_t)best;
+        std::memcpy(scanline + 1, candidates[best].data(), rowSize);
+    }
+
+    uLongf compressedSize = compressBound((uLong)scanlines.size());
+    std::vector<uint8_t> compressed(compressedSize);
+    if (compress2(compressed.data(), &compressedSize, scanlines.data(), (uLong)scanlines.size(), level) != Z_OK) {
+        return false;
+    }
+
+    static const uint8_t SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    png.reserve(sizeof(SIGNATURE) + 3 * 12 + 13 + compressedSize);
+    png.insert(png.end(), SIGNATURE, SIGNATURE + sizeof(SIGNATURE));
+
+    // 8 bits per channel, truecolor, deflate, adaptive filtering, no interlace
+    std::vector<uint8_t> header;
+    PutUint32(header, (uint32_t)width);
+    PutUint32(header, (uint32_t)height);
+    const uint8_t format[5] = { 8, 2, 0, 0, 0 };
+    header.insert(header.end(), format, format + 5);
+    PutChunk(png, "IHDR", header.data(), header.size());
+    PutChunk(png, "IDAT", compressed.data(), compressedSize);
+    PutChunk(png, "IEND", nullptr, 0);
+    return true;
+}
@@ -0,0 +1,457 @@
+// STL includes
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "memorytracker.h"
+#include "profiler.h"
+
+#ifdef __EMSCRIPTEN__
+#define GL_GLEXT_PROTOTYPES
+#include <GLES2/gl2ext.h>
+#define PROFILER_TIME_ELAPSED GL_TIME_ELAPSED_EXT
+#define PROFILER_GET_QUERY_RESULT glGetQueryObjectui64vEXT
+#else
+#define PROFILER_TIME_ELAPSED GL_TIME_ELAPSED
+#define PROFILER_GET_QUERY_RESULT glGetQueryObjectui64v
+#endif
+
+namespace {
+thread_local void* threadDataSlot = nullptr;
+
+const std::chrono::steady_clock::time_point profilerEpoch = std::chrono::steady_clock::now();
+}
+
+Profiler* Profiler::instance = nullptr;
+std::atomic<uint64_t> Profiler::counters[(int)ProfileCounter::MAX_PROFILE_COUNTERS];
+std::atomic<float> Profiler::gauges[(int)ProfileGauge::MAX_PROFILE_GAUGES];
+
+const char* ProfileCounterToString(ProfileCounter counter) {
+    switch(counter) {
+        case ProfileCounter::DrawCalls: return "DrawCalls";
+        case ProfileCounter::Triangles: return "Triangles";
+        case ProfileCounter::StateChanges: return "StateChanges";
+        case ProfileCounter::BufferUploads: return "BufferUploads";
+        case ProfileCounter::UploadBytes: return "UploadBytes";
+        case ProfileCounter::DefragmentBytes: return "DefragmentBytes";
+        case ProfileCounter::ShadowUpdates: return "ShadowUpdates";
+        default: return "UNKNOWN";
+    }
+}
+
+const char* ProfileGaugeToString(ProfileGauge gauge) {
+    switch(gauge) {
+        case ProfileGauge::GeometryOccupancy: return "GeometryOccupancy";
+        case ProfileGauge::GeometryFragmentation: return "GeometryFragmentation";
+        case ProfileGauge::CpuMraysPerSecond: return "CpuMraysPerSecond";
+        case ProfileGauge::FractalCompletion: return "FractalCompletion";
+        default: return "UNKNOWN";
+    }
+}
+
+Profiler* Profiler::GetInstance() {
+    if(instance == nullptr) {
+        instance = new Profiler();
+    }
+    return instance;
+}
+
+Profiler::Profiler() {
+    if(instance == nullptr) {
+        instance = this;
+    }
+    for (auto& counter : counters) {
+        counter.store(0, std::memory_order_relaxed);
+    }
+}
+
+Profiler::~Profiler() {
+    ShutdownGpuTimers();
+    if(instance == this) {
+        instance = nullptr;
+    }
+}
+
+uint64_t Profiler::NowNs() const {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - profilerEpoch).count();
+}
+
+bool Profiler::ThreadData::Push(const ProfileEvent& event) {
+    uint32_t currentHead = head.load(std::memory_order_relaxed);
+    if (currentHead - tail.load(std::memory_order_acquire) >= CAPACITY) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    events[currentHead % CAPACITY] = event;
+    head.store(currentHead + 1, std::memory_order_release);
+    return true;
+}
+
+Profiler::ThreadData* Profiler::GetThreadData() {
+    ThreadData* data = static_cast<ThreadData*>(threadDataSlot);
+    if (data) {
+        return data;
+    }
+
+    // First zone on this thread: register a ring for it
+    std::lock_guard<std::mutex> lock(threadsMutex);
+    threads.push_back(std::make_unique<ThreadData>());
+    data = threads.back().get();
+    data->threadId = (uint32_t)threads.size();
+    data->threadName = "Thread " + std::to_string(data->threadId);
+    threadDataSlot = data;
+    return data;
+}
+
+void Profiler::SetThreadName(const char* name) {
+    ThreadData* data = GetThreadData();
+    std::lock_guard<std::mutex> lock(threadsMutex);
+    data->threadName = name;
+}
+
+void Profiler::BeginZone(const char* name) {
+    ThreadData* data = GetThreadData();
+    if (data->depth >= sizeof(data->stack) / sizeof(data->stack[0])) {
+        data->depth++;
+        return;
+    }
+    ProfileEvent& event = data->stack[data->depth];
+    event.name = name;
+    event.depth = data->depth;
+    event.startNs = NowNs();
+    data->depth++;
+}
+
+void Profiler::EndZone() {
+    ThreadData* data = GetThreadData();
+    if (data->depth == 0) {
+        return;
+    }
+    data->depth--;
+    if (data->depth >= sizeof(data->stack) / sizeof(data->stack[0])) {
+        return;
+    }
+    ProfileEvent& event = data->stack[data->depth];
+    event.endNs = NowNs();
+    if (bEnabled) {
+        data->Push(event);
+    }
+}
+
+void Profiler::InitGpuTimers() {
+    bGpuInitialized = true;
+
+    #ifdef __EMSCRIPTEN__
+    bGpuTimersSupported = emscripten_webgl_enable_extension(emscripten_webgl_get_current_context(), "EXT_disjoint_timer_query_webgl2");
+    #else
+    // GL_TIME_ELAPSED queries are core since 3.3
+    bGpuTimersSupported = true;
+    #endif
+
+    for (auto& frame : gpuFrames) {
+        for (auto& query : frame.queries) {
+            glGenQueries(1, &query.queryId);
+        }
+    }
+    std::cout << "GPU timer queries " << (bGpuTimersSupported ? "available" : "not available") << std::endl;
+}
+
+void Profiler::ShutdownGpuTimers() {
+    if (!bGpuInitialized) return;
+    for (auto& frame : gpuFrames) {
+        for (auto& query : frame.queries) {
+            glDeleteQueries(1, &query.queryId);
+            query.queryId = 0;
+        }
+        frame.queryCount = 0;
+    }
+    bGpuInitialized = false;
+    bGpuTimersSupported = false;
+    bGpuZoneOpen = false;
+    gpuZoneDepth = 0;
+}
+
+void Profiler::BeginGpuZone(const char* name) {
+    if (!bEnabled) return;
+    if (!bGpuInitialized) {
+        InitGpuTimers();
+    }
+    if (!bGpuTimersSupported) return;
+    // Only the outermost zone runs a query; the ones inside it just count depth
+    if (gpuZoneDepth++ > 0) return;
+
+    GpuFrame& frame = gpuFrames[currentGpuFrame];
+    if (frame.queryCount >= MAX_GPU_ZONES_PER_FRAME) return;
+
+    GpuQuery& query = frame.queries[frame.queryCount++];
+    query.name = name;
+    query.cpuStartNs = NowNs();
+    glBeginQuery(PROFILER_TIME_ELAPSED, query.queryId);
+    bGpuZoneOpen = true;
+}
+
+void Profiler::EndGpuZone() {
+    if (gpuZoneDepth == 0) return;
+    if (--gpuZoneDepth > 0 || !bGpuZoneOpen) return;
+    glEndQuery(PROFILER_TIME_ELAPSED);
+    bGpuZoneOpen = false;
+}
+
+void Profiler::ResolveGpuFrame(GpuFrame& frame) {
+    if (frame.queryCount == 0) return;
+
+    #ifdef __EMSCRIPTEN__
+    // A disjoint event (clock change, context switch) invalidates everything in flight
+    GLint disjoint = 0;
+    glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+    if (disjoint) {
+        frame.queryCount = 0;
+        return;
+    }
+    #endif
+
+    // Results older than GPU_LATENCY frames are normally available; anything
+    // still in flight is dropped rather than waited on
+    std::lock_guard<std::mutex> lock(threadsMutex);
+    double totalMs = 0.0;
+    gpuZoneCount = 0;
+    for (unsigned int i = 0; i < frame.queryCount; i++) {
+        GpuQuery& query = frame.queries[i];
+        GLuint available = 0;
+        glGetQueryObjectuiv(query.queryId, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) continue;
+
+        GLuint64 elapsedNs = 0;
+        PROFILER_GET_QUERY_RESULT(query.queryId, GL_QUERY_RESULT, &elapsedNs);
+        double ms = elapsedNs / 1.0e6;
+        totalMs += ms;
+
+        ZoneAccumulator* zone = FindZone(gpuZones, gpuZoneCount, query.name);
+        if (zone) {
+            zone->gpuMs += ms;
+            zone->calls++;
+        }
+
+        // GL_TIME_ELAPSED carries no timestamp, so GPU zones are placed at their submission time
+        if (bCapturing && capturedEvents.size() < maxCapturedEvents) {
+            capturedEvents.push_back({ query.name, query.cpuStartNs, elapsedNs, GPU_THREAD_ID });
+        }
+    }
+
+    resolvedGpuFrameIndex = frame.frameIndex;
+    resolvedGpuFrameMs = (float)totalMs;
+    frame.queryCount = 0;
+}
+
+void Profiler::BeginGpuFrame(unsigned int cpuFrameIndex) {
+    // Reuse the oldest query slot, reading back what it held GPU_LATENCY frames ago
+    currentGpuFrame = gpuFrameCounter++ % GPU_LATENCY;
+    GpuFrame& frame = gpuFrames[currentGpuFrame];
+    if (bGpuInitialized && bGpuTimersSupported) {
+        ResolveGpuFrame(frame);
+    }
+    frame.frameIndex = cpuFrameIndex;
+    frame.queryCount = 0;
+}
+
+void Profiler::BeginFrame() {
+    frameStartNs = NowNs();
+    if (!bExternalGpuFrames) {
+        BeginGpuFrame(frameIndex);
+    }
+    BeginZone("Frame");
+}
+
+void Profiler::EndFrame() {
+    EndZone();
+    uint64_t frameEndNs = NowNs();
+
+    // Drain every thread's ring into the per-frame zone stats (and the capture)
+    zoneCount = 0;
+    {
+        std::lock_guard<std::mutex> lock(threadsMutex);
+        summary.gpuFrameIndex = resolvedGpuFrameIndex;
+        summary.gpuFrameMs = resolvedGpuFrameMs;
+        for (auto& thread : threads) {
+            uint32_t tail = thread->tail.load(std::memory_order_relaxed);
+            uint32_t head = thread->head.load(std::memory_order_acquire);
+            for (; tail != head; tail++) {
+                const ProfileEvent& event = thread->events[tail % ThreadData::CAPACITY];
+                ZoneAccumulator* zone = FindZone(zones, zoneCount, event.name);
+                if (zone) {
+                    zone->cpuMs += (event.endNs - event.startNs) / 1.0e6;
+                    zone->calls++;
+                }
+                if (bCapturing && capturedEvents.size() < maxCapturedEvents) {
+                    capturedEvents.push_back({ event.name, event.startNs, event.endNs - event.startNs, thread->threadId });
+                }
+            }
+            thread->tail.store(tail, std::memory_order_release);
+        }
+    }
+
+    // Swap out the counters for this frame
+    uint64_t frameCounters[(int)ProfileCounter::MAX_PROFILE_COUNTERS];
+    for (int i = 0; i < (int)ProfileCounter::MAX_PROFILE_COUNTERS; i++) {
+        frameCounters[i] = counters[i].exchange(0, std::memory_order_relaxed);
+        counterTotals[i] += frameCounters[i];
+    }
+
+    summary.frameIndex = frameIndex;
+    summary.cpuFrameMs = (frameEndNs - frameStartNs) / 1.0e6f;
+    summary.drawCalls = (unsigned int)frameCounters[(int)ProfileCounter::DrawCalls];
+    summary.triangles = (unsigned int)frameCounters[(int)ProfileCounter::Triangles];
+    summary.stateChanges = (unsigned int)frameCounters[(int)ProfileCounter::StateChanges];
+    summary.bufferUploads = (unsigned int)frameCounters[(int)ProfileCounter::BufferUploads];
+    summary.uploadBytes = (unsigned int)frameCounters[(int)ProfileCounter::UploadBytes];
+    summary.defragmentBytes = (unsigned int)frameCounters[(int)ProfileCounter::DefragmentBytes];
+    summary.shadowUpdates = (unsigned int)frameCounters[(int)ProfileCounter::ShadowUpdates];
+
+    float frameGauges[(int)ProfileGauge::MAX_PROFILE_GAUGES];
+    for (int i = 0; i < (int)ProfileGauge::MAX_PROFILE_GAUGES; i++) {
+        frameGauges[i] = gauges[i].load(std::memory_order_relaxed);
+    }
+    summary.geometryOccupancy = frameGauges[(int)ProfileGauge::GeometryOccupancy];
+    summary.geometryFragmentation = frameGauges[(int)ProfileGauge::GeometryFragmentation];
+    summary.cpuMraysPerSecond = frameGauges[(int)ProfileGauge::CpuMraysPerSecond];
+    summary.fractalCompletion = frameGauges[(int)ProfileGauge::FractalCompletion];
+
+    MemoryTracker::EndFrame();
+    summary.heapAllocations = (unsigned int)MemoryTracker::GetFrameAllocations();
+    summary.heapBytes = (unsigned int)MemoryTracker::GetFrameBytes();
+
+    if (bCapturing && capturedCounters.size() < maxCapturedEvents) {
+        TraceCounter counter;
+        counter.timeNs = frameStartNs;
+        std::memcpy(counter.values, frameCounters, sizeof(frameCounters));
+        std::memcpy(counter.gaugeValues, frameGauges, sizeof(frameGauges));
+        capturedCounters.push_back(counter);
+    }
+
+    frameIndex++;
+}
+
+Profiler::ZoneAccumulator* Profiler::FindZone(ZoneAccumulator* list, unsigned int& count, const char* name) {
+    for (unsigned int i = 0; i < count; i++) {
+        if (list[i].name == name || std::strcmp(list[i].name, name) == 0) {
+            return &list[i];
+        }
+    }
+    if (count >= MAX_ZONE_STATS) {
+        return nullptr;
+    }
+    ZoneAccumulator& zone = list[count++];
+    zone.name = name;
+    zone.cpuMs = 0.0;
+    zone.gpuMs = 0.0;
+    zone.calls = 0;
+    return &zone;
+}
+
+std::vector<ProfileZoneStat> Profiler::GetZoneStats() const {
+    std::lock_guard<std::mutex> lock(threadsMutex);
+    std::vector<ProfileZoneStat> stats;
+    for (unsigned int i = 0; i < zoneCount; i++) {
+        ProfileZoneStat stat;
+        stat.name = zones[i].name;
+        stat.cpuMs = (float)zones[i].cpuMs;
+        stat.calls = zones[i].calls;
+        stats.push_back(stat);
+    }
+    // GPU zones come from an older frame; match them up by name
+    for (unsigned int i = 0; i < gpuZoneCount; i++) {
+        bool bMatched = false;
+        for (auto& stat : stats) {
+            if (stat.name == gpuZones[i].name) {
+                stat.gpuMs = (float)gpuZones[i].gpuMs;
+                bMatched = true;
+                break;
+            }
+        }
+        if (!bMatched) {
+            ProfileZoneStat stat;
+            stat.name = gpuZones[i].name;
+            stat.gpuMs = (float)gpuZones[i].gpuMs;
+            stat.calls = gpuZones[i].calls;
+            stats.push_back(stat);
+        }
+    }
+    return stats;
+}
+
+void Profiler::StartCapture(size_t maxEvents) {
+    capturedEvents.clear();
+    capturedCounters.clear();
+    maxCapturedEvents = maxEvents;
+    capturedEvents.reserve(maxEvents < 65536 ? maxEvents : 65536);
+    bCapturing = true;
+}
+
+void Profiler::StopCapture() {
+    bCapturing = false;
+}
+
+std::string Profiler::GetTraceJson() const {
+    std::ostringstream json;
+    json << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+    char buffer[256];
+    bool bFirst = true;
+    auto separator = [&]() {
+        if (!bFirst) json << ",\n";
+        bFirst = false;
+    };
+
+    // Thread name metadata
+    {
+        std::lock_guard<std::mutex> lock(threadsMutex);
+        for (const auto& thread : threads) {
+            separator();
+            json << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread->threadId
+                 << ",\"args\":{\"name\":\"" << thread->threadName << "\"}}";
+        }
+    }
+    separator();
+    json << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << GPU_THREAD_ID << ",\"args\":{\"name\":\"GPU\"}}";
+
+    // Complete events, timestamps in microseconds
+    for (const auto& event : capturedEvents) {
+        separator();
+        snprintf(buffer, sizeof(buffer), "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+            event.name, event.threadId, event.startNs / 1000.0, event.durationNs / 1000.0);
+        json << buffer;
+    }
+
+    // Per-frame counters
+    for (const auto& counter : capturedCounters) {
+        for (int i = 0; i < (int)ProfileCounter::MAX_PROFILE_COUNTERS; i++) {
+            separator();
+            snprintf(buffer, sizeof(buffer), "{\"name\":\"%s\",\"ph\":\"C\",\"pid\":1,\"ts\":%.3f,\"args\":{\"value\":%llu}}",
+                ProfileCounterToString((ProfileCounter)i), counter.timeNs / 1000.0, (unsigned long long)counter.values[i]);
+            json << buffer;
+        }
+        for (int i = 0; i < (int)ProfileGauge::MAX_PROFILE_GAUGES; i++) {
+            separator();
+            snprintf(buffer, sizeof(buffer), "{\"name\":\"%s\",\"ph\":\"C\",\"pid\":1,\"ts\":%.3f,\"args\":{\"value\":%.4f}}",
+                ProfileGaugeToString((ProfileGauge)i), counter.timeNs / 1000.0, counter.gaugeValues[i]);
+            json << buffer;
+        }
+    }
+
+    json << "\n]}\n";
+    return json.str();
+}
+
+bool Profiler::WriteTrace(const std::string& path) const {
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Failed to write trace: " << path << std::endl;
+        return false;
+    }
+    file << GetTraceJson();
+    std::cout << "Wrote trace with " << capturedEvents.size() << " events to " << path << std::endl;
+    return true;
+}
@@ -0,0 +1,105 @@
+// rendertarget.cpp
+
+// C++ standard library
+#include <algorithm>
+#include <iostream>
+
+// local headers
+#include "rendertarget.h"
+
+RenderTarget::RenderTarget()
+{
+}
+
+RenderTarget::~RenderTarget()
+{
+    Destroy();
+}
+
+bool RenderTarget::Create(int width, int height, bool bDepth, int colorCount)
+{
+    Destroy();
+
+    this->width = width;
+    this->height = height;
+    this->bHasDepth = bDepth;
+    this->colorCount = std::clamp(colorCount, 1, MAX_COLOR_TEXTURES);
+
+    glGenTextures(this->colorCount, colorTextures);
+    for (int i = 0; i < this->colorCount; i++) {
+        glBindTexture(GL_TEXTURE_2D, colorTextures[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    GLenum drawBuffers[MAX_COLOR_TEXTURES];
+    for (int i = 0; i < this->colorCount; i++) {
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, colorTextures[i], 0);
+        drawBuffers[i] = GL_COLOR_ATTACHMENT0 + i;
+    }
+    // The draw buffers are framebuffer state, so this holds whenever it is bound
+    if (this->colorCount > 1) {
+        glDrawBuffers(this->colorCount, drawBuffers);
+    }
+
+    if (bDepth) {
+        glGenRenderbuffers(1, &depthRenderbuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, depthRenderbuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthRenderbuffer);
+    }
+
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Render target " << width << "x" << height << " incomplete: 0x" << std::hex << status << std::dec << std::endl;
+        Destroy();
+        return false;
+    }
+    return true;
+}
+
+bool RenderTarget::Resize(int newWidth, int newHeight)
+{
+    if (IsValid() && newWidth == width && newHeight == height) {
+        return true;
+    }
+    return Create(newWidth, newHeight, bHasDepth, colorCount);
+}
+
+void RenderTarget::Destroy()
+{
+    if (depthRenderbuffer) {
+        glDeleteRenderbuffers(1, &depthRenderbuffer);
+        depthRenderbuffer = 0;
+    }
+    for (GLuint& colorTexture : colorTextures) {
+        if (colorTexture) {
+            glDeleteTextures(1, &colorTexture);
+            colorTexture = 0;
+        }
+    }
+    if (framebuffer) {
+        glDeleteFramebuffers(1, &framebuffer);
+        framebuffer = 0;
+    }
+}
+
+void RenderTarget::Bind() const
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glViewport(0, 0, width, height);
+}
+
+void RenderTarget::BindDefault(int width, int height)
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, width, height);
+}
@@ -0,0 +1,84 @@
+// resolutionscaler.cpp
+
+// C++ standard library
+#include <algorithm>
+#include <cmath>
+
+// local headers
+#include "resolutionscaler.h"
+
+ResolutionScaler::ResolutionScaler() {
+}
+
+void ResolutionScaler::SetBounds(float minScale, float maxScale) {
+    this->maxScale = std::clamp(maxScale, STEP, 1.0f);
+    this->minScale = std::clamp(minScale, STEP, this->maxScale);
+    scale = std::clamp(scale, this->minScale, this->maxScale);
+}
+
+void ResolutionScaler::Reset() {
+    scale = maxScale;
+    bHasSample = false;
+    bChanged = false;
+    bLastChangeRaised = false;
+    framesOver = 0;
+    framesUnder = 0;
+    raiseFrames = RAISE_FRAMES;
+}
+
+float ResolutionScaler::Quantize(float value) const {
+    return std::clamp(std::round(value / STEP) * STEP, minScale, maxScale);
+}
+
+void ResolutionScaler::SetScale(float newScale, unsigned int currentFrame) {
+    bChanged = true;
+    bLastChangeRaised = newScale > scale;
+    scale = newScale;
+    changedAtFrame = currentFrame;
+    framesOver = 0;
+    framesUnder = 0;
+}
+
+bool ResolutionScaler::Update(unsigned int sampleFrame, float frameMs, unsigned int currentFrame) {
+    // No new result, or one measured at the previous scale
+    if (frameMs <= 0.0f || (bHasSample && sampleFrame == lastSampleFrame)) {
+        return false;
+    }
+    bHasSample = true;
+    lastSampleFrame = sampleFrame;
+    if (bChanged && sampleFrame <= changedAtFrame) {
+        return false;
+    }
+
+    float ratio = frameMs / targetMs;
+    if (ratio > 1.0f) {
+        framesOver++;
+        framesUnder = 0;
+    }
+    else if (ratio < headroom) {
+        framesUnder++;
+        framesOver = 0;
+    }
+    else {
+        framesOver = 0;
+        framesUnder = 0;
+    }
+
+    if (framesOver >= DROP_FRAMES && scale > minScale) {
+        // A raise that didn't fit: wait longer before trying again
+        if (bLastChangeRaised && currentFrame - changedAtFrame <= raiseFrames + DROP_FRAMES * 4) {
+            raiseFrames = std::min(raiseFrames * 2, MAX_RAISE_FRAMES);
+        }
+        else {
+            raiseFrames = RAISE_FRAMES;
+        }
+        float newScale = std::min(Quantize(scale / std::sqrt(ratio)), scale - STEP);
+        SetScale(std::max(newScale, minScale), currentFrame);
+        return true;
+    }
+    if (framesUnder >= raiseFrames && scale < maxScale) {
+        SetScale(Quantize(scale + STEP), currentFrame);
+        return true;
+    }
+    return false;
+}
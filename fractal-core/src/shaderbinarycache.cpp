@@ -0,0 +1,141 @@
+// ShaderBinaryCache.cpp
+
+// C++ standard library
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <filesystem>
+
+// local headers
+#include "shaderbinarycache.h"
+
+namespace {
+const uint32_t CACHE_MAGIC = 0x46534243; // "FSBC"
+const uint32_t CACHE_VERSION = 1;
+
+uint64_t HashString(const std::string& value, uint64_t hash = 14695981039346656037ull) {
+    // FNV-1a, good enough to key cache files
+    for (unsigned char c : value) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+#ifndef __EMSCRIPTEN__
+std::string GetGLString(GLenum name) {
+    const GLubyte* value = glGetString(name);
+    return value ? reinterpret_cast<const char*>(value) : "";
+}
+#endif
+}
+
+ShaderBinaryCache* ShaderBinaryCache::instance = nullptr;
+
+ShaderBinaryCache* ShaderBinaryCache::GetInstance() {
+    if(instance == nullptr) {
+        instance = new ShaderBinaryCache();
+    }
+    return instance;
+}
+
+ShaderBinaryCache::ShaderBinaryCache()
+    : cacheDirectory("shader-cache")
+{
+    if(instance == nullptr) {
+        instance = this;
+    }
+}
+
+ShaderBinaryCache::~ShaderBinaryCache() {
+    if(instance == this) {
+        instance = nullptr;
+    }
+}
+
+bool ShaderBinaryCache::IsEnabled() {
+    #ifdef __EMSCRIPTEN__
+    return false;
+    #else
+    if (!bCapabilitiesChecked) {
+        bCapabilitiesChecked = true;
+
+        GLint numFormats = 0;
+        if (GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary) {
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+        }
+        bSupported = numFormats > 0;
+        driverString = GetGLString(GL_VENDOR) + "|" + GetGLString(GL_RENDERER) + "|" + GetGLString(GL_VERSION);
+
+        if (bSupported) {
+            std::error_code error;
+            std::filesystem::create_directories(cacheDirectory, error);
+            if (error) {
+                std::cerr << "Failed to create shader cache directory " << cacheDirectory << ": " << error.message() << std::endl;
+                bSupported = false;
+            }
+        }
+        std::cout << "Shader binary cache " << (bSupported ? "enabled at " + cacheDirectory : "not supported") << std::endl;
+    }
+    return bUserEnabled && bSupported;
+    #endif
+}
+
+std::string ShaderBinaryCache::MakeKey(const std::string& sources, const std::string& definesKey) {
+    uint64_t hash = HashString(sources);
+    hash = HashString(definesKey, hash);
+    hash = HashString(driverString, hash);
+
+    char key[17];
+    snprintf(key, sizeof(key), "%016llx", (unsigned long long)hash);
+    return key;
+}
+
+std::string ShaderBinaryCache::GetEntryPath(const std::string& key) const {
+    return cacheDirectory + "/" + key + ".bin";
+}
+
+bool ShaderBinaryCache::Load(const std::string& key, GLenum& format, std::vector<char>& binary) const {
+    std::ifstream file(GetEntryPath(key), std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    uint32_t header[4] = {0};
+    file.read(reinterpret_cast<char*>(header), sizeof(header));
+    if (!file || header[0] != CACHE_MAGIC || header[1] != CACHE_VERSION || header[3] == 0) {
+        return false;
+    }
+
+    // A truncated or corrupt entry can claim any size, so check it against what is actually left
+    std::streampos dataStart = file.tellg();
+    file.seekg(0, std::ios::end);
+    std::streampos fileEnd = file.tellg();
+    if (dataStart < 0 || fileEnd < dataStart || (uint64_t)(fileEnd - dataStart) < header[3]) {
+        return false;
+    }
+    file.seekg(dataStart);
+
+    format = header[2];
+    binary.resize(header[3]);
+    file.read(binary.data(), binary.size());
+    return (bool)file;
+}
+
+void ShaderBinaryCache::Store(const std::string& key, GLenum format, const std::vector<char>& binary) const {
+    // Write to a temporary file and rename so an interrupted run never leaves a truncated entry
+    std::string path = GetEntryPath(key);
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            std::cerr << "Failed to write shader cache entry: " << tempPath << std::endl;
+            return;
+        }
+        uint32_t header[4] = { CACHE_MAGIC, CACHE_VERSION, (uint32_t)format, (uint32_t)binary.size() };
+        file.write(reinterpret_cast<const char*>(header), sizeof(header));
+        file.write(binary.data(), binary.size());
+    }
+    std::rename(tempPath.c_str(), path.c_str());
+}
@@ -4,23 +4,74 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <algorithm>
 
 // local headers
 #include "shaderprogram.h"
+#include "shaderbinarycache.h"
 #include "assetutils.h"
 
-ShaderProgram::ShaderProgram()
+ShaderDefines& ShaderDefines::Set(const std::string& name, int value)
+{
+    defines[name] = value;
+    return *this;
+}
+
+void ShaderDefines::Remove(const std::string& name)
+{
+    defines.erase(name);
+}
+
+bool ShaderDefines::Has(const std::string& name) const
+{
+    return defines.find(name) != defines.end();
+}
+
+std::string ShaderDefines::GetKey() const
+{
+    std::string key;
+    for (const auto& define : defines) {
+        key += define.first + "=" + std::to_string(define.second) + ";";
+    }
+    return key;
+}
+
+std::string ShaderDefines::GetPreamble() const
+{
+    std::string preamble;
+    for (const auto& define : defines) {
+        preamble += "#define " + define.first + " " + std::to_string(define.second) + "\n";
+    }
+    return preamble;
+}
+
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+std::vector<ShaderProgram*> ShaderProgram::pendingPrograms;
+bool ShaderProgram::bCapabilitiesChecked = false;
+bool ShaderProgram::bParallelCompile = false;
+
+ShaderProgram::ShaderProgram(const ShaderDefines& defines)
+    : defines(defines)
 {
     programId = glCreateProgram();
 }
 
 ShaderProgram::~ShaderProgram()
 {
+    RemovePending();
+    DeleteStageShaders();
     glDeleteProgram(programId);
 }
 
 void ShaderProgram::Use()
 {
+    // A program that was submitted but never finished is resolved on first use
+    if (state == State::Pending) {
+        Finish();
+    }
     glUseProgram(programId);
 }
 
@@ -36,34 +87,231 @@ void ShaderProgram::AttachShaderFromFile(const char* path, unsigned int shaderTy
     }
     std::stringstream buffer;
     buffer << file.rdbuf();
-    std::string source = buffer.str();
-    const char* src = source.c_str();
 
-    unsigned int shader = glCreateShader(shaderType);
-    glShaderSource(shader, 1, &src, nullptr);
-    glCompileShader(shader);
+    // Compilation is deferred to Submit() so a cached binary can skip it entirely
+    ShaderStage stage;
+    stage.type = shaderType;
+    stage.path = path;
+    stage.source = InjectDefines(buffer.str());
+    stages.push_back(stage);
+}
 
-    int success;
-    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        char infoLog[512];
-        glGetShaderInfoLog(shader, 512, nullptr, infoLog);
-        std::cerr << "Shader '" << path << "' compilation failed: " << infoLog << std::endl;
+void ShaderProgram::Link()
+{
+    Submit();
+    Finish();
+}
+
+void ShaderProgram::Submit()
+{
+    if (state != State::Unlinked) {
+        return;
     }
-    glAttachShader(programId, shader);
-    glDeleteShader(shader);
+    DetectCapabilities();
+
+    ShaderBinaryCache* cache = ShaderBinaryCache::GetInstance();
+    if (cache->IsEnabled()) {
+        std::string sources;
+        for (const auto& stage : stages) {
+            sources += std::to_string(stage.type) + ":" + stage.source;
+        }
+        cacheKey = cache->MakeKey(sources, defines.GetKey());
+
+        #ifndef __EMSCRIPTEN__
+        GLenum format = 0;
+        std::vector<char> binary;
+        if (cache->Load(cacheKey, format, binary)) {
+            // Link status is checked in Finish(); a rejected binary falls back to source there
+            glProgramBinary(programId, format, binary.data(), (GLsizei)binary.size());
+            bLoadedFromBinary = true;
+            state = State::Pending;
+            pendingPrograms.push_back(this);
+            return;
+        }
+        #endif
+    }
+
+    SubmitFromSource();
+    pendingPrograms.push_back(this);
 }
 
-void ShaderProgram::Link()
+void ShaderProgram::SubmitFromSource()
 {
+    // Issue every compile and the link without querying status, so the driver
+    // can work on them in parallel (KHR_parallel_shader_compile) or at least lazily
+    for (const auto& stage : stages) {
+        const char* src = stage.source.c_str();
+        GLuint shader = glCreateShader(stage.type);
+        glShaderSource(shader, 1, &src, nullptr);
+        glCompileShader(shader);
+        glAttachShader(programId, shader);
+        stageShaders.push_back(shader);
+    }
+
+    #ifndef __EMSCRIPTEN__
+    if (!cacheKey.empty()) {
+        glProgramParameteri(programId, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    #endif
+
     glLinkProgram(programId);
+    bLoadedFromBinary = false;
+    state = State::Pending;
+}
+
+bool ShaderProgram::IsReady() const
+{
+    if (state != State::Pending) {
+        return true;
+    }
+    if (!bParallelCompile) {
+        // Without the extension the status query blocks anyway
+        return true;
+    }
+    GLint completed = GL_FALSE;
+    glGetProgramiv(programId, GL_COMPLETION_STATUS_KHR, &completed);
+    return completed == GL_TRUE;
+}
+
+bool ShaderProgram::Finish()
+{
+    if (state != State::Pending) {
+        return state == State::Ready;
+    }
+    RemovePending();
+
     int success;
     glGetProgramiv(programId, GL_LINK_STATUS, &success);
+
+    if (!success && bLoadedFromBinary) {
+        // Stale or incompatible binary, rebuild from source and overwrite the entry
+        std::cerr << "Cached program binary rejected, recompiling [" << defines.GetKey() << "]" << std::endl;
+        SubmitFromSource();
+        glGetProgramiv(programId, GL_LINK_STATUS, &success);
+    }
+
     if (!success) {
+        for (size_t i = 0; i < stageShaders.size(); i++) {
+            int compiled;
+            glGetShaderiv(stageShaders[i], GL_COMPILE_STATUS, &compiled);
+            if (!compiled) {
+                char infoLog[512];
+                glGetShaderInfoLog(stageShaders[i], 512, nullptr, infoLog);
+                std::cerr << "Shader '" << stages[i].path << "' [" << defines.GetKey() << "] compilation failed: " << infoLog << std::endl;
+            }
+        }
         char infoLog[512];
         glGetProgramInfoLog(programId, 512, nullptr, infoLog);
         std::cerr << "Program linking failed: " << infoLog << std::endl;
+        state = State::Failed;
+    } else {
+        state = State::Ready;
+        if (!bLoadedFromBinary) {
+            StoreBinary();
+        }
+    }
+
+    DeleteStageShaders();
+    return success;
+}
+
+void ShaderProgram::FinishPending()
+{
+    // Finish() removes the program from the list, so always take the front
+    while (!pendingPrograms.empty()) {
+        pendingPrograms.front()->Finish();
+    }
+}
+
+void ShaderProgram::FinishReady()
+{
+    for (size_t i = 0; i < pendingPrograms.size();) {
+        ShaderProgram* program = pendingPrograms[i];
+        if (program->IsReady()) {
+            // Removes it from the list, so i already names the next one
+            program->Finish();
+        }
+        else {
+            i++;
+        }
+    }
+}
+
+void ShaderProgram::DetectCapabilities()
+{
+    if (bCapabilitiesChecked) {
+        return;
+    }
+    bCapabilitiesChecked = true;
+
+    #ifdef __EMSCRIPTEN__
+    bParallelCompile = emscripten_webgl_enable_extension(emscripten_webgl_get_current_context(), "KHR_parallel_shader_compile");
+    #else
+    #ifdef GLEW_KHR_parallel_shader_compile
+    if (GLEW_KHR_parallel_shader_compile) {
+        glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+        bParallelCompile = true;
+    }
+    #endif
+    #endif
+    std::cout << "Parallel shader compile " << (bParallelCompile ? "available" : "not available") << std::endl;
+}
+
+void ShaderProgram::StoreBinary()
+{
+    #ifndef __EMSCRIPTEN__
+    if (cacheKey.empty()) {
+        return;
+    }
+    GLint length = 0;
+    glGetProgramiv(programId, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return;
+    }
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(programId, length, nullptr, &format, binary.data());
+    ShaderBinaryCache::GetInstance()->Store(cacheKey, format, binary);
+    #endif
+}
+
+void ShaderProgram::DeleteStageShaders()
+{
+    for (GLuint shader : stageShaders) {
+        glDetachShader(programId, shader);
+        glDeleteShader(shader);
+    }
+    stageShaders.clear();
+}
+
+void ShaderProgram::RemovePending()
+{
+    auto it = std::find(pendingPrograms.begin(), pendingPrograms.end(), this);
+    if (it != pendingPrograms.end()) {
+        pendingPrograms.erase(it);
+    }
+}
+
+std::string ShaderProgram::InjectDefines(const std::string& source) const
+{
+    std::string preamble = defines.GetPreamble();
+    if (preamble.empty()) {
+        return source;
+    }
+
+    // GLSL requires #version to be the first directive, so defines go right after it
+    size_t insertPos = 0;
+    if (source.compare(0, 8, "#version") == 0) {
+        size_t lineEnd = source.find('\n');
+        insertPos = (lineEnd == std::string::npos) ? source.size() : lineEnd + 1;
+    }
+    std::string result = source;
+    if (insertPos == result.size() && (result.empty() || result.back() != '\n')) {
+        result += '\n';
+        insertPos = result.size();
     }
+    result.insert(insertPos, preamble);
+    return result;
 }
 
 int ShaderProgram::GetAttribLocation(const char* name)
@@ -0,0 +1,50 @@
+// ShaderVariantCache.cpp
+
+// C++ standard library
+#include <iostream>
+
+// local headers
+#include "shadervariantcache.h"
+
+ShaderVariantCache::ShaderVariantCache(const std::string& vertexPath, const std::string& fragmentPath)
+    : vertexPath(vertexPath), fragmentPath(fragmentPath)
+{
+}
+
+ShaderVariantCache::~ShaderVariantCache()
+{
+    // ShaderProgram destructors delete the GL programs
+}
+
+ShaderProgram* ShaderVariantCache::Get(const ShaderDefines& defines)
+{
+    std::string key = defines.GetKey();
+    auto it = variants.find(key);
+    if (it != variants.end()) {
+        return it->second.get();
+    }
+
+    // Submitted only; the program finishes before the first frame (ShaderProgram::FinishPending)
+    // or on first Use() if it was requested mid-frame
+    std::cout << "Compiling shader variant " << vertexPath << "/" << fragmentPath << " [" << key << "]" << std::endl;
+    std::unique_ptr<ShaderProgram> program = std::make_unique<ShaderProgram>(defines);
+    program->AttachShaderFromFile(vertexPath.c_str(), GL_VERTEX_SHADER);
+    program->AttachShaderFromFile(fragmentPath.c_str(), GL_FRAGMENT_SHADER);
+    program->Submit();
+
+    ShaderProgram* result = program.get();
+    variants[key] = std::move(program);
+    return result;
+}
+
+void ShaderVariantCache::WarmUp(const std::vector<ShaderDefines>& variantList)
+{
+    for (const auto& defines : variantList) {
+        Get(defines);
+    }
+}
+
+bool ShaderVariantCache::HasVariant(const ShaderDefines& defines) const
+{
+    return variants.find(defines.GetKey()) != variants.end();
+}
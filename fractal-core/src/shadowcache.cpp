@@ -0,0 +1,470 @@
+// shadowcache.cpp
+
+// C++ standard library
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <functional>
+
+// glm
+#include <glm/gtc/matrix_transform.hpp>
+
+// local headers
+#include "frustum.h"
+#include "profiler.h"
+#include "shadowcache.h"
+
+namespace {
+// Fraction of a cascade's extent added on each side when it is fitted, so the
+// camera can move a little before the cascade has to be rendered again
+constexpr float GUARD_BAND = 0.15f;
+// Constant depth bias applied when sampling, on top of the polygon offset
+constexpr float DEPTH_BIAS = 0.0015f;
+// Splits blend logarithmic (1) and uniform (0) spacing
+constexpr float SPLIT_LAMBDA = 0.75f;
+
+glm::vec3 StableUp(const glm::vec3& direction)
+{
+    return std::abs(direction.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+}
+
+void ExpandBox(glm::vec3& boxMin, glm::vec3& boxMax, const glm::vec3& point)
+{
+    boxMin = glm::min(boxMin, point);
+    boxMax = glm::max(boxMax, point);
+}
+}
+
+ShadowCache::ShadowCache()
+{
+    pending.reserve(MAX_SHADOW_LAYERS);
+}
+
+void ShadowCache::Configure(int newMapSize, int newUpdateBudget, float newMaxDistance)
+{
+    mapSize = std::max(newMapSize, 16);
+    updateBudget = newUpdateBudget;
+    maxDistance = std::max(newMaxDistance, 1.0f);
+    // Everything has to be refitted for the new resolution
+    cachedLights.clear();
+}
+
+void ShadowCache::Update(const std::vector<Light>& lights, const Camera& camera,
+                         const std::vector<MeshInstance>& instances, uint64_t instanceVersion,
+                         const std::vector<size_t>& movedInstances,
+                         const glm::vec3& defaultCenter, float defaultRadius, ShadowFrame& frame)
+{
+    PROFILE_ZONE("ShadowCache::Update");
+    frame.bEnabled = true;
+    frame.mapSize = mapSize;
+    frame.updates.clear();
+    frame.casters.clear();
+
+    AssignLayers(lights);
+    if (instanceVersion != casterVersion || defaultCenter != casterDefaultCenter || defaultRadius != casterDefaultRadius) {
+        RebuildCasters(instances, defaultCenter, defaultRadius);
+        casterVersion = instanceVersion;
+    }
+    else if (!movedInstances.empty()) {
+        InvalidateMovedCasters(instances, movedInstances, defaultCenter, defaultRadius);
+    }
+
+    for (size_t i = 0; i < lights.size() && i < cachedLights.size(); i++) {
+        CachedLight& cached = cachedLights[i];
+        if (cached.firstLayer < 0) {
+            continue;
+        }
+        const Light& light = lights[i];
+        bool bChanged = !cached.bFitted || LightChanged(light, cached);
+        cached.position = light.getPosition();
+        cached.direction = light.getDirection();
+        cached.spotAngle = light.getSpotAngle();
+
+        switch (cached.type) {
+            case Light::Type::Directional:
+                // Cascades follow the camera, so they are checked every frame
+                FitCascades(light, cached, camera, bChanged);
+                break;
+            case Light::Type::Spot:
+                if (bChanged) {
+                    FitSpot(light, cached);
+                }
+                break;
+            case Light::Type::Point:
+                if (bChanged) {
+                    FitParaboloids(light, cached);
+                }
+                break;
+        }
+        cached.bFitted = true;
+    }
+
+    // Pick this frame's updates: maps that were never rendered first, then
+    // nearer cascades, then whichever has waited longest
+    pending.clear();
+    for (int layer = 0; layer < layerCount; layer++) {
+        CachedView& view = views[layer];
+        if (view.bDirty) {
+            view.dirtyFrames++;
+            pending.push_back(layer);
+        }
+        else {
+            cachedViews++;
+        }
+    }
+    std::sort(pending.begin(), pending.end(), [this](int a, int b) {
+        const CachedView& viewA = views[a];
+        const CachedView& viewB = views[b];
+        if (viewA.bRendered != viewB.bRendered) return !viewA.bRendered;
+        if (viewA.cascade != viewB.cascade) return viewA.cascade < viewB.cascade;
+        if (viewA.dirtyFrames != viewB.dirtyFrames) return viewA.dirtyFrames > viewB.dirtyFrames;
+        return a < b;
+    });
+    size_t updateCount = updateBudget > 0 ? std::min(pending.size(), (size_t)updateBudget) : pending.size();
+
+    for (size_t i = 0; i < updateCount; i++) {
+        int layer = pending[i];
+        CachedView& view = views[layer];
+
+        ShadowView update;
+        update.lightMatrix = view.lightMatrix;
+        update.layer = layer;
+        update.projection = view.projection;
+        update.paraboloidSide = view.paraboloidSide;
+        update.nearPlane = view.nearPlane;
+        update.farPlane = view.farPlane;
+        CollectCasters(view, instances, frame, update);
+        frame.updates.push_back(update);
+
+        // The render thread draws it before anything samples this packet's maps
+        view.renderedMatrix = view.lightMatrix;
+        view.renderedNear = view.nearPlane;
+        view.renderedFar = view.farPlane;
+        view.renderedTexelWorldSize = view.texelWorldSize;
+        view.bRendered = true;
+        view.bDirty = false;
+        view.dirtyFrames = 0;
+        renderedViews++;
+    }
+    Profiler::Count(ProfileCounter::ShadowUpdates, updateCount);
+
+    FillSampling(frame, lights.size());
+}
+
+void ShadowCache::AssignLayers(const std::vector<Light>& lights)
+{
+    // Layers only move when the set of shadowed lights changes
+    bool bSame = cachedLights.size() == lights.size();
+    for (size_t i = 0; bSame && i < lights.size(); i++) {
+        bSame = cachedLights[i].type == lights[i].getType() && cachedLights[i].bCastsShadows == lights[i].getCastsShadows();
+    }
+    if (bSame) {
+        return;
+    }
+
+    cachedLights.assign(lights.size(), CachedLight());
+    layerCount = 0;
+    for (int layer = 0; layer < MAX_SHADOW_LAYERS; layer++) {
+        views[layer] = CachedView();
+    }
+
+    for (size_t i = 0; i < lights.size(); i++) {
+        CachedLight& cached = cachedLights[i];
+        cached.type = lights[i].getType();
+        cached.bCastsShadows = lights[i].getCastsShadows();
+        if (!cached.bCastsShadows || i >= (size_t)MeshRenderer::MAX_LIGHTS) {
+            continue;
+        }
+
+        int needed = cached.type == Light::Type::Directional ? SHADOW_CASCADE_COUNT : cached.type == Light::Type::Spot ? 1 : 2;
+        if (layerCount + needed > MAX_SHADOW_LAYERS) {
+            continue;
+        }
+        cached.firstLayer = layerCount;
+        cached.layers = needed;
+        for (int k = 0; k < needed; k++) {
+            CachedView& view = views[layerCount + k];
+            view.lightIndex = (int)i;
+            view.cascade = k;
+            view.projection = cached.type == Light::Type::Point ? ShadowProjection::Paraboloid : ShadowProjection::Projective;
+            view.paraboloidSide = k == 0 ? 1.0f : -1.0f;
+        }
+        layerCount += needed;
+    }
+}
+
+bool ShadowCache::LightChanged(const Light& light, const CachedLight& cached) const
+{
+    switch (cached.type) {
+        case Light::Type::Directional:
+            return light.getDirection() != cached.direction;
+        case Light::Type::Spot:
+            return light.getPosition() != cached.position || light.getDirection() != cached.direction || light.getSpotAngle() != cached.spotAngle;
+        case Light::Type::Point:
+            return light.getPosition() != cached.position;
+    }
+    return true;
+}
+
+glm::vec4 ShadowCache::CasterSphere(const MeshInstance& instance, const glm::vec3& defaultCenter, float defaultRadius) const
+{
+    const glm::vec3& localCenter = instance.mesh ? instance.mesh->boundsCenter : defaultCenter;
+    float localRadius = instance.mesh ? instance.mesh->boundsRadius : defaultRadius;
+
+    const glm::mat4& transform = instance.transform;
+    float scale = std::max(glm::length(glm::vec3(transform[0])), std::max(glm::length(glm::vec3(transform[1])), glm::length(glm::vec3(transform[2]))));
+    return glm::vec4(glm::vec3(transform * glm::vec4(localCenter, 1.0f)), localRadius * scale);
+}
+
+void ShadowCache::RebuildCasters(const std::vector<MeshInstance>& instances, const glm::vec3& defaultCenter, float defaultRadius)
+{
+    casterDefaultCenter = defaultCenter;
+    casterDefaultRadius = defaultRadius;
+    casterSpheres.resize(instances.size());
+    sceneMin = glm::vec3(0.0f);
+    sceneMax = glm::vec3(0.0f);
+    for (size_t i = 0; i < instances.size(); i++) {
+        glm::vec4 sphere = CasterSphere(instances[i], defaultCenter, defaultRadius);
+        casterSpheres[i] = sphere;
+        glm::vec3 center(sphere);
+        if (i == 0) {
+            sceneMin = center - sphere.w;
+            sceneMax = center + sphere.w;
+        }
+        ExpandBox(sceneMin, sceneMax, center - sphere.w);
+        ExpandBox(sceneMin, sceneMax, center + sphere.w);
+    }
+
+    // Depth ranges come from the scene bounds, so every map has to be refitted
+    for (CachedLight& cached : cachedLights) {
+        cached.bFitted = false;
+    }
+    for (int layer = 0; layer < layerCount; layer++) {
+        views[layer].bDirty = true;
+    }
+}
+
+void ShadowCache::InvalidateMovedCasters(const std::vector<MeshInstance>& instances, const std::vector<size_t>& movedInstances,
+                                         const glm::vec3& defaultCenter, float defaultRadius)
+{
+    bool bBoundsGrew = false;
+    for (size_t index : movedInstances) {
+        if (index >= instances.size() || index >= casterSpheres.size()) {
+            continue;
+        }
+        glm::vec4 before = casterSpheres[index];
+        glm::vec4 after = CasterSphere(instances[index], defaultCenter, defaultRadius);
+        casterSpheres[index] = after;
+
+        // The caster left one spot and arrived at another; both shadows change
+        for (int layer = 0; layer < layerCount; layer++) {
+            CachedView& view = views[layer];
+            if (view.bRendered && !view.bDirty && (SphereInView(view, before) || SphereInView(view, after))) {
+                view.bDirty = true;
+            }
+        }
+
+        glm::vec3 center(after);
+        glm::vec3 newMin = glm::min(sceneMin, center - after.w);
+        glm::vec3 newMax = glm::max(sceneMax, center + after.w);
+        bBoundsGrew = bBoundsGrew || newMin != sceneMin || newMax != sceneMax;
+        sceneMin = newMin;
+        sceneMax = newMax;
+    }
+
+    if (bBoundsGrew) {
+        for (CachedLight& cached : cachedLights) {
+            cached.bFitted = false;
+        }
+    }
+}
+
+void ShadowCache::FitCascades(const Light& light, const CachedLight& cached, const Camera& camera, bool bLightChanged)
+{
+    glm::vec3 direction = glm::normalize(light.getDirection());
+    // Rotation only, so light space axes and the texel grid stay put as the camera moves
+    glm::mat4 lightView = glm::lookAt(glm::vec3(0.0f), direction, StableUp(direction));
+
+    // Scene bounds in light space clip the cascades and give the caster depth range
+    glm::vec3 sceneLightMin(FLT_MAX);
+    glm::vec3 sceneLightMax(-FLT_MAX);
+    for (int corner = 0; corner < 8; corner++) {
+        glm::vec3 point((corner & 1) ? sceneMax.x : sceneMin.x, (corner & 2) ? sceneMax.y : sceneMin.y, (corner & 4) ? sceneMax.z : sceneMin.z);
+        ExpandBox(sceneLightMin, sceneLightMax, glm::vec3(lightView * glm::vec4(point, 1.0f)));
+    }
+
+    float nearDistance = camera.getNear();
+    float farDistance = std::max(std::min(camera.getFar(), maxDistance), nearDistance * 2.0f);
+    float tanY = std::tan(glm::radians(camera.getFOV()) * 0.5f);
+    float tanX = tanY * camera.getAspect();
+    glm::mat4 cameraToLight = lightView * glm::inverse(camera.getViewMatrix());
+
+    float sliceNear = nearDistance;
+    for (int cascade = 0; cascade < cached.layers; cascade++) {
+        float fraction = (float)(cascade + 1) / (float)cached.layers;
+        float uniformSplit = nearDistance + (farDistance - nearDistance) * fraction;
+        float logSplit = nearDistance * std::pow(farDistance / nearDistance, fraction);
+        float sliceFar = glm::mix(uniformSplit, logSplit, SPLIT_LAMBDA);
+
+        // The camera frustum slice in light space
+        glm::vec3 sliceMin(FLT_MAX);
+        glm::vec3 sliceMax(-FLT_MAX);
+        for (int corner = 0; corner < 8; corner++) {
+            float depth = (corner & 4) ? sliceFar : sliceNear;
+            glm::vec3 point(((corner & 1) ? 1.0f : -1.0f) * tanX * depth, ((corner & 2) ? 1.0f : -1.0f) * tanY * depth, -depth);
+            ExpandBox(sliceMin, sliceMax, glm::vec3(cameraToLight * glm::vec4(point, 1.0f)));
+        }
+        sliceNear = sliceFar;
+
+        // Nothing outside the scene casts or receives, so don't spend texels on it
+        glm::vec3 tightMin = glm::max(sliceMin, sceneLightMin);
+        glm::vec3 tightMax = glm::min(sliceMax, sceneLightMax);
+        if (tightMin.x > tightMax.x || tightMin.y > tightMax.y) {
+            tightMin = sliceMin;
+            tightMax = sliceMax;
+        }
+        // Casters between the light and the slice still shadow it: extend toward the light
+        float zNear = std::max(sceneLightMax.z, tightMax.z);
+        float zFar = std::min(tightMin.z, zNear);
+
+        CachedView& view = views[cached.firstLayer + cascade];
+        bool bContained = !bLightChanged && cached.bFitted
+            && tightMin.x >= view.boxMin.x && tightMin.y >= view.boxMin.y
+            && tightMax.x <= view.boxMax.x && tightMax.y <= view.boxMax.y
+            && zNear <= view.boxMax.z && zFar >= view.boxMin.z;
+        if (bContained) {
+            continue;
+        }
+
+        // Refit with a guard band. Extents move in quarter octaves and the box
+        // is snapped to its texel grid, so a refit doesn't shift the texels.
+        float extent = std::max(tightMax.x - tightMin.x, tightMax.y - tightMin.y) * (1.0f + 2.0f * GUARD_BAND);
+        extent = std::exp2(std::ceil(std::log2(std::max(extent, 0.001f)) * 4.0f) / 4.0f);
+        float texel = extent / (float)mapSize;
+        glm::vec2 center((tightMin.x + tightMax.x) * 0.5f, (tightMin.y + tightMax.y) * 0.5f);
+        center = glm::floor(center / texel) * texel;
+        float zMargin = (zNear - zFar) * GUARD_BAND + 1.0f;
+
+        view.boxMin = glm::vec3(center - extent * 0.5f, zFar - zMargin);
+        view.boxMax = glm::vec3(center + extent * 0.5f, zNear + zMargin);
+        glm::mat4 projection = glm::ortho(view.boxMin.x, view.boxMax.x, view.boxMin.y, view.boxMax.y, -view.boxMax.z, -view.boxMin.z);
+        view.lightMatrix = projection * lightView;
+        view.nearPlane = -view.boxMax.z;
+        view.farPlane = -view.boxMin.z;
+        view.texelWorldSize = texel;
+        view.bDirty = true;
+    }
+}
+
+float ShadowCache::FarthestSceneDistance(const glm::vec3& position) const
+{
+    glm::vec3 farthest = glm::max(glm::abs(sceneMin - position), glm::abs(sceneMax - position));
+    return std::max(glm::length(farthest), 1.0f);
+}
+
+void ShadowCache::FitSpot(const Light& light, const CachedLight& cached)
+{
+    glm::vec3 position = light.getPosition();
+    glm::vec3 direction = glm::normalize(light.getDirection());
+    CachedView& view = views[cached.firstLayer];
+
+    view.farPlane = FarthestSceneDistance(position);
+    view.nearPlane = std::max(0.05f, view.farPlane * 0.001f);
+    // A little wider than the cone so its edge isn't cut by the map border
+    float fov = std::min(light.getSpotAngle() * 1.1f + 2.0f, 170.0f);
+    glm::mat4 projection = glm::perspective(glm::radians(fov), 1.0f, view.nearPlane, view.farPlane);
+    view.lightMatrix = projection * glm::lookAt(position, position + direction, StableUp(direction));
+    view.texelWorldSize = 0.0f;
+    view.bDirty = true;
+}
+
+void ShadowCache::FitParaboloids(const Light& light, const CachedLight& cached)
+{
+    glm::vec3 position = light.getPosition();
+    float farPlane = FarthestSceneDistance(position);
+    for (int side = 0; side < cached.layers; side++) {
+        CachedView& view = views[cached.firstLayer + side];
+        // Axis aligned: each hemisphere is split along world z
+        view.lightMatrix = glm::translate(glm::mat4(1.0f), -position);
+        view.nearPlane = 0.05f;
+        view.farPlane = farPlane;
+        view.texelWorldSize = 0.0f;
+        view.bDirty = true;
+    }
+}
+
+bool ShadowCache::SphereInView(const CachedView& view, const glm::vec4& sphere) const
+{
+    glm::vec3 center(sphere);
+    if (view.projection == ShadowProjection::Projective) {
+        return Frustum(view.renderedMatrix).IntersectsSphere(center, sphere.w);
+    }
+    glm::vec3 offset = center - -glm::vec3(view.renderedMatrix[3]);
+    if (glm::length(offset) - sphere.w > view.renderedFar) {
+        return false;
+    }
+    return view.paraboloidSide * offset.z + sphere.w > 0.0f;
+}
+
+void ShadowCache::CollectCasters(const CachedView& view, const std::vector<MeshInstance>& instances, ShadowFrame& frame, ShadowView& out) const
+{
+    out.firstCaster = (uint32_t)frame.casters.size();
+    size_t count = std::min(instances.size(), casterSpheres.size());
+    if (view.projection == ShadowProjection::Projective) {
+        Frustum frustum(view.lightMatrix);
+        for (size_t i = 0; i < count; i++) {
+            if (frustum.IntersectsSphere(glm::vec3(casterSpheres[i]), casterSpheres[i].w)) {
+                frame.casters.push_back({ instances[i].transform, instances[i].mesh });
+            }
+        }
+    }
+    else {
+        glm::vec3 position = -glm::vec3(view.lightMatrix[3]);
+        for (size_t i = 0; i < count; i++) {
+            glm::vec3 offset = glm::vec3(casterSpheres[i]) - position;
+            float radius = casterSpheres[i].w;
+            if (glm::length(offset) - radius <= view.farPlane && view.paraboloidSide * offset.z + radius > 0.0f) {
+                frame.casters.push_back({ instances[i].transform, instances[i].mesh });
+            }
+        }
+    }
+
+    // Same mesh back to back so the render thread can batch them
+    std::sort(frame.casters.begin() + out.firstCaster, frame.casters.end(), [](const ShadowCaster& a, const ShadowCaster& b) {
+        return std::less<const Mesh*>()(a.mesh, b.mesh);
+    });
+    out.casterCount = (uint32_t)frame.casters.size() - out.firstCaster;
+}
+
+void ShadowCache::FillSampling(ShadowFrame& frame, size_t lightCount) const
+{
+    // Shadow map [0, 1] texture space from clip space
+    static const glm::mat4 clipToTexture = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(0.5f)), glm::vec3(0.5f));
+
+    ShadowSampling& sampling = frame.sampling;
+    for (int layer = 0; layer < MAX_SHADOW_LAYERS; layer++) {
+        const CachedView& view = views[layer];
+        if (layer >= layerCount || !view.bRendered) {
+            sampling.matrices[layer] = glm::mat4(1.0f);
+            sampling.layerParams[layer] = glm::vec4(0.0f);
+        }
+        else if (view.projection == ShadowProjection::Paraboloid) {
+            sampling.matrices[layer] = view.renderedMatrix;
+            sampling.layerParams[layer] = glm::vec4(1.0f, 1.0f, view.renderedNear, view.renderedFar);
+        }
+        else {
+            sampling.matrices[layer] = clipToTexture * view.renderedMatrix;
+            sampling.layerParams[layer] = glm::vec4(1.0f, 0.0f, view.renderedTexelWorldSize, view.renderedFar);
+        }
+    }
+    for (int i = 0; i < MeshRenderer::MAX_LIGHTS; i++) {
+        if ((size_t)i < lightCount && (size_t)i < cachedLights.size() && cachedLights[i].firstLayer >= 0) {
+            sampling.lightShadows[i] = glm::vec4((float)cachedLights[i].firstLayer, (float)cachedLights[i].layers, 0.0f, 0.0f);
+        }
+        else {
+            sampling.lightShadows[i] = glm::vec4(-1.0f, 0.0f, 0.0f, 0.0f);
+        }
+    }
+    sampling.params = glm::vec4(1.0f / (float)mapSize, DEPTH_BIAS, 0.0f, 0.0f);
+    frame.layerCount = layerCount;
+}
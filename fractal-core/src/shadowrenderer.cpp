@@ -0,0 +1,204 @@
+// shadowrenderer.cpp
+
+// C++ standard library
+#include <cstring>
+#include <iostream>
+
+// glm
+#include <glm/gtc/type_ptr.hpp>
+
+// local headers
+#include "shadowrenderer.h"
+#include "framearena.h"
+#include "geometrypool.h"
+#include "profiler.h"
+#include "streambuffer.h"
+
+ShadowRenderer::ShadowRenderer()
+{
+    // All four variants are submitted up front so the first shadowed frame doesn't hitch
+    variants = std::make_unique<ShaderVariantCache>("shadow.vert", "shadow.frag");
+    for (int paraboloid = 0; paraboloid < 2; paraboloid++) {
+        for (int instanced = 0; instanced < 2; instanced++) {
+            ShaderDefines defines;
+            if (paraboloid) {
+                defines.Set("PARABOLOID");
+            }
+            if (instanced) {
+                defines.Set("USE_INSTANCE_ATTRIBUTES");
+            }
+            programs[paraboloid][instanced] = variants->Get(defines);
+        }
+    }
+}
+
+ShadowRenderer::~ShadowRenderer()
+{
+    Destroy();
+}
+
+bool ShadowRenderer::Allocate(int size)
+{
+    Destroy();
+
+    // One depth layer per ShadowCache layer, compared in hardware when sampled
+    glGenTextures(1, &depthTexture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, depthTexture);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT24, size, size, MAX_SHADOW_LAYERS, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthTexture, 0, 0);
+    GLenum none = GL_NONE;
+    glDrawBuffers(1, &none);
+    glReadBuffer(GL_NONE);
+
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Shadow map array " << size << "x" << size << " incomplete: 0x" << std::hex << status << std::dec << std::endl;
+        Destroy();
+        return false;
+    }
+    mapSize = size;
+    return true;
+}
+
+void ShadowRenderer::Destroy()
+{
+    if (framebuffer) {
+        glDeleteFramebuffers(1, &framebuffer);
+        framebuffer = 0;
+    }
+    if (depthTexture) {
+        glDeleteTextures(1, &depthTexture);
+        depthTexture = 0;
+    }
+    mapSize = 0;
+}
+
+void ShadowRenderer::Render(const ShadowFrame& frame, const Mesh* defaultMesh)
+{
+    if (!frame.bEnabled || frame.mapSize <= 0) {
+        return;
+    }
+    if (frame.mapSize != mapSize && !Allocate(frame.mapSize)) {
+        return;
+    }
+    if (frame.updates.empty()) {
+        return;
+    }
+    PROFILE_ZONE("ShadowRenderer::Render");
+    PROFILE_GPU_ZONE("Shadows");
+
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glViewport(0, 0, mapSize, mapSize);
+    // Slope scaled offset keeps lit surfaces from shadowing themselves
+    glEnable(GL_POLYGON_OFFSET_FILL);
+    glPolygonOffset(2.0f, 4.0f);
+
+    for (const ShadowView& view : frame.updates) {
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthTexture, 0, view.layer);
+        glClear(GL_DEPTH_BUFFER_BIT);
+        DrawView(frame, view, defaultMesh);
+    }
+
+    glDisable(GL_POLYGON_OFFSET_FILL);
+}
+
+void ShadowRenderer::SetViewUniforms(ShaderProgram* program, const ShadowView& view)
+{
+    glUniformMatrix4fv(glGetUniformLocation(program->programId, "lightMatrix"), 1, GL_FALSE, glm::value_ptr(view.lightMatrix));
+    if (view.projection == ShadowProjection::Paraboloid) {
+        glUniform3f(glGetUniformLocation(program->programId, "paraboloid"), view.paraboloidSide, view.nearPlane, view.farPlane);
+    }
+}
+
+void ShadowRenderer::DrawView(const ShadowFrame& frame, const ShadowView& view, const Mesh* defaultMesh)
+{
+    bool bParaboloid = view.projection == ShadowProjection::Paraboloid;
+    bool bBatching = GeometryPool::GetInstance()->IsBatching();
+    if (bBatching) {
+        DrawPooledCasters(frame, view, defaultMesh, bParaboloid);
+    }
+
+    // Everything the batch didn't take: one draw per caster with its model matrix
+    ShaderProgram* program = programs[bParaboloid][0];
+    bool bBound = false;
+    GLint modelLocation = -1;
+    for (uint32_t i = view.firstCaster; i < view.firstCaster + view.casterCount; i++) {
+        const ShadowCaster& caster = frame.casters[i];
+        const Mesh* mesh = caster.mesh ? caster.mesh : defaultMesh;
+        if (!mesh || (bBatching && mesh->IsPooled())) {
+            continue;
+        }
+        if (!bBound) {
+            bBound = true;
+            program->Use();
+            Profiler::Count(ProfileCounter::StateChanges);
+            SetViewUniforms(program, view);
+            modelLocation = glGetUniformLocation(program->programId, "model");
+        }
+        glUniformMatrix4fv(modelLocation, 1, GL_FALSE, glm::value_ptr(caster.transform));
+        mesh->Draw();
+    }
+}
+
+void ShadowRenderer::DrawPooledCasters(const ShadowFrame& frame, const ShadowView& view, const Mesh* defaultMesh, bool bParaboloid)
+{
+    size_t pooledCount = 0;
+    for (uint32_t i = view.firstCaster; i < view.firstCaster + view.casterCount; i++) {
+        const Mesh* mesh = frame.casters[i].mesh ? frame.casters[i].mesh : defaultMesh;
+        if (mesh && mesh->IsPooled()) {
+            pooledCount++;
+        }
+    }
+    if (pooledCount == 0) {
+        return;
+    }
+
+    // Casters arrive sorted by mesh, so each mesh is one draw of the multi-draw
+    StreamBuffer* stream = StreamBuffer::GetInstance();
+    StreamAllocation instanceData = stream->Allocate(sizeof(InstanceVertex) * pooledCount);
+    if (!instanceData.IsValid()) {
+        return;
+    }
+    GeometryDraw* draws = FrameArena::GetThreadArena().AllocateArray<GeometryDraw>(pooledCount);
+    size_t drawCount = 0;
+    size_t written = 0;
+    const Mesh* drawMesh = nullptr;
+    InstanceVertex vertex = {};
+    for (uint32_t i = view.firstCaster; i < view.firstCaster + view.casterCount; i++) {
+        const ShadowCaster& caster = frame.casters[i];
+        const Mesh* mesh = caster.mesh ? caster.mesh : defaultMesh;
+        if (!mesh || !mesh->IsPooled()) {
+            continue;
+        }
+        vertex.model = caster.transform;
+        memcpy(instanceData.data + written * sizeof(InstanceVertex), &vertex, sizeof(vertex));
+
+        if (mesh != drawMesh) {
+            drawMesh = mesh;
+            GeometryDraw draw;
+            draw.range = mesh->GetPoolRange();
+            draw.baseInstance = (GLuint)written;
+            draws[drawCount++] = draw;
+        }
+        draws[drawCount - 1].instanceCount++;
+        written++;
+    }
+    stream->Flush(instanceData);
+
+    ShaderProgram* program = programs[bParaboloid][1];
+    program->Use();
+    Profiler::Count(ProfileCounter::StateChanges);
+    SetViewUniforms(program, view);
+    GeometryPool::GetInstance()->DrawBatch(draws, drawCount, instanceData);
+}
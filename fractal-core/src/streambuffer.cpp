@@ -0,0 +1,260 @@
+// streambuffer.cpp
+
+// C++ standard library
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+// local headers
+#include "streambuffer.h"
+#include "profiler.h"
+
+StreamBuffer* StreamBuffer::instance = nullptr;
+
+StreamBuffer* StreamBuffer::GetInstance()
+{
+    if (instance == nullptr) {
+        instance = new StreamBuffer();
+    }
+    return instance;
+}
+
+StreamBuffer::StreamBuffer(size_t regionSize)
+    : regionSize(regionSize), currentRegion(REGION_COUNT - 1)
+{
+    // GL objects are created on first use, on the thread that owns the context
+    if (instance == nullptr) {
+        instance = this;
+    }
+}
+
+StreamBuffer::~StreamBuffer()
+{
+    Destroy();
+    DestroyRetired();
+    if (instance == this) {
+        instance = nullptr;
+    }
+}
+
+bool StreamBuffer::Create(size_t newRegionSize)
+{
+    bCreated = true;
+    regionSize = newRegionSize;
+    const size_t totalSize = regionSize * REGION_COUNT;
+
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+
+    #ifndef __EMSCRIPTEN__
+    if (GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage) {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_COPY_WRITE_BUFFER, totalSize, nullptr, flags);
+        mapped = static_cast<unsigned char*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, totalSize, flags));
+        if (!mapped) {
+            // Immutable storage can't be respecified, start over with a plain buffer
+            std::cerr << "Persistent mapping failed, streaming with glBufferSubData" << std::endl;
+            glDeleteBuffers(1, &buffer);
+            glGenBuffers(1, &buffer);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        }
+    }
+    #endif
+
+    bPersistent = mapped != nullptr;
+    if (!bPersistent) {
+        glBufferData(GL_COPY_WRITE_BUFFER, totalSize, nullptr, GL_STREAM_DRAW);
+        staging.resize(regionSize);
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    stats.regionBytes = (unsigned int)regionSize;
+    stats.bPersistent = bPersistent;
+    if (glGetError() != GL_NO_ERROR) {
+        std::cerr << "Failed to create " << totalSize << " byte stream buffer" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void StreamBuffer::Destroy()
+{
+    for (auto& fence : fences) {
+        if (fence) {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+    if (buffer) {
+        if (mapped) {
+            glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+            glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        }
+        glDeleteBuffers(1, &buffer);
+        buffer = 0;
+    }
+    mapped = nullptr;
+    staging.clear();
+}
+
+void StreamBuffer::DestroyRetired()
+{
+    // Deleting a buffer the GPU still reads from is fine, the driver defers it
+    for (auto& old : retired) {
+        if (old.bMapped) {
+            glBindBuffer(GL_COPY_WRITE_BUFFER, old.buffer);
+            glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        }
+        glDeleteBuffers(1, &old.buffer);
+    }
+    retired.clear();
+}
+
+void StreamBuffer::Grow(size_t minRegionSize)
+{
+    PROFILE_ZONE("StreamBuffer::Grow");
+    size_t newRegionSize = regionSize * 2;
+    while (newRegionSize < minRegionSize) {
+        newRegionSize *= 2;
+    }
+
+    // Earlier allocations this frame still point into the old buffer
+    retired.push_back({ buffer, mapped != nullptr, std::move(staging) });
+    buffer = 0;
+    mapped = nullptr;
+    staging = std::vector<unsigned char>();
+
+    // The fences only guarded regions of the old buffer
+    for (auto& fence : fences) {
+        if (fence) {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+
+    Create(newRegionSize);
+    currentRegion = 0;
+    head = 0;
+    stats.grows++;
+    std::cout << "Stream buffer grown to " << REGION_COUNT << " x " << (regionSize >> 10) << " KB" << std::endl;
+}
+
+void StreamBuffer::WaitForRegion(unsigned int region)
+{
+    stats.lastWaitMs = 0.0f;
+    GLsync fence = fences[region];
+    if (!fence) {
+        return;
+    }
+
+    // Poll first so the common case never counts as a wait
+    GLenum result = glClientWaitSync(fence, 0, 0);
+    if (result == GL_TIMEOUT_EXPIRED) {
+        PROFILE_ZONE("StreamBuffer::WaitForRegion");
+        auto start = std::chrono::steady_clock::now();
+        do {
+            result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+        } while (result == GL_TIMEOUT_EXPIRED);
+
+        float waitMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        stats.fenceWaits++;
+        stats.lastWaitMs = waitMs;
+        stats.totalWaitMs += waitMs;
+        stats.maxWaitMs = std::max(stats.maxWaitMs, waitMs);
+    }
+    if (result == GL_WAIT_FAILED) {
+        std::cerr << "Stream buffer fence wait failed" << std::endl;
+    }
+
+    glDeleteSync(fence);
+    fences[region] = nullptr;
+}
+
+void StreamBuffer::BeginFrame()
+{
+    if (!bCreated) {
+        Create(regionSize);
+    }
+
+    currentRegion = (currentRegion + 1) % REGION_COUNT;
+    head = 0;
+    stats.frames++;
+
+    if (bPersistent) {
+        WaitForRegion(currentRegion);
+    }
+    else if (currentRegion == 0 && buffer) {
+        // Orphan on wrap so the uploads never wait on draws still reading the old storage
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, regionSize * REGION_COUNT, nullptr, GL_STREAM_DRAW);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+}
+
+void StreamBuffer::EndFrame()
+{
+    if (bPersistent && buffer) {
+        if (fences[currentRegion]) {
+            glDeleteSync(fences[currentRegion]);
+        }
+        fences[currentRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    stats.lastFrameBytes = (unsigned int)head;
+    stats.peakFrameBytes = std::max(stats.peakFrameBytes, stats.lastFrameBytes);
+    DestroyRetired();
+}
+
+StreamAllocation StreamBuffer::Allocate(size_t size, size_t alignment)
+{
+    StreamAllocation allocation;
+    if (!bCreated && !Create(regionSize)) {
+        return allocation;
+    }
+    if (alignment == 0) {
+        alignment = 1;
+    }
+
+    size_t offset = (head + alignment - 1) / alignment * alignment;
+    if (offset + size > regionSize) {
+        Grow(size);
+        offset = 0;
+    }
+    if (!buffer) {
+        return allocation;
+    }
+
+    allocation.buffer = buffer;
+    allocation.offset = (GLintptr)(currentRegion * regionSize + offset);
+    allocation.size = (GLsizeiptr)size;
+    allocation.data = bPersistent ? mapped + allocation.offset : staging.data() + offset;
+    head = offset + size;
+    return allocation;
+}
+
+void StreamBuffer::Flush(const StreamAllocation& allocation)
+{
+    if (!allocation.IsValid() || allocation.size == 0) {
+        return;
+    }
+
+    // Coherent mappings are visible to commands issued after the write
+    if (!bPersistent) {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, allocation.buffer);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, allocation.offset, allocation.size, allocation.data);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+    Profiler::CountUpload(allocation.size);
+}
+
+size_t StreamBuffer::GetUniformAlignment()
+{
+    if (uniformAlignment == 0) {
+        GLint value = 0;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &value);
+        uniformAlignment = value > 0 ? (size_t)value : 256;
+    }
+    return uniformAlignment;
+}
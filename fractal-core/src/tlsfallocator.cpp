@@ -0,0 +1,272 @@
+// tlsfallocator.cpp
+
+// local headers
+#include "tlsfallocator.h"
+
+TlsfAllocator::TlsfAllocator(uint32_t capacity)
+{
+    Reset(capacity);
+}
+
+uint32_t TlsfAllocator::HighestBit(uint32_t value)
+{
+    return 31 - (uint32_t)__builtin_clz(value);
+}
+
+uint32_t TlsfAllocator::LowestBit(uint32_t value)
+{
+    return (uint32_t)__builtin_ctz(value);
+}
+
+void TlsfAllocator::Mapping(uint32_t size, uint32_t& firstLevel, uint32_t& secondLevel)
+{
+    // Sizes below SL_COUNT get one bin each, above that each power of two is
+    // split into SL_COUNT equal ranges
+    if (size < SL_COUNT) {
+        firstLevel = 0;
+        secondLevel = size;
+        return;
+    }
+    uint32_t bit = HighestBit(size);
+    firstLevel = bit - SL_BITS + 1;
+    secondLevel = (size >> (bit - SL_BITS)) ^ SL_COUNT;
+}
+
+void TlsfAllocator::Reset(uint32_t newCapacity)
+{
+    blocks.Clear();
+    firstLevelBitmap = 0;
+    for (uint32_t i = 0; i < FL_COUNT; i++) {
+        secondLevelBitmaps[i] = 0;
+        for (uint32_t j = 0; j < SL_COUNT; j++) {
+            freeHeads[i][j] = INVALID;
+        }
+    }
+    lastBlock = INVALID;
+    capacity = 0;
+    used = 0;
+    allocationCount = 0;
+    freeBlockCount = 0;
+    Grow(newCapacity);
+}
+
+void TlsfAllocator::Grow(uint32_t newCapacity)
+{
+    if (newCapacity <= capacity) {
+        return;
+    }
+    uint32_t extra = newCapacity - capacity;
+
+    if (lastBlock != INVALID && blocks[lastBlock].bFree) {
+        RemoveFree(lastBlock);
+        blocks[lastBlock].size += extra;
+        InsertFree(lastBlock);
+    }
+    else {
+        uint32_t block = NewBlock();
+        blocks[block].offset = capacity;
+        blocks[block].size = extra;
+        blocks[block].prevPhysical = lastBlock;
+        if (lastBlock != INVALID) {
+            blocks[lastBlock].nextPhysical = block;
+        }
+        lastBlock = block;
+        InsertFree(block);
+    }
+    capacity = newCapacity;
+}
+
+uint32_t TlsfAllocator::NewBlock()
+{
+    return blocks.Create();
+}
+
+void TlsfAllocator::ReleaseBlock(uint32_t block)
+{
+    blocks.Destroy(block);
+}
+
+void TlsfAllocator::InsertFree(uint32_t block)
+{
+    uint32_t firstLevel, secondLevel;
+    Mapping(blocks[block].size, firstLevel, secondLevel);
+
+    uint32_t head = freeHeads[firstLevel][secondLevel];
+    blocks[block].bFree = true;
+    blocks[block].prevFree = INVALID;
+    blocks[block].nextFree = head;
+    if (head != INVALID) {
+        blocks[head].prevFree = block;
+    }
+    freeHeads[firstLevel][secondLevel] = block;
+    firstLevelBitmap |= 1u << firstLevel;
+    secondLevelBitmaps[firstLevel] |= 1u << secondLevel;
+    freeBlockCount++;
+}
+
+void TlsfAllocator::RemoveFree(uint32_t block)
+{
+    uint32_t firstLevel, secondLevel;
+    Mapping(blocks[block].size, firstLevel, secondLevel);
+
+    Block& entry = blocks[block];
+    if (entry.prevFree != INVALID) {
+        blocks[entry.prevFree].nextFree = entry.nextFree;
+    }
+    else {
+        freeHeads[firstLevel][secondLevel] = entry.nextFree;
+    }
+    if (entry.nextFree != INVALID) {
+        blocks[entry.nextFree].prevFree = entry.prevFree;
+    }
+    if (freeHeads[firstLevel][secondLevel] == INVALID) {
+        secondLevelBitmaps[firstLevel] &= ~(1u << secondLevel);
+        if (secondLevelBitmaps[firstLevel] == 0) {
+            firstLevelBitmap &= ~(1u << firstLevel);
+        }
+    }
+    entry.bFree = false;
+    entry.prevFree = INVALID;
+    entry.nextFree = INVALID;
+    freeBlockCount--;
+}
+
+uint32_t TlsfAllocator::FindFree(uint32_t size) const
+{
+    uint32_t firstLevel, secondLevel;
+
+    // Round up to the next bin boundary so any block found is large enough
+    uint64_t rounded = size;
+    if (size >= SL_COUNT) {
+        rounded += (1ull << (HighestBit(size) - SL_BITS)) - 1;
+    }
+    if (rounded <= 0xFFFFFFFFull) {
+        Mapping((uint32_t)rounded, firstLevel, secondLevel);
+        uint32_t secondLevelMap = secondLevelBitmaps[firstLevel] & (~0u << secondLevel);
+        if (secondLevelMap == 0) {
+            uint32_t firstLevelMap = firstLevel + 1 < 32 ? firstLevelBitmap & (~0u << (firstLevel + 1)) : 0;
+            if (firstLevelMap != 0) {
+                firstLevel = LowestBit(firstLevelMap);
+                secondLevelMap = secondLevelBitmaps[firstLevel];
+            }
+        }
+        if (secondLevelMap != 0) {
+            return freeHeads[firstLevel][LowestBit(secondLevelMap)];
+        }
+    }
+
+    // The request's own bin may still hold a block that fits exactly
+    Mapping(size, firstLevel, secondLevel);
+    for (uint32_t block = freeHeads[firstLevel][secondLevel]; block != INVALID; block = blocks[block].nextFree) {
+        if (blocks[block].size >= size) {
+            return block;
+        }
+    }
+    return INVALID;
+}
+
+uint32_t TlsfAllocator::Allocate(uint32_t size)
+{
+    if (size == 0) {
+        return INVALID;
+    }
+    uint32_t block = FindFree(size);
+    if (block == INVALID) {
+        return INVALID;
+    }
+    RemoveFree(block);
+
+    // Return the tail to the free lists
+    if (blocks[block].size > size) {
+        uint32_t remainder = NewBlock();
+        // NewBlock may reallocate the array, so index again from here on
+        blocks[remainder].offset = blocks[block].offset + size;
+        blocks[remainder].size = blocks[block].size - size;
+        blocks[remainder].prevPhysical = block;
+        blocks[remainder].nextPhysical = blocks[block].nextPhysical;
+        if (blocks[block].nextPhysical != INVALID) {
+            blocks[blocks[block].nextPhysical].prevPhysical = remainder;
+        }
+        else {
+            lastBlock = remainder;
+        }
+        blocks[block].nextPhysical = remainder;
+        blocks[block].size = size;
+        InsertFree(remainder);
+    }
+
+    used += size;
+    allocationCount++;
+    return block;
+}
+
+void TlsfAllocator::Absorb(uint32_t block, uint32_t next)
+{
+    // Merge next into block; next must directly follow it
+    blocks[block].size += blocks[next].size;
+    blocks[block].nextPhysical = blocks[next].nextPhysical;
+    if (blocks[next].nextPhysical != INVALID) {
+        blocks[blocks[next].nextPhysical].prevPhysical = block;
+    }
+    else {
+        lastBlock = block;
+    }
+    ReleaseBlock(next);
+}
+
+void TlsfAllocator::Free(uint32_t block)
+{
+    if (!blocks.IsAlive(block) || blocks[block].bFree) {
+        return;
+    }
+    used -= blocks[block].size;
+    allocationCount--;
+
+    uint32_t next = blocks[block].nextPhysical;
+    if (next != INVALID && blocks[next].bFree) {
+        RemoveFree(next);
+        Absorb(block, next);
+    }
+    uint32_t previous = blocks[block].prevPhysical;
+    if (previous != INVALID && blocks[previous].bFree) {
+        RemoveFree(previous);
+        Absorb(previous, block);
+        block = previous;
+    }
+    InsertFree(block);
+}
+
+uint32_t TlsfAllocator::GetLastUsedBlock() const
+{
+    uint32_t block = lastBlock;
+    while (block != INVALID && blocks[block].bFree) {
+        block = blocks[block].prevPhysical;
+    }
+    return block;
+}
+
+uint32_t TlsfAllocator::GetLargestFree() const
+{
+    if (firstLevelBitmap == 0) {
+        return 0;
+    }
+    // The largest block is in the highest non-empty bin, but that bin spans a range
+    uint32_t firstLevel = HighestBit(firstLevelBitmap);
+    uint32_t secondLevel = HighestBit(secondLevelBitmaps[firstLevel]);
+    uint32_t largest = 0;
+    for (uint32_t block = freeHeads[firstLevel][secondLevel]; block != INVALID; block = blocks[block].nextFree) {
+        if (blocks[block].size > largest) {
+            largest = blocks[block].size;
+        }
+    }
+    return largest;
+}
+
+float TlsfAllocator::GetFragmentation() const
+{
+    uint32_t freeUnits = GetFree();
+    if (freeUnits == 0) {
+        return 0.0f;
+    }
+    return 1.0f - (float)GetLargestFree() / (float)freeUnits;
+}
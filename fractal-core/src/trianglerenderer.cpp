@@ -8,6 +8,7 @@
 // local headers
 #include "trianglerenderer.h"
 #include "shaderprogram.h"
+#include "profiler.h"
 
 namespace {
 ShaderProgram* triangleShader = nullptr;
@@ -17,6 +18,13 @@ bool triangleSetup = false;
 
 TriangleRenderer::TriangleRenderer()
 {
+    // Submitted here so it compiles alongside the other programs before the first frame
+    if (!triangleShader) {
+        triangleShader = new ShaderProgram();
+        triangleShader->AttachShaderFromFile("passthrough.vert", GL_VERTEX_SHADER);
+        triangleShader->AttachShaderFromFile("passthrough.frag", GL_FRAGMENT_SHADER);
+        triangleShader->Submit();
+    }
 }
 
 TriangleRenderer::~TriangleRenderer()
@@ -25,14 +33,11 @@ TriangleRenderer::~TriangleRenderer()
 
 void TriangleRenderer::Render()
 {
+    PROFILE_ZONE("TriangleRenderer::Render");
+    PROFILE_GPU_ZONE("TriangleRenderer");
+
     // --- Triangle rendering ---
     if (!triangleSetup) {
-        triangleShader = new ShaderProgram();
-
-        triangleShader->AttachShaderFromFile("passthrough.vert", GL_VERTEX_SHADER);
-        triangleShader->AttachShaderFromFile("passthrough.frag", GL_FRAGMENT_SHADER);
-        triangleShader->Link();
-
         float vertices[] = {
             // positions        // colors
              0.0f,  0.5f, 0.0f,  1.0f, 0.0f, 0.0f, // red
@@ -62,6 +67,8 @@ void TriangleRenderer::Render()
 
     glBindVertexArray(VAO);
     glDrawArrays(GL_TRIANGLES, 0, 3);
+    Profiler::CountDraw(1);
+    Profiler::Count(ProfileCounter::StateChanges, 2);
     glBindVertexArray(0);
 } 
 
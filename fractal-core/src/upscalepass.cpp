@@ -0,0 +1,68 @@
+// upscalepass.cpp
+
+// C++ standard library
+#include <algorithm>
+
+// local headers
+#include "upscalepass.h"
+#include "shaderprogram.h"
+#include "profiler.h"
+
+namespace {
+ShaderProgram* upscaleShader = nullptr;
+}
+
+UpscalePass::UpscalePass()
+{
+    // Submitted here so it compiles alongside the other programs before the first frame
+    if (!upscaleShader) {
+        upscaleShader = new ShaderProgram();
+        upscaleShader->AttachShaderFromFile("upscale.vert", GL_VERTEX_SHADER);
+        upscaleShader->AttachShaderFromFile("upscale.frag", GL_FRAGMENT_SHADER);
+        upscaleShader->Submit();
+    }
+}
+
+UpscalePass::~UpscalePass()
+{
+    if (emptyVAO) {
+        glDeleteVertexArrays(1, &emptyVAO);
+    }
+}
+
+void UpscalePass::Render(const RenderTarget& source, int width, int height, float sharpness)
+{
+    Render(source.GetColorTexture(), source.GetWidth(), source.GetHeight(), width, height, sharpness);
+}
+
+void UpscalePass::Render(GLuint texture, int textureWidth, int textureHeight, int width, int height, float sharpness)
+{
+    PROFILE_ZONE("UpscalePass::Render");
+    PROFILE_GPU_ZONE("UpscalePass");
+
+    // Core profiles refuse to draw without a bound VAO, even with no attributes
+    if (!emptyVAO) {
+        glGenVertexArrays(1, &emptyVAO);
+    }
+
+    float texelX = 1.0f / (float)textureWidth;
+    float texelY = 1.0f / (float)textureHeight;
+
+    glDisable(GL_DEPTH_TEST);
+    upscaleShader->Use();
+    glUniform2f(glGetUniformLocation(upscaleShader->programId, "uUvScale"), width * texelX, height * texelY);
+    glUniform2f(glGetUniformLocation(upscaleShader->programId, "uTexelSize"), texelX, texelY);
+    glUniform2f(glGetUniformLocation(upscaleShader->programId, "uUvMax"), (width - 0.5f) * texelX, (height - 0.5f) * texelY);
+    glUniform1f(glGetUniformLocation(upscaleShader->programId, "uSharpness"), std::max(sharpness, 0.0f));
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glUniform1i(glGetUniformLocation(upscaleShader->programId, "uScene"), 0);
+
+    glBindVertexArray(emptyVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    Profiler::CountDraw(1);
+    Profiler::Count(ProfileCounter::StateChanges, 3);
+    glBindVertexArray(0);
+    glEnable(GL_DEPTH_TEST);
+}
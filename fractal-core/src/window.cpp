@@ -1,15 +1,24 @@
 // window.cpp
 
 // C++ standard library
+#include <cstring>
 #include <iostream>
 
 // local headers
 #include "window.h"
 
-Window::Window(int width, int height)
+#ifndef __EMSCRIPTEN__
+// EGL for headless contexts; keep X11 types out of this translation unit
+#define EGL_NO_X11
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+Window::Window(int width, int height, bool bHeadless)
 {
     this->width = width;
     this->height = height;
+    this->bHeadless = bHeadless;
     bIsInitialized = false;
     
     #ifdef __EMSCRIPTEN__
@@ -32,6 +41,11 @@ bool Window::Init(const std::string& canvasId)
     }
     
     #ifdef __EMSCRIPTEN__
+    if (bHeadless) {
+        std::cerr << "Headless mode is not available in the web build" << std::endl;
+        return false;
+    }
+
     // Initialize WebGL context for Emscripten
     EmscriptenWebGLContextAttributes attrs;
     emscripten_webgl_init_context_attributes(&attrs);
@@ -63,33 +77,56 @@ bool Window::Init(const std::string& canvasId)
     }
     
     #else
-    // Initialize GLFW for native platform
-    std::cout << "Initializing GLFW" << std::endl;
-    if (!glfwInit()) {
-        std::cerr << "Failed to initialize GLFW" << std::endl;
-        return false;
+    if (bHeadless) {
+        if (!InitHeadless()) {
+            DestroyHeadless();
+            return false;
+        }
     }
+    else {
+        // Initialize GLFW for native platform
+        std::cout << "Initializing GLFW" << std::endl;
+        if (!glfwInit()) {
+            std::cerr << "Failed to initialize GLFW" << std::endl;
+            return false;
+        }
     
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-    std::cout << "Creating GLFW window" << std::endl;
-    window = glfwCreateWindow(width, height, "Fractal Renderer", nullptr, nullptr);
-    if (!window) {
-        std::cerr << "Failed to create GLFW window" << std::endl;
-        glfwTerminate();
-        return false;
-    }
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+        std::cout << "Creating GLFW window" << std::endl;
+        window = glfwCreateWindow(width, height, "Fractal Renderer", nullptr, nullptr);
+        if (!window) {
+            std::cerr << "Failed to create GLFW window" << std::endl;
+            glfwTerminate();
+            return false;
+        }
     
-    glfwMakeContextCurrent(window);
+        glfwMakeContextCurrent(window);
     
-    // Initialize OpenGL extensions (GLEW would be used here in a full implementation)
-    if (glewInit() != GLEW_OK) {
-        std::cerr << "Failed to initialize GLEW" << std::endl;
-        return false;
+        // Initialize OpenGL extensions (GLEW would be used here in a full implementation)
+        if (glewInit() != GLEW_OK) {
+            std::cerr << "Failed to initialize GLEW" << std::endl;
+            return false;
+        }
     }
     #endif
+
+    // Headless rendering goes to an offscreen target that stays bound for the
+    // lifetime of the window, so renderers never know the difference
+    if (bHeadless) {
+        headlessTarget = std::make_unique<RenderTarget>();
+        if (!headlessTarget->Create(width, height)) {
+            std::cerr << "Failed to create headless render target" << std::endl;
+            headlessTarget.reset();
+            #ifndef __EMSCRIPTEN__
+            DestroyHeadless();
+            #endif
+            return false;
+        }
+        headlessTarget->Bind();
+    }
     
     // Set up viewport
     glViewport(0, 0, width, height);
@@ -117,26 +154,190 @@ void Window::Destroy()
         glContext = 0;
     }
     #else
+    headlessTarget.reset();
     if (window) {
         glfwDestroyWindow(window);
         window = nullptr;
         glfwTerminate();
     }
+    DestroyHeadless();
     #endif
     
     bIsInitialized = false;
 }
 
+#ifndef __EMSCRIPTEN__
+bool Window::InitHeadless()
+{
+    std::cout << "Initializing headless EGL context" << std::endl;
+
+    // Prefer Mesa's surfaceless platform (works with llvmpipe and without any
+    // display server), fall back to the default display
+    EGLDisplay display = EGL_NO_DISPLAY;
+    const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if (clientExtensions && strstr(clientExtensions, "EGL_MESA_platform_surfaceless")) {
+        auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+        if (getPlatformDisplay) {
+            display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        }
+    }
+    if (display == EGL_NO_DISPLAY) {
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+    if (display == EGL_NO_DISPLAY) {
+        std::cerr << "Failed to get an EGL display" << std::endl;
+        return false;
+    }
+
+    EGLint major = 0;
+    EGLint minor = 0;
+    if (!eglInitialize(display, &major, &minor)) {
+        std::cerr << "Failed to initialize EGL: 0x" << std::hex << eglGetError() << std::dec << std::endl;
+        return false;
+    }
+    eglDisplay = display;
+    std::cout << "EGL " << major << "." << minor << " (" << eglQueryString(display, EGL_VENDOR) << ")" << std::endl;
+
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        std::cerr << "EGL display does not support desktop OpenGL" << std::endl;
+        return false;
+    }
+
+    const EGLint configAttribs[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8,
+        EGL_GREEN_SIZE, 8,
+        EGL_BLUE_SIZE, 8,
+        EGL_ALPHA_SIZE, 8,
+        EGL_DEPTH_SIZE, 24,
+        EGL_NONE
+    };
+    EGLConfig config = nullptr;
+    EGLint numConfigs = 0;
+    if (!eglChooseConfig(display, configAttribs, &config, 1, &numConfigs) || numConfigs == 0) {
+        std::cerr << "No EGL config for an OpenGL pbuffer context" << std::endl;
+        return false;
+    }
+
+    // Same 3.3 core context the GLFW path asks for
+    const EGLint contextAttribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttribs);
+    if (context == EGL_NO_CONTEXT) {
+        std::cerr << "Failed to create EGL context: 0x" << std::hex << eglGetError() << std::dec << std::endl;
+        return false;
+    }
+    eglContext = context;
+
+    // Rendering goes to an FBO, so a surface is only needed when the
+    // implementation cannot make a context current without one
+    EGLSurface surface = EGL_NO_SURFACE;
+    const char* displayExtensions = eglQueryString(display, EGL_EXTENSIONS);
+    if (!displayExtensions || !strstr(displayExtensions, "EGL_KHR_surfaceless_context")) {
+        const EGLint pbufferAttribs[] = {
+            EGL_WIDTH, 1,
+            EGL_HEIGHT, 1,
+            EGL_NONE
+        };
+        surface = eglCreatePbufferSurface(display, config, pbufferAttribs);
+        if (surface == EGL_NO_SURFACE) {
+            std::cerr << "Failed to create EGL pbuffer surface: 0x" << std::hex << eglGetError() << std::dec << std::endl;
+            return false;
+        }
+        eglSurface = surface;
+    }
+
+    if (!eglMakeCurrent(display, surface, surface, context)) {
+        std::cerr << "Failed to make EGL context current: 0x" << std::hex << eglGetError() << std::dec << std::endl;
+        return false;
+    }
+
+    // GLEW built against GLX reports a missing X display even though the EGL
+    // context is current and every entry point resolved fine
+    glewExperimental = GL_TRUE;
+    GLenum glewResult = glewInit();
+    if (glewResult != GLEW_OK && glewResult != GLEW_ERROR_NO_GLX_DISPLAY) {
+        std::cerr << "Failed to initialize GLEW: " << glewGetErrorString(glewResult) << std::endl;
+        return false;
+    }
+    glGetError();
+
+    std::cout << "Headless renderer: " << glGetString(GL_RENDERER) << std::endl;
+    return true;
+}
+
+void Window::DestroyHeadless()
+{
+    if (!eglDisplay) {
+        return;
+    }
+    eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (eglSurface) {
+        eglDestroySurface(eglDisplay, eglSurface);
+        eglSurface = nullptr;
+    }
+    if (eglContext) {
+        eglDestroyContext(eglDisplay, eglContext);
+        eglContext = nullptr;
+    }
+    eglTerminate(eglDisplay);
+    eglDisplay = nullptr;
+}
+#endif
+
 void Window::Resize(int newWidth, int newHeight)
 {
     width = newWidth;
     height = newHeight;
     
     if (bIsInitialized) {
+        if (headlessTarget) {
+            headlessTarget->Resize(width, height);
+            headlessTarget->Bind();
+        }
         glViewport(0, 0, width, height);
     }
 }
 
+void Window::BindBackBuffer() const
+{
+    if (headlessTarget) {
+        headlessTarget->Bind();
+    }
+    else {
+        RenderTarget::BindDefault(width, height);
+    }
+}
+
+bool Window::ReadPixels(std::vector<unsigned char>& pixels) const
+{
+    if (!bIsInitialized) {
+        return false;
+    }
+
+    const size_t rowBytes = (size_t)width * 4;
+    pixels.resize(rowBytes * height);
+
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+    // GL rows start at the bottom
+    std::vector<unsigned char> row(rowBytes);
+    for (int y = 0; y < height / 2; y++) {
+        unsigned char* top = pixels.data() + y * rowBytes;
+        unsigned char* bottom = pixels.data() + (height - 1 - y) * rowBytes;
+        memcpy(row.data(), top, rowBytes);
+        memcpy(top, bottom, rowBytes);
+        memcpy(bottom, row.data(), rowBytes);
+    }
+    return glGetError() == GL_NO_ERROR;
+}
+
 void Window::SwapBuffers()
 {
     #ifndef __EMSCRIPTEN__
@@ -146,11 +347,48 @@ void Window::SwapBuffers()
     #endif
 }
 
+void Window::SetVsync(bool bEnabled)
+{
+    #ifndef __EMSCRIPTEN__
+    if (window) {
+        glfwSwapInterval(bEnabled ? 1 : 0);
+    }
+    #endif
+}
+
+void Window::MakeCurrent()
+{
+    #ifndef __EMSCRIPTEN__
+    if (bHeadless) {
+        EGLSurface surface = eglSurface ? (EGLSurface)eglSurface : EGL_NO_SURFACE;
+        eglMakeCurrent((EGLDisplay)eglDisplay, surface, surface, (EGLContext)eglContext);
+    }
+    else if (window) {
+        glfwMakeContextCurrent(window);
+    }
+    #endif
+}
+
+void Window::ReleaseCurrent()
+{
+    #ifndef __EMSCRIPTEN__
+    if (bHeadless) {
+        eglMakeCurrent((EGLDisplay)eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    }
+    else if (window) {
+        glfwMakeContextCurrent(nullptr);
+    }
+    #endif
+}
+
 bool Window::ShouldClose() const
 {
     #ifdef __EMSCRIPTEN__
     return false; // Emscripten doesn't have a close concept
     #else
+    if (bHeadless) {
+        return bShouldClose;
+    }
     return window ? glfwWindowShouldClose(window) : true;
     #endif
 }
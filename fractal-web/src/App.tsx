@@ -6,6 +6,7 @@ import type { MainModule as FractalModule, Engine, Keyboard, Mouse } from './cpp
 export default function App() {
   const [wasmModule, setWasmModule] = useState<FractalModule>()
   const [engine, setEngine] = useState<Engine>()
+  const [frameStats, setFrameStats] = useState<string>('')
 
   const canvasRef = useRef<HTMLCanvasElement>(null)
   const animationRef = useRef<number | undefined>(undefined)
@@ -114,20 +115,10 @@ export default function App() {
     }
   }, [engine])
 
-  // Helper function to get keyboard state
-  const getKeyboardState = () => {
-    if (!engine) return null
-    return engine.getKeyboard()
-  }
-
-  const getMouseState = () => {
-    if (!engine) return null
-    return engine.getMouse()
-  }
-
   const startRenderLoop = () => {
     console.log('Starting render loop...')
     let lastTime = performance.now()
+    let lastStatsTime = lastTime
     
     const renderLoop = () => {
       const currentTime = performance.now()
@@ -135,48 +126,21 @@ export default function App() {
       lastTime = currentTime
 
       if (engine) {
-        // TODO: Fix keyboard input checking after rebuilding TypeScript definitions
-        // Get fresh keyboard reference from engine each frame
-        const currentKeyboard = getKeyboardState()
-        const currentMouse = getMouseState()
-        const currentCamera = engine.getCamera()
-        const cameraMoveSpeed = 5.0 // Units per second
-
-        //handle keyboard input
-        if(!currentKeyboard) {
-          console.log('Keyboard not found')
+        // Input, fixed-step simulation and interpolated rendering all happen in the engine,
+        // the same way the native loop drives it
+        engine.frame(deltaTime)
+
+        // Refresh the profiler readout a few times per second
+        if (currentTime - lastStatsTime > 250) {
+          lastStatsTime = currentTime
+          const summary = engine.getFrameSummary()
+          const completion = engine.getFractalCompletion()
+          setFrameStats(`CPU ${summary.cpuFrameMs.toFixed(2)} ms | GPU ${summary.gpuFrameMs.toFixed(2)} ms | ` +
+            `${summary.drawCalls} draws | ${summary.triangles} tris | ${summary.stateChanges} state changes | ` +
+            `${(summary.uploadBytes / 1024).toFixed(1)} KB uploaded | jitter ${engine.getFrameJitterMs().toFixed(2)} ms | ` +
+            `render scale ${Math.round(engine.getRenderScale() * 100)}%` +
+            (completion < 1 ? ` | refining ${Math.round(completion * 100)}%` : ''))
         }
-        else if(!currentCamera) {
-          console.log('Camera not found')
-        }
-        else {
-          // Test keyboard input
-          if(currentKeyboard.isKeyDown(32)) {
-          }
-          if(currentKeyboard.isKeyDown('A'.charCodeAt(0))) {
-            currentCamera.moveLeft(cameraMoveSpeed * deltaTime)
-          }
-          if(currentKeyboard.isKeyDown('D'.charCodeAt(0))) {
-            currentCamera.moveRight(cameraMoveSpeed * deltaTime)
-          }
-          if(currentKeyboard.isKeyDown('S'.charCodeAt(0))) {
-            currentCamera.moveBackward(cameraMoveSpeed * deltaTime)
-          }
-          if(currentKeyboard.isKeyDown('W'.charCodeAt(0))) {
-            currentCamera.moveForward(cameraMoveSpeed * deltaTime)
-          }
-          if(currentMouse && currentCamera && currentMouse.isButtonDown(0)) {
-            const deltaX = -currentMouse.getDeltaX()
-            const deltaY = -currentMouse.getDeltaY()
-            currentCamera.rotateYaw(deltaX * 0.1 * deltaTime)
-            currentCamera.rotatePitch(deltaY * 0.1 * deltaTime)
-          }
-        }
-
-        // Mouse input is handled via events, not polling
-        // The engine's mouse input system handles the camera rotation automatically
-        engine.update(deltaTime) // Use actual delta time
-        engine.render()
       }
       animationRef.current = requestAnimationFrame(renderLoop)
     }
@@ -201,6 +165,7 @@ export default function App() {
       <h1>Fractal Web</h1>
       <p>WebAssembly module {wasmModule ? 'loaded' : 'loading...'}</p>
       <p>Controls: WASD to move, QE for up/down, Right-click + drag to rotate</p>
+      <p>{frameStats}</p>
 
       <canvas
         ref={canvasRef}
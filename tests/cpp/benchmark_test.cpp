@@ -0,0 +1,138 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "benchmark.h"
+#include "camerapath.h"
+
+namespace {
+float Distance(const glm::vec3& a, const glm::vec3& b) {
+    return glm::length(a - b);
+}
+
+// Keyframes one second apart, so each segment's parameter runs at the same rate
+CameraPath EvenPath() {
+    CameraPath path;
+    path.AddKeyframe(0.0f, glm::vec3(0.0f, 0.0f, 10.0f), glm::vec3(0.0f));
+    path.AddKeyframe(2.0f, glm::vec3(0.0f, 5.0f, -10.0f), glm::vec3(0.0f, 2.0f, 0.0f));
+    path.AddKeyframe(1.0f, glm::vec3(10.0f, 2.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f));
+    path.AddKeyframe(3.0f, glm::vec3(-10.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+    return path;
+}
+}
+
+TEST(BenchmarkStatsTest, NearestRankPercentiles) {
+    std::vector<float> samples;
+    for (int i = 1; i <= 100; i++) {
+        samples.push_back((float)i);
+    }
+    std::shuffle(samples.begin(), samples.end(), std::mt19937(3));
+    BenchmarkStats stats = BenchmarkStats::FromSamples(samples);
+    EXPECT_EQ(stats.samples, 100u);
+    EXPECT_FLOAT_EQ(stats.mean, 50.5f);
+    EXPECT_FLOAT_EQ(stats.p50, 50.0f);
+    EXPECT_FLOAT_EQ(stats.p95, 95.0f);
+    EXPECT_FLOAT_EQ(stats.p99, 99.0f);
+    EXPECT_FLOAT_EQ(stats.max, 100.0f);
+
+    // Ranks round up to a sample that was actually measured
+    stats = BenchmarkStats::FromSamples({5.0f, 1.0f, 3.0f, 2.0f, 4.0f});
+    EXPECT_FLOAT_EQ(stats.mean, 3.0f);
+    EXPECT_FLOAT_EQ(stats.p50, 3.0f);
+    EXPECT_FLOAT_EQ(stats.p95, 5.0f);
+    EXPECT_FLOAT_EQ(stats.p99, 5.0f);
+
+    stats = BenchmarkStats::FromSamples({7.0f});
+    EXPECT_FLOAT_EQ(stats.p50, 7.0f);
+    EXPECT_FLOAT_EQ(stats.p99, 7.0f);
+    stats = BenchmarkStats::FromSamples({});
+    EXPECT_EQ(stats.samples, 0u);
+    EXPECT_FLOAT_EQ(stats.max, 0.0f);
+}
+
+TEST(CameraPathTest, PassesThroughKeyframesAndClampsAtTheEnds) {
+    CameraPath path = EvenPath();
+    ASSERT_EQ(path.GetKeyframeCount(), 4u);
+    EXPECT_FLOAT_EQ(path.GetDuration(), 3.0f);
+
+    glm::vec3 position;
+    glm::vec3 target;
+    for (const CameraKeyframe& key : path.GetKeyframes()) {
+        path.Evaluate(key.time, position, target);
+        EXPECT_LT(Distance(position, key.position), 1e-5f);
+        EXPECT_LT(Distance(target, key.target), 1e-5f);
+    }
+    const CameraKeyframe& first = path.GetKeyframes().front();
+    const CameraKeyframe& last = path.GetKeyframes().back();
+    path.Evaluate(-5.0f, position, target);
+    EXPECT_LT(Distance(position, first.position), 1e-5f);
+    path.Evaluate(50.0f, position, target);
+    EXPECT_LT(Distance(position, last.position), 1e-5f);
+    EXPECT_LT(Distance(target, last.target), 1e-5f);
+
+    // One keyframe holds still, none leaves the outputs alone
+    CameraPath single;
+    single.AddKeyframe(1.0f, glm::vec3(1.0f, 2.0f, 3.0f), glm::vec3(0.0f));
+    single.Evaluate(9.0f, position, target);
+    EXPECT_LT(Distance(position, glm::vec3(1.0f, 2.0f, 3.0f)), 1e-6f);
+    CameraPath empty;
+    position = glm::vec3(4.0f);
+    empty.Evaluate(0.0f, position, target);
+    EXPECT_LT(Distance(position, glm::vec3(4.0f)), 1e-6f);
+}
+
+TEST(CameraPathTest, IsSmoothAcrossKeyframes) {
+    CameraPath path = EvenPath();
+    const float h = 1e-3f;
+    glm::vec3 target;
+    for (float time : {1.0f, 2.0f}) {
+        // Position and velocity agree from both sides of an interior keyframe
+        glm::vec3 before2, before, at, after, after2;
+        path.Evaluate(time - 2.0f * h, before2, target);
+        path.Evaluate(time - h, before, target);
+        path.Evaluate(time, at, target);
+        path.Evaluate(time + h, after, target);
+        path.Evaluate(time + 2.0f * h, after2, target);
+        EXPECT_LT(Distance(before, at), 0.05f);
+        EXPECT_LT(Distance(after, at), 0.05f);
+        glm::vec3 velocityBefore = (at - before2) / (2.0f * h);
+        glm::vec3 velocityAfter = (after2 - at) / (2.0f * h);
+        EXPECT_LT(Distance(velocityBefore, velocityAfter), 0.1f * glm::length(velocityBefore));
+    }
+
+    // No step anywhere along the way is far out of line with its neighbours
+    glm::vec3 previous;
+    path.Evaluate(0.0f, previous, target);
+    for (int i = 1; i <= 300; i++) {
+        glm::vec3 position;
+        path.Evaluate((float)i * 0.01f, position, target);
+        EXPECT_LT(Distance(position, previous), 0.5f);
+        previous = position;
+    }
+}
+
+TEST(CameraPathTest, LoopingWrapsAroundTheClosingKey) {
+    CameraPath path = EvenPath();
+    path.AddKeyframe(4.0f, glm::vec3(0.0f, 0.0f, 10.0f), glm::vec3(0.0f));
+    path.SetLooping(true);
+
+    glm::vec3 a, b, target;
+    for (float time : {0.3f, 1.7f, 3.9f}) {
+        path.Evaluate(time, a, target);
+        path.Evaluate(time + 2.0f * path.GetDuration(), b, target);
+        EXPECT_LT(Distance(a, b), 1e-3f);
+        path.Evaluate(time - path.GetDuration(), b, target);
+        EXPECT_LT(Distance(a, b), 1e-3f);
+    }
+
+    // The seam is as smooth as any other keyframe
+    const float h = 1e-3f;
+    glm::vec3 before, after;
+    path.Evaluate(4.0f - h, before, target);
+    path.Evaluate(4.0f + h, after, target);
+    EXPECT_LT(Distance(before, after), 0.05f);
+}
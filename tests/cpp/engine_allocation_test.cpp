@@ -0,0 +1,47 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+#include "Engine.h"
+#include "memorytracker.h"
+
+// Once warmed up, a frame of simulation and rendering must not touch the heap.
+// Needs a GL context; skipped where EGL can't create one. Run from fractal-core
+// so the assets are found (make run does).
+TEST(EngineAllocationTest, SteadyStateFramesDoNotAllocate) {
+    EngineConfig config;
+    config.bHeadless = true;
+    config.width = 320;
+    config.height = 180;
+    config.frameLimit = 100000;
+    config.fixedTimestep = 1.0f / 60.0f;
+    config.bRenderThread = false;
+    config.bVsync = false;
+
+    Engine engine;
+    if (!engine.Initialize(config)) {
+        GTEST_SKIP() << "Engine failed to initialize (no headless GL context?)";
+    }
+
+    const float dt = 1.0f / 60.0f;
+    for (int i = 0; i < 120; i++) {
+        engine.Frame(dt);
+    }
+
+    // Everything a frame does outside asset loading counts, including the untagged
+    // profiler, resolution scaler and benchmark bookkeeping between the scopes
+    uint64_t allocations[(int)MemoryTag::Count] = {};
+    for (int i = 0; i < 240; i++) {
+        engine.Frame(dt);
+        for (int tag = 0; tag < (int)MemoryTag::Count; tag++) {
+            allocations[tag] += MemoryTracker::GetFrameAllocations((MemoryTag)tag);
+        }
+    }
+
+    for (int tag = 0; tag < (int)MemoryTag::Count; tag++) {
+        if ((MemoryTag)tag == MemoryTag::Assets) {
+            continue;
+        }
+        EXPECT_EQ(allocations[tag], 0u) << MemoryTagToString((MemoryTag)tag);
+    }
+}
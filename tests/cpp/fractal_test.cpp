@@ -0,0 +1,962 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <set>
+#include <tuple>
+#include <vector>
+
+#include <zlib.h>
+
+#include "fractal/animationrenderer.h"
+#include "fractal/cpuraymarcher.h"
+#include "fractal/deepzoom.h"
+#include "fractal/distanceestimator.h"
+#include "fractal/fixedpoint.h"
+#include "fractal/fractalanimation.h"
+#include "fractal/formula.h"
+#include "fractal/fractalcollider.h"
+#include "fractal/progressiverenderer.h"
+#include "fractal/simdmath.h"
+#include "fractal/surfacemesher.h"
+#include "fractal/temporalrenderer.h"
+#include "jobsystem.h"
+#include "pngencoder.h"
+
+namespace {
+typedef simd::FloatNative Lanes;
+const int WIDTH = Lanes::WIDTH;
+
+// Deterministic points in the cube [-extent, extent]^3
+std::vector<glm::vec3> SamplePoints(int count, float extent) {
+    std::vector<glm::vec3> points;
+    uint32_t state = 12345u;
+    auto next = [&state, extent]() {
+        state = state * 1664525u + 1013904223u;
+        return ((float)(state >> 8) / (float)(1u << 24) * 2.0f - 1.0f) * extent;
+    };
+    for (int i = 0; i < count; i++) {
+        float x = next();
+        float y = next();
+        float z = next();
+        points.push_back(glm::vec3(x, y, z));
+    }
+    return points;
+}
+
+// Estimates for WIDTH points at once through the packet path
+std::vector<float> PacketDistances(const std::vector<glm::vec3>& points, const FractalParams& params) {
+    std::vector<float> distances(points.size());
+    float x[WIDTH], y[WIDTH], z[WIDTH];
+    for (size_t i = 0; i + WIDTH <= points.size(); i += WIDTH) {
+        for (int lane = 0; lane < WIDTH; lane++) {
+            x[lane] = points[i + lane].x;
+            y[lane] = points[i + lane].y;
+            z[lane] = points[i + lane].z;
+        }
+        simd::Vec3<Lanes> p(Lanes::Load(x), Lanes::Load(y), Lanes::Load(z));
+        FractalDistance(p, params).Store(&distances[i]);
+    }
+    return distances;
+}
+
+uint8_t Channel(uint32_t pixel, int channel) {
+    return (uint8_t)((pixel >> (channel * 8)) & 0xFF);
+}
+
+// Pixels with any channel more than tolerance apart
+int CountDiffering(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b, int tolerance) {
+    int differing = 0;
+    for (size_t i = 0; i < a.size(); i++) {
+        for (int channel = 0; channel < 3; channel++) {
+            if (std::abs(Channel(a[i], channel) - Channel(b[i], channel)) > tolerance) {
+                differing++;
+                break;
+            }
+        }
+    }
+    return differing;
+}
+
+FractalView FrontView(int width, int height) {
+    FractalView view;
+    view.position = glm::vec3(0.0f, 0.0f, 3.0f);
+    view.aspect = (float)width / (float)height;
+    return view;
+}
+
+// Deep zoom view iterated directly in doubles, with the same pixel mapping,
+// smooth count and palette as CpuDeepZoom; only valid while doubles resolve it
+std::vector<uint32_t> DirectDeepZoom(const DeepZoomView& view, int width, int height) {
+    std::vector<uint32_t> pixels(width * height);
+    double aspect = (double)width / (double)height;
+    double centerX = view.centerX.ToDouble();
+    double centerY = view.centerY.ToDouble();
+    bool bJulia = view.formula == DeepZoomFormula::Julia;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            double px = centerX + (((double)x + 0.5) * 2.0 / width - 1.0) * aspect * view.scale;
+            double py = centerY + (((double)y + 0.5) * 2.0 / height - 1.0) * view.scale;
+            double cx = bJulia ? view.juliaX : px;
+            double cy = bJulia ? view.juliaY : py;
+            double zx = bJulia ? px : 0.0;
+            double zy = bJulia ? py : 0.0;
+            glm::vec3 color(0.0f);
+            for (int i = 1; i <= view.iterations; i++) {
+                double nextX = zx * zx - zy * zy + cx;
+                zy = 2.0 * zx * zy + cy;
+                zx = nextX;
+                double magnitude = zx * zx + zy * zy;
+                if (magnitude > CpuDeepZoom::ESCAPE_RADIUS_SQUARED) {
+                    color = CpuDeepZoom::Palette((float)i + 1.0f - std::log2(0.5f * std::log2((float)magnitude)));
+                    break;
+                }
+            }
+            pixels[y * width + x] = CpuRayMarcher::PackPixel(color);
+        }
+    }
+    return pixels;
+}
+
+DeepZoomView ViewAt(const char* x, const char* y, double scale, int iterations, float aspect) {
+    DeepZoomView view;
+    view.scale = scale;
+    view.iterations = iterations;
+    view.aspect = aspect;
+    EXPECT_TRUE(view.SetCenter(x, y));
+    return view;
+}
+
+uint32_t ReadUint32(const uint8_t* bytes) {
+    return ((uint32_t)bytes[0] << 24) | ((uint32_t)bytes[1] << 16) | ((uint32_t)bytes[2] << 8) | (uint32_t)bytes[3];
+}
+
+// Minimal decoder for the 8-bit RGB files EncodePng writes, back to opaque RGBA8
+// pixels bottom row first; every filter type is undone
+bool DecodePng(const std::vector<uint8_t>& png, int& width, int& height, std::vector<uint32_t>& pixels) {
+    const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    if (png.size() < 8 || !std::equal(signature, signature + 8, png.begin())) {
+        return false;
+    }
+    std::vector<uint8_t> compressed;
+    width = height = 0;
+    for (size_t at = 8; at + 12 <= png.size();) {
+        uint32_t size = ReadUint32(&png[at]);
+        std::string type(png.begin() + at + 4, png.begin() + at + 8);
+        const uint8_t* data = &png[at + 8];
+        if (crc32(0L, &png[at + 4], size + 4) != ReadUint32(data + size)) {
+            return false;
+        }
+        if (type == "IHDR") {
+            width = (int)ReadUint32(data);
+            height = (int)ReadUint32(data + 4);
+            if (data[8] != 8 || data[9] != 2) {
+                return false;
+            }
+        }
+        else if (type == "IDAT") {
+            compressed.insert(compressed.end(), data, data + size);
+        }
+        at += 12 + size;
+    }
+
+    const size_t rowSize = (size_t)width * 3;
+    std::vector<uint8_t> raw((rowSize + 1) * (size_t)height);
+    uLongf rawSize = (uLongf)raw.size();
+    if (width <= 0 || uncompress(raw.data(), &rawSize, compressed.data(), (uLong)compressed.size()) != Z_OK ||
+        rawSize != raw.size()) {
+        return false;
+    }
+    std::vector<uint8_t> above(rowSize, 0);
+    std::vector<uint8_t> row(rowSize);
+    pixels.assign((size_t)width * (size_t)height, 0);
+    for (int y = 0; y < height; y++) {
+        const uint8_t* line = &raw[(size_t)y * (rowSize + 1)];
+        for (size_t i = 0; i < rowSize; i++) {
+            int a = i >= 3 ? row[i - 3] : 0;
+            int b = above[i];
+            int c = i >= 3 ? above[i - 3] : 0;
+            int p = a + b - c;
+            int paeth = (std::abs(p - a) <= std::abs(p - b) && std::abs(p - a) <= std::abs(p - c)) ? a :
+                        std::abs(p - b) <= std::abs(p - c) ? b : c;
+            int predictions[5] = { 0, a, b, (a + b) / 2, paeth };
+            if (line[0] > 4) {
+                return false;
+            }
+            row[i] = (uint8_t)(line[1 + i] + predictions[line[0]]);
+        }
+        for (int x = 0; x < width; x++) {
+            pixels[(size_t)(height - 1 - y) * width + x] =
+                row[x * 3] | (row[x * 3 + 1] << 8) | (row[x * 3 + 2] << 16) | 0xFF000000u;
+        }
+        above = row;
+    }
+    return true;
+}
+
+bool ReadPngFile(const std::string& path, int& width, int& height, std::vector<uint32_t>& pixels) {
+    std::ifstream file(path, std::ios::binary);
+    std::vector<uint8_t> png((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return DecodePng(png, width, height, pixels);
+}
+
+bool WriteText(const std::string& path, const char* text) {
+    std::ofstream file(path);
+    file << text;
+    return (bool)file;
+}
+}
+
+TEST(SimdMathTest, LanesMatchTheStandardLibrary) {
+    float inputs[WIDTH];
+    float results[WIDTH];
+    float maxSinError = 0.0f, maxAtanError = 0.0f, maxLogError = 0.0f, maxExpError = 0.0f, maxAcosError = 0.0f;
+    for (int i = 0; i < 4096; i += WIDTH) {
+        for (int lane = 0; lane < WIDTH; lane++) {
+            inputs[lane] = -20.0f + 40.0f * (float)(i + lane) / 4096.0f;
+        }
+        Lanes x = Lanes::Load(inputs);
+
+        simd::Sin(x).Store(results);
+        for (int lane = 0; lane < WIDTH; lane++) {
+            maxSinError = std::max(maxSinError, std::fabs(results[lane] - std::sin(inputs[lane])));
+        }
+        simd::Atan2(x, Lanes(-3.0f)).Store(results);
+        for (int lane = 0; lane < WIDTH; lane++) {
+            maxAtanError = std::max(maxAtanError, std::fabs(results[lane] - std::atan2(inputs[lane], -3.0f)));
+        }
+        simd::Exp(x).Store(results);
+        for (int lane = 0; lane < WIDTH; lane++) {
+            maxExpError = std::max(maxExpError, std::fabs(results[lane] / std::exp(inputs[lane]) - 1.0f));
+        }
+        Lanes positive = simd::Abs(x) + Lanes(1e-3f);
+        simd::Log(positive).Store(results);
+        for (int lane = 0; lane < WIDTH; lane++) {
+            maxLogError = std::max(maxLogError, std::fabs(results[lane] - std::log(std::fabs(inputs[lane]) + 1e-3f)));
+        }
+        simd::Acos(x * Lanes(0.05f)).Store(results);
+        for (int lane = 0; lane < WIDTH; lane++) {
+            maxAcosError = std::max(maxAcosError, std::fabs(results[lane] - std::acos(inputs[lane] * 0.05f)));
+        }
+    }
+    EXPECT_LT(maxSinError, 1e-6f);
+    EXPECT_LT(maxAtanError, 1e-6f);
+    EXPECT_LT(maxExpError, 1e-6f);
+    EXPECT_LT(maxLogError, 1e-6f);
+    EXPECT_LT(maxAcosError, 2e-6f);
+}
+
+TEST(DistanceEstimatorTest, PacketsMatchScalarReference) {
+    std::vector<glm::vec3> points = SamplePoints(WIDTH * 64, 1.6f);
+    FractalParams params;
+    for (FractalType type : { FractalType::Mandelbulb, FractalType::QuaternionJulia }) {
+        params.type = type;
+        std::vector<float> packet = PacketDistances(points, params);
+        for (size_t i = 0; i < points.size(); i++) {
+            float reference = EstimateDistance(points[i], params);
+            EXPECT_NEAR(packet[i], reference, 1e-5f + std::fabs(reference) * 1e-4f) << FractalTypeToString(type) << " point " << i;
+        }
+    }
+}
+
+TEST(DistanceEstimatorTest, MandelbulbBounds) {
+    FractalParams params;
+    // The origin never escapes
+    EXPECT_LT(EstimateDistance(glm::vec3(0.0f), params), 0.0f);
+    // The bulb fits inside radius 1.2, so from 3 away the estimate is positive
+    // and no longer than the distance to that sphere plus its own radius
+    float distance = EstimateDistance(glm::vec3(0.0f, 0.0f, 3.0f), params);
+    EXPECT_GT(distance, 0.5f);
+    EXPECT_LT(distance, 3.0f);
+    // Further away is further
+    EXPECT_GT(EstimateDistance(glm::vec3(0.0f, 0.0f, 6.0f), params), distance);
+}
+
+TEST(FormulaTest, SpecializesListedWholePowersOnly) {
+    FractalParams params;
+    EXPECT_EQ(SelectFormulaKernel(params, true).power, 8);
+    EXPECT_EQ(FormulaKernelName(SelectFormulaKernel(params, true)), "mandelbulb8");
+    EXPECT_FALSE(SelectFormulaKernel(params, false).IsSpecialized());
+
+    params.power = 7.5f;
+    EXPECT_FALSE(SelectFormulaKernel(params, true).IsSpecialized());
+    params.power = 40.0f;
+    EXPECT_FALSE(SelectFormulaKernel(params, true).IsSpecialized());
+    params.power = 3.0f;
+    EXPECT_EQ(SelectFormulaKernel(params, true).power, 3);
+
+    params.type = FractalType::QuaternionJulia;
+    EXPECT_EQ(FormulaKernelName(SelectFormulaKernel(params, true)), "julia");
+}
+
+TEST(FormulaTest, SpecializedKernelsMatchGeneric) {
+    std::vector<glm::vec3> points = SamplePoints(WIDTH * 256, 1.4f);
+    for (int power = 2; power <= 8; power++) {
+        FractalParams params;
+        params.power = (float)power;
+        FormulaKernel formula = SelectFormulaKernel(params, true);
+        ASSERT_EQ(formula.power, power);
+
+        // Points that never escape are chaotic, so a few may drift apart over
+        // the iterations; everywhere else the two agree to rounding
+        int differing = 0;
+        float x[WIDTH], y[WIDTH], z[WIDTH], generic[WIDTH], specialized[WIDTH];
+        for (size_t i = 0; i + WIDTH <= points.size(); i += WIDTH) {
+            for (int lane = 0; lane < WIDTH; lane++) {
+                x[lane] = points[i + lane].x;
+                y[lane] = points[i + lane].y;
+                z[lane] = points[i + lane].z;
+            }
+            simd::Vec3<Lanes> p(Lanes::Load(x), Lanes::Load(y), Lanes::Load(z));
+            MandelbulbDistance(p, params).Store(generic);
+            VisitFormulaKernel(params, formula, [&p, &specialized](const auto& kernel) {
+                kernel(p).Store(specialized);
+            });
+            for (int lane = 0; lane < WIDTH; lane++) {
+                if (std::fabs(specialized[lane] - generic[lane]) > 1e-4f + std::fabs(generic[lane]) * 1e-3f) {
+                    differing++;
+                }
+            }
+        }
+        EXPECT_LE(differing, (int)points.size() / 100) << "power " << power;
+    }
+}
+
+TEST(JobSystemTest, ParallelForVisitsEveryIndexOnce) {
+    JobSystem jobs;
+    jobs.Start(3);
+    std::vector<std::atomic<int>> visits(10000);
+    for (std::atomic<int>& visit : visits) {
+        visit = 0;
+    }
+    jobs.ParallelFor(visits.size(), 7, [&visits](size_t i) {
+        visits[i].fetch_add(1);
+    });
+    for (size_t i = 0; i < visits.size(); i++) {
+        ASSERT_EQ(visits[i].load(), 1) << "index " << i;
+    }
+    jobs.Stop();
+}
+
+TEST(JobSystemTest, NestedJobsAndNoWorkers) {
+    for (int workers : { 0, 2 }) {
+        JobSystem jobs;
+        jobs.Start(workers);
+        std::atomic<int> total(0);
+        jobs.ParallelFor(16, 1, [&jobs, &total](size_t) {
+            jobs.ParallelFor(32, 4, [&total](size_t) {
+                total.fetch_add(1);
+            });
+        });
+        EXPECT_EQ(total.load(), 16 * 32) << workers << " workers";
+    }
+}
+
+TEST(CpuRayMarcherTest, PacketImageMatchesReference) {
+    const int width = 61;   // not a multiple of the tile or packet width
+    const int height = 37;
+    FractalView view = FrontView(width, height);
+    FractalParams params;
+    RayMarchSettings settings;
+
+    CpuRayMarcher marcher;
+    std::vector<uint32_t> packet(width * height);
+    std::vector<uint32_t> reference(width * height);
+    marcher.Render(view, params, settings, width, height, packet.data());
+    EXPECT_EQ(marcher.GetStats().rays, (uint64_t)(width * height));
+    EXPECT_GT(marcher.GetStats().steps, 0u);
+    marcher.RenderReference(view, params, settings, width, height, reference.data());
+
+    // Lanes and scalar share the code, so only hits right at the threshold may flip
+    EXPECT_LE(CountDiffering(packet, reference, 2), width * height / 100);
+
+    // The bulb fills the centre; the corners look past it at the background
+    uint32_t center = reference[(height / 2) * width + width / 2];
+    uint32_t corner = reference[0];
+    EXPECT_EQ(Channel(corner, 3), 255);
+    EXPECT_NE(center, corner);
+    EXPECT_GT(Channel(center, 0), Channel(center, 2));    // warm albedo against the cool background
+    EXPECT_LT(Channel(corner, 0), Channel(corner, 2));
+}
+
+TEST(CpuRayMarcherTest, SpecializedImageMatchesGeneric) {
+    const int width = 64;
+    const int height = 48;
+    FractalView view = FrontView(width, height);
+    FractalParams params;
+    RayMarchSettings settings;
+
+    CpuRayMarcher marcher;
+    std::vector<uint32_t> specialized(width * height);
+    std::vector<uint32_t> generic(width * height);
+    marcher.Render(view, params, settings, width, height, specialized.data());
+    EXPECT_TRUE(marcher.GetStats().formula.IsSpecialized());
+    settings.bSpecializedKernels = false;
+    marcher.Render(view, params, settings, width, height, generic.data());
+    EXPECT_FALSE(marcher.GetStats().formula.IsSpecialized());
+
+    EXPECT_LE(CountDiffering(specialized, generic, 2), width * height / 50);
+}
+
+TEST(ProgressiveRendererTest, PreviewWhileMovingThenRefines) {
+    const int width = 64;
+    const int height = 48;
+    FractalView view = FrontView(width, height);
+    FractalParams params;
+    RayMarchSettings settings;
+
+    ProgressiveRenderer progressive;
+    ProgressiveSettings progressiveSettings;
+    progressiveSettings.budgetMs = 0.0f;    // one batch of tiles per update
+    progressive.SetSettings(progressiveSettings);
+
+    // A new view only gets the preview
+    progressive.Update(view, params, settings, width, height);
+    EXPECT_TRUE(progressive.GetStats().bPreview);
+    EXPECT_EQ(progressive.GetImageWidth(), width / progressiveSettings.previewDivisor);
+    EXPECT_EQ(progressive.GetImageHeight(), height / progressiveSettings.previewDivisor);
+    EXPECT_EQ(progressive.GetCompletion(), 0.0f);
+
+    // Holding still refines at full resolution, a little more every update
+    float completion = 0.0f;
+    int updates = 0;
+    while (progressive.GetCompletion() < 1.0f && updates < 10000) {
+        progressive.Update(view, params, settings, width, height);
+        EXPECT_FALSE(progressive.GetStats().bPreview);
+        EXPECT_GE(progressive.GetCompletion(), completion);
+        completion = progressive.GetCompletion();
+        updates++;
+    }
+    EXPECT_GT(updates, 1);
+    const ProgressiveStats& stats = progressive.GetStats();
+    EXPECT_TRUE(stats.bComplete);
+    EXPECT_EQ(progressive.GetImageWidth(), width);
+    EXPECT_EQ(stats.samplesDone, stats.samplesPlanned);
+    // The silhouette and creases are edges, most of the image is not
+    EXPECT_GT(stats.edgePixels, 0);
+    EXPECT_LT(stats.edgePixels, width * height / 2);
+    EXPECT_EQ(stats.samplesPlanned, (uint64_t)(width * height * progressiveSettings.baseSamples) +
+              (uint64_t)stats.edgePixels * (uint64_t)(progressiveSettings.edgeSamples - progressiveSettings.baseSamples));
+
+    // Finished work stays finished while nothing changes
+    progressive.Update(view, params, settings, width, height);
+    EXPECT_EQ(progressive.GetStats().frameRays, 0u);
+
+    // Only a change to the view or the formula starts over
+    FractalParams julia = params;
+    julia.type = FractalType::QuaternionJulia;
+    progressive.Update(view, julia, settings, width, height);
+    EXPECT_TRUE(progressive.GetStats().bPreview);
+    EXPECT_EQ(progressive.GetCompletion(), 0.0f);
+}
+
+TEST(ProgressiveRendererTest, SingleSampleMatchesFullRender) {
+    const int width = 61;
+    const int height = 37;
+    FractalView view = FrontView(width, height);
+    FractalParams params;
+    RayMarchSettings settings;
+
+    ProgressiveRenderer progressive;
+    ProgressiveSettings progressiveSettings;
+    progressiveSettings.budgetMs = 1000.0f;
+    progressiveSettings.baseSamples = 1;
+    progressiveSettings.edgeSamples = 1;
+    progressive.SetSettings(progressiveSettings);
+    progressive.Update(view, params, settings, width, height);
+    progressive.Update(view, params, settings, width, height);
+    ASSERT_EQ(progressive.GetCompletion(), 1.0f);
+
+    // One ray through each pixel centre is exactly what the plain renderer traces
+    CpuRayMarcher marcher;
+    std::vector<uint32_t> full(width * height);
+    marcher.Render(view, params, settings, width, height, full.data());
+    EXPECT_LE(CountDiffering(progressive.GetPixels(), full, 2), width * height / 100);
+}
+
+TEST(TemporalRendererTest, ReprojectsWhileMovingAndSettlesWhenStill) {
+    const int width = 96;
+    const int height = 64;
+    const int pixelCount = width * height;
+    auto orbit = [&](float degrees) {
+        float angle = glm::radians(degrees);
+        return FractalView::LookAt(glm::vec3(2.6f * std::sin(angle), 0.4f, 2.6f * std::cos(angle)), glm::vec3(0.0f), 45.0f,
+                                   (float)width / (float)height);
+    };
+    FractalParams params;
+    RayMarchSettings settings;
+    CpuRayMarcher marcher;
+    std::vector<uint32_t> full(pixelCount);
+
+    // Without a history every pixel is traced, which is the plain render
+    TemporalRenderer temporal;
+    temporal.Update(orbit(0.0f), params, settings, width, height);
+    EXPECT_TRUE(temporal.GetStats().bReset);
+    EXPECT_EQ(temporal.GetStats().rays, (uint64_t)pixelCount);
+    marcher.Render(orbit(0.0f), params, settings, width, height, full.data());
+    EXPECT_LE(CountDiffering(temporal.GetPixels(), full, 2), pixelCount / 100);
+
+    // Moving, a quarter of the pixels are traced plus the ones reprojection rejects
+    const int MOVING_FRAMES = 8;
+    for (int frame = 1; frame <= MOVING_FRAMES; frame++) {
+        temporal.Update(orbit(0.5f * (float)frame), params, settings, width, height);
+        const TemporalStats& stats = temporal.GetStats();
+        EXPECT_FALSE(stats.bReset);
+        EXPECT_EQ(stats.rays + stats.reprojected, (uint64_t)pixelCount);
+        EXPECT_EQ(stats.rays, (uint64_t)(pixelCount / TemporalRenderer::PATTERN_CELLS) + stats.rejected);
+        EXPECT_LT(stats.rays, (uint64_t)pixelCount * 2 / 5);
+    }
+    // Reprojected pixels sit up to half a pixel off their centres
+    FractalView last = orbit(0.5f * (float)MOVING_FRAMES);
+    marcher.Render(last, params, settings, width, height, full.data());
+    EXPECT_LE(CountDiffering(temporal.GetPixels(), full, 24), pixelCount / 8);
+
+    // Holding still traces what was reprojected, one cell at a time, then stops
+    for (int frame = 0; frame < TemporalRenderer::PATTERN_CELLS; frame++) {
+        temporal.Update(last, params, settings, width, height);
+    }
+    EXPECT_LE(CountDiffering(temporal.GetPixels(), full, 2), pixelCount / 100);
+    temporal.Update(last, params, settings, width, height);
+    EXPECT_EQ(temporal.GetStats().rays, 0u);
+
+    // Anything but the view throws the history away
+    FractalParams julia = params;
+    julia.type = FractalType::QuaternionJulia;
+    temporal.Update(last, julia, settings, width, height);
+    EXPECT_TRUE(temporal.GetStats().bReset);
+    EXPECT_EQ(temporal.GetStats().rays, (uint64_t)pixelCount);
+}
+
+TEST(CpuRayMarcherTest, ConePrepassMatchesPlainMarch) {
+    const int width = 64;
+    const int height = 48;
+    FractalView view = FrontView(width, height);
+    FractalParams params;
+    RayMarchSettings settings;
+
+    CpuRayMarcher marcher;
+    std::vector<uint32_t> plain(width * height);
+    std::vector<uint32_t> cone(width * height);
+    marcher.Render(view, params, settings, width, height, plain.data());
+    uint64_t plainSteps = marcher.GetStats().steps;
+    EXPECT_EQ(marcher.GetStats().coneSteps, 0u);
+    settings.bConePrepass = true;
+    marcher.Render(view, params, settings, width, height, cone.data());
+    EXPECT_GT(marcher.GetStats().coneSteps, 0u);
+    EXPECT_LT(marcher.GetStats().steps + marcher.GetStats().coneSteps, plainSteps);
+
+    // Cones stop short of the surface, so hits agree and shading differs only
+    // where the steps a cone stands in for differ from the ray's
+    EXPECT_LE(CountDiffering(plain, cone, 8), width * height / 10);
+}
+
+TEST(FractalColliderTest, QueriesMatchTheEstimate) {
+    FractalParams params;
+    FractalCollider collider;
+    collider.SetScene(params);
+
+    // Sphere distances are the estimate at the centre, packets and single lanes alike
+    std::vector<glm::vec3> points = SamplePoints(203, 1.6f);
+    std::vector<SphereQuery> spheres(points.size());
+    for (size_t i = 0; i < points.size(); i++) {
+        spheres[i].center = points[i];
+        spheres[i].radius = 0.05f;
+    }
+    std::vector<ProximityResult> proximity(spheres.size());
+    collider.QuerySpheres(spheres.data(), (int)spheres.size(), proximity.data());
+    EXPECT_EQ(collider.GetStats().spheres, spheres.size());
+    for (size_t i = 0; i < points.size(); i++) {
+        float expected = std::max(glm::length(points[i]) - params.bailout, EstimateDistance(points[i], params)) - 0.05f;
+        EXPECT_NEAR(proximity[i].distance, expected, 1e-3f * std::max(1.0f, std::fabs(expected)));
+        EXPECT_NEAR(glm::length(proximity[i].normal), 1.0f, 1e-3f);
+    }
+    ProximityResult single;
+    collider.QuerySpheres(&spheres[7], 1, &single);
+    EXPECT_NEAR(single.distance, proximity[7].distance, 1e-5f);
+
+    // Rays towards the middle all hit, at a point the estimate puts on the surface,
+    // and a swept sphere touches before the ray through its centre does
+    const int CASTS = 256;
+    std::vector<SphereCast> rays(CASTS);
+    std::vector<SphereCast> swept(CASTS);
+    std::vector<glm::vec3> origins = SamplePoints(CASTS, 1.0f);
+    for (int i = 0; i < CASTS; i++) {
+        rays[i].origin = glm::normalize(origins[i] + glm::vec3(0.0f, 0.0f, 0.01f)) * 3.0f;
+        rays[i].direction = -glm::normalize(rays[i].origin);
+        rays[i].maxDistance = 4.0f;
+        swept[i] = rays[i];
+        swept[i].radius = 0.1f;
+    }
+    std::vector<CastResult> rayHits(CASTS);
+    std::vector<CastResult> sweptHits(CASTS);
+    collider.CastSpheres(rays.data(), CASTS, rayHits.data());
+    collider.CastSpheres(swept.data(), CASTS, sweptHits.data());
+    for (int i = 0; i < CASTS; i++) {
+        ASSERT_TRUE(rayHits[i].bHit);
+        ASSERT_TRUE(sweptHits[i].bHit);
+        EXPECT_LT(EstimateDistance(rayHits[i].point, params), 2.0f * collider.GetSettings().hitDistance);
+        EXPECT_GT(EstimateDistance(rays[i].origin + rays[i].direction * (rayHits[i].distance - 0.01f), params), 0.0f);
+        EXPECT_LT(sweptHits[i].distance, rayHits[i].distance);
+        EXPECT_LT(glm::dot(sweptHits[i].normal, swept[i].direction), 0.0f);
+    }
+}
+
+TEST(FractalColliderTest, CameraSlidesAlongTheSurface) {
+    FractalParams params;
+    FractalCollider collider;
+    collider.SetScene(params);
+    // Wide enough that its normals smooth over the finest bumps
+    SweptSphereController controller;
+    SweptSphereSettings controllerSettings;
+    controllerSettings.radius = 0.1f;
+    controller.SetSettings(controllerSettings);
+    const float radius = controllerSettings.radius;
+
+    // Flying straight at the set stops just outside it, however the move is cut up
+    glm::vec3 position(0.0f, 0.0f, 3.0f);
+    for (int i = 0; i < 40; i++) {
+        position = controller.Move(collider, position, glm::vec3(0.0f, 0.0f, -0.1f));
+        SphereQuery sphere{position, radius};
+        ProximityResult proximity;
+        collider.QuerySpheres(&sphere, 1, &proximity);
+        EXPECT_GE(proximity.distance, 0.0f);
+    }
+    EXPECT_TRUE(controller.IsTouching());
+    EXPECT_GT(position.z, 0.5f);
+
+    // Pushing into it at an angle slides sideways instead of stopping
+    glm::vec3 stopped = position;
+    position = controller.Move(collider, position, glm::vec3(0.2f, 0.0f, -0.2f));
+    EXPECT_TRUE(controller.IsTouching());
+    EXPECT_GT(position.x - stopped.x, 0.05f);
+    SphereQuery sphere{position, radius};
+    ProximityResult proximity;
+    collider.QuerySpheres(&sphere, 1, &proximity);
+    EXPECT_GE(proximity.distance, 0.0f);
+
+    // Backing away is never held up
+    glm::vec3 away = controller.Move(collider, position, glm::vec3(0.0f, 0.0f, 0.5f));
+    EXPECT_FALSE(controller.IsTouching());
+    EXPECT_NEAR(away.z - position.z, 0.5f, 1e-5f);
+}
+
+TEST(SurfaceMesherTest, ChunksWeldIntoOneSurface) {
+    FractalParams params;
+    SurfaceMeshSettings settings;
+    settings.resolution = 40;
+    settings.chunkCells = 40;
+    SurfaceMesher mesher;
+    SurfaceMesh whole = mesher.Extract(params, settings);
+    settings.chunkCells = 8;
+    SurfaceMesh chunked = mesher.Extract(params, settings);
+    EXPECT_EQ(mesher.GetStats().chunks, 125u);
+    ASSERT_GT(chunked.indices.size(), 0u);
+
+    // Seams share their vertices, so chunking changes nothing and no position repeats
+    EXPECT_EQ(chunked.positions.size(), whole.positions.size());
+    EXPECT_EQ(chunked.indices.size(), whole.indices.size());
+    std::set<std::tuple<float, float, float>> unique;
+    for (const glm::vec3& p : chunked.positions) {
+        unique.insert(std::make_tuple(p.x, p.y, p.z));
+    }
+    EXPECT_EQ(unique.size(), chunked.positions.size());
+
+    // Vertices sit on the iso surface within a cell, and triangles face along the gradient
+    float cellSize = 2.0f * settings.bounds / (float)settings.resolution;
+    for (size_t i = 0; i < chunked.positions.size(); i += 97) {
+        float distance = EstimateDistance(chunked.positions[i], params) - settings.isoCells * cellSize;
+        EXPECT_LT(std::fabs(distance), cellSize);
+    }
+    size_t facing = 0;
+    for (size_t i = 0; i < chunked.indices.size(); i += 3) {
+        glm::vec3 a = chunked.positions[chunked.indices[i]];
+        glm::vec3 b = chunked.positions[chunked.indices[i + 1]];
+        glm::vec3 c = chunked.positions[chunked.indices[i + 2]];
+        glm::vec3 e = b - a;
+        glm::vec3 f = c - a;
+        glm::vec3 face(e.y * f.z - e.z * f.y, e.z * f.x - e.x * f.z, e.x * f.y - e.y * f.x);
+        glm::vec3 normal = chunked.normals[chunked.indices[i]] + chunked.normals[chunked.indices[i + 1]] +
+                           chunked.normals[chunked.indices[i + 2]];
+        facing += glm::dot(face, normal) > 0.0f ? 1 : 0;
+    }
+    EXPECT_GE(facing * 20, chunked.indices.size() / 3 * 19);
+}
+
+TEST(FixedPointTest, ParsePrintAndArithmetic) {
+    FixedPoint value;
+    ASSERT_TRUE(FixedPoint::Parse("-1.25", 3, value));
+    EXPECT_TRUE(value.IsNegative());
+    EXPECT_EQ(value.ToDouble(), -1.25);
+    EXPECT_EQ(value.ToString(4), "-1.2500");
+    ASSERT_TRUE(FixedPoint::Parse("0.000000000000000000000000000001", 6, value));
+    EXPECT_EQ(value.ToString(31), "0.0000000000000000000000000000009");
+    EXPECT_NEAR(value.ToDouble(), 1e-30, 1e-45);
+    EXPECT_FALSE(FixedPoint::Parse("1e-30", 6, value));
+    EXPECT_FALSE(FixedPoint::Parse("-", 6, value));
+    EXPECT_FALSE(FixedPoint::Parse("40000", 6, value));
+
+    const double inputs[] = {0.0, 1.5, -0.75, 0.1, -1.9999, 3.0e-7, -2.5};
+    for (double a : inputs) {
+        for (double b : inputs) {
+            FixedPoint x = FixedPoint::FromDouble(a, 4);
+            FixedPoint y = FixedPoint::FromDouble(b, 4);
+            EXPECT_NEAR((x + y).ToDouble(), a + b, 1e-15);
+            EXPECT_NEAR((x - y).ToDouble(), a - b, 1e-15);
+            EXPECT_NEAR((x * y).ToDouble(), a * b, 1e-15);
+        }
+    }
+
+    // Far below double precision: (1 + 2^-100)^2 - 1 = 2^-99 + 2^-200
+    FixedPoint one = FixedPoint::FromDouble(1.0, 5);
+    FixedPoint tiny = FixedPoint::FromDouble(std::ldexp(1.0, -100), 5);
+    FixedPoint square = (one + tiny) * (one + tiny) - one;
+    EXPECT_EQ(square.ToDouble(), std::ldexp(1.0, -99));
+    EXPECT_EQ((-tiny * tiny).WithLimbs(3).ToDouble(), 0.0);
+    EXPECT_GT(FixedPoint::LimbsForScale(1e-30), FixedPoint::LimbsForScale(1e-6));
+}
+
+TEST(DeepZoomTest, PerturbationMatchesDirectIteration) {
+    const int width = 64;
+    const int height = 48;
+    // Views where float iteration itself doesn't drift from doubles, so any
+    // difference comes from the perturbation
+    DeepZoomView views[2] = {
+        ViewAt("0.0000002", "1", 1e-6, 2000, 4.0f / 3.0f),
+        ViewAt("0", "0", 1.5, 100, 4.0f / 3.0f)
+    };
+    views[1].formula = DeepZoomFormula::Julia;
+    for (const DeepZoomView& view : views) {
+        std::shared_ptr<ReferenceOrbit> orbit = ComputeReferenceOrbit(view);
+        ASSERT_GT(orbit->referenceLength, 1);
+
+        CpuDeepZoom deepZoom;
+        std::vector<uint32_t> perturbed(width * height);
+        deepZoom.Render(view, *orbit, width, height, perturbed.data());
+        std::vector<uint32_t> direct = DirectDeepZoom(view, width, height);
+        // Only pixels on the edge of an escape band may land on the other side
+        EXPECT_LE(CountDiffering(perturbed, direct, 8), width * height / 100) << DeepZoomFormulaToString(view.formula);
+    }
+}
+
+TEST(DeepZoomTest, PacketImageMatchesReferenceAtDepth) {
+    const int width = 64;
+    const int height = 48;
+    DeepZoomView view = ViewAt("0", "1", 1e-30, 4000, 4.0f / 3.0f);
+    view.angle = 0.3f;
+    std::shared_ptr<ReferenceOrbit> orbit = ComputeReferenceOrbit(view);
+    EXPECT_EQ(orbit->limbs, FixedPoint::LimbsForScale(1e-30));
+
+    CpuDeepZoom deepZoom;
+    std::vector<uint32_t> packet(width * height);
+    std::vector<uint32_t> reference(width * height);
+    deepZoom.Render(view, *orbit, width, height, packet.data());
+    DeepZoomStats stats = deepZoom.GetStats();
+    deepZoom.RenderReference(view, *orbit, width, height, reference.data());
+    EXPECT_EQ(stats.iterations, deepZoom.GetStats().iterations);
+    EXPECT_GT(stats.rebases, 0u);
+    EXPECT_LE(CountDiffering(packet, reference, 8), width * height / 100);
+
+    // Structure at 1e-30 rather than one flat color
+    std::vector<uint32_t> flat(width * height, packet[0]);
+    EXPECT_GT(CountDiffering(packet, flat, 8), width * height / 4);
+}
+
+TEST(DeepZoomTest, OrbitCacheReusesNearbyOrbits) {
+    DeepZoomView view = ViewAt("-0.75", "0.1", 1e-3, 500, 1.0f);
+    ReferenceOrbitCache cache;
+    cache.BuildNow(view);
+    ASSERT_TRUE(cache.GetOrbit());
+    uint64_t id = cache.GetOrbit()->id;
+
+    // A small zoom stays within reach of the orbit
+    view.ZoomAt(0.5f, 0.0f, 2.0);
+    cache.BuildNow(view);
+    EXPECT_EQ(cache.GetOrbit()->id, id);
+
+    // Deeper than its precision, or further off, needs a new one
+    view.ZoomAt(0.0f, 0.0f, 1e20);
+    EXPECT_FALSE(cache.GetOrbit()->Fits(view));
+    cache.BuildNow(view);
+    EXPECT_NE(cache.GetOrbit()->id, id);
+    EXPECT_TRUE(cache.GetOrbit()->Fits(view));
+    EXPECT_EQ(cache.GetOrbit()->GetOffset(view), glm::vec2(0.0f));
+
+    view.formula = DeepZoomFormula::Julia;
+    EXPECT_FALSE(cache.GetOrbit()->Fits(view));
+}
+
+TEST(PngEncoderTest, DecodesToTheSamePixels) {
+    // Gradients, noise and flat runs so every filter gets picked somewhere
+    const int width = 37;
+    const int height = 23;
+    std::vector<uint32_t> pixels(width * height);
+    uint32_t state = 7u;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            state = state * 1664525u + 1013904223u;
+            uint32_t noise = y % 3 == 0 ? (state >> 8) : 0u;
+            pixels[y * width + x] = ((uint32_t)(x * 7) & 0xFF) | ((uint32_t)(y * 11) << 8 & 0xFF00) | (noise & 0xFF0000) | 0xFF000000u;
+        }
+    }
+    std::vector<uint8_t> png;
+    ASSERT_TRUE(EncodePng(pixels.data(), width, height, png));
+    int decodedWidth = 0;
+    int decodedHeight = 0;
+    std::vector<uint32_t> decoded;
+    ASSERT_TRUE(DecodePng(png, decodedWidth, decodedHeight, decoded));
+    EXPECT_EQ(decodedWidth, width);
+    EXPECT_EQ(decodedHeight, height);
+    EXPECT_EQ(decoded, pixels);
+}
+
+TEST(FractalAnimationTest, CurvesAndFileRoundTrip) {
+    std::string path = (std::filesystem::temp_directory_path() / "fractal-test.anim").string();
+    ASSERT_TRUE(WriteText(path,
+        "type julia\n"
+        "fps 10\n"
+        "key 0 spline\n"
+        "camera 0 0 3  0 0 0\n"
+        "power 8 step\n"
+        "iterations 10 smooth\n"
+        "key 1 spline\n"
+        "camera 3 0 0  0 0 0\n"
+        "power 4\n"
+        "iterations 20\n"
+        "key 3\n"
+        "camera 0 0 -3  0 1 0\n"
+        "julia 0.1 0.2 0.3 0.4\n"));
+    FractalAnimation animation;
+    ASSERT_TRUE(animation.Load(path));
+    EXPECT_EQ(animation.GetType(), FractalType::QuaternionJulia);
+    EXPECT_EQ(animation.GetFrameCount(), 31);
+
+    // Keys are hit exactly, and values hold outside them
+    FractalAnimationFrame first = animation.EvaluateFrame(0);
+    EXPECT_EQ(first.position, glm::vec3(0.0f, 0.0f, 3.0f));
+    EXPECT_EQ(first.params.type, FractalType::QuaternionJulia);
+    EXPECT_EQ(first.params.iterations, 10);
+    EXPECT_EQ(animation.Evaluate(1.0f).position, glm::vec3(3.0f, 0.0f, 0.0f));
+    EXPECT_EQ(animation.Evaluate(9.0f).target, glm::vec3(0.0f, 1.0f, 0.0f));
+    EXPECT_EQ(animation.Evaluate(2.0f).params.juliaC, glm::vec4(0.1f, 0.2f, 0.3f, 0.4f));
+
+    // Step holds, smooth eases through the middle, spline bows out past the chord
+    EXPECT_EQ(animation.Evaluate(0.9f).params.power, 8.0f);
+    EXPECT_EQ(animation.Evaluate(2.0f).params.power, 4.0f);
+    EXPECT_EQ(animation.Evaluate(0.5f).params.iterations, 15);
+    EXPECT_EQ(animation.Evaluate(0.1f).params.iterations, 10);
+    glm::vec3 middle = animation.Evaluate(0.5f).position;
+    EXPECT_GT(glm::length(middle), glm::length(glm::vec3(1.5f, 0.0f, 1.5f)));
+    glm::vec3 before = animation.Evaluate(0.999f).position;
+    glm::vec3 after = animation.Evaluate(1.001f).position;
+    EXPECT_LT(glm::length(after - before), 0.02f);
+
+    // Saved and loaded again, every frame evaluates the same
+    ASSERT_TRUE(animation.Save(path));
+    FractalAnimation loaded;
+    ASSERT_TRUE(loaded.Load(path));
+    EXPECT_EQ(loaded.GetFrameCount(), animation.GetFrameCount());
+    for (int frame = 0; frame < animation.GetFrameCount(); frame += 3) {
+        FractalAnimationFrame a = animation.EvaluateFrame(frame);
+        FractalAnimationFrame b = loaded.EvaluateFrame(frame);
+        EXPECT_LT(glm::length(a.position - b.position), 1e-4f);
+        EXPECT_EQ(a.params, b.params);
+    }
+
+    ASSERT_TRUE(WriteText(path, "key 0\npower 8 bouncy\n"));
+    EXPECT_FALSE(loaded.Load(path));
+    std::filesystem::remove(path);
+}
+
+TEST(AnimationRendererTest, WritesEveryFrameAndResumes) {
+    std::string path = (std::filesystem::temp_directory_path() / "fractal-test-frames.anim").string();
+    std::string directory = (std::filesystem::temp_directory_path() / "fractal-test-frames").string();
+    std::filesystem::remove_all(directory);
+    ASSERT_TRUE(WriteText(path,
+        "fps 4\n"
+        "key 0 smooth\n"
+        "camera 0 0 3  0 0 0\n"
+        "power 8\n"
+        "key 1\n"
+        "camera 1.5 0.5 2.5  0 0 0\n"
+        "power 6\n"));
+    FractalAnimation animation;
+    ASSERT_TRUE(animation.Load(path));
+
+    AnimationRenderSettings settings;
+    settings.outputDirectory = directory;
+    settings.width = 24;
+    settings.height = 16;
+    settings.samples = 2;
+    RayMarchSettings march;
+    const float aspect = (float)settings.width / (float)settings.height;
+    std::vector<std::vector<uint32_t>> expected(animation.GetFrameCount());
+    CpuRayMarcher marcher;
+    auto render = [&](const FractalAnimationFrame& frame, int, AnimationImage& image) {
+        image.width = settings.width;
+        image.height = settings.height;
+        image.pixels.resize(settings.width * settings.height);
+        marcher.RenderSamples(frame.GetView(aspect), frame.params, march, image.width, image.height, settings.samples,
+                              image.pixels.data());
+        expected[frame.index] = image.pixels;
+        return true;
+    };
+    AnimationRenderer renderer;
+    ASSERT_TRUE(renderer.Render(animation, settings, render));
+    EXPECT_EQ(renderer.GetStats().frames, 5);
+    EXPECT_EQ(renderer.GetStats().rendered, 5);
+    EXPECT_GT(renderer.GetStats().secondsPerFrame, 0.0f);
+
+    int width = 0;
+    int height = 0;
+    std::vector<uint32_t> pixels;
+    for (int frame = 0; frame < 5; frame++) {
+        ASSERT_TRUE(ReadPngFile(AnimationRenderer::GetFramePath(directory, frame), width, height, pixels));
+        EXPECT_EQ(width, settings.width);
+        EXPECT_EQ(height, settings.height);
+        EXPECT_EQ(pixels, expected[frame]);
+    }
+    EXPECT_NE(expected[0], expected[4]);
+
+    // A second run only fills in what is missing
+    std::filesystem::remove(AnimationRenderer::GetFramePath(directory, 3));
+    ASSERT_TRUE(renderer.Render(animation, settings, render));
+    EXPECT_EQ(renderer.GetStats().skipped, 4);
+    EXPECT_EQ(renderer.GetStats().rendered, 1);
+    ASSERT_TRUE(ReadPngFile(AnimationRenderer::GetFramePath(directory, 3), width, height, pixels));
+    EXPECT_EQ(pixels, expected[3]);
+
+    // Deferred reads lag one frame behind, and oversized images are box filtered down
+    std::filesystem::remove_all(directory);
+    std::vector<AnimationImage> drawn(settings.framesInFlight);
+    std::vector<int> order;
+    auto draw = [&](const FractalAnimationFrame& frame, int slot, AnimationImage&) {
+        AnimationImage& image = drawn[slot];
+        image.width = settings.width * 2;
+        image.height = settings.height * 2;
+        image.pixels.assign(image.width * image.height, 0xFF000000u);
+        // One bright pixel in every 2x2 block; a quarter of the light survives the filter
+        for (int y = 0; y < image.height; y += 2) {
+            for (int x = 0; x < image.width; x += 2) {
+                image.pixels[y * image.width + x] = CpuRayMarcher::PackPixel(glm::vec3((float)frame.index / 4.0f, 1.0f, 0.0f));
+            }
+        }
+        order.push_back(frame.index);
+        return true;
+    };
+    auto read = [&](int slot, AnimationImage& image) {
+        image = drawn[slot];
+        order.push_back(-1);
+        return true;
+    };
+    ASSERT_TRUE(renderer.Render(animation, settings, draw, read));
+    EXPECT_EQ(order, std::vector<int>({ 0, 1, -1, 2, -1, 3, -1, 4, -1, -1 }));
+    ASSERT_TRUE(ReadPngFile(AnimationRenderer::GetFramePath(directory, 4), width, height, pixels));
+    EXPECT_EQ(width, settings.width);
+    EXPECT_EQ(pixels[0], CpuRayMarcher::PackPixel(glm::vec3(0.25f, 0.25f, 0.0f)));
+
+    std::filesystem::remove_all(directory);
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+
+#include "frameclock.h"
+#include "framepacer.h"
+
+namespace {
+// Powers of two keep the accumulator exact
+const double STEP = 1.0 / 64.0;
+}
+
+TEST(FrameClockTest, AccumulatesFixedSteps) {
+    FrameClock clock(STEP, 4);
+
+    EXPECT_EQ(clock.Advance(STEP * 0.5), 0);
+    EXPECT_FLOAT_EQ(clock.GetAlpha(), 0.5f);
+    EXPECT_EQ(clock.Advance(STEP * 0.5), 1);
+    EXPECT_FLOAT_EQ(clock.GetAlpha(), 0.0f);
+
+    // Leftovers carry into the next frame and show up as the blend factor
+    EXPECT_EQ(clock.Advance(STEP * 3.25), 3);
+    EXPECT_FLOAT_EQ(clock.GetAlpha(), 0.25f);
+    EXPECT_EQ(clock.Advance(STEP * 0.75), 1);
+    EXPECT_FLOAT_EQ(clock.GetAlpha(), 0.0f);
+    EXPECT_EQ(clock.GetDroppedSteps(), 0u);
+
+    // Time running backwards adds nothing
+    EXPECT_EQ(clock.Advance(-1.0), 0);
+    EXPECT_FLOAT_EQ(clock.GetAlpha(), 0.0f);
+}
+
+TEST(FrameClockTest, CatchUpIsCappedAndTheRestDropped) {
+    FrameClock clock(STEP, 4);
+    clock.Advance(STEP * 0.25);
+
+    // 10.5 steps due: four run, six are dropped, the fraction stays
+    EXPECT_EQ(clock.Advance(STEP * 10.25), 4);
+    EXPECT_EQ(clock.GetDroppedSteps(), 6u);
+    EXPECT_FLOAT_EQ(clock.GetAlpha(), 0.5f);
+
+    // A long stall is clamped to MAX_FRAME_TIME first, 16 steps here
+    EXPECT_EQ(clock.Advance(1.0), 4);
+    EXPECT_EQ(clock.GetDroppedSteps(), 6u + 12u);
+    EXPECT_FLOAT_EQ(clock.GetAlpha(), 0.5f);
+
+    clock.Reset();
+    EXPECT_FLOAT_EQ(clock.GetAlpha(), 0.0f);
+    clock.SetMaxSteps(0);
+    EXPECT_EQ(clock.GetMaxSteps(), 1);
+    EXPECT_EQ(clock.Advance(STEP * 3.0), 1);
+    EXPECT_EQ(clock.GetDroppedSteps(), 18u + 2u);
+
+    // Invalid settings fall back instead of dividing by zero
+    FrameClock fallback(0.0, 0);
+    EXPECT_DOUBLE_EQ(fallback.GetStep(), 1.0 / 60.0);
+    EXPECT_EQ(fallback.GetMaxSteps(), 1);
+    fallback.SetStep(-1.0);
+    EXPECT_DOUBLE_EQ(fallback.GetStep(), 1.0 / 60.0);
+}
+
+TEST(FramePacerTest, HostFramesWaitForTheCap) {
+    FramePacer pacer;
+    pacer.SetTargetFps(30.0f);
+    double elapsed = 0.0;
+
+    // A 60 Hz display capped at 30 runs every other callback, with the time of both
+    EXPECT_FALSE(pacer.ShouldRunFrame(1.0 / 60.0, elapsed));
+    EXPECT_TRUE(pacer.ShouldRunFrame(1.0 / 60.0, elapsed));
+    EXPECT_NEAR(elapsed, 1.0 / 30.0, 1e-9);
+    // Slightly early callbacks still make the slot
+    EXPECT_FALSE(pacer.ShouldRunFrame(0.0165, elapsed));
+    EXPECT_TRUE(pacer.ShouldRunFrame(0.0165, elapsed));
+    EXPECT_NEAR(elapsed, 0.033, 1e-9);
+
+    // Uncapped, every callback runs and the intervals feed the statistics
+    FramePacer uncapped;
+    EXPECT_FLOAT_EQ(uncapped.GetJitterMs(), 0.0f);
+    EXPECT_TRUE(uncapped.ShouldRunFrame(0.010, elapsed));
+    EXPECT_TRUE(uncapped.ShouldRunFrame(0.030, elapsed));
+    EXPECT_NEAR(uncapped.GetAverageFrameMs(), 20.0f, 1e-4f);
+    EXPECT_NEAR(uncapped.GetJitterMs(), 10.0f, 1e-4f);
+}
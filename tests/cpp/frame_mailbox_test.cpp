@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "framemailbox.h"
+
+TEST(FrameMailboxTest, DeliversEveryItemInOrder) {
+    const int COUNT = 10000;
+    FrameMailbox<int> mailbox;
+
+    std::thread producer([&]() {
+        for (int i = 0; i < COUNT; i++) {
+            mailbox.GetWriteSlot() = i;
+            ASSERT_TRUE(mailbox.Publish());
+        }
+        mailbox.Close();
+    });
+
+    int expected = 0;
+    while (int* item = mailbox.Acquire()) {
+        EXPECT_EQ(*item, expected);
+        expected++;
+    }
+    producer.join();
+    EXPECT_EQ(expected, COUNT);
+}
+
+TEST(FrameMailboxTest, PublishWaitsForThePreviousItem) {
+    FrameMailbox<int> mailbox;
+    mailbox.GetWriteSlot() = 1;
+    ASSERT_TRUE(mailbox.Publish());
+
+    std::atomic<bool> bPublished{false};
+    std::thread producer([&]() {
+        mailbox.GetWriteSlot() = 2;
+        EXPECT_TRUE(mailbox.Publish());
+        bPublished = true;
+    });
+
+    // Nobody has taken item 1 yet, so item 2 must not go out
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_FALSE(bPublished);
+
+    int* item = mailbox.Acquire();
+    ASSERT_NE(item, nullptr);
+    EXPECT_EQ(*item, 1);
+    producer.join();
+    EXPECT_TRUE(bPublished);
+
+    item = mailbox.Acquire();
+    ASSERT_NE(item, nullptr);
+    EXPECT_EQ(*item, 2);
+}
+
+TEST(FrameMailboxTest, CloseHandsOutTheLastItemThenNothing) {
+    FrameMailbox<int> mailbox;
+    mailbox.GetWriteSlot() = 7;
+    ASSERT_TRUE(mailbox.Publish());
+    mailbox.Close();
+
+    // Closed mailboxes take nothing new
+    mailbox.GetWriteSlot() = 8;
+    EXPECT_FALSE(mailbox.Publish());
+
+    int* item = mailbox.Acquire();
+    ASSERT_NE(item, nullptr);
+    EXPECT_EQ(*item, 7);
+    EXPECT_EQ(mailbox.Acquire(), nullptr);
+}
@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+#include "framearena.h"
+#include "memorytracker.h"
+#include "objectpool.h"
+
+namespace {
+// Stores through a volatile pointer keep the compiler from eliding new/delete pairs
+int* volatile sink = nullptr;
+
+void AllocateOnce() {
+    sink = new int(1);
+    delete sink;
+    sink = nullptr;
+}
+}
+
+TEST(FrameArenaTest, AllocationsAreAlignedAndDisjoint) {
+    FrameArena arena(1024);
+    unsigned char* a = static_cast<unsigned char*>(arena.Allocate(3, 1));
+    double* b = arena.AllocateArray<double>(4);
+    unsigned char* c = static_cast<unsigned char*>(arena.Allocate(16, 64));
+
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(b) % alignof(double), 0u);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(c) % 64, 0u);
+    EXPECT_GE(reinterpret_cast<unsigned char*>(b), a + 3);
+    EXPECT_GE(c, reinterpret_cast<unsigned char*>(b + 4));
+}
+
+TEST(FrameArenaTest, ResetReusesTheBlock) {
+    FrameArena arena(1024);
+    void* first = arena.Allocate(128);
+    arena.Reset();
+    EXPECT_EQ(arena.GetUsed(), 0u);
+    EXPECT_EQ(arena.Allocate(128), first);
+}
+
+TEST(FrameArenaTest, OverflowGrowsToThePeakOnReset) {
+    FrameArena arena(256);
+    for (int i = 0; i < 16; i++) {
+        ASSERT_NE(arena.Allocate(100), nullptr);
+    }
+    EXPECT_EQ(arena.GetCapacity(), 256u);
+    arena.Reset();
+
+    // The same frame now fits in the block
+    EXPECT_GE(arena.GetCapacity(), arena.GetPeak());
+    size_t capacity = arena.GetCapacity();
+    for (int i = 0; i < 16; i++) {
+        arena.Allocate(100);
+    }
+    arena.Reset();
+    EXPECT_EQ(arena.GetCapacity(), capacity);
+}
+
+TEST(ObjectPoolTest, DestroyedSlotsAreReused) {
+    ObjectPool<int> pool;
+    ObjectPool<int>::Handle a = pool.Create(1);
+    ObjectPool<int>::Handle b = pool.Create(2);
+    EXPECT_EQ(pool[a], 1);
+    EXPECT_EQ(pool[b], 2);
+    EXPECT_EQ(pool.GetSize(), 2u);
+
+    pool.Destroy(a);
+    EXPECT_FALSE(pool.IsAlive(a));
+    EXPECT_TRUE(pool.IsAlive(b));
+    EXPECT_FALSE(pool.IsAlive(ObjectPool<int>::INVALID));
+
+    ObjectPool<int>::Handle c = pool.Create(3);
+    EXPECT_EQ(c, a);
+    EXPECT_EQ(pool[c], 3);
+    EXPECT_EQ(pool.GetSlotCount(), 2u);
+}
+
+TEST(ObjectPoolTest, ChurnAtWorkingSizeDoesNotAllocate) {
+    ObjectPool<int> pool;
+    ObjectPool<int>::Handle handles[64];
+    for (int i = 0; i < 64; i++) {
+        handles[i] = pool.Create(i);
+    }
+
+    uint64_t before = MemoryTracker::GetTotalAllocations();
+    for (int round = 0; round < 8; round++) {
+        for (int i = 0; i < 64; i++) {
+            pool.Destroy(handles[i]);
+        }
+        for (int i = 0; i < 64; i++) {
+            handles[i] = pool.Create(i);
+        }
+    }
+    EXPECT_EQ(MemoryTracker::GetTotalAllocations(), before);
+}
+
+TEST(MemoryTrackerTest, CountsAllocationsByScopeTag) {
+    MemoryTracker::EndFrame();
+    {
+        MEMORY_SCOPE(MemoryTag::Assets);
+        AllocateOnce();
+        AllocateOnce();
+        {
+            MEMORY_SCOPE(MemoryTag::Render);
+            AllocateOnce();
+        }
+        EXPECT_EQ(MemoryTracker::GetCurrentTag(), MemoryTag::Assets);
+    }
+    EXPECT_EQ(MemoryTracker::GetCurrentTag(), MemoryTag::Untagged);
+    MemoryTracker::EndFrame();
+
+    EXPECT_EQ(MemoryTracker::GetFrameAllocations(MemoryTag::Assets), 2u);
+    EXPECT_EQ(MemoryTracker::GetFrameAllocations(MemoryTag::Render), 1u);
+    EXPECT_GE(MemoryTracker::GetFrameBytes(MemoryTag::Assets), 2 * sizeof(int));
+    EXPECT_GE(MemoryTracker::GetFrameAllocations(), 3u);
+
+    // A frame without allocations reads back as zero
+    MemoryTracker::EndFrame();
+    EXPECT_EQ(MemoryTracker::GetFrameAllocations(MemoryTag::Assets), 0u);
+}
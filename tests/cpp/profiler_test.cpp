@@ -0,0 +1,56 @@
+#include <gtest/gtest.h>
+
+#include "Engine.h"
+#include "profiler.h"
+
+namespace {
+#ifdef __EMSCRIPTEN__
+const GLenum TIME_ELAPSED = GL_TIME_ELAPSED_EXT;
+#else
+const GLenum TIME_ELAPSED = GL_TIME_ELAPSED;
+#endif
+
+GLint CurrentTimerQuery() {
+    GLint query = 0;
+    glGetQueryiv(TIME_ELAPSED, GL_CURRENT_QUERY, &query);
+    return query;
+}
+}
+
+// GL_TIME_ELAPSED queries can't nest, so an inner zone must neither start its own
+// query nor end the outer one. Needs a GL context; skipped where EGL can't create one.
+TEST(ProfilerTest, NestedGpuZonesLeaveTheOuterQueryRunning) {
+    EngineConfig config;
+    config.bHeadless = true;
+    config.width = 64;
+    config.height = 64;
+    config.bRenderThread = false;
+    config.bVsync = false;
+
+    Engine engine;
+    if (!engine.Initialize(config)) {
+        GTEST_SKIP() << "Engine failed to initialize (no headless GL context?)";
+    }
+    Profiler* profiler = Profiler::GetInstance();
+    profiler->SetEnabled(true);
+    profiler->BeginGpuZone("Outer");
+    if (!profiler->HasGpuTimers()) {
+        profiler->EndGpuZone();
+        GTEST_SKIP() << "No GPU timer queries";
+    }
+    GLint outer = CurrentTimerQuery();
+    EXPECT_NE(outer, 0);
+
+    {
+        PROFILE_GPU_ZONE("Inner");
+        EXPECT_EQ(profiler->GetGpuZoneDepth(), 2u);
+        EXPECT_EQ(CurrentTimerQuery(), outer);
+    }
+    EXPECT_EQ(profiler->GetGpuZoneDepth(), 1u);
+    EXPECT_EQ(CurrentTimerQuery(), outer);
+
+    profiler->EndGpuZone();
+    EXPECT_EQ(profiler->GetGpuZoneDepth(), 0u);
+    EXPECT_EQ(CurrentTimerQuery(), 0);
+    EXPECT_EQ(glGetError(), (GLenum)GL_NO_ERROR);
+}
@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+#include "resolutionscaler.h"
+
+namespace {
+// GPU timings come back this many frames after submission
+const unsigned int LATENCY = 2;
+// Samples of the frames still in flight when the scale changes are thrown away
+const int STALE = (int)LATENCY;
+
+// Feeds one frame cost per submitted frame, the way the engine does
+struct ScriptedFrames {
+    ResolutionScaler& scaler;
+    unsigned int frame = LATENCY;
+
+    // Frames of cost ms until the scale changes, 0 if it doesn't within limit
+    int RunUntilChange(float ms, int limit) {
+        for (int i = 1; i <= limit; i++) {
+            frame++;
+            if (scaler.Update(frame - LATENCY, ms, frame)) {
+                return i;
+            }
+        }
+        return 0;
+    }
+};
+}
+
+TEST(ResolutionScalerTest, DropsInProportionToTheOvershoot) {
+    ResolutionScaler scaler;
+    scaler.SetTargetMs(10.0f);
+    scaler.SetBounds(0.5f, 1.0f);
+    ScriptedFrames frames{scaler};
+
+    // Twice the budget: cost goes with scale squared, so 1 / sqrt(2), quantized
+    EXPECT_EQ(frames.RunUntilChange(20.0f, 100), (int)ResolutionScaler::DROP_FRAMES);
+    EXPECT_NEAR(scaler.GetScale(), 0.70f, 1e-5f);
+
+    // Samples from before the change don't count, however bad, nor do repeats
+    unsigned int changedAt = frames.frame;
+    for (unsigned int sample = changedAt - LATENCY; sample <= changedAt; sample++) {
+        EXPECT_FALSE(scaler.Update(sample, 100.0f, changedAt));
+        EXPECT_FALSE(scaler.Update(sample, 100.0f, changedAt));
+    }
+    EXPECT_NEAR(scaler.GetScale(), 0.70f, 1e-5f);
+
+    // Just over budget still drops a whole step
+    EXPECT_EQ(frames.RunUntilChange(10.5f, 100), STALE + (int)ResolutionScaler::DROP_FRAMES);
+    EXPECT_NEAR(scaler.GetScale(), 0.65f, 1e-5f);
+
+    // Far over budget stops at the lower bound, and stays there
+    EXPECT_EQ(frames.RunUntilChange(1000.0f, 100), STALE + (int)ResolutionScaler::DROP_FRAMES);
+    EXPECT_NEAR(scaler.GetScale(), 0.5f, 1e-5f);
+    EXPECT_EQ(frames.RunUntilChange(1000.0f, 100), 0);
+
+    // Within the headroom band nothing moves either way
+    EXPECT_EQ(frames.RunUntilChange(9.0f, 2000), 0);
+    EXPECT_NEAR(scaler.GetScale(), 0.5f, 1e-5f);
+}
+
+TEST(ResolutionScalerTest, FailedRaisesBackOff) {
+    ResolutionScaler scaler;
+    scaler.SetTargetMs(10.0f);
+    scaler.SetBounds(0.5f, 1.0f);
+    ScriptedFrames frames{scaler};
+    ASSERT_GT(frames.RunUntilChange(1000.0f, 100), 0);
+    ASSERT_NEAR(scaler.GetScale(), 0.5f, 1e-5f);
+
+    // Under budget climbs one step after the hold
+    EXPECT_EQ(frames.RunUntilChange(5.0f, 2000), STALE + (int)ResolutionScaler::RAISE_FRAMES);
+    EXPECT_NEAR(scaler.GetScale(), 0.55f, 1e-5f);
+
+    // Each raise that goes straight back over budget doubles the hold, up to the cap
+    unsigned int hold = ResolutionScaler::RAISE_FRAMES;
+    for (int attempt = 0; attempt < 7; attempt++) {
+        EXPECT_EQ(frames.RunUntilChange(10.5f, 100), STALE + (int)ResolutionScaler::DROP_FRAMES);
+        EXPECT_NEAR(scaler.GetScale(), 0.5f, 1e-5f);
+        hold = std::min(hold * 2, ResolutionScaler::MAX_RAISE_FRAMES);
+        EXPECT_EQ(frames.RunUntilChange(5.0f, 2000), STALE + (int)hold);
+        EXPECT_NEAR(scaler.GetScale(), 0.55f, 1e-5f);
+    }
+    EXPECT_EQ(hold, ResolutionScaler::MAX_RAISE_FRAMES);
+
+    // A raise that holds up for a whole hold resets it: a later drop is not its fault
+    EXPECT_EQ(frames.RunUntilChange(9.0f, (int)ResolutionScaler::MAX_RAISE_FRAMES + 20), 0);
+    EXPECT_EQ(frames.RunUntilChange(10.5f, 100), (int)ResolutionScaler::DROP_FRAMES);
+    EXPECT_EQ(frames.RunUntilChange(5.0f, 2000), STALE + (int)ResolutionScaler::RAISE_FRAMES);
+
+    // Climbs stop at the upper bound, which clamps the scale when it moves
+    for (int i = 0; i < 20; i++) {
+        frames.RunUntilChange(1.0f, 2000);
+    }
+    EXPECT_NEAR(scaler.GetScale(), 1.0f, 1e-5f);
+    scaler.SetBounds(0.25f, 0.8f);
+    EXPECT_NEAR(scaler.GetScale(), 0.8f, 1e-5f);
+    EXPECT_EQ(frames.RunUntilChange(1.0f, 2000), 0);
+}
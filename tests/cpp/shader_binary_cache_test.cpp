@@ -0,0 +1,59 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#include "shaderbinarycache.h"
+
+namespace {
+std::string MakeCacheDirectory() {
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "fractal-shader-cache-test";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    return directory.string();
+}
+}
+
+TEST(ShaderBinaryCacheTest, StoredEntriesLoadBack) {
+    ShaderBinaryCache cache;
+    cache.SetCacheDirectory(MakeCacheDirectory());
+    std::vector<char> binary = { 'p', 'r', 'o', 'g', 'r', 'a', 'm' };
+    cache.Store("entry", 0x1234, binary);
+
+    GLenum format = 0;
+    std::vector<char> loaded;
+    ASSERT_TRUE(cache.Load("entry", format, loaded));
+    EXPECT_EQ(format, 0x1234u);
+    EXPECT_EQ(loaded, binary);
+    EXPECT_FALSE(cache.Load("missing", format, loaded));
+}
+
+// A bad entry is a miss, never a crash: a header claiming more bytes than the file
+// holds must not reach the resize
+TEST(ShaderBinaryCacheTest, TruncatedEntriesAreMisses) {
+    ShaderBinaryCache cache;
+    std::string directory = MakeCacheDirectory();
+    cache.SetCacheDirectory(directory);
+    cache.Store("entry", 0x1234, std::vector<char>(64, 'x'));
+
+    std::string path = directory + "/entry.bin";
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+    GLenum format = 0;
+    std::vector<char> loaded;
+    EXPECT_FALSE(cache.Load("entry", format, loaded));
+
+    // A garbage size near 4 GB on a tiny file
+    {
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        uint32_t size = 0xfffffff0u;
+        file.seekp(3 * sizeof(uint32_t));
+        file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+    }
+    EXPECT_FALSE(cache.Load("entry", format, loaded));
+
+    // Header only
+    std::filesystem::resize_file(path, 2 * sizeof(uint32_t));
+    EXPECT_FALSE(cache.Load("entry", format, loaded));
+}
@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "shadowcache.h"
+
+namespace {
+const glm::vec3 MESH_CENTER(0.0f);
+const float MESH_RADIUS = 1.0f;
+
+MeshInstance InstanceAt(const glm::vec3& position) {
+    MeshInstance instance;
+    instance.transform = glm::translate(glm::mat4(1.0f), position);
+    return instance;
+}
+
+Camera MakeCamera() {
+    Camera camera;
+    camera.setPerspective(45.0f, 16.0f / 9.0f, 0.1f, 100.0f);
+    camera.setPosition(glm::vec3(0.0f, 10.0f, 60.0f));
+    camera.lookAt(glm::vec3(0.0f));
+    return camera;
+}
+
+Light Sun() {
+    return Light(Light::Type::Directional, glm::vec3(0.0f), glm::normalize(glm::vec3(-0.4f, -1.0f, -0.3f)));
+}
+}
+
+TEST(ShadowCacheTest, StaticSceneIsRenderedOnceThenCached) {
+    ShadowCache cache;
+    cache.Configure(512, 0, 200.0f);
+    std::vector<Light> lights = { Sun() };
+    std::vector<MeshInstance> instances = { InstanceAt(glm::vec3(-10.0f, 0.0f, 0.0f)), InstanceAt(glm::vec3(10.0f, 0.0f, 0.0f)) };
+    std::vector<size_t> moved;
+    Camera camera = MakeCamera();
+    ShadowFrame frame;
+
+    cache.Update(lights, camera, instances, 1, moved, MESH_CENTER, MESH_RADIUS, frame);
+    EXPECT_EQ(frame.layerCount, SHADOW_CASCADE_COUNT);
+    EXPECT_EQ(frame.updates.size(), (size_t)SHADOW_CASCADE_COUNT);
+    EXPECT_EQ(frame.sampling.lightShadows[0].x, 0.0f);
+    EXPECT_EQ(frame.sampling.lightShadows[0].y, (float)SHADOW_CASCADE_COUNT);
+
+    // Nothing moved: every cascade is reused
+    cache.Update(lights, camera, instances, 1, moved, MESH_CENTER, MESH_RADIUS, frame);
+    EXPECT_TRUE(frame.updates.empty());
+    EXPECT_EQ(frame.sampling.layerParams[0].x, 1.0f);
+    EXPECT_EQ(cache.GetRenderedViews(), (uint64_t)SHADOW_CASCADE_COUNT);
+}
+
+TEST(ShadowCacheTest, BudgetSpreadsUpdatesOverFrames) {
+    ShadowCache cache;
+    cache.Configure(512, 1, 200.0f);
+    std::vector<Light> lights = { Sun() };
+    std::vector<MeshInstance> instances = { InstanceAt(glm::vec3(0.0f)) };
+    std::vector<size_t> moved;
+    Camera camera = MakeCamera();
+    ShadowFrame frame;
+
+    // Nearest cascade first, then outwards
+    for (int cascade = 0; cascade < SHADOW_CASCADE_COUNT; cascade++) {
+        cache.Update(lights, camera, instances, 1, moved, MESH_CENTER, MESH_RADIUS, frame);
+        ASSERT_EQ(frame.updates.size(), 1u);
+        EXPECT_EQ(frame.updates[0].layer, cascade);
+    }
+    cache.Update(lights, camera, instances, 1, moved, MESH_CENTER, MESH_RADIUS, frame);
+    EXPECT_TRUE(frame.updates.empty());
+}
+
+TEST(ShadowCacheTest, MovingCasterOnlyInvalidatesViewsContainingIt) {
+    ShadowCache cache;
+    cache.Configure(512, 0, 200.0f);
+    // A point light between two casters: one per paraboloid hemisphere
+    std::vector<Light> lights = { Light(Light::Type::Point, glm::vec3(0.0f)) };
+    std::vector<MeshInstance> instances = {
+        InstanceAt(glm::vec3(0.0f, 0.0f, 20.0f)),
+        InstanceAt(glm::vec3(0.0f, 0.0f, -20.0f)),
+        InstanceAt(glm::vec3(5.0f, 0.0f, 15.0f))
+    };
+    std::vector<size_t> moved;
+    Camera camera = MakeCamera();
+    ShadowFrame frame;
+
+    cache.Update(lights, camera, instances, 1, moved, MESH_CENTER, MESH_RADIUS, frame);
+    ASSERT_EQ(frame.updates.size(), 2u);
+    EXPECT_EQ(frame.updates[0].projection, ShadowProjection::Paraboloid);
+
+    // Stays inside the scene bounds and the +z hemisphere
+    instances[2] = InstanceAt(glm::vec3(5.0f, 0.0f, 10.0f));
+    moved.push_back(2);
+    cache.Update(lights, camera, instances, 1, moved, MESH_CENTER, MESH_RADIUS, frame);
+    ASSERT_EQ(frame.updates.size(), 1u);
+    EXPECT_EQ(frame.updates[0].paraboloidSide, 1.0f);
+    EXPECT_EQ(frame.updates[0].casterCount, 2u);
+}
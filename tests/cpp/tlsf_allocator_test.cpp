@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "tlsfallocator.h"
+
+TEST(TlsfAllocatorTest, FreedNeighboursCoalesce) {
+    TlsfAllocator allocator(1000);
+    uint32_t a = allocator.Allocate(100);
+    uint32_t b = allocator.Allocate(200);
+    uint32_t c = allocator.Allocate(300);
+    ASSERT_NE(c, TlsfAllocator::INVALID);
+    EXPECT_EQ(allocator.GetOffset(a), 0u);
+    EXPECT_EQ(allocator.GetOffset(b), 100u);
+    EXPECT_EQ(allocator.GetOffset(c), 300u);
+    EXPECT_EQ(allocator.GetUsed(), 600u);
+    EXPECT_EQ(allocator.GetAllocationCount(), 3u);
+    EXPECT_EQ(allocator.GetFreeBlockCount(), 1u);
+    EXPECT_FLOAT_EQ(allocator.GetFragmentation(), 0.0f);
+    EXPECT_EQ(allocator.GetLastUsedBlock(), c);
+
+    // A hole in the middle splits the free space
+    allocator.Free(b);
+    EXPECT_EQ(allocator.GetFreeBlockCount(), 2u);
+    EXPECT_EQ(allocator.GetLargestFree(), 400u);
+    EXPECT_FLOAT_EQ(allocator.GetFragmentation(), 1.0f - 400.0f / 600.0f);
+
+    // Its neighbour joins it, then the last allocation joins both free sides
+    allocator.Free(a);
+    EXPECT_EQ(allocator.GetFreeBlockCount(), 2u);
+    EXPECT_EQ(allocator.GetLargestFree(), 400u);
+    allocator.Free(c);
+    EXPECT_EQ(allocator.GetFreeBlockCount(), 1u);
+    EXPECT_EQ(allocator.GetLargestFree(), 1000u);
+    EXPECT_EQ(allocator.GetUsed(), 0u);
+    EXPECT_EQ(allocator.GetLastUsedBlock(), TlsfAllocator::INVALID);
+
+    uint32_t whole = allocator.Allocate(1000);
+    ASSERT_NE(whole, TlsfAllocator::INVALID);
+    EXPECT_EQ(allocator.GetOffset(whole), 0u);
+    EXPECT_EQ(allocator.Allocate(1), TlsfAllocator::INVALID);
+}
+
+TEST(TlsfAllocatorTest, GrowExtendsTheRange) {
+    TlsfAllocator allocator(100);
+    uint32_t first = allocator.Allocate(100);
+    ASSERT_NE(first, TlsfAllocator::INVALID);
+    EXPECT_EQ(allocator.Allocate(10), TlsfAllocator::INVALID);
+
+    // Full to the end: the new range is a block of its own
+    allocator.Grow(150);
+    EXPECT_EQ(allocator.GetCapacity(), 150u);
+    EXPECT_EQ(allocator.GetOffset(first), 0u);
+    uint32_t second = allocator.Allocate(50);
+    ASSERT_NE(second, TlsfAllocator::INVALID);
+    EXPECT_EQ(allocator.GetOffset(second), 100u);
+    EXPECT_EQ(allocator.GetLastUsedBlock(), second);
+
+    // A free tail is extended in place
+    allocator.Free(second);
+    EXPECT_EQ(allocator.GetLastUsedBlock(), first);
+    allocator.Grow(400);
+    EXPECT_EQ(allocator.GetFreeBlockCount(), 1u);
+    EXPECT_EQ(allocator.GetLargestFree(), 300u);
+
+    // Shrinking is not a thing
+    allocator.Grow(200);
+    EXPECT_EQ(allocator.GetCapacity(), 400u);
+}
+
+// Random allocations, frees and growth against a map of what should be live
+TEST(TlsfAllocatorTest, RandomizedAllocationsStayDisjoint) {
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<uint32_t> sizes(1, 300);
+    TlsfAllocator allocator(4096);
+    std::vector<uint32_t> live;
+    uint32_t expectedUsed = 0;
+
+    for (int step = 0; step < 5000; step++) {
+        uint32_t action = rng() % 16;
+        if (action < 9 || live.empty()) {
+            uint32_t size = sizes(rng);
+            uint32_t block = allocator.Allocate(size);
+            if (block == TlsfAllocator::INVALID) {
+                // Only ever fails when no free block could hold it
+                EXPECT_LT(allocator.GetLargestFree(), size);
+                continue;
+            }
+            EXPECT_EQ(allocator.GetSize(block), size);
+            allocator.SetUserData(block, size);
+            live.push_back(block);
+            expectedUsed += size;
+        }
+        else if (action < 15) {
+            size_t index = rng() % live.size();
+            expectedUsed -= allocator.GetSize(live[index]);
+            allocator.Free(live[index]);
+            live[index] = live.back();
+            live.pop_back();
+        }
+        else if (allocator.GetCapacity() < 64 * 1024) {
+            allocator.Grow(allocator.GetCapacity() + 512);
+        }
+
+        if (step % 50 != 0) {
+            continue;
+        }
+        // Live blocks keep their size and data, tile no part of the range twice,
+        // and the last used block is the one furthest along
+        std::map<uint32_t, uint32_t> byOffset;
+        uint32_t lastOffset = 0;
+        uint32_t lastBlock = TlsfAllocator::INVALID;
+        for (uint32_t block : live) {
+            EXPECT_EQ(allocator.GetUserData(block), allocator.GetSize(block));
+            byOffset[allocator.GetOffset(block)] = allocator.GetSize(block);
+            if (lastBlock == TlsfAllocator::INVALID || allocator.GetOffset(block) > lastOffset) {
+                lastOffset = allocator.GetOffset(block);
+                lastBlock = block;
+            }
+        }
+        ASSERT_EQ(byOffset.size(), live.size());
+        uint32_t end = 0;
+        for (const auto& entry : byOffset) {
+            EXPECT_GE(entry.first, end);
+            end = entry.first + entry.second;
+        }
+        EXPECT_LE(end, allocator.GetCapacity());
+        EXPECT_EQ(allocator.GetLastUsedBlock(), lastBlock);
+        EXPECT_EQ(allocator.GetUsed(), expectedUsed);
+        EXPECT_EQ(allocator.GetAllocationCount(), (uint32_t)live.size());
+        EXPECT_LE(allocator.GetLargestFree(), allocator.GetFree());
+        EXPECT_GE(allocator.GetFragmentation(), 0.0f);
+        EXPECT_LT(allocator.GetFragmentation(), 1.0f);
+    }
+
+    // Everything freed merges back into one block
+    for (uint32_t block : live) {
+        allocator.Free(block);
+    }
+    EXPECT_EQ(allocator.GetUsed(), 0u);
+    EXPECT_EQ(allocator.GetFreeBlockCount(), 1u);
+    EXPECT_EQ(allocator.GetLargestFree(), allocator.GetCapacity());
+    EXPECT_FLOAT_EQ(allocator.GetFragmentation(), 0.0f);
+}